@@ -0,0 +1,34 @@
+-- title: Counter
+-- 示例应用：复制到应用目录（默认 /mnt/app/apps）后出现在主屏幕上，
+-- 打开后修改并保存本文件，界面会重新加载并保留计数
+local app = {}
+local count = 0
+
+function app.open(root, state)
+    count = state or 0
+
+    local label = lv.label_create(root)
+    label:set_text(tostring(count))
+    label:align(lv.ALIGN_CENTER, 0, -30)
+
+    local add = lv.button_create(root)
+    add:align(lv.ALIGN_CENTER, 0, 30)
+    lv.label_create(add):set_text("+1")
+    add:on(lv.EVENT_CLICKED, function()
+        count = count + 1
+        label:set_text(tostring(count))
+    end)
+
+    local exit = lv.button_create(root)
+    exit:align(lv.ALIGN_TOP_LEFT, 0, 0)
+    lv.label_create(exit):set_text("exit")
+    exit:on(lv.EVENT_CLICKED, function()
+        apps.close()
+    end)
+end
+
+function app.close(root)
+    return count
+end
+
+return app
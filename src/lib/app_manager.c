@@ -0,0 +1,246 @@
+/**
+ * @file app_manager.c
+ * @brief 主屏幕应用生命周期管理实现
+ *
+ * 应用占用的内存在打开时记下 LVGL 已用内存，挂起时加上这段时间的增量（同一时间只有
+ * 一个应用在运行，增量基本都属于它）。淘汰时用 lv_obj_delete_async 删除根对象，
+ * 挂起可能发生在应用自己的事件回调中（如返回按钮）。
+ */
+
+#include "app_manager.h"
+#include <stdio.h>
+#include <string.h>
+#include "container.h"
+
+/**
+ * @brief 登记的应用
+ */
+typedef struct {
+    app_desc_t desc;
+    app_state_t state;
+    lv_obj_t *root;             /**< 根对象，可能为 NULL */
+    size_t cost;                /**< 占用的内存（挂起时更新） */
+    size_t mark;                /**< 打开时的 LVGL 已用内存 */
+    uint32_t last_used;         /**< 最近使用序号 */
+} app_entry_t;
+
+static app_entry_t entries[APP_MANAGER_MAX];
+static int entry_count = 0;
+static int current = -1;
+static uint32_t use_counter = 0;
+static size_t budget = APP_MANAGER_BUDGET;
+static app_manager_stats_t mgr_stats;
+
+static size_t heap_used(void) {
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+static void show_home(bool show) {
+    if (parent == NULL) {
+        return;
+    }
+    if (show) {
+        lv_obj_remove_flag(parent, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(parent, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+/**
+ * @brief 根对象被其他代码删除时同步状态
+ */
+static void root_delete_cb(lv_event_t *e) {
+    app_entry_t *a = (app_entry_t *)lv_event_get_user_data(e);
+    if (a->state == APP_STATE_DESTROYED || lv_event_get_target(e) != a->root) {
+        return;
+    }
+    a->state = APP_STATE_DESTROYED;
+    if (a->desc.destroy != NULL) {
+        a->desc.destroy(a->root, a->desc.user_data);
+    }
+    a->root = NULL;
+    a->cost = 0;
+    if (current == a - entries) {
+        current = -1;
+        show_home(true);
+    }
+}
+
+static void destroy_entry(app_entry_t *a) {
+    if (a->state == APP_STATE_DESTROYED) {
+        return;
+    }
+    bool was_current = current == a - entries;
+    a->state = APP_STATE_DESTROYED;
+    if (a->desc.destroy != NULL) {
+        a->desc.destroy(a->root, a->desc.user_data);
+    }
+    if (a->root != NULL) {
+        lv_obj_remove_event_cb_with_user_data(a->root, root_delete_cb, a);
+        lv_obj_add_flag(a->root, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_delete_async(a->root);
+        a->root = NULL;
+    }
+    a->cost = 0;
+    if (was_current) {
+        current = -1;
+        if (a->desc.hide_home) {
+            show_home(true);
+        }
+    }
+}
+
+/**
+ * @brief 挂起应用超出预算时按最久未用的顺序销毁
+ */
+static void evict(void) {
+    for (;;) {
+        app_entry_t *victim = NULL;
+        size_t total = 0;
+        int count = 0;
+        for (int i = 0; i < entry_count; i++) {
+            app_entry_t *a = &entries[i];
+            if (a->state != APP_STATE_SUSPENDED) {
+                continue;
+            }
+            total += a->cost;
+            count++;
+            if (victim == NULL || a->last_used < victim->last_used) {
+                victim = a;
+            }
+        }
+        if (victim == NULL || (total <= budget && count <= APP_MANAGER_MAX_SUSPENDED)) {
+            return;
+        }
+        printf("[app] 淘汰 %s（%zu KB，挂起共 %zu KB）\n", victim->desc.name, victim->cost / 1024, total / 1024);
+        destroy_entry(victim);
+        mgr_stats.evictions++;
+    }
+}
+
+static void suspend_current(void) {
+    app_entry_t *a = &entries[current];
+    if (a->desc.suspend != NULL) {
+        a->desc.suspend(a->root, a->desc.user_data);
+    }
+    if (a->root != NULL) {
+        lv_obj_add_flag(a->root, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    // 运行期间的内存增量计入应用（释放多于分配时减少）
+    size_t used = heap_used();
+    if (used >= a->mark) {
+        a->cost += used - a->mark;
+    } else {
+        a->cost = a->cost > a->mark - used ? a->cost - (a->mark - used) : 0;
+    }
+    a->state = APP_STATE_SUSPENDED;
+    a->last_used = ++use_counter;
+    current = -1;
+    mgr_stats.suspends++;
+    if (a->desc.hide_home) {
+        show_home(true);
+    }
+    evict();
+}
+
+/*=====================
+ * 公共接口
+ *====================*/
+
+int app_manager_register(const app_desc_t *desc) {
+    if (entry_count >= APP_MANAGER_MAX || desc->create == NULL) {
+        return -1;
+    }
+    app_entry_t *a = &entries[entry_count];
+    memset(a, 0, sizeof(*a));
+    a->desc = *desc;
+    return entry_count++;
+}
+
+bool app_manager_open(int id) {
+    if (id < 0 || id >= entry_count) {
+        return false;
+    }
+    if (current == id) {
+        return true;
+    }
+    if (current >= 0) {
+        suspend_current();
+    }
+
+    app_entry_t *a = &entries[id];
+    a->mark = heap_used();
+    if (a->state == APP_STATE_SUSPENDED) {
+        if (a->root != NULL) {
+            lv_obj_remove_flag(a->root, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_move_foreground(a->root);
+        }
+        if (a->desc.resume != NULL) {
+            a->desc.resume(a->root, a->desc.user_data);
+        }
+        mgr_stats.resumes++;
+    } else {
+        a->root = NULL;
+        a->cost = 0;
+        if (!a->desc.create(&a->root, a->desc.user_data)) {
+            printf("[app] %s 创建失败\n", a->desc.name);
+            a->root = NULL;
+            show_home(true);
+            return false;
+        }
+        if (a->root != NULL) {
+            lv_obj_add_event_cb(a->root, root_delete_cb, LV_EVENT_DELETE, a);
+        }
+        mgr_stats.creates++;
+    }
+
+    a->state = APP_STATE_RUNNING;
+    a->last_used = ++use_counter;
+    current = id;
+    if (a->desc.hide_home) {
+        show_home(false);
+    }
+    return true;
+}
+
+void app_manager_close(void) {
+    if (current >= 0) {
+        suspend_current();
+    } else {
+        show_home(true);
+    }
+}
+
+void app_manager_destroy(int id) {
+    if (id >= 0 && id < entry_count) {
+        destroy_entry(&entries[id]);
+    }
+}
+
+app_state_t app_manager_get_state(int id) {
+    return id >= 0 && id < entry_count ? entries[id].state : APP_STATE_DESTROYED;
+}
+
+int app_manager_current(void) {
+    return current;
+}
+
+void app_manager_set_budget(size_t bytes) {
+    budget = bytes;
+    evict();
+}
+
+void app_manager_get_stats(app_manager_stats_t *stats) {
+    *stats = mgr_stats;
+    stats->suspended = 0;
+    stats->suspended_bytes = 0;
+    for (int i = 0; i < entry_count; i++) {
+        if (entries[i].state == APP_STATE_SUSPENDED) {
+            stats->suspended++;
+            stats->suspended_bytes += entries[i].cost;
+        }
+    }
+}
@@ -0,0 +1,126 @@
+/**
+ * @file app_manager.h
+ * @brief 主屏幕应用生命周期管理头文件
+ *
+ * 每个应用登记一组回调：create（创建界面）、suspend（离开前停止定时器/动画/播放）、
+ * resume（回到前台）、destroy（删除界面前释放其他资源）。离开应用时不删除界面，
+ * 而是挂起：根对象加上 LV_OBJ_FLAG_HIDDEN（不参与布局和渲染），再次打开时只需去掉
+ * 隐藏标志，下一帧就能显示，不需要重建。
+ *
+ * 挂起的应用按占用的 LVGL 内存（运行期间 lv_mem_monitor 已用内存的增量）计入预算，
+ * 超过 APP_MANAGER_BUDGET 或挂起数超过 APP_MANAGER_MAX_SUSPENDED 时按最久未用的顺序
+ * 销毁。使用系统 malloc（LV_STDLIB_CLIB）时无法统计内存，只按挂起数淘汰。
+ *
+ * 根对象为 NULL 的应用（界面直接建在屏幕上，如视觉小说）由 suspend/resume 自行处理显示。
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef APP_MANAGER_H
+#define APP_MANAGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lvgl/lvgl.h"
+
+#define APP_MANAGER_MAX             24                  /**< 最多登记的应用数 */
+#define APP_MANAGER_BUDGET          (2 * 1024 * 1024)   /**< 挂起应用占用内存的默认上限 */
+#define APP_MANAGER_MAX_SUSPENDED   4                   /**< 最多同时挂起的应用数 */
+
+/**
+ * @brief 应用状态
+ */
+typedef enum {
+    APP_STATE_DESTROYED = 0,    /**< 未创建或已销毁 */
+    APP_STATE_RUNNING,          /**< 前台运行 */
+    APP_STATE_SUSPENDED,        /**< 挂起（隐藏，保留界面） */
+} app_state_t;
+
+/**
+ * @brief 创建回调
+ * @param root 输出根对象，界面不在一个根对象下时为 NULL
+ * @param user_data 登记时的用户数据
+ * @return 是否成功
+ */
+typedef bool (*app_create_cb_t)(lv_obj_t **root, void *user_data);
+
+/**
+ * @brief 挂起/恢复/销毁回调
+ * @param root 创建时返回的根对象
+ * @param user_data 登记时的用户数据
+ */
+typedef void (*app_cb_t)(lv_obj_t *root, void *user_data);
+
+/**
+ * @brief 应用描述
+ */
+typedef struct {
+    const char *name;           /**< 名称（日志） */
+    app_create_cb_t create;     /**< 创建界面（必须） */
+    app_cb_t suspend;           /**< 挂起前调用（可选） */
+    app_cb_t resume;            /**< 恢复后调用（可选） */
+    app_cb_t destroy;           /**< 删除根对象前调用（可选） */
+    bool hide_home;             /**< 运行时隐藏主界面 */
+    void *user_data;            /**< 传给回调的用户数据 */
+} app_desc_t;
+
+/**
+ * @brief 生命周期统计
+ */
+typedef struct {
+    uint32_t creates;           /**< 创建次数 */
+    uint32_t resumes;           /**< 从挂起恢复的次数（没有重建） */
+    uint32_t suspends;          /**< 挂起次数 */
+    uint32_t evictions;         /**< 因预算被销毁的次数 */
+    uint32_t suspended;         /**< 当前挂起的应用数 */
+    size_t suspended_bytes;     /**< 当前挂起应用占用的内存 */
+} app_manager_stats_t;
+
+/**
+ * @brief 登记应用
+ * @param desc 应用描述（复制，name 需要一直有效）
+ * @return 应用ID，失败返回-1
+ */
+int app_manager_register(const app_desc_t *desc);
+
+/**
+ * @brief 打开应用：挂起当前应用，恢复挂起的应用或创建新的应用
+ * @param id 应用ID
+ * @return 是否成功
+ */
+bool app_manager_open(int id);
+
+/**
+ * @brief 挂起当前应用，回到主界面
+ */
+void app_manager_close(void);
+
+/**
+ * @brief 销毁应用（运行中的应用销毁后回到主界面）
+ * @param id 应用ID
+ */
+void app_manager_destroy(int id);
+
+/**
+ * @brief 获取应用状态
+ */
+app_state_t app_manager_get_state(int id);
+
+/**
+ * @brief 获取当前运行的应用ID，没有时返回-1
+ */
+int app_manager_current(void);
+
+/**
+ * @brief 设置挂起应用的内存预算（超出时立即淘汰）
+ * @param bytes 字节数
+ */
+void app_manager_set_budget(size_t bytes);
+
+/**
+ * @brief 获取生命周期统计
+ * @param stats 输出
+ */
+void app_manager_get_stats(app_manager_stats_t *stats);
+
+#endif /* APP_MANAGER_H */
@@ -9,16 +9,18 @@
 static pthread_t audio_thread = 0;
 static volatile int is_playing = 0;
 static volatile int is_paused = 0;
+static audio_player_t *playing_player = NULL;  // 播放线程正在使用的播放器（主线程访问）
 static AVFormatContext *out_fmt_ctx = NULL;
 static snd_mixer_t *mixer_handle = NULL;
 static snd_mixer_elem_t *mixer_elem = NULL;
 
-// ALSA PCM 句柄（直接输出）
+// ALSA PCM 句柄（直接输出），每个 audio_player_t 持有一个引用
 static snd_pcm_t *pcm_handle = NULL;
+static int pcm_refs = 0;
 static pthread_mutex_t pcm_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-// ALSA PCM 初始化（备用方案）
-static int audio_pcm_init(void) {
+// 打开并配置 PCM 设备（持有 pcm_mutex）
+static int audio_pcm_open(void) {
     int err;
     snd_pcm_hw_params_t *hw_params;
     unsigned int rate = 44100;
@@ -26,10 +28,6 @@ static int audio_pcm_init(void) {
     int dir;
     snd_pcm_format_t format = SND_PCM_FORMAT_S16_LE;
     
-    if (pcm_handle) {
-        return 0; // 已经初始化
-    }
-    
     // 打开 PCM 设备
     err = snd_pcm_open(&pcm_handle, "default", SND_PCM_STREAM_PLAYBACK, 0);
     if (err < 0) {
@@ -109,6 +107,20 @@ static int audio_pcm_init(void) {
     return 0;
 }
 
+// ALSA PCM 初始化（备用方案），已经打开时只增加引用（可以在工作线程调用）
+static int audio_pcm_init(void) {
+    int ret = 0;
+
+    pthread_mutex_lock(&pcm_mutex);
+    if (pcm_handle) {
+        pcm_refs++;
+    } else if ((ret = audio_pcm_open()) == 0) {
+        pcm_refs = 1;
+    }
+    pthread_mutex_unlock(&pcm_mutex);
+    return ret;
+}
+
 // ALSA PCM 写入
 static int audio_pcm_write(const uint8_t *data, int size) {
     int err;
@@ -140,10 +152,10 @@ static int audio_pcm_write(const uint8_t *data, int size) {
     return 0;
 }
 
-// ALSA PCM 清理
+// ALSA PCM 清理，最后一个引用释放时才关闭设备
 static void audio_pcm_deinit(void) {
     pthread_mutex_lock(&pcm_mutex);
-    if (pcm_handle) {
+    if (pcm_handle && --pcm_refs == 0) {
         snd_pcm_drain(pcm_handle);
         snd_pcm_close(pcm_handle);
         pcm_handle = NULL;
@@ -512,7 +524,10 @@ audio_player_t *audio_player_init(lv_obj_t *volume_slider) {
     return player;
 }
 int audio_player_open(audio_player_t *player, const char *file_path) {
-    audio_player_stop(player);
+    // 新建的播放器没有打开过文件，不需要停止（可以在工作线程打开）
+    if (player->fmt_ctx) {
+        audio_player_stop(player);
+    }
 
     if (avformat_open_input(&player->fmt_ctx, file_path, NULL, NULL) != 0)
         return -1;
@@ -557,7 +572,13 @@ void audio_player_play(audio_player_t *player) {
     if (!player->fmt_ctx) return;
     is_paused = 0;
     if (!is_playing) {
+        // 上一个播放器播放结束后线程还没有回收
+        if (audio_thread != 0) {
+            pthread_join(audio_thread, NULL);
+            audio_thread = 0;
+        }
         is_playing = 1;
+        playing_player = player;
         pthread_create(&audio_thread, NULL, audio_playback_thread, player);
     }
 }
@@ -570,14 +591,18 @@ void audio_player_pause(audio_player_t *player) {
 void audio_player_stop(audio_player_t *player) {
     if (!player) return;
 
-    // 停止播放标志
-    is_playing = 0;
-    is_paused = 0;
+    // 播放线程属于其他播放器时不能停止
+    if (playing_player == player) {
+        // 停止播放标志
+        is_playing = 0;
+        is_paused = 0;
 
-    // 等待播放线程结束（确保线程不再使用任何资源）
-    if (audio_thread != 0) {
-        pthread_join(audio_thread, NULL);
-        audio_thread = 0;
+        // 等待播放线程结束（确保线程不再使用任何资源）
+        if (audio_thread != 0) {
+            pthread_join(audio_thread, NULL);
+            audio_thread = 0;
+        }
+        playing_player = NULL;
     }
 
     // 现在可以安全地清理资源
@@ -2,6 +2,7 @@
 #include "file_manager.h"
 #include "events.h"
 #include "container.h"
+#include "lua_app.h"
 #include "lvgl/src/widgets/label/lv_label.h"
 
 void button(void)
@@ -21,6 +22,9 @@ void button(void)
     lv_obj_t * btn_2048 = lv_btn_create(parent);
     lv_obj_t * btn_video = lv_btn_create(parent);
 
+    /* 内置应用登记到 app_manager，离开时挂起而不是删除 */
+    register_apps();
+
     lv_obj_add_event_cb(btn1, event_open_manager, LV_EVENT_ALL, NULL);
     lv_obj_add_event_cb(btn2,event_open_settings, LV_EVENT_ALL, NULL);
     lv_obj_add_event_cb(btn_robot, btn_robot_click, LV_EVENT_CLICKED, NULL);
@@ -46,4 +50,12 @@ void button(void)
     lv_label_set_text(btn_label_2048, "2048");
     lv_label_set_text(btn_label_exit, "exit");
     lv_label_set_text(btn_label_video, "Video");
+
+    /* 应用目录中的 Lua 应用 */
+    for (int i = 0; i < lua_app_count(); i++) {
+        lv_obj_t * btn_app = lv_btn_create(parent);
+        lv_obj_add_event_cb(btn_app, event_open_lua_app, LV_EVENT_CLICKED, (void *)(intptr_t)i);
+        lv_obj_t * btn_label_app = lv_label_create(btn_app);
+        lv_label_set_text(btn_label_app, lua_app_title(i));
+    }
 }
@@ -0,0 +1,576 @@
+/**
+ * @file dir_cache.c
+ * @brief 目录列表缓存实现
+ *
+ * 每个缓存目录占用一个槽位，目录项与文件名各用一块连续内存保存；
+ * 槽位按最近使用时间淘汰。inotify 监听在读取目录之前添加，
+ * 保证读取期间发生的变化也能使缓存失效。
+ */
+
+#include "dir_cache.h"
+#include "lvgl/lvgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#define DIR_CACHE_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+                              IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF)
+
+struct dir_cache_dir {
+    char *path;                 /**< 规范化后的系统路径 */
+    uint32_t hash;              /**< 路径哈希 */
+    int wd;                     /**< inotify 监听描述符，-1 表示未监听 */
+    int64_t dir_mtime;          /**< 目录自身的修改时间（无 inotify 时用于校验） */
+    dir_cache_entry_t *entries; /**< 目录项数组 */
+    int count;                  /**< 目录项数量 */
+    char *names;                /**< 所有文件名的连续存储 */
+    uint32_t last_used;         /**< LRU 时间戳 */
+    int refs;                   /**< 打开中的句柄数 */
+    bool in_use;                /**< 槽位是否有效 */
+    bool stale;                 /**< 已失效但仍被引用，释放引用后回收 */
+    bool temporary;             /**< 槽位已满时临时分配，关闭即释放 */
+};
+
+/**
+ * @brief LVGL 目录读取游标
+ */
+typedef struct {
+    dir_cache_dir_t *dir;
+    int index;
+} dir_cursor_t;
+
+static dir_cache_dir_t dirs[DIR_CACHE_MAX_DIRS];
+static int inotify_fd = -1;
+static uint32_t use_clock = 0;
+static bool initialized = false;
+static lv_fs_drv_t cache_drv;
+static lv_timer_t *poll_timer = NULL;
+
+static void register_fs_drv(void);
+
+/**
+ * @brief FNV-1a 字符串哈希
+ */
+static uint32_t path_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief 规范化路径：去掉多余的结尾斜杠
+ */
+static void normalize_path(const char *in, char *out, size_t out_size) {
+    snprintf(out, out_size, "%s", (in && in[0]) ? in : "/");
+    size_t len = strlen(out);
+    while (len > 1 && out[len - 1] == '/') {
+        out[--len] = '\0';
+    }
+}
+
+/**
+ * @brief 目录项排序：目录优先，其次按扩展名，最后按名称
+ */
+static int entry_compare(const void *a, const void *b) {
+    const dir_cache_entry_t *ea = (const dir_cache_entry_t *)a;
+    const dir_cache_entry_t *eb = (const dir_cache_entry_t *)b;
+
+    if (ea->is_dir != eb->is_dir) {
+        return ea->is_dir ? -1 : 1;
+    }
+
+    if (!ea->is_dir) {
+        const char *xa = strrchr(ea->name, '.');
+        const char *xb = strrchr(eb->name, '.');
+        int r = strcasecmp(xa ? xa : "", xb ? xb : "");
+        if (r != 0) {
+            return r;
+        }
+    }
+
+    return strcmp(ea->name, eb->name);
+}
+
+/**
+ * @brief 释放槽位中的列表数据
+ */
+static void release_listing(dir_cache_dir_t *d) {
+    free(d->entries);
+    free(d->names);
+    free(d->path);
+    d->entries = NULL;
+    d->names = NULL;
+    d->path = NULL;
+    d->count = 0;
+}
+
+/**
+ * @brief 判断 wd 是否还被其他有效槽位使用
+ */
+static bool watch_shared(const dir_cache_dir_t *self, int wd) {
+    for (int i = 0; i < DIR_CACHE_MAX_DIRS; i++) {
+        if (&dirs[i] != self && dirs[i].in_use && !dirs[i].stale && dirs[i].wd == wd) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 回收槽位（移除 inotify 监听并释放内存）
+ */
+static void drop_slot(dir_cache_dir_t *d) {
+    if (d->wd >= 0 && inotify_fd >= 0 && !watch_shared(d, d->wd)) {
+        inotify_rm_watch(inotify_fd, d->wd);
+    }
+    release_listing(d);
+    d->wd = -1;
+    d->in_use = false;
+    d->stale = false;
+}
+
+/**
+ * @brief 使槽位失效：无引用立即回收，否则标记为过期
+ */
+static void invalidate_slot(dir_cache_dir_t *d) {
+    if (d->refs > 0) {
+        d->stale = true;
+    } else {
+        drop_slot(d);
+    }
+}
+
+/**
+ * @brief 读取目录内容到槽位
+ * @return 成功返回 true
+ */
+static bool fill_listing(dir_cache_dir_t *d, const char *path) {
+    DIR *dp = opendir(path);
+    if (dp == NULL) {
+        printf("[dir_cache] Failed to open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    int dfd = dirfd(dp);
+    int cap = 32;
+    size_t names_cap = 1024;
+    size_t names_len = 0;
+    dir_cache_entry_t *entries = malloc(sizeof(dir_cache_entry_t) * cap);
+    char *names = malloc(names_cap);
+    int count = 0;
+
+    if (entries == NULL || names == NULL) {
+        free(entries);
+        free(names);
+        closedir(dp);
+        return false;
+    }
+
+    struct dirent *de;
+    while ((de = readdir(dp)) != NULL) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) {
+            continue;
+        }
+
+        size_t nlen = strlen(de->d_name) + 1;
+        if (names_len + nlen > names_cap) {
+            while (names_len + nlen > names_cap) {
+                names_cap *= 2;
+            }
+            char *grown = realloc(names, names_cap);
+            if (grown == NULL) {
+                break;
+            }
+            names = grown;
+        }
+        if (count == cap) {
+            dir_cache_entry_t *grown = realloc(entries, sizeof(dir_cache_entry_t) * cap * 2);
+            if (grown == NULL) {
+                break;
+            }
+            entries = grown;
+            cap *= 2;
+        }
+
+        dir_cache_entry_t *e = &entries[count];
+        memset(e, 0, sizeof(*e));
+        memcpy(names + names_len, de->d_name, nlen);
+        // 填充期间 names 可能被 realloc，先记录偏移，结束后再换成指针
+        e->name = (const char *)(uintptr_t)names_len;
+        names_len += nlen;
+
+        struct stat st;
+        if (fstatat(dfd, de->d_name, &st, 0) == 0) {
+            e->is_dir = S_ISDIR(st.st_mode);
+            e->size = e->is_dir ? 0 : (int64_t)st.st_size;
+            e->mtime = (int64_t)st.st_mtime;
+        } else {
+            e->is_dir = (de->d_type == DT_DIR);
+        }
+        count++;
+    }
+    closedir(dp);
+
+    for (int i = 0; i < count; i++) {
+        entries[i].name = names + (uintptr_t)entries[i].name;
+    }
+    qsort(entries, count, sizeof(dir_cache_entry_t), entry_compare);
+
+    struct stat dst;
+    d->dir_mtime = (stat(path, &dst) == 0) ? (int64_t)dst.st_mtime : 0;
+    d->entries = entries;
+    d->names = names;
+    d->count = count;
+    return true;
+}
+
+/**
+ * @brief 查找有效的缓存槽位
+ */
+static dir_cache_dir_t *find_slot(const char *path, uint32_t hash) {
+    for (int i = 0; i < DIR_CACHE_MAX_DIRS; i++) {
+        dir_cache_dir_t *d = &dirs[i];
+        if (d->in_use && !d->stale && d->hash == hash && strcmp(d->path, path) == 0) {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 获取一个空闲槽位，必要时淘汰最久未使用且无引用的目录
+ */
+static dir_cache_dir_t *alloc_slot(void) {
+    dir_cache_dir_t *victim = NULL;
+
+    for (int i = 0; i < DIR_CACHE_MAX_DIRS; i++) {
+        dir_cache_dir_t *d = &dirs[i];
+        if (!d->in_use) {
+            return d;
+        }
+        if (d->refs == 0 && (victim == NULL || d->last_used < victim->last_used)) {
+            victim = d;
+        }
+    }
+
+    if (victim != NULL) {
+        drop_slot(victim);
+    }
+    return victim;
+}
+
+void dir_cache_init(void) {
+    if (initialized) {
+        return;
+    }
+
+    memset(dirs, 0, sizeof(dirs));
+    for (int i = 0; i < DIR_CACHE_MAX_DIRS; i++) {
+        dirs[i].wd = -1;
+    }
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        printf("[dir_cache] inotify unavailable (%s), falling back to mtime checks\n", strerror(errno));
+    }
+
+    register_fs_drv();
+
+    initialized = true;
+    printf("[dir_cache] Initialized (letter %c, %d dirs)\n", DIR_CACHE_LETTER, DIR_CACHE_MAX_DIRS);
+}
+
+dir_cache_dir_t *dir_cache_open(const char *path) {
+    char norm[PATH_MAX];
+    normalize_path(path, norm, sizeof(norm));
+    uint32_t hash = path_hash(norm);
+
+    dir_cache_dir_t *d = find_slot(norm, hash);
+    if (d != NULL && d->wd < 0) {
+        // 没有 inotify 监听时，用目录 mtime 判断是否有增删
+        struct stat st;
+        if (stat(norm, &st) != 0 || (int64_t)st.st_mtime != d->dir_mtime) {
+            invalidate_slot(d);
+            d = NULL;
+        }
+    }
+
+    if (d == NULL) {
+        d = alloc_slot();
+        if (d == NULL) {
+            d = calloc(1, sizeof(dir_cache_dir_t));
+            if (d == NULL) {
+                return NULL;
+            }
+            d->temporary = true;
+        }
+
+        d->wd = -1;
+        if (!d->temporary && inotify_fd >= 0) {
+            d->wd = inotify_add_watch(inotify_fd, norm, DIR_CACHE_WATCH_MASK);
+        }
+
+        if (!fill_listing(d, norm)) {
+            if (d->temporary) {
+                free(d);
+            } else {
+                drop_slot(d);
+            }
+            return NULL;
+        }
+
+        d->path = strdup(norm);
+        d->hash = hash;
+        d->in_use = true;
+        d->stale = false;
+        d->refs = 0;
+    }
+
+    d->refs++;
+    d->last_used = ++use_clock;
+    return d;
+}
+
+int dir_cache_count(const dir_cache_dir_t *dir) {
+    return dir ? dir->count : 0;
+}
+
+const dir_cache_entry_t *dir_cache_entry(const dir_cache_dir_t *dir, int index) {
+    if (dir == NULL || index < 0 || index >= dir->count) {
+        return NULL;
+    }
+    return &dir->entries[index];
+}
+
+void dir_cache_close(dir_cache_dir_t *dir) {
+    if (dir == NULL) {
+        return;
+    }
+
+    dir->refs--;
+    if (dir->refs > 0) {
+        return;
+    }
+
+    if (dir->temporary) {
+        release_listing(dir);
+        free(dir);
+    } else if (dir->stale) {
+        drop_slot(dir);
+    }
+}
+
+void dir_cache_invalidate(const char *path) {
+    char norm[PATH_MAX];
+    normalize_path(path, norm, sizeof(norm));
+
+    dir_cache_dir_t *d = find_slot(norm, path_hash(norm));
+    if (d != NULL) {
+        invalidate_slot(d);
+    }
+}
+
+void dir_cache_poll(void) {
+    if (inotify_fd < 0) {
+        return;
+    }
+
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+
+    while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len; ) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ev->len;
+
+            for (int i = 0; i < DIR_CACHE_MAX_DIRS; i++) {
+                dir_cache_dir_t *d = &dirs[i];
+                // IN_Q_OVERFLOW 时 wd 为 -1，事件可能丢失，全部失效
+                bool overflow = (ev->mask & IN_Q_OVERFLOW) != 0;
+                if (!d->in_use || (!overflow && d->wd != ev->wd)) {
+                    continue;
+                }
+                if (ev->mask & IN_IGNORED) {
+                    // 内核已移除监听（目录被删除或卸载）
+                    d->wd = -1;
+                }
+                invalidate_slot(d);
+            }
+        }
+    }
+}
+
+void dir_cache_deinit(void) {
+    if (!initialized) {
+        return;
+    }
+
+    if (poll_timer != NULL) {
+        lv_timer_delete(poll_timer);
+        poll_timer = NULL;
+    }
+
+    for (int i = 0; i < DIR_CACHE_MAX_DIRS; i++) {
+        if (dirs[i].in_use) {
+            drop_slot(&dirs[i]);
+        }
+    }
+
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+    initialized = false;
+}
+
+/*=====================
+ * LVGL 文件系统驱动
+ *====================*/
+
+static void *fs_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode) {
+    LV_UNUSED(drv);
+    int flags = 0;
+    if (mode == LV_FS_MODE_WR) {
+        flags = O_WRONLY | O_CREAT;
+    } else if (mode == LV_FS_MODE_RD) {
+        flags = O_RDONLY;
+    } else if (mode == (LV_FS_MODE_WR | LV_FS_MODE_RD)) {
+        flags = O_RDWR | O_CREAT;
+    }
+
+    int fd = open(path, flags | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        return NULL;
+    }
+    // fd 可能为 0，加 1 避免与 NULL 混淆
+    return (void *)(intptr_t)(fd + 1);
+}
+
+static lv_fs_res_t fs_close(lv_fs_drv_t *drv, void *file_p) {
+    LV_UNUSED(drv);
+    close((int)(intptr_t)file_p - 1);
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br) {
+    LV_UNUSED(drv);
+    ssize_t r = read((int)(intptr_t)file_p - 1, buf, btr);
+    if (r < 0) {
+        *br = 0;
+        return LV_FS_RES_UNKNOWN;
+    }
+    *br = (uint32_t)r;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_write(lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw) {
+    LV_UNUSED(drv);
+    ssize_t r = write((int)(intptr_t)file_p - 1, buf, btw);
+    if (r < 0) {
+        *bw = 0;
+        return LV_FS_RES_UNKNOWN;
+    }
+    *bw = (uint32_t)r;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence) {
+    LV_UNUSED(drv);
+    int w = SEEK_SET;
+    if (whence == LV_FS_SEEK_CUR) {
+        w = SEEK_CUR;
+    } else if (whence == LV_FS_SEEK_END) {
+        w = SEEK_END;
+    }
+    off_t off = (whence == LV_FS_SEEK_SET) ? (off_t)pos : (off_t)(int32_t)pos;
+    return lseek((int)(intptr_t)file_p - 1, off, w) < 0 ? LV_FS_RES_UNKNOWN : LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p) {
+    LV_UNUSED(drv);
+    off_t off = lseek((int)(intptr_t)file_p - 1, 0, SEEK_CUR);
+    if (off < 0) {
+        return LV_FS_RES_UNKNOWN;
+    }
+    *pos_p = (uint32_t)off;
+    return LV_FS_RES_OK;
+}
+
+static void *fs_dir_open(lv_fs_drv_t *drv, const char *path) {
+    LV_UNUSED(drv);
+    dir_cursor_t *cur = malloc(sizeof(dir_cursor_t));
+    if (cur == NULL) {
+        return NULL;
+    }
+
+    cur->dir = dir_cache_open(path);
+    cur->index = 0;
+    if (cur->dir == NULL) {
+        free(cur);
+        return NULL;
+    }
+    return cur;
+}
+
+static lv_fs_res_t fs_dir_read(lv_fs_drv_t *drv, void *rddir_p, char *fn, uint32_t fn_len) {
+    LV_UNUSED(drv);
+    dir_cursor_t *cur = (dir_cursor_t *)rddir_p;
+
+    const dir_cache_entry_t *e = dir_cache_entry(cur->dir, cur->index);
+    if (e == NULL) {
+        fn[0] = '\0';
+        return LV_FS_RES_OK;
+    }
+    cur->index++;
+
+    // 与 lv_fs_posix 保持一致：目录名以 '/' 开头
+    if (e->is_dir) {
+        snprintf(fn, fn_len, "/%s", e->name);
+    } else {
+        snprintf(fn, fn_len, "%s", e->name);
+    }
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_dir_close(lv_fs_drv_t *drv, void *rddir_p) {
+    LV_UNUSED(drv);
+    dir_cursor_t *cur = (dir_cursor_t *)rddir_p;
+    dir_cache_close(cur->dir);
+    free(cur);
+    return LV_FS_RES_OK;
+}
+
+static void poll_timer_cb(lv_timer_t *timer) {
+    LV_UNUSED(timer);
+    dir_cache_poll();
+}
+
+static void register_fs_drv(void) {
+    lv_fs_drv_init(&cache_drv);
+    cache_drv.letter = DIR_CACHE_LETTER;
+    cache_drv.open_cb = fs_open;
+    cache_drv.close_cb = fs_close;
+    cache_drv.read_cb = fs_read;
+    cache_drv.write_cb = fs_write;
+    cache_drv.seek_cb = fs_seek;
+    cache_drv.tell_cb = fs_tell;
+    cache_drv.dir_open_cb = fs_dir_open;
+    cache_drv.dir_read_cb = fs_dir_read;
+    cache_drv.dir_close_cb = fs_dir_close;
+    lv_fs_drv_register(&cache_drv);
+
+    if (inotify_fd >= 0) {
+        poll_timer = lv_timer_create(poll_timer_cb, DIR_CACHE_POLL_MS, NULL);
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * @file dir_cache.h
+ * @brief 目录列表缓存头文件
+ *
+ * 按路径缓存目录项（名称、类型、大小），并按文件浏览器的排序顺序保存；
+ * 通过 inotify 监听目录变化使缓存失效，缓存目录数量受 LRU 上限约束。
+ * 同时注册一个 LVGL 文件系统驱动（盘符 DIR_CACHE_LETTER），
+ * 文件浏览器通过该盘符读取目录时直接命中缓存，无需重新 readdir/stat。
+ */
+
+#ifndef DIR_CACHE_H
+#define DIR_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DIR_CACHE_LETTER    'C'     /**< 带缓存的 LVGL 文件系统盘符 */
+#define DIR_CACHE_MAX_DIRS  16      /**< 最多缓存的目录数量（LRU 淘汰） */
+#define DIR_CACHE_POLL_MS   250     /**< inotify 事件轮询周期 */
+
+/**
+ * @brief 缓存的目录项
+ */
+typedef struct {
+    const char *name;   /**< 文件名（不含路径） */
+    bool is_dir;        /**< 是否为目录 */
+    int64_t size;       /**< 文件大小（字节），目录为 0 */
+    int64_t mtime;      /**< 修改时间（秒） */
+} dir_cache_entry_t;
+
+/**
+ * @brief 已打开（被引用）的目录列表句柄
+ */
+typedef struct dir_cache_dir dir_cache_dir_t;
+
+/**
+ * @brief 初始化目录缓存，注册 LVGL 文件系统驱动和 inotify 轮询定时器
+ * @note 需在 lv_init() 之后调用，可重复调用
+ */
+void dir_cache_init(void);
+
+/**
+ * @brief 打开目录列表，命中缓存时不访问文件系统
+ * @param path 系统路径（如 "/mnt/app"）
+ * @return 目录句柄（持有引用，需 dir_cache_close 释放），失败返回 NULL
+ */
+dir_cache_dir_t *dir_cache_open(const char *path);
+
+/**
+ * @brief 获取目录项数量
+ */
+int dir_cache_count(const dir_cache_dir_t *dir);
+
+/**
+ * @brief 获取第 index 个目录项（已按 目录优先/扩展名/名称 排序）
+ */
+const dir_cache_entry_t *dir_cache_entry(const dir_cache_dir_t *dir, int index);
+
+/**
+ * @brief 释放目录句柄引用
+ */
+void dir_cache_close(dir_cache_dir_t *dir);
+
+/**
+ * @brief 使指定目录的缓存失效
+ * @param path 系统路径
+ */
+void dir_cache_invalidate(const char *path);
+
+/**
+ * @brief 处理挂起的 inotify 事件（定时器中自动调用）
+ */
+void dir_cache_poll(void);
+
+/**
+ * @brief 释放所有缓存并关闭 inotify
+ */
+void dir_cache_deinit(void);
+
+#endif /* DIR_CACHE_H */
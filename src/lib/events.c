@@ -10,45 +10,151 @@
 #include "virsual_novel/visual_novel_engine.h"
 #include "lv_lib_100ask/lv_lib_100ask.h"
 #include "button.h"
+#include "lua_app.h"
+#include "app_manager.h"
 extern lv_obj_t *parent;
 lv_obj_t *obj_2048 = NULL;
 player_t *current_player = NULL;
 
+// 内置应用在 app_manager 中的ID
+static int app_file_manager = -1;
+static int app_settings = -1;
+static int app_2048 = -1;
+static int app_visual_novel = -1;
+
+/* 内置应用的生命周期回调：离开时挂起（隐藏），超出内存预算时才销毁 */
+
+static bool manager_create(lv_obj_t **root, void *user_data)
+{
+    (void)user_data;
+    file_manager();
+    *root = manager;
+    return manager != NULL;
+}
+
+static void manager_destroy(lv_obj_t *root, void *user_data)
+{
+    (void)root;
+    (void)user_data;
+    manager = NULL;
+}
+
+static bool settings_create(lv_obj_t **root, void *user_data)
+{
+    (void)user_data;
+    settings();
+    *root = setting;
+    return setting != NULL;
+}
+
+static void settings_destroy(lv_obj_t *root, void *user_data)
+{
+    (void)root;
+    (void)user_data;
+    settings_close();
+    setting = NULL;
+}
+
+static bool game_2048_create(lv_obj_t **root, void *user_data)
+{
+    (void)user_data;
+    obj_2048 = lv_100ask_2048_create(lv_screen_active());
+    if (obj_2048 == NULL) {
+        printf("[2048] Failed to create 2048 game object\n");
+        return false;
+    }
+
+    lv_obj_set_size(obj_2048, 200, 200);
+
+    if (btn_exit != NULL) {
+        lv_obj_set_size(btn_exit, 40, 40);
+    }
+
+    lv_obj_center(obj_2048);
+    *root = obj_2048;
+    return true;
+}
+
+static void game_2048_destroy(lv_obj_t *root, void *user_data)
+{
+    (void)root;
+    (void)user_data;
+    obj_2048 = NULL;
+}
+
+// 视觉小说的界面直接建在屏幕上，没有根对象，挂起时只暂停引擎
+static bool visual_novel_create(lv_obj_t **root, void *user_data)
+{
+    (void)user_data;
+    *root = NULL;
+    vn_engine_start();
+    return true;
+}
+
+static void visual_novel_suspend(lv_obj_t *root, void *user_data)
+{
+    (void)root;
+    (void)user_data;
+    vn_engine_pause();
+}
+
+static void visual_novel_resume(lv_obj_t *root, void *user_data)
+{
+    (void)root;
+    (void)user_data;
+    vn_engine_resume();
+}
+
+static void visual_novel_destroy(lv_obj_t *root, void *user_data)
+{
+    (void)root;
+    (void)user_data;
+    vn_engine_deinit();
+}
+
+void register_apps(void)
+{
+    static const app_desc_t file_manager_app = {
+        .name = "file_manager", .create = manager_create, .destroy = manager_destroy, .hide_home = true,
+    };
+    // 设置菜单建在主界面容器中，不隐藏主界面
+    static const app_desc_t settings_app = {
+        .name = "settings", .create = settings_create, .destroy = settings_destroy, .hide_home = false,
+    };
+    static const app_desc_t game_2048_app = {
+        .name = "2048", .create = game_2048_create, .destroy = game_2048_destroy, .hide_home = true,
+    };
+    static const app_desc_t visual_novel_app = {
+        .name = "visual_novel", .create = visual_novel_create, .suspend = visual_novel_suspend,
+        .resume = visual_novel_resume, .destroy = visual_novel_destroy, .hide_home = false,
+    };
+
+    app_file_manager = app_manager_register(&file_manager_app);
+    app_settings = app_manager_register(&settings_app);
+    app_2048 = app_manager_register(&game_2048_app);
+    app_visual_novel = app_manager_register(&visual_novel_app);
+}
+
 void event_open_manager(lv_event_t * e)
 {
     lv_event_code_t code = lv_event_get_code(e);
 
     if(code == LV_EVENT_CLICKED) {
-      lv_obj_add_flag(parent, LV_OBJ_FLAG_HIDDEN);
-      file_manager();
+      app_manager_open(app_file_manager);
     }
 }
 
+// 文件管理器和设置共用：挂起当前应用，回到主界面（e 可能为 NULL）
 void event_close_manager(lv_event_t * e){
-  // 如果是通过代码调用（非事件触发），e 可能为 NULL
-  lv_obj_t * manager = NULL;
-  if (e) {
-    manager = lv_event_get_user_data(e);
-  } else {
-    // 如果没有事件，直接使用全局 manager 变量
-    extern lv_obj_t *manager;
-    manager = manager;
-  }
-
-  if (manager) {
-    lv_obj_del(manager);
-    manager = NULL;
-  }
-
-  lv_obj_clear_flag(parent, LV_OBJ_FLAG_HIDDEN);
-  settings_close();
+  (void)e;
+  app_manager_close();
 }
 
 void event_open_settings(lv_event_t *e)
 {
     lv_event_code_t code = lv_event_get_code(e);
     if(code == LV_EVENT_CLICKED) {
-      settings();
+      app_manager_open(app_settings);
     }
 }
 
@@ -87,13 +193,14 @@ void file_select_event(lv_event_t * e)
 void event_open_visual_novel(lv_event_t * e)
 {
     (void)e; // 避免未使用参数警告
-    vn_engine_start();
+    app_manager_open(app_visual_novel);
 }
 
+// 视觉小说的界面不能隐藏，关闭时销毁（自动存档，下次打开从同一页继续）
 void event_close_visual_novel(lv_event_t * e)
 {
     (void)e;
-    vn_engine_deinit();
+    app_manager_destroy(app_visual_novel);
 }
 
 void event_close_player(lv_event_t * e)
@@ -115,32 +222,19 @@ void player_destroy_callback(player_t *player)
 
 void event_open_2048(lv_event_t *e){
     (void)e;
-    lv_obj_add_flag(parent, LV_OBJ_FLAG_HIDDEN);
-    obj_2048 = lv_100ask_2048_create(lv_screen_active());
-    
-    if (obj_2048 == NULL) {
-        printf("[2048] Failed to create 2048 game object\n");
-        lv_obj_clear_flag(parent, LV_OBJ_FLAG_HIDDEN);
-        return;
-    }
-    
-    lv_obj_set_size(obj_2048, 200, 200);
-    
-    if (btn_exit != NULL) {
-        lv_obj_set_size(btn_exit, 40, 40);
-    }
-
-    lv_obj_center(obj_2048);
+    app_manager_open(app_2048);
 }
 void event_close_2048(lv_event_t *e){
   (void)e;
-  
-  if (obj_2048 != NULL) {
-    lv_obj_del(obj_2048);
-    obj_2048 = NULL;
-  }
-  
-  lv_obj_clear_flag(parent, LV_OBJ_FLAG_HIDDEN);
+  app_manager_close();
+}
+
+void event_open_lua_app(lv_event_t *e)
+{
+    int index = (int)(intptr_t)lv_event_get_user_data(e);
+    if (!lua_app_open(index)) {
+        printf("[events] Failed to open app: %s\n", lua_app_title(index));
+    }
 }
 
 void event_play_video(lv_event_t *e)
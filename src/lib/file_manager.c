@@ -1,18 +1,41 @@
 #include "audio.h"
 #include <string.h>
+#include <strings.h>
+#include <stdlib.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include "./file_manager.h"
 #include "./container.h"
 #include "./events.h"
 #include "./player.h"
+#include "./dir_cache.h"
+#include "./media_library.h"
+#include "./thumb_cache.h"
+
+#define FM_THUMB_SIZE   24      /**< 文件列表行内缩略图尺寸 */
+#define FM_THUMB_SLOTS  64      /**< 界面侧保留的缩略图数量（LRU） */
+
+/**
+ * @brief 文件列表缩略图槽
+ */
+typedef struct {
+    char *path;                 /**< 文件完整路径，NULL 表示空槽 */
+    lv_image_dsc_t *thumb;      /**< 缩略图，无封面或未完成时为 NULL */
+    bool ready;                 /**< 是否已完成（包括无缩略图） */
+    uint32_t last_used;         /**< 最近使用序号 */
+} fm_thumb_t;
 
 lv_obj_t *manager = NULL;
 static lv_obj_t *file_list = NULL;
 static char current_path[PATH_MAX] = "/mnt/app";
+static lv_obj_t *file_table = NULL;
+static fm_thumb_t thumbs[FM_THUMB_SLOTS];
+static uint32_t thumb_use_counter = 0;
+static uint32_t thumb_draw_start = 0;   /**< 本次绘制开始时的使用序号，之后用到的槽位不能淘汰 */
 
 // 将 LVGL 文件浏览器路径转换为实际系统路径
 // A:/xxx -> /xxx (根据 lv_conf.h 中 LV_FS_POSIX_LETTER = 'A')
+// C:/xxx -> /xxx (dir_cache.h 中 DIR_CACHE_LETTER = 'C')
 static const char *convert_lvgl_path(const char *lvgl_path)
 {
     static char real_path[PATH_MAX];
@@ -21,9 +44,9 @@ static const char *convert_lvgl_path(const char *lvgl_path)
         return NULL;
     }
     
-    // 检查是否是 A:/ 开头的路径
-    if (strncmp(lvgl_path, "A:/", 3) == 0) {
-        // 去掉 A:/ 前缀，直接使用后面的路径
+    // 检查是否是 X:/ 形式的盘符路径
+    if (isupper((unsigned char)lvgl_path[0]) && strncmp(lvgl_path + 1, ":/", 2) == 0) {
+        // 去掉盘符前缀，直接使用后面的路径
         snprintf(real_path, sizeof(real_path), "%s", lvgl_path + 2);
     } else {
         // 不是 A:/ 路径，直接使用
@@ -34,6 +57,154 @@ static const char *convert_lvgl_path(const char *lvgl_path)
 }
 
 
+// 是否为可以生成缩略图的文件（图片、视频、带封面的音频）
+static bool has_thumbnail(const char *name)
+{
+    static const char *const exts[] = {
+        ".png", ".jpg", ".jpeg", ".bmp", ".gif",
+        ".mp4", ".mkv", ".avi", ".mov", ".webm"
+    };
+
+    const char *dot = strrchr(name, '.');
+    if (!dot) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+        if (strcasecmp(dot, exts[i]) == 0) {
+            return true;
+        }
+    }
+    return media_library_is_audio_path(name);
+}
+
+static void thumb_slot_clear(fm_thumb_t *slot)
+{
+    // 每个槽位的请求以槽位为分组，淘汰时取消未完成的请求，不再解码已经离开可视区域的文件
+    if (slot->path && !slot->ready) {
+        thumb_cache_cancel(slot);
+    }
+    if (slot->thumb) {
+        lv_image_cache_drop(slot->thumb);
+        thumb_cache_free(slot->thumb);
+    }
+    free(slot->path);
+    memset(slot, 0, sizeof(*slot));
+}
+
+// 缩略图完成回调：填入对应槽位并重绘文件列表
+static void thumb_ready_cb(const char *path, lv_image_dsc_t *thumb, void *user_data)
+{
+    fm_thumb_t *slot = user_data;
+
+    if (slot->path && !slot->ready && strcmp(slot->path, path) == 0) {
+        slot->thumb = thumb;
+        slot->ready = true;
+        if (thumb && file_table) {
+            lv_obj_invalidate(file_table);
+        }
+        return;
+    }
+
+    // 槽位已被淘汰（淘汰时已取消请求，这里只是防御）
+    thumb_cache_free(thumb);
+}
+
+// 查找缩略图，不存在时分配槽位（淘汰最久未用的）并发起异步请求
+// 本次绘制中已经用到的槽位不会被淘汰：绘制任务在绘制事件之后才执行，期间缩略图不能释放
+static fm_thumb_t *thumb_lookup(const char *path)
+{
+    fm_thumb_t *victim = NULL;
+    for (int i = 0; i < FM_THUMB_SLOTS; i++) {
+        if (thumbs[i].path && strcmp(thumbs[i].path, path) == 0) {
+            thumbs[i].last_used = ++thumb_use_counter;
+            return &thumbs[i];
+        }
+        if (thumbs[i].last_used <= thumb_draw_start &&
+            (victim == NULL || thumbs[i].last_used < victim->last_used)) {
+            victim = &thumbs[i];
+        }
+    }
+    // 可见行多于槽位时，其余行这次不显示缩略图
+    if (!victim) {
+        return NULL;
+    }
+
+    thumb_slot_clear(victim);
+    victim->path = strdup(path);
+    if (!victim->path) {
+        return NULL;
+    }
+    victim->last_used = ++thumb_use_counter;
+    if (!thumb_cache_request(path, FM_THUMB_SIZE, FM_THUMB_SIZE, LV_COLOR_FORMAT_RGB565, thumb_ready_cb, victim)) {
+        victim->ready = true;
+    }
+    return victim;
+}
+
+// 文件列表开始绘制：记录使用序号，本次绘制中用到的槽位被固定到下次绘制
+static void file_table_draw_begin_event(lv_event_t *e)
+{
+    (void)e;
+    thumb_draw_start = thumb_use_counter;
+}
+
+// 在文件列表第一列的右侧绘制缩略图，只有可见行会触发绘制，因此只请求可见行的缩略图
+static void file_table_draw_event(lv_event_t *e)
+{
+    lv_draw_task_t *task = lv_event_get_draw_task(e);
+    lv_draw_dsc_base_t *base = lv_draw_task_get_draw_dsc(task);
+    if (base->part != LV_PART_ITEMS || lv_draw_task_get_type(task) != LV_DRAW_TASK_TYPE_LABEL) {
+        return;
+    }
+    // 第 0 行为表头，第 0 列为文件名
+    if (base->id1 == 0 || base->id2 != 0) {
+        return;
+    }
+
+    lv_obj_t *fmg = lv_event_get_user_data(e);
+    const char *cell = lv_table_get_cell_value(file_table, base->id1, 0);
+    const char *dir = lv_file_explorer_get_current_path(fmg);
+    // 单元格内容为 "符号(3 字节) + 两个空格 + 文件名"，与 lv_file_explorer 取选中文件名的方式一致
+    if (!cell || !dir || strlen(cell) <= 5) {
+        return;
+    }
+    const char *name = cell + 5;
+    if (!has_thumbnail(name)) {
+        return;
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s", convert_lvgl_path(dir), name);
+    fm_thumb_t *slot = thumb_lookup(path);
+    if (!slot || !slot->thumb) {
+        return;
+    }
+
+    lv_area_t cell_area;
+    lv_draw_task_get_area(task, &cell_area);
+    int32_t w = slot->thumb->header.w;
+    int32_t h = slot->thumb->header.h;
+    lv_area_t area;
+    area.x1 = cell_area.x2 - FM_THUMB_SIZE + 1 + (FM_THUMB_SIZE - w) / 2;
+    area.y1 = cell_area.y1 + (lv_area_get_height(&cell_area) - h) / 2;
+    area.x2 = area.x1 + w - 1;
+    area.y2 = area.y1 + h - 1;
+
+    lv_draw_image_dsc_t img_dsc;
+    lv_draw_image_dsc_init(&img_dsc);
+    img_dsc.src = slot->thumb;
+    lv_draw_image(base->layer, &img_dsc, &area);
+}
+
+// 文件管理器关闭时取消未完成的请求并释放缩略图
+static void file_explorer_delete_event(lv_event_t *e)
+{
+    (void)e;
+    for (int i = 0; i < FM_THUMB_SLOTS; i++) {
+        thumb_slot_clear(&thumbs[i]);
+    }
+    file_table = NULL;
+}
 
 void file_manager(void) {
 
@@ -54,39 +225,24 @@ void file_manager(void) {
     lv_obj_center(back_label);
 
     lv_obj_t *fmg =lv_file_explorer_create(manager);
-    lv_file_explorer_set_sort(fmg, LV_EXPLORER_SORT_KIND);
+    /* dir_cache 已按 目录优先/扩展名/名称 排好序，浏览器无需再次排序 */
+    lv_file_explorer_set_sort(fmg, LV_EXPLORER_SORT_NONE);
     lv_obj_set_size(fmg, 960, 540);
 
-    /* Get the file table object and set row height */
+    /* 文件列表行内缩略图：通过绘制任务事件叠加，缩略图在后台线程生成 */
+    file_table = lv_file_explorer_get_file_table(fmg);
+    lv_obj_add_flag(file_table, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+    lv_obj_add_event_cb(file_table, file_table_draw_begin_event, LV_EVENT_DRAW_MAIN_BEGIN, NULL);
+    lv_obj_add_event_cb(file_table, file_table_draw_event, LV_EVENT_DRAW_TASK_ADDED, fmg);
+    lv_obj_add_event_cb(fmg, file_explorer_delete_event, LV_EVENT_DELETE, NULL);
 
-    lv_file_explorer_open_dir(fmg,"A:/");
+    /* 通过带缓存的盘符浏览，重复打开或返回上级目录时直接命中缓存 */
+    lv_file_explorer_open_dir(fmg,"C:/");
 
     /* 添加文件选择事件处理 */
     lv_obj_add_event_cb(fmg, file_select_event, LV_EVENT_VALUE_CHANGED, fmg);
   }
 
-static bool is_end_with(const char * str1, const char * str2)
-{
-    if(str1 == NULL || str2 == NULL)
-        return false;
-    
-    uint16_t len1 = strlen(str1);
-    uint16_t len2 = strlen(str2);
-    if((len1 < len2) || (len1 == 0 || len2 == 0))
-        return false;
-    
-    while(len2 >= 1)
-    {
-        if(tolower(str2[len2 - 1])  != tolower(str1[len1 - 1]))
-            return false;
-
-        len2--;
-        len1--;
-    }
-
-    return true;
-}
-
 // 音乐播放器函数：根据文件路径创建或更新播放器
 void music_player(const char * path)
 {
@@ -98,13 +254,8 @@ void music_player(const char * path)
 
     printf("[file_manager] Opening file: %s\n", real_path);
 
-    // 检查是否是音频文件
-    if (is_end_with(real_path, ".mp3") ||
-        is_end_with(real_path, ".wav") ||
-        is_end_with(real_path, ".flac") ||
-        is_end_with(real_path, ".aac") ||
-        is_end_with(real_path, ".ogg") ||
-        is_end_with(real_path, ".m4a")) {
+    // 检查是否是音频文件（扩展名列表与媒体库索引共用）
+    if (media_library_is_audio_path(real_path)) {
 
         printf("[file_manager] Audio file detected, creating player...\n");
 
@@ -0,0 +1,484 @@
+/**
+ * @file font_atlas.c
+ * @brief TTF 字体与共享字形图集实现
+ *
+ * 包装字体的 get_glyph_dsc 直接转发给 Tiny TTF；get_glyph_bitmap 先按
+ * (字体, 字形索引) 查找图集，未命中时让 Tiny TTF 光栅化，复制到图集后立即
+ * 释放 Tiny TTF 的缓存项。图集中的字形以指向图集内部的 A8 draw_buf 返回
+ * （stride 为图集宽度），绘制时不再复制。
+ *
+ * 图集按高度分行：高度取整到4像素，同一高度的字形从左到右排列。
+ * 没有空间时淘汰最久未使用、且不低于所需高度的一整行。
+ * LVGL 在主线程中同步绘制（LV_USE_OS 为 LV_OS_NONE），返回的字形在绘制下一个
+ * 字形之前已经用完，因此淘汰时不需要检查字形是否正在使用。
+ */
+
+#include "font_atlas.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define SHELF_ROUND     4       /**< 行高取整 */
+#define GLYPH_ALIGN     4       /**< 字形起始列对齐（与 LV_DRAW_BUF_ALIGN 一致） */
+#define GLYPH_BUCKETS   1024    /**< 字形哈希桶数量（2的幂） */
+#define TTF_CACHE_CNT   4       /**< Tiny TTF 自身缓存的字形数（字形由图集缓存） */
+
+/**
+ * @brief 图集中的字形
+ */
+typedef struct atlas_glyph {
+    struct atlas_glyph *hash_next;
+    struct atlas_glyph *shelf_next;
+    uint32_t gid;               /**< 字形索引 */
+    uint16_t shelf;             /**< 所在行 */
+    uint8_t font;               /**< 字体槽位 */
+    lv_draw_buf_t buf;          /**< 指向图集内部的 A8 位图 */
+} atlas_glyph_t;
+
+/**
+ * @brief 图集中的一行
+ */
+typedef struct {
+    int y;
+    int h;
+    int x;                      /**< 下一个字形的起始列 */
+    uint32_t last_used;
+    atlas_glyph_t *glyphs;
+} atlas_shelf_t;
+
+/**
+ * @brief 包装后的字体
+ */
+typedef struct {
+    lv_font_t font;             /**< 返回给调用方的字体 */
+    lv_font_t *src;             /**< Tiny TTF 字体 */
+    bool used;
+} atlas_font_t;
+
+static uint8_t *pixels = NULL;
+static int atlas_size = 0;
+static atlas_shelf_t *shelves = NULL;
+static int shelf_count = 0;
+static int max_shelves = 0;
+static int next_y = 0;
+static atlas_glyph_t *buckets[GLYPH_BUCKETS];
+static atlas_font_t fonts[FONT_ATLAS_MAX_FONTS];
+static uint32_t use_clock = 0;
+static font_atlas_stats_t stats;
+
+static uint32_t glyph_hash(uint8_t font, uint32_t gid) {
+    return ((gid * 2654435761u) ^ (font * 40503u)) & (GLYPH_BUCKETS - 1);
+}
+
+static atlas_glyph_t *find_glyph(uint8_t font, uint32_t gid) {
+    for (atlas_glyph_t *g = buckets[glyph_hash(font, gid)]; g != NULL; g = g->hash_next) {
+        if (g->gid == gid && g->font == font) {
+            return g;
+        }
+    }
+    return NULL;
+}
+
+static void unlink_glyph(atlas_glyph_t *glyph) {
+    atlas_glyph_t **pp = &buckets[glyph_hash(glyph->font, glyph->gid)];
+    while (*pp != NULL && *pp != glyph) {
+        pp = &(*pp)->hash_next;
+    }
+    if (*pp == glyph) {
+        *pp = glyph->hash_next;
+    }
+}
+
+/**
+ * @brief 清空一行，行高保持不变
+ */
+static void clear_shelf(atlas_shelf_t *s) {
+    while (s->glyphs != NULL) {
+        atlas_glyph_t *g = s->glyphs;
+        s->glyphs = g->shelf_next;
+        unlink_glyph(g);
+        free(g);
+        stats.glyphs--;
+    }
+    s->x = 0;
+}
+
+/**
+ * @brief 为 w*h 的字形分配位置
+ * @param w 宽度
+ * @param h 高度
+ * @param allow_evict 是否允许淘汰
+ * @return 行，失败返回NULL；字形从该行的 x 列开始
+ */
+static atlas_shelf_t *alloc_rect(int w, int h, bool allow_evict) {
+    int aligned_w = (w + GLYPH_ALIGN - 1) & ~(GLYPH_ALIGN - 1);
+    int shelf_h = (h + SHELF_ROUND - 1) & ~(SHELF_ROUND - 1);
+    if (aligned_w > atlas_size || shelf_h > atlas_size) {
+        return NULL;
+    }
+
+    // 同一高度、还有空间的行
+    for (int i = 0; i < shelf_count; i++) {
+        atlas_shelf_t *s = &shelves[i];
+        if (s->h == shelf_h && s->x + aligned_w <= atlas_size) {
+            return s;
+        }
+    }
+
+    // 新建一行
+    if (next_y + shelf_h <= atlas_size && shelf_count < max_shelves) {
+        atlas_shelf_t *s = &shelves[shelf_count++];
+        memset(s, 0, sizeof(*s));
+        s->y = next_y;
+        s->h = shelf_h;
+        next_y += shelf_h;
+        stats.shelves = shelf_count;
+        stats.used_height = next_y;
+        return s;
+    }
+    if (!allow_evict) {
+        return NULL;
+    }
+
+    // 淘汰最久未使用的行；同高度的行优先，避免浪费高度
+    atlas_shelf_t *victim = NULL;
+    for (int i = 0; i < shelf_count; i++) {
+        atlas_shelf_t *s = &shelves[i];
+        if (s->h < shelf_h) {
+            continue;
+        }
+        bool exact = s->h == shelf_h;
+        bool victim_exact = victim != NULL && victim->h == shelf_h;
+        if (victim == NULL || (exact && !victim_exact) ||
+            (exact == victim_exact && s->last_used < victim->last_used)) {
+            victim = s;
+        }
+    }
+    if (victim != NULL) {
+        clear_shelf(victim);
+        stats.evictions++;
+    }
+    return victim;
+}
+
+/**
+ * @brief 把光栅化的位图复制到图集
+ * @param font 字体槽位
+ * @param gid 字形索引
+ * @param bmp Tiny TTF 返回的位图
+ * @param w 宽度
+ * @param h 高度
+ * @param allow_evict 是否允许淘汰
+ * @return 图集中的字形，放不下返回NULL
+ */
+static atlas_glyph_t *store_glyph(uint8_t font, uint32_t gid, const lv_draw_buf_t *bmp, int w, int h, bool allow_evict) {
+    atlas_glyph_t *glyph = (atlas_glyph_t *)calloc(1, sizeof(atlas_glyph_t));
+    if (glyph == NULL) {
+        return NULL;
+    }
+    atlas_shelf_t *s = alloc_rect(w, h, allow_evict);
+    if (s == NULL) {
+        free(glyph);
+        return NULL;
+    }
+
+    uint8_t *dst = pixels + (size_t)s->y * atlas_size + s->x;
+    for (int row = 0; row < h; row++) {
+        memcpy(dst + (size_t)row * atlas_size, bmp->data + (size_t)row * bmp->header.stride, (size_t)w);
+    }
+    // 数据长度按 stride*h 计算，图集末尾预留了一行
+    lv_draw_buf_init(&glyph->buf, (uint32_t)w, (uint32_t)h, LV_COLOR_FORMAT_A8, (uint32_t)atlas_size,
+                     dst, (uint32_t)atlas_size * (uint32_t)h);
+
+    s->x += (w + GLYPH_ALIGN - 1) & ~(GLYPH_ALIGN - 1);
+    s->last_used = ++use_clock;
+    glyph->gid = gid;
+    glyph->shelf = (uint16_t)(s - shelves);
+    glyph->font = font;
+    glyph->shelf_next = s->glyphs;
+    s->glyphs = glyph;
+    uint32_t b = glyph_hash(font, gid);
+    glyph->hash_next = buckets[b];
+    buckets[b] = glyph;
+    stats.glyphs++;
+    return glyph;
+}
+
+/**
+ * @brief 让 Tiny TTF 光栅化字形
+ */
+static const lv_draw_buf_t *ttf_bitmap(atlas_font_t *af, lv_font_glyph_dsc_t *g_dsc, lv_draw_buf_t *draw_buf) {
+    const lv_font_t *resolved = g_dsc->resolved_font;
+    g_dsc->resolved_font = af->src;
+    const lv_draw_buf_t *bmp = (const lv_draw_buf_t *)af->src->get_glyph_bitmap(g_dsc, draw_buf);
+    g_dsc->resolved_font = resolved;
+    return bmp;
+}
+
+static void ttf_release(atlas_font_t *af, lv_font_glyph_dsc_t *g_dsc) {
+    if (af->src->release_glyph != NULL) {
+        af->src->release_glyph(af->src, g_dsc);
+    }
+    g_dsc->entry = NULL;
+}
+
+/*=====================
+ * lv_font_t 回调
+ *====================*/
+
+static bool atlas_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t letter,
+                                uint32_t letter_next) {
+    const atlas_font_t *af = (const atlas_font_t *)font->dsc;
+    return af->src->get_glyph_dsc(af->src, dsc_out, letter, letter_next);
+}
+
+static const void *atlas_get_glyph_bitmap(lv_font_glyph_dsc_t *g_dsc, lv_draw_buf_t *draw_buf) {
+    atlas_font_t *af = (atlas_font_t *)g_dsc->resolved_font->dsc;
+    uint8_t slot = (uint8_t)(af - fonts);
+    if (g_dsc->box_w == 0 || g_dsc->box_h == 0) {
+        return NULL;
+    }
+
+    atlas_glyph_t *glyph = find_glyph(slot, g_dsc->gid.index);
+    if (glyph != NULL) {
+        stats.hits++;
+        // 字形按行淘汰，行的使用时间取其中字形的最近使用时间
+        shelves[glyph->shelf].last_used = ++use_clock;
+        g_dsc->entry = NULL;
+        return &glyph->buf;
+    }
+
+    stats.misses++;
+    const lv_draw_buf_t *bmp = ttf_bitmap(af, g_dsc, draw_buf);
+    if (bmp == NULL) {
+        return NULL;
+    }
+    glyph = store_glyph(slot, g_dsc->gid.index, bmp, g_dsc->box_w, g_dsc->box_h, true);
+    if (glyph == NULL) {
+        // 图集放不下（字形过大），直接使用 Tiny TTF 的缓存项，由 release_glyph 释放
+        stats.bypass++;
+        return bmp;
+    }
+    ttf_release(af, g_dsc);
+    return &glyph->buf;
+}
+
+static void atlas_release_glyph(const lv_font_t *font, lv_font_glyph_dsc_t *g_dsc) {
+    // 只有直接返回 Tiny TTF 位图时才持有缓存项
+    if (g_dsc->entry != NULL) {
+        ttf_release((atlas_font_t *)font->dsc, g_dsc);
+    }
+}
+
+/*=====================
+ * 公共接口
+ *====================*/
+
+bool font_atlas_init(int size) {
+    if (pixels != NULL) {
+        return true;
+    }
+    if (size <= 0) {
+        size = FONT_ATLAS_DEFAULT_SIZE;
+    }
+    size = (size + GLYPH_ALIGN - 1) & ~(GLYPH_ALIGN - 1);
+
+    // 末尾多分配一行：最后一行字形的 draw_buf 数据长度按 stride*h 计算
+    pixels = (uint8_t *)calloc((size_t)size + 1, (size_t)size);
+    max_shelves = size / SHELF_ROUND;
+    shelves = (atlas_shelf_t *)calloc((size_t)max_shelves, sizeof(atlas_shelf_t));
+    if (pixels == NULL || shelves == NULL) {
+        printf("字形图集分配失败\n");
+        free(pixels);
+        free(shelves);
+        pixels = NULL;
+        shelves = NULL;
+        return false;
+    }
+    atlas_size = size;
+    shelf_count = 0;
+    next_y = 0;
+    memset(buckets, 0, sizeof(buckets));
+    memset(&stats, 0, sizeof(stats));
+    stats.size = size;
+    return true;
+}
+
+lv_font_t *font_atlas_load(const char *path, int size) {
+#if LV_USE_TINY_TTF && LV_TINY_TTF_FILE_SUPPORT
+    if (path == NULL || path[0] == '\0' || size <= 0) {
+        return NULL;
+    }
+    if (pixels == NULL && !font_atlas_init(0)) {
+        return NULL;
+    }
+
+    // Tiny TTF 通过 LVGL 文件系统读取字体，系统路径加上 POSIX 驱动的盘符
+    bool has_letter = isupper((unsigned char)path[0]) && path[1] == ':';
+    const char *sys_path = has_letter ? path + 2 : path;
+    struct stat st;
+    if (stat(sys_path, &st) != 0) {
+        printf("字体文件不存在: %s\n", sys_path);
+        return NULL;
+    }
+    char lv_path[512];
+    if (has_letter) {
+        snprintf(lv_path, sizeof(lv_path), "%s", path);
+    } else {
+        snprintf(lv_path, sizeof(lv_path), "%c:%s", LV_FS_POSIX_LETTER, path);
+    }
+
+    atlas_font_t *af = NULL;
+    for (int i = 0; i < FONT_ATLAS_MAX_FONTS; i++) {
+        if (!fonts[i].used) {
+            af = &fonts[i];
+            break;
+        }
+    }
+    if (af == NULL) {
+        printf("最多同时加载 %d 个字体\n", FONT_ATLAS_MAX_FONTS);
+        return NULL;
+    }
+
+    lv_font_t *src = lv_tiny_ttf_create_file_ex(lv_path, size, LV_FONT_KERNING_NORMAL, TTF_CACHE_CNT);
+    if (src == NULL) {
+        printf("字体加载失败: %s\n", sys_path);
+        return NULL;
+    }
+
+    memset(af, 0, sizeof(*af));
+    af->src = src;
+    af->used = true;
+    af->font.get_glyph_dsc = atlas_get_glyph_dsc;
+    af->font.get_glyph_bitmap = atlas_get_glyph_bitmap;
+    af->font.release_glyph = atlas_release_glyph;
+    af->font.line_height = src->line_height;
+    af->font.base_line = src->base_line;
+    af->font.kerning = src->kerning;
+    af->font.underline_position = src->underline_position;
+    af->font.underline_thickness = src->underline_thickness;
+    af->font.dsc = af;
+    return &af->font;
+#else
+    (void)size;
+    printf("未启用 LV_USE_TINY_TTF/LV_TINY_TTF_FILE_SUPPORT，无法加载字体: %s\n", path ? path : "");
+    return NULL;
+#endif
+}
+
+void font_atlas_unload(lv_font_t *font) {
+    if (font == NULL) {
+        return;
+    }
+    atlas_font_t *af = (atlas_font_t *)font->dsc;
+    if (af < fonts || af >= fonts + FONT_ATLAS_MAX_FONTS || !af->used) {
+        return;
+    }
+    uint8_t slot = (uint8_t)(af - fonts);
+
+    for (int i = 0; i < shelf_count; i++) {
+        atlas_glyph_t **pp = &shelves[i].glyphs;
+        while (*pp != NULL) {
+            atlas_glyph_t *g = *pp;
+            if (g->font == slot) {
+                *pp = g->shelf_next;
+                unlink_glyph(g);
+                free(g);
+                stats.glyphs--;
+            } else {
+                pp = &g->shelf_next;
+            }
+        }
+    }
+
+#if LV_USE_TINY_TTF
+    lv_tiny_ttf_destroy(af->src);
+#endif
+    memset(af, 0, sizeof(*af));
+}
+
+int font_atlas_warm(lv_font_t *font, const char *text) {
+    if (font == NULL || text == NULL || pixels == NULL) {
+        return 0;
+    }
+    atlas_font_t *af = (atlas_font_t *)font->dsc;
+    if (af < fonts || af >= fonts + FONT_ATLAS_MAX_FONTS || !af->used) {
+        return 0;
+    }
+    uint8_t slot = (uint8_t)(af - fonts);
+
+    int added = 0;
+    uint32_t i = 0;
+    while (text[i] != '\0') {
+        uint32_t letter = lv_text_encoded_next(text, &i);
+        lv_font_glyph_dsc_t g;
+        memset(&g, 0, sizeof(g));
+        if (!af->src->get_glyph_dsc(af->src, &g, letter, 0) || g.box_w == 0 || g.box_h == 0 ||
+            find_glyph(slot, g.gid.index) != NULL) {
+            continue;
+        }
+        g.resolved_font = font;
+
+        const lv_draw_buf_t *bmp = ttf_bitmap(af, &g, NULL);
+        if (bmp == NULL) {
+            continue;
+        }
+        atlas_glyph_t *glyph = store_glyph(slot, g.gid.index, bmp, g.box_w, g.box_h, false);
+        ttf_release(af, &g);
+        if (glyph == NULL) {
+            break;  // 图集已满，剩下的字形在绘制时按需光栅化
+        }
+        added++;
+    }
+    return added;
+}
+
+int font_atlas_warm_file(lv_font_t *font, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = size > 0 ? (char *)malloc((size_t)size + 1) : NULL;
+    if (text == NULL) {
+        fclose(f);
+        return 0;
+    }
+    size_t n = fread(text, 1, (size_t)size, f);
+    fclose(f);
+    text[n] = '\0';
+
+    int added = font_atlas_warm(font, text);
+    free(text);
+    return added;
+}
+
+void font_atlas_get_stats(font_atlas_stats_t *out) {
+    if (out != NULL) {
+        *out = stats;
+    }
+}
+
+void font_atlas_deinit(void) {
+    for (int i = 0; i < FONT_ATLAS_MAX_FONTS; i++) {
+        if (fonts[i].used) {
+            font_atlas_unload(&fonts[i].font);
+        }
+    }
+    if (pixels != NULL) {
+        printf("字形图集统计: 命中 %u, 光栅化 %u, 淘汰 %u 行, 绕过 %u\n",
+               stats.hits, stats.misses, stats.evictions, stats.bypass);
+    }
+    free(pixels);
+    free(shelves);
+    pixels = NULL;
+    shelves = NULL;
+    atlas_size = 0;
+    shelf_count = 0;
+    max_shelves = 0;
+    next_y = 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file font_atlas.h
+ * @brief TTF 字体与共享字形图集头文件
+ *
+ * 通过 LVGL 的 Tiny TTF 按指定字号加载 TTF/OTF 字体，并包装为新的 lv_font_t：
+ * 光栅化后的字形复制到一张所有字体共享的 A8 图集中，按行（shelf）装箱，
+ * 图集满时整行淘汰最久未使用的字形。绘制时直接引用图集中的像素，
+ * 同一字形只光栅化一次，任意字号都按原始像素绘制，不需要缩放变换。
+ *
+ * tools/font_bake 可以从故事或文本中统计用到的字符，生成字形集文件，
+ * 加载字体后用 font_atlas_warm_file 预先光栅化这些字形。
+ *
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef FONT_ATLAS_H
+#define FONT_ATLAS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lvgl/lvgl.h"
+
+#define FONT_ATLAS_DEFAULT_SIZE     512         /**< 默认图集边长（像素），A8 每像素1字节 */
+#define FONT_ATLAS_MAX_FONTS        8           /**< 同时加载的字体数 */
+#define FONT_ATLAS_DEFAULT_UI_FONT  "/mnt/app/fonts/ui.ttf"
+#define FONT_ATLAS_UI_SIZE          16          /**< 界面字体字号 */
+
+/**
+ * @brief 图集统计
+ */
+typedef struct {
+    uint32_t hits;              /**< 命中次数 */
+    uint32_t misses;            /**< 光栅化次数 */
+    uint32_t evictions;         /**< 淘汰的行数 */
+    uint32_t bypass;            /**< 图集放不下、直接使用 Tiny TTF 缓存的次数 */
+    int glyphs;                 /**< 图集中的字形数 */
+    int shelves;                /**< 行数 */
+    int used_height;            /**< 已分配的高度 */
+    int size;                   /**< 图集边长 */
+} font_atlas_stats_t;
+
+/**
+ * @brief 初始化图集
+ * @param size 图集边长，<=0 使用默认值
+ * @return 是否成功
+ */
+bool font_atlas_init(int size);
+
+/**
+ * @brief 加载字体（未初始化时按默认大小初始化图集）
+ * @param path 字体文件路径（系统路径或 X:/ 盘符路径）
+ * @param size 字号（像素）
+ * @return 字体，失败返回NULL；fallback 由调用方设置
+ */
+lv_font_t *font_atlas_load(const char *path, int size);
+
+/**
+ * @brief 卸载字体并从图集中删除其字形
+ * @param font font_atlas_load 返回的字体
+ */
+void font_atlas_unload(lv_font_t *font);
+
+/**
+ * @brief 预先光栅化文本中的字形，图集需要淘汰时停止
+ * @param font font_atlas_load 返回的字体
+ * @param text UTF-8 文本
+ * @return 新放入图集的字形数
+ */
+int font_atlas_warm(lv_font_t *font, const char *text);
+
+/**
+ * @brief 从字形集文件（UTF-8 文本，tools/font_bake 生成）预先光栅化字形
+ * @param font font_atlas_load 返回的字体
+ * @param path 字形集文件路径
+ * @return 新放入图集的字形数，文件不存在返回-1
+ */
+int font_atlas_warm_file(lv_font_t *font, const char *path);
+
+/**
+ * @brief 获取图集统计
+ * @param stats 输出
+ */
+void font_atlas_get_stats(font_atlas_stats_t *stats);
+
+/**
+ * @brief 卸载所有字体并释放图集
+ */
+void font_atlas_deinit(void);
+
+#endif /* FONT_ATLAS_H */
@@ -0,0 +1,1096 @@
+/**
+ * @file http_fetch.c
+ * @brief HTTP(S) 资源下载与磁盘缓存实现
+ *
+ * 缓存目录布局：
+ *   blobs/<内容 SHA-256>   下载的内容，相同内容只保存一份
+ *   meta/<URL SHA-256>     URL 元数据："V1" / ETag / 内容哈希 / 上次验证时间
+ * meta 文件的 mtime 作为最近使用时间，淘汰时删除最久未用的 meta；
+ * 内容文件只在没有任何 meta 引用时才删除（多个 URL 可能共用同一份内容）。
+ * 所有文件都先写临时文件再 rename，多个线程同时下载同一 URL 也不会读到半个文件。
+ */
+
+#include "http_fetch.h"
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#define HF_MAX_REDIRECTS    5
+#define HF_MAX_IDLE_CONNS   8       /**< 连接池中最多保留的空闲连接 */
+#define HF_IDLE_TIMEOUT     30      /**< 空闲连接超过该秒数后不再复用 */
+#define HF_CONNECT_TIMEOUT  10000   /**< 连接超时（毫秒） */
+#define HF_IO_TIMEOUT       15      /**< 读写超时（秒） */
+#define HF_HOST_MAX         256
+#define HF_URL_MAX          2048
+#define HF_ETAG_MAX         256
+#define HF_HASH_HEX         65
+#define HF_DIR_MAX          256     /**< 缓存目录路径长度上限 */
+
+/**
+ * @brief 解析后的 URL
+ */
+typedef struct {
+    bool https;
+    char host[HF_HOST_MAX];
+    int port;
+    char path[HF_URL_MAX];
+} hf_url_t;
+
+/**
+ * @brief 连接（明文或 TLS）
+ */
+typedef struct hf_conn {
+    struct hf_conn *next;
+    int fd;
+    SSL *ssl;
+    char key[HF_HOST_MAX + 16];     /**< scheme://host:port */
+    time_t last_used;
+} hf_conn_t;
+
+/**
+ * @brief 带缓冲的读取器
+ */
+typedef struct {
+    hf_conn_t *conn;
+    char buf[16384];
+    int pos;
+    int len;
+} hf_reader_t;
+
+/**
+ * @brief 响应信息
+ */
+typedef struct {
+    int status;
+    long long content_length;       /**< -1 表示未知 */
+    bool chunked;
+    bool keep_alive;
+    char etag[HF_ETAG_MAX];
+    char location[HF_URL_MAX];
+} hf_response_t;
+
+/**
+ * @brief URL 元数据
+ */
+typedef struct {
+    char etag[HF_ETAG_MAX];
+    char blob[HF_HASH_HEX];
+    long long checked;              /**< 上次下载或验证的时间 */
+} hf_meta_t;
+
+/**
+ * @brief 响应体写入目标（临时文件 + SHA-256）
+ */
+typedef struct {
+    int fd;
+    EVP_MD_CTX *md;
+    long long size;
+} hf_sink_t;
+
+static char cache_dir_buf[HF_DIR_MAX];
+static size_t cache_limit = HTTP_FETCH_DEFAULT_LIMIT;
+static size_t cache_bytes = 0;
+static bool initialized = false;
+static SSL_CTX *ssl_ctx = NULL;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static hf_conn_t *idle_conns = NULL;
+static int idle_count = 0;
+
+/*=====================
+ * 工具函数
+ *====================*/
+
+bool http_fetch_is_url(const char *s) {
+    return s != NULL && (strncasecmp(s, "http://", 7) == 0 || strncasecmp(s, "https://", 8) == 0);
+}
+
+static void sha256_hex(const void *data, size_t len, char out[HF_HASH_HEX]) {
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int md_len = 0;
+    EVP_Digest(data, len, md, &md_len, EVP_sha256(), NULL);
+    for (unsigned int i = 0; i < md_len && i < 32; i++) {
+        sprintf(out + i * 2, "%02x", md[i]);
+    }
+    out[64] = '\0';
+}
+
+static void blob_path(const char *hex, char *out, size_t size) {
+    snprintf(out, size, "%s/blobs/%s", cache_dir_buf, hex);
+}
+
+static void meta_path(const char *url, char *out, size_t size) {
+    char hex[HF_HASH_HEX];
+    sha256_hex(url, strlen(url), hex);
+    snprintf(out, size, "%s/meta/%s", cache_dir_buf, hex);
+}
+
+static bool parse_url(const char *url, hf_url_t *u) {
+    memset(u, 0, sizeof(*u));
+    const char *p;
+    if (strncasecmp(url, "https://", 8) == 0) {
+        u->https = true;
+        u->port = 443;
+        p = url + 8;
+    } else if (strncasecmp(url, "http://", 7) == 0) {
+        u->port = 80;
+        p = url + 7;
+    } else {
+        return false;
+    }
+
+    size_t host_len = strcspn(p, ":/?#");
+    if (host_len == 0 || host_len >= sizeof(u->host)) {
+        return false;
+    }
+    memcpy(u->host, p, host_len);
+    p += host_len;
+
+    if (*p == ':') {
+        char *end;
+        long port = strtol(p + 1, &end, 10);
+        if (end == p + 1 || port <= 0 || port > 65535) {
+            return false;
+        }
+        u->port = (int)port;
+        p = end;
+    }
+
+    // 片段不发送给服务器
+    size_t path_len = strcspn(p, "#");
+    if (path_len == 0) {
+        strcpy(u->path, "/");
+    } else if (*p == '?') {
+        snprintf(u->path, sizeof(u->path), "/%.*s", (int)path_len, p);
+    } else {
+        if (path_len >= sizeof(u->path)) {
+            return false;
+        }
+        memcpy(u->path, p, path_len);
+        u->path[path_len] = '\0';
+    }
+    return true;
+}
+
+/*=====================
+ * 元数据
+ *====================*/
+
+static bool meta_load(const char *url, hf_meta_t *m) {
+    char path[PATH_MAX];
+    meta_path(url, path, sizeof(path));
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+
+    memset(m, 0, sizeof(*m));
+    char line[HF_ETAG_MAX + 8];
+    bool ok = false;
+    // 内容哈希占满 m->blob，整行（含换行）先读入 line 再复制
+    if (fgets(line, sizeof(line), f) && strcmp(line, "V1\n") == 0 &&
+        fgets(m->etag, sizeof(m->etag), f) &&
+        fgets(line, sizeof(line), f) && strcspn(line, "\r\n") == 64) {
+        m->etag[strcspn(m->etag, "\r\n")] = '\0';
+        memcpy(m->blob, line, 64);
+        m->blob[64] = '\0';
+        ok = fgets(line, sizeof(line), f) != NULL;
+        m->checked = atoll(line);
+    }
+    fclose(f);
+    return ok;
+}
+
+static bool meta_store(const char *url, const hf_meta_t *m) {
+    char path[PATH_MAX];
+    char tmp[PATH_MAX];
+    meta_path(url, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s/meta/.tmp-XXXXXX", cache_dir_buf);
+
+    int fd = mkstemp(tmp);
+    if (fd < 0) {
+        return false;
+    }
+    FILE *f = fdopen(fd, "w");
+    if (f == NULL) {
+        close(fd);
+        unlink(tmp);
+        return false;
+    }
+    fprintf(f, "V1\n%s\n%s\n%lld\n", m->etag, m->blob, m->checked);
+    bool ok = fclose(f) == 0;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 更新 meta 文件的 mtime（最近使用时间）
+ */
+static void meta_touch(const char *url) {
+    char path[PATH_MAX];
+    meta_path(url, path, sizeof(path));
+    utimensat(AT_FDCWD, path, NULL, 0);
+}
+
+/*=====================
+ * 缓存大小与淘汰
+ *====================*/
+
+typedef struct {
+    char name[HF_HASH_HEX];
+    char blob[HF_HASH_HEX];
+    time_t mtime;
+    int *refs;                      /**< 内容被多少个 meta 引用（同一内容的条目共用） */
+} hf_evict_t;
+
+static int evict_compare(const void *a, const void *b) {
+    time_t ta = ((const hf_evict_t *)a)->mtime;
+    time_t tb = ((const hf_evict_t *)b)->mtime;
+    return (ta > tb) - (ta < tb);
+}
+
+static int evict_blob_compare(const void *a, const void *b) {
+    return strcmp(((const hf_evict_t *)a)->blob, ((const hf_evict_t *)b)->blob);
+}
+
+/**
+ * @brief 统计 blobs 目录的总大小
+ */
+static size_t scan_blob_bytes(void) {
+    char dir[HF_DIR_MAX + 8];
+    snprintf(dir, sizeof(dir), "%s/blobs", cache_dir_buf);
+    DIR *dp = opendir(dir);
+    if (dp == NULL) {
+        return 0;
+    }
+
+    size_t total = 0;
+    struct dirent *de;
+    while ((de = readdir(dp)) != NULL) {
+        struct stat st;
+        if (de->d_name[0] != '.' && fstatat(dirfd(dp), de->d_name, &st, 0) == 0 && S_ISREG(st.st_mode)) {
+            total += (size_t)st.st_size;
+        }
+    }
+    closedir(dp);
+    return total;
+}
+
+/**
+ * @brief 缓存超出上限时按最近使用时间淘汰到上限的 90%（调用方持有 cache_lock）
+ *
+ * 先统计每份内容被多少个 meta 引用，删除 meta 时引用数减一，
+ * 减到 0 才删除内容文件，其它 URL 仍在使用的内容不会被删除。
+ */
+static void evict_locked(void) {
+    if (cache_bytes <= cache_limit) {
+        return;
+    }
+
+    char dir[HF_DIR_MAX + 8];
+    snprintf(dir, sizeof(dir), "%s/meta", cache_dir_buf);
+    DIR *dp = opendir(dir);
+    if (dp == NULL) {
+        return;
+    }
+
+    hf_evict_t *items = NULL;
+    int count = 0;
+    int cap = 0;
+    struct dirent *de;
+    while ((de = readdir(dp)) != NULL) {
+        struct stat st;
+        if (de->d_name[0] == '.' || strlen(de->d_name) != 64 || fstatat(dirfd(dp), de->d_name, &st, 0) != 0) {
+            continue;
+        }
+        if (count == cap) {
+            cap = cap ? cap * 2 : 64;
+            hf_evict_t *grown = realloc(items, sizeof(hf_evict_t) * cap);
+            if (grown == NULL) {
+                break;
+            }
+            items = grown;
+        }
+
+        hf_evict_t *it = &items[count];
+        memset(it, 0, sizeof(*it));
+        memcpy(it->name, de->d_name, 64);   // 上面已确认长度为 64
+        it->mtime = st.st_mtime;
+
+        // meta 第三行为内容哈希
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+        FILE *f = fopen(path, "r");
+        if (f != NULL) {
+            char line[HF_ETAG_MAX + 8];
+            if (fgets(line, sizeof(line), f) && fgets(line, sizeof(line), f) &&
+                fgets(it->blob, sizeof(it->blob), f)) {
+                it->blob[strcspn(it->blob, "\r\n")] = '\0';
+            }
+            fclose(f);
+        }
+        count++;
+    }
+    closedir(dp);
+
+    // 按内容哈希分组统计引用数，同组条目共用一个计数
+    int *refs = calloc(count > 0 ? count : 1, sizeof(int));
+    if (refs == NULL) {
+        free(items);
+        return;
+    }
+    qsort(items, count, sizeof(hf_evict_t), evict_blob_compare);
+    for (int i = 0, group = -1; i < count; i++) {
+        if (i == 0 || strcmp(items[i].blob, items[i - 1].blob) != 0) {
+            group++;
+        }
+        items[i].refs = &refs[group];
+        refs[group]++;
+    }
+    qsort(items, count, sizeof(hf_evict_t), evict_compare);
+
+    size_t target = cache_limit / 10 * 9;
+    int removed = 0;
+    for (int i = 0; i < count && cache_bytes > target; i++) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", dir, items[i].name);
+        if (unlink(path) != 0) {
+            continue;
+        }
+        removed++;
+
+        // 还有其它 URL 引用的内容保留，只删除 meta
+        if (--*items[i].refs > 0 || items[i].blob[0] == '\0') {
+            continue;
+        }
+        struct stat st;
+        blob_path(items[i].blob, path, sizeof(path));
+        if (stat(path, &st) == 0 && unlink(path) == 0) {
+            cache_bytes -= (size_t)st.st_size < cache_bytes ? (size_t)st.st_size : cache_bytes;
+        }
+    }
+    free(refs);
+    free(items);
+
+    if (removed > 0) {
+        printf("[http] Evicted %d cached entries, %zu bytes in use\n", removed, cache_bytes);
+    }
+}
+
+/**
+ * @brief 把下载的临时文件登记为内容文件并写入 meta（调用方持有 cache_lock）
+ *
+ * 与淘汰在同一把锁内完成，淘汰统计引用时不会删除刚下载、还没有写入 meta 的内容。
+ * @param url URL
+ * @param tmp 下载的临时文件，成功或失败都会被移走或删除
+ * @param m 元数据（内容哈希、ETag、验证时间）
+ * @return 是否成功
+ */
+static bool commit_locked(const char *url, const char *tmp, const hf_meta_t *m) {
+    char path[PATH_MAX];
+    struct stat st;
+    blob_path(m->blob, path, sizeof(path));
+    if (stat(path, &st) == 0) {
+        // 相同内容已存在时直接复用
+        unlink(tmp);
+    } else if (stat(tmp, &st) == 0 && rename(tmp, path) == 0) {
+        cache_bytes += (size_t)st.st_size;
+    } else {
+        unlink(tmp);
+        return false;
+    }
+    return meta_store(url, m);
+}
+
+/*=====================
+ * 连接
+ *====================*/
+
+static void conn_close(hf_conn_t *c) {
+    if (c == NULL) {
+        return;
+    }
+    if (c->ssl != NULL) {
+        SSL_free(c->ssl);
+    }
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+    free(c);
+}
+
+static int tcp_connect(const char *host, int port) {
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, port_str, &hints, &res) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+
+        // 非阻塞连接以便设置超时
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int rc = connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc != 0 && errno == EINPROGRESS) {
+            struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (poll(&pfd, 1, HF_CONNECT_TIMEOUT) == 1 &&
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+                rc = 0;
+            }
+        }
+        if (rc == 0) {
+            fcntl(fd, F_SETFL, flags);
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (fd >= 0) {
+        struct timeval tv = { .tv_sec = HF_IO_TIMEOUT, .tv_usec = 0 };
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static hf_conn_t *conn_open(const hf_url_t *u, const char *key) {
+    hf_conn_t *c = calloc(1, sizeof(hf_conn_t));
+    if (c == NULL) {
+        return NULL;
+    }
+    c->fd = tcp_connect(u->host, u->port);
+    snprintf(c->key, sizeof(c->key), "%s", key);
+    if (c->fd < 0) {
+        printf("[http] Cannot connect to %s:%d\n", u->host, u->port);
+        conn_close(c);
+        return NULL;
+    }
+
+    if (u->https) {
+        c->ssl = SSL_new(ssl_ctx);
+        if (c->ssl == NULL) {
+            conn_close(c);
+            return NULL;
+        }
+        // SNI 与证书主机名校验
+        SSL_set_tlsext_host_name(c->ssl, u->host);
+        SSL_set1_host(c->ssl, u->host);
+        SSL_set_fd(c->ssl, c->fd);
+        if (SSL_connect(c->ssl) != 1) {
+            printf("[http] TLS handshake with %s failed: %s\n", u->host,
+                   ERR_reason_error_string(ERR_get_error()));
+            conn_close(c);
+            return NULL;
+        }
+    }
+    return c;
+}
+
+/**
+ * @brief 从连接池取出空闲连接，没有则新建
+ */
+static hf_conn_t *conn_acquire(const hf_url_t *u, bool *reused) {
+    char key[HF_HOST_MAX + 16];
+    snprintf(key, sizeof(key), "%s://%s:%d", u->https ? "https" : "http", u->host, u->port);
+
+    time_t now = time(NULL);
+    hf_conn_t *found = NULL;
+    hf_conn_t *expired = NULL;
+
+    pthread_mutex_lock(&pool_lock);
+    hf_conn_t **pp = &idle_conns;
+    while (*pp != NULL) {
+        hf_conn_t *c = *pp;
+        if (now - c->last_used > HF_IDLE_TIMEOUT) {
+            *pp = c->next;
+            c->next = expired;
+            expired = c;
+            idle_count--;
+        } else if (found == NULL && strcmp(c->key, key) == 0) {
+            *pp = c->next;
+            found = c;
+            idle_count--;
+        } else {
+            pp = &c->next;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    while (expired != NULL) {
+        hf_conn_t *next = expired->next;
+        conn_close(expired);
+        expired = next;
+    }
+
+    *reused = found != NULL;
+    return found ? found : conn_open(u, key);
+}
+
+/**
+ * @brief 请求结束后归还连接
+ */
+static void conn_release(hf_conn_t *c, bool keep) {
+    if (c == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool_lock);
+    if (keep && idle_count < HF_MAX_IDLE_CONNS) {
+        c->last_used = time(NULL);
+        c->next = idle_conns;
+        idle_conns = c;
+        idle_count++;
+        c = NULL;
+    }
+    pthread_mutex_unlock(&pool_lock);
+    conn_close(c);
+}
+
+static bool conn_write_all(hf_conn_t *c, const char *data, size_t len) {
+    while (len > 0) {
+        int n;
+        if (c->ssl != NULL) {
+            n = SSL_write(c->ssl, data, (int)len);
+        } else {
+            n = (int)send(c->fd, data, len, MSG_NOSIGNAL);
+        }
+        if (n <= 0) {
+            if (c->ssl == NULL && n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static int conn_read(hf_conn_t *c, char *buf, int size) {
+    for (;;) {
+        int n = c->ssl != NULL ? SSL_read(c->ssl, buf, size) : (int)recv(c->fd, buf, size, 0);
+        if (n < 0 && c->ssl == NULL && errno == EINTR) {
+            continue;
+        }
+        return n;
+    }
+}
+
+/*=====================
+ * 响应解析
+ *====================*/
+
+static bool reader_fill(hf_reader_t *r) {
+    if (r->pos < r->len) {
+        return true;
+    }
+    int n = conn_read(r->conn, r->buf, sizeof(r->buf));
+    if (n <= 0) {
+        return false;
+    }
+    r->pos = 0;
+    r->len = n;
+    return true;
+}
+
+/**
+ * @brief 读取一行（去掉 CRLF）
+ */
+static bool reader_line(hf_reader_t *r, char *out, size_t size) {
+    size_t n = 0;
+    for (;;) {
+        if (!reader_fill(r)) {
+            return false;
+        }
+        char ch = r->buf[r->pos++];
+        if (ch == '\n') {
+            break;
+        }
+        if (n + 1 < size) {
+            out[n++] = ch;
+        }
+    }
+    if (n > 0 && out[n - 1] == '\r') {
+        n--;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+/**
+ * @brief 读取 len 字节交给 sink（sink 为 NULL 时丢弃）；len 为 -1 时读到连接关闭
+ */
+static bool reader_body(hf_reader_t *r, long long len, hf_sink_t *sink, long long *total) {
+    while (len != 0) {
+        if (!reader_fill(r)) {
+            return len < 0;     // 未知长度时以连接关闭结束
+        }
+        int avail = r->len - r->pos;
+        int chunk = (len > 0 && len < avail) ? (int)len : avail;
+
+        *total += chunk;
+        if (*total > HTTP_FETCH_MAX_BODY) {
+            printf("[http] Response body too large\n");
+            return false;
+        }
+        if (sink != NULL) {
+            if (write(sink->fd, r->buf + r->pos, chunk) != chunk) {
+                return false;
+            }
+            EVP_DigestUpdate(sink->md, r->buf + r->pos, chunk);
+            sink->size += chunk;
+        }
+        r->pos += chunk;
+        if (len > 0) {
+            len -= chunk;
+        }
+    }
+    return true;
+}
+
+static bool read_chunked(hf_reader_t *r, hf_sink_t *sink) {
+    long long total = 0;
+    char line[256];
+    for (;;) {
+        if (!reader_line(r, line, sizeof(line))) {
+            return false;
+        }
+        char *end;
+        long long size = strtoll(line, &end, 16);
+        if (end == line || size < 0) {
+            return false;
+        }
+        if (size == 0) {
+            break;
+        }
+        if (!reader_body(r, size, sink, &total) || !reader_line(r, line, sizeof(line))) {
+            return false;
+        }
+    }
+
+    // 忽略 trailer，直到空行
+    do {
+        if (!reader_line(r, line, sizeof(line))) {
+            return false;
+        }
+    } while (line[0] != '\0');
+    return true;
+}
+
+/**
+ * @brief 逗号分隔的头部值中是否包含 token（不区分大小写）
+ */
+static bool has_token(const char *value, const char *token) {
+    size_t len = strlen(token);
+    while (*value != '\0') {
+        while (*value == ' ' || *value == '\t' || *value == ',') {
+            value++;
+        }
+        size_t n = strcspn(value, ", \t;");
+        if (n == len && strncasecmp(value, token, len) == 0) {
+            return true;
+        }
+        value += n;
+        value += strcspn(value, ",");
+    }
+    return false;
+}
+
+static bool read_headers(hf_reader_t *r, hf_response_t *resp) {
+    char line[HF_URL_MAX + 64];
+    if (!reader_line(r, line, sizeof(line))) {
+        return false;
+    }
+
+    int minor = 0;
+    if (sscanf(line, "HTTP/1.%d %d", &minor, &resp->status) != 2) {
+        return false;
+    }
+    resp->content_length = -1;
+    resp->keep_alive = minor >= 1;
+
+    for (;;) {
+        if (!reader_line(r, line, sizeof(line))) {
+            return false;
+        }
+        if (line[0] == '\0') {
+            break;
+        }
+
+        char *colon = strchr(line, ':');
+        if (colon == NULL) {
+            continue;
+        }
+        *colon = '\0';
+        char *value = colon + 1;
+        while (*value == ' ' || *value == '\t') {
+            value++;
+        }
+
+        if (strcasecmp(line, "Content-Length") == 0) {
+            resp->content_length = atoll(value);
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+            resp->chunked = has_token(value, "chunked");
+        } else if (strcasecmp(line, "Connection") == 0) {
+            if (has_token(value, "close")) {
+                resp->keep_alive = false;
+            } else if (has_token(value, "keep-alive")) {
+                resp->keep_alive = true;
+            }
+        } else if (strcasecmp(line, "ETag") == 0) {
+            snprintf(resp->etag, sizeof(resp->etag), "%s", value);
+        } else if (strcasecmp(line, "Location") == 0) {
+            snprintf(resp->location, sizeof(resp->location), "%s", value);
+        }
+    }
+    return true;
+}
+
+/*=====================
+ * 请求
+ *====================*/
+
+/**
+ * @brief 发送一次 GET 请求；状态为 200 时响应体写入 sink
+ * @return true 表示收到完整响应（任意状态码）
+ */
+static bool do_get(const hf_url_t *u, const char *etag, hf_sink_t *sink, hf_response_t *resp) {
+    char req[HF_URL_MAX + HF_HOST_MAX + HF_ETAG_MAX + 256];
+    int len = snprintf(req, sizeof(req),
+                       "GET %s HTTP/1.1\r\n"
+                       "Host: %s\r\n"
+                       "User-Agent: v833-lvgl\r\n"
+                       "Accept-Encoding: identity\r\n"
+                       "Connection: keep-alive\r\n",
+                       u->path, u->host);
+    if (etag != NULL && etag[0] != '\0') {
+        len += snprintf(req + len, sizeof(req) - len, "If-None-Match: %s\r\n", etag);
+    }
+    len += snprintf(req + len, sizeof(req) - len, "\r\n");
+    if (len >= (int)sizeof(req)) {
+        return false;
+    }
+
+    // 复用的连接可能已被服务器关闭，收到响应头之前失败时换新连接重试一次
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = false;
+        hf_conn_t *c = conn_acquire(u, &reused);
+        if (c == NULL) {
+            return false;
+        }
+
+        hf_reader_t *r = malloc(sizeof(hf_reader_t));
+        if (r == NULL) {
+            conn_close(c);
+            return false;
+        }
+        r->conn = c;
+        r->pos = r->len = 0;
+
+        memset(resp, 0, sizeof(*resp));
+        if (!conn_write_all(c, req, (size_t)len) || !read_headers(r, resp)) {
+            free(r);
+            conn_close(c);
+            if (reused) {
+                continue;
+            }
+            return false;
+        }
+
+        // 只有 200 保存响应体，其它状态读完丢弃以便复用连接
+        hf_sink_t *target = resp->status == 200 ? sink : NULL;
+        bool no_body = resp->status == 204 || resp->status == 304 || (resp->status >= 100 && resp->status < 200);
+        bool ok = true;
+        long long total = 0;
+        if (no_body) {
+            ok = true;
+        } else if (resp->chunked) {
+            ok = read_chunked(r, target);
+        } else if (resp->content_length >= 0) {
+            ok = reader_body(r, resp->content_length, target, &total);
+        } else {
+            ok = reader_body(r, -1, target, &total);
+            resp->keep_alive = false;
+        }
+
+        // 缓冲区中有多余数据说明响应格式异常，不复用连接
+        bool keep = ok && resp->keep_alive && r->pos == r->len;
+        free(r);
+        conn_release(c, keep);
+        return ok;
+    }
+    return false;
+}
+
+/**
+ * @brief 根据 Location 计算重定向后的 URL
+ */
+static bool resolve_location(const hf_url_t *base, const char *location, char *out, size_t size) {
+    const char *scheme = base->https ? "https" : "http";
+    int n;
+    if (http_fetch_is_url(location)) {
+        n = snprintf(out, size, "%s", location);
+    } else if (location[0] == '/' && location[1] == '/') {
+        n = snprintf(out, size, "%s:%s", scheme, location);
+    } else if (location[0] == '/') {
+        n = snprintf(out, size, "%s://%s:%d%s", scheme, base->host, base->port, location);
+    } else {
+        return false;
+    }
+    return n > 0 && (size_t)n < size;
+}
+
+/**
+ * @brief 下载 URL（跟随重定向）
+ * @param url URL
+ * @param etag 条件请求的 ETag，可为 NULL
+ * @param meta 输出：200 时填写内容哈希和 ETag
+ * @param tmp 输出：200 时为下载内容所在的临时文件，由调用方登记或删除
+ * @return HTTP 状态码（200/304/...），网络错误返回 -1
+ */
+static int fetch_url(const char *url, const char *etag, hf_meta_t *meta, char tmp[PATH_MAX]) {
+    char current[HF_URL_MAX];
+    snprintf(current, sizeof(current), "%s", url);
+
+    for (int hop = 0; hop <= HF_MAX_REDIRECTS; hop++) {
+        hf_url_t u;
+        if (!parse_url(current, &u)) {
+            printf("[http] Invalid URL: %s\n", current);
+            return -1;
+        }
+
+        hf_sink_t sink;
+        snprintf(tmp, PATH_MAX, "%s/blobs/.tmp-XXXXXX", cache_dir_buf);
+        sink.fd = mkstemp(tmp);
+        sink.md = EVP_MD_CTX_new();
+        sink.size = 0;
+        if (sink.fd < 0 || sink.md == NULL || EVP_DigestInit_ex(sink.md, EVP_sha256(), NULL) != 1) {
+            if (sink.fd >= 0) {
+                close(sink.fd);
+                unlink(tmp);
+            }
+            EVP_MD_CTX_free(sink.md);
+            return -1;
+        }
+
+        // 重定向后的地址不使用原 URL 的 ETag
+        hf_response_t resp;
+        bool ok = do_get(&u, hop == 0 ? etag : NULL, &sink, &resp);
+        bool write_ok = close(sink.fd) == 0;
+
+        if (ok && write_ok && resp.status == 200) {
+            unsigned char md[EVP_MAX_MD_SIZE];
+            unsigned int md_len = 0;
+            EVP_DigestFinal_ex(sink.md, md, &md_len);
+            EVP_MD_CTX_free(sink.md);
+            for (unsigned int i = 0; i < md_len && i < 32; i++) {
+                sprintf(meta->blob + i * 2, "%02x", md[i]);
+            }
+            snprintf(meta->etag, sizeof(meta->etag), "%s", resp.etag);
+            return 200;
+        }
+
+        EVP_MD_CTX_free(sink.md);
+        unlink(tmp);
+        if (!ok || !write_ok) {
+            return -1;
+        }
+
+        if (resp.status >= 300 && resp.status < 400 && resp.status != 304 && resp.location[0] != '\0') {
+            char next[HF_URL_MAX];
+            if (!resolve_location(&u, resp.location, next, sizeof(next))) {
+                return -1;
+            }
+            snprintf(current, sizeof(current), "%s", next);
+            continue;
+        }
+        return resp.status;
+    }
+
+    printf("[http] Too many redirects: %s\n", url);
+    return -1;
+}
+
+/*=====================
+ * 公共接口
+ *====================*/
+
+bool http_fetch_init(const char *cache_dir, size_t max_bytes) {
+    if (initialized) {
+        return true;
+    }
+
+    if (cache_dir == NULL) {
+        cache_dir = HTTP_FETCH_DEFAULT_DIR;
+    }
+    if (strlen(cache_dir) >= sizeof(cache_dir_buf)) {
+        printf("[http] Cache dir path too long: %s\n", cache_dir);
+        return false;
+    }
+    snprintf(cache_dir_buf, sizeof(cache_dir_buf), "%s", cache_dir);
+    cache_limit = max_bytes ? max_bytes : HTTP_FETCH_DEFAULT_LIMIT;
+
+    char path[PATH_MAX];
+    mkdir(cache_dir_buf, 0755);
+    snprintf(path, sizeof(path), "%s/blobs", cache_dir_buf);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/meta", cache_dir_buf);
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+        printf("[http] Cannot create cache dir %s: %s\n", cache_dir_buf, strerror(errno));
+        return false;
+    }
+
+    // 对端关闭连接时 SSL_write 会触发 SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+
+    OPENSSL_init_ssl(0, NULL);
+    ssl_ctx = SSL_CTX_new(TLS_client_method());
+    if (ssl_ctx == NULL) {
+        return false;
+    }
+    SSL_CTX_set_min_proto_version(ssl_ctx, TLS1_2_VERSION);
+    SSL_CTX_set_verify(ssl_ctx, SSL_VERIFY_PEER, NULL);
+    // 使用系统证书（可通过 SSL_CERT_FILE / SSL_CERT_DIR 环境变量指定）
+    if (SSL_CTX_set_default_verify_paths(ssl_ctx) != 1) {
+        printf("[http] Warning: no CA certificates, https downloads will fail\n");
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    cache_bytes = scan_blob_bytes();
+    evict_locked();
+    pthread_mutex_unlock(&cache_lock);
+
+    initialized = true;
+    printf("[http] Cache %s: %zu/%zu bytes\n", cache_dir_buf, cache_bytes, cache_limit);
+    return true;
+}
+
+bool http_fetch_cached_path(const char *url, char *path, size_t size) {
+    hf_meta_t m;
+    struct stat st;
+    if (!initialized || !meta_load(url, &m)) {
+        return false;
+    }
+    blob_path(m.blob, path, size);
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    meta_touch(url);
+    return true;
+}
+
+http_fetch_result_t http_fetch_sync(const char *url, char *path, size_t size) {
+    if (!initialized || !http_fetch_is_url(url) || strlen(url) >= HF_URL_MAX) {
+        return HTTP_FETCH_ERROR;
+    }
+
+    hf_meta_t m;
+    struct stat st;
+    bool have = meta_load(url, &m);
+    if (have) {
+        blob_path(m.blob, path, size);
+        have = stat(path, &st) == 0;
+    }
+
+    long long now = (long long)time(NULL);
+    if (have && now - m.checked >= 0 && now - m.checked < HTTP_FETCH_REVALIDATE_SEC) {
+        meta_touch(url);
+        return HTTP_FETCH_OK;
+    }
+
+    hf_meta_t fresh;
+    char tmp[PATH_MAX];
+    memset(&fresh, 0, sizeof(fresh));
+    int status = fetch_url(url, have ? m.etag : NULL, &fresh, tmp);
+
+    if (status == 304 && have) {
+        m.checked = now;
+        meta_store(url, &m);
+        return HTTP_FETCH_OK;
+    }
+
+    if (status == 200) {
+        fresh.checked = now;
+        blob_path(fresh.blob, path, size);
+        pthread_mutex_lock(&cache_lock);
+        bool ok = commit_locked(url, tmp, &fresh);
+        if (ok) {
+            evict_locked();
+        }
+        pthread_mutex_unlock(&cache_lock);
+
+        // 淘汰可能删除了刚下载的内容（缓存上限小于单个文件时）
+        return ok && stat(path, &st) == 0 ? HTTP_FETCH_OK : HTTP_FETCH_ERROR;
+    }
+
+    if (have) {
+        // 离线或服务器错误时沿用旧内容
+        printf("[http] Using cached copy of %s (status %d)\n", url, status);
+        meta_touch(url);
+        return HTTP_FETCH_CACHED;
+    }
+
+    printf("[http] Fetch failed (status %d): %s\n", status, url);
+    return HTTP_FETCH_ERROR;
+}
+
+void http_fetch_deinit(void) {
+    if (!initialized) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    hf_conn_t *c = idle_conns;
+    idle_conns = NULL;
+    idle_count = 0;
+    pthread_mutex_unlock(&pool_lock);
+    while (c != NULL) {
+        hf_conn_t *next = c->next;
+        conn_close(c);
+        c = next;
+    }
+
+    SSL_CTX_free(ssl_ctx);
+    ssl_ctx = NULL;
+    initialized = false;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file http_fetch.h
+ * @brief HTTP(S) 资源下载与磁盘缓存头文件
+ *
+ * 通过 OpenSSL 下载 http:// 和 https:// 资源，连接按主机复用（keep-alive），
+ * 可以在多个线程中同时下载。下载内容按 SHA-256 保存为内容寻址的缓存文件，
+ * URL 元数据记录 ETag，过期后用 If-None-Match 重新验证；网络不可用时直接使用缓存。
+ * 缓存总大小超过上限时按最近使用时间淘汰。
+ *
+ * 接口线程安全，下载是阻塞的，应在工作线程（如视觉小说预取线程）中调用。
+ */
+
+#ifndef HTTP_FETCH_H
+#define HTTP_FETCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define HTTP_FETCH_DEFAULT_DIR      "/mnt/app/.http_cache"
+#define HTTP_FETCH_DEFAULT_LIMIT    (64 * 1024 * 1024)  /**< 默认缓存上限（字节） */
+#define HTTP_FETCH_MAX_BODY         (16 * 1024 * 1024)  /**< 单个资源大小上限 */
+#define HTTP_FETCH_REVALIDATE_SEC   (24 * 3600)         /**< 缓存多久后重新验证 */
+
+/**
+ * @brief 下载结果
+ */
+typedef enum {
+    HTTP_FETCH_OK = 0,          /**< 已下载或已验证 */
+    HTTP_FETCH_CACHED,          /**< 使用缓存（未联网验证或网络失败） */
+    HTTP_FETCH_ERROR            /**< 失败 */
+} http_fetch_result_t;
+
+/**
+ * @brief 初始化下载服务
+ * @param cache_dir 缓存目录，NULL 使用默认目录
+ * @param max_bytes 缓存上限，0 使用默认值
+ * @return 是否成功
+ */
+bool http_fetch_init(const char *cache_dir, size_t max_bytes);
+
+/**
+ * @brief 判断字符串是否为 http:// 或 https:// URL
+ */
+bool http_fetch_is_url(const char *s);
+
+/**
+ * @brief 查询缓存（不联网）
+ * @param url URL
+ * @param path 输出本地文件路径
+ * @param size 缓冲区大小
+ * @return 是否命中
+ */
+bool http_fetch_cached_path(const char *url, char *path, size_t size);
+
+/**
+ * @brief 同步获取资源（阻塞，可在任意线程调用）
+ *
+ * 缓存未过期时直接返回；过期时发送条件请求，304 时沿用缓存；
+ * 网络失败但有缓存时返回 HTTP_FETCH_CACHED。
+ * @param url URL
+ * @param path 输出本地文件路径
+ * @param size 缓冲区大小
+ * @return 下载结果
+ */
+http_fetch_result_t http_fetch_sync(const char *url, char *path, size_t size);
+
+/**
+ * @brief 关闭所有连接
+ */
+void http_fetch_deinit(void);
+
+#endif /* HTTP_FETCH_H */
@@ -0,0 +1,265 @@
+/**
+ * @file img_decode.c
+ * @brief 基于 FFmpeg 的图片解码实现
+ *
+ * 流程：选择内嵌封面流（AV_DISPOSITION_ATTACHED_PIC）或第一个视频流，
+ * 取得第一个数据包后再打开解码器，这样 JPEG 可以先从包头解析原始尺寸，
+ * 按目标尺寸设置 lowres（1/2、1/4、1/8 解码），最后用 swscale 缩放到输出格式。
+ * 不调用 avformat_find_stream_info，避免为探测格式额外解码一帧。
+ */
+
+#include "img_decode.h"
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IMG_DECODE_MAX_PACKETS  64  /**< 视频首帧最多读取的数据包数 */
+
+int img_decode_bpp(lv_color_format_t cf) {
+    return cf == LV_COLOR_FORMAT_RGB565 ? 2 : 4;
+}
+
+/**
+ * @brief FFmpeg 错误是否由文件内容引起（内存不足、I/O 错误等暂时的失败返回false）
+ */
+static bool content_error(int err) {
+    return err != AVERROR(ENOMEM) && err != AVERROR(EIO) && err != AVERROR(EACCES) &&
+           err != AVERROR(EPERM) && err != AVERROR(EMFILE) && err != AVERROR(ENFILE) &&
+           err != AVERROR(EINTR) && err != AVERROR(EAGAIN) && err != AVERROR(ENOENT) &&
+           err != AVERROR(EBUSY);
+}
+
+void img_decode_free(img_decode_result_t *res) {
+    if (res == NULL) {
+        return;
+    }
+    free(res->data);
+    memset(res, 0, sizeof(*res));
+}
+
+/**
+ * @brief 从 JPEG 数据中解析 SOF 段得到图片尺寸
+ */
+static bool jpeg_dimensions(const uint8_t *d, int size, int *w, int *h) {
+    if (d == NULL || size < 4 || d[0] != 0xFF || d[1] != 0xD8) {
+        return false;
+    }
+
+    int i = 2;
+    while (i + 9 < size) {
+        if (d[i] != 0xFF) {
+            i++;
+            continue;
+        }
+
+        uint8_t m = d[i + 1];
+        if (m == 0xFF) {
+            i++;
+            continue;
+        }
+        if (m == 0x01 || (m >= 0xD0 && m <= 0xD8)) {
+            i += 2;
+            continue;
+        }
+
+        // SOF0~SOF15，排除 DHT(C4)、JPG(C8)、DAC(CC)
+        if (m >= 0xC0 && m <= 0xCF && m != 0xC4 && m != 0xC8 && m != 0xCC) {
+            *h = (d[i + 5] << 8) | d[i + 6];
+            *w = (d[i + 7] << 8) | d[i + 8];
+            return *w > 0 && *h > 0;
+        }
+
+        i += 2 + ((d[i + 2] << 8) | d[i + 3]);
+    }
+    return false;
+}
+
+/**
+ * @brief 读取所选流的第一个数据包
+ */
+static bool read_first_packet(AVFormatContext *fmt, int stream, AVPacket *pkt) {
+    while (av_read_frame(fmt, pkt) >= 0) {
+        if (pkt->stream_index == stream) {
+            return true;
+        }
+        av_packet_unref(pkt);
+    }
+    return false;
+}
+
+/**
+ * @brief 解码出第一帧
+ */
+static bool decode_first_frame(AVFormatContext *fmt, int stream, AVCodecContext *ctx,
+                               AVPacket *pkt, bool single_packet, AVFrame *frame) {
+    int sent = 0;
+    bool have_pkt = true;
+
+    while (sent < IMG_DECODE_MAX_PACKETS) {
+        if (have_pkt) {
+            int ret = avcodec_send_packet(ctx, pkt);
+            av_packet_unref(pkt);
+            if (ret < 0 && ret != AVERROR(EAGAIN)) {
+                return false;
+            }
+            sent++;
+        }
+
+        if (avcodec_receive_frame(ctx, frame) == 0) {
+            return true;
+        }
+
+        if (single_packet || fmt == NULL) {
+            break;
+        }
+        have_pkt = read_first_packet(fmt, stream, pkt);
+        if (!have_pkt) {
+            break;
+        }
+    }
+
+    // 刷新解码器，取出缓存的帧
+    avcodec_send_packet(ctx, NULL);
+    return avcodec_receive_frame(ctx, frame) == 0;
+}
+
+bool img_decode_file(const char *path, int max_w, int max_h, lv_color_format_t cf, img_decode_result_t *out) {
+    if (path == NULL || out == NULL) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+
+    AVFormatContext *fmt = NULL;
+    AVCodecContext *ctx = NULL;
+    AVPacket *pkt = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    struct SwsContext *sws = NULL;
+    bool ok = false;
+    bool permanent = false;     // 失败原因与文件内容有关（只在对应的分支中设置）
+
+    if (pkt == NULL || frame == NULL) {
+        goto cleanup;
+    }
+    int err = avformat_open_input(&fmt, path, NULL, NULL);
+    if (err != 0) {
+        permanent = content_error(err);
+        goto cleanup;
+    }
+
+    // 优先使用内嵌封面（音频文件的专辑图）
+    int stream = -1;
+    bool attached = false;
+    for (unsigned i = 0; i < fmt->nb_streams; i++) {
+        if (fmt->streams[i]->disposition & AV_DISPOSITION_ATTACHED_PIC) {
+            stream = (int)i;
+            attached = true;
+            break;
+        }
+    }
+    if (stream < 0) {
+        stream = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    }
+    if (stream < 0) {
+        permanent = true;
+        goto cleanup;
+    }
+
+    AVStream *st = fmt->streams[stream];
+    if (attached) {
+        if (av_packet_ref(pkt, &st->attached_pic) < 0) {
+            goto cleanup;
+        }
+    } else if (!read_first_packet(fmt, stream, pkt)) {
+        permanent = true;
+        goto cleanup;
+    }
+
+    const AVCodec *codec = avcodec_find_decoder(st->codecpar->codec_id);
+    if (codec == NULL) {
+        permanent = true;
+        goto cleanup;
+    }
+    ctx = avcodec_alloc_context3(codec);
+    if (ctx == NULL || avcodec_parameters_to_context(ctx, st->codecpar) < 0) {
+        goto cleanup;
+    }
+    ctx->thread_count = 1;
+
+    // 解码阶段降采样：选择不小于目标尺寸的最大 lowres 级别
+    int src_w = st->codecpar->width;
+    int src_h = st->codecpar->height;
+    if (src_w <= 0 || src_h <= 0) {
+        jpeg_dimensions(pkt->data, pkt->size, &src_w, &src_h);
+    }
+    if (codec->max_lowres > 0 && max_w > 0 && max_h > 0 && src_w > 0 && src_h > 0) {
+        int lowres = 0;
+        while (lowres < codec->max_lowres &&
+               (src_w >> (lowres + 1)) >= max_w && (src_h >> (lowres + 1)) >= max_h) {
+            lowres++;
+        }
+        ctx->lowres = lowres;
+    }
+
+    err = avcodec_open2(ctx, codec, NULL);
+    if (err < 0) {
+        permanent = content_error(err);
+        goto cleanup;
+    }
+    if (!decode_first_frame(attached ? NULL : fmt, stream, ctx, pkt, attached, frame)) {
+        permanent = true;
+        goto cleanup;
+    }
+
+    // 保持宽高比缩放到目标范围内，不放大
+    int dst_w = frame->width;
+    int dst_h = frame->height;
+    if (max_w > 0 && dst_w > max_w) {
+        dst_h = (int)((int64_t)dst_h * max_w / dst_w);
+        dst_w = max_w;
+    }
+    if (max_h > 0 && dst_h > max_h) {
+        dst_w = (int)((int64_t)dst_w * max_h / dst_h);
+        dst_h = max_h;
+    }
+    if (dst_w < 1) dst_w = 1;
+    if (dst_h < 1) dst_h = 1;
+
+    enum AVPixelFormat dst_fmt = (cf == LV_COLOR_FORMAT_RGB565) ? AV_PIX_FMT_RGB565LE : AV_PIX_FMT_BGRA;
+    sws = sws_getContext(frame->width, frame->height, (enum AVPixelFormat)frame->format,
+                         dst_w, dst_h, dst_fmt, SWS_AREA, NULL, NULL, NULL);
+    if (sws == NULL) {
+        goto cleanup;
+    }
+
+    int bpp = img_decode_bpp(cf);
+    out->stride = dst_w * bpp;
+    out->data = malloc((size_t)out->stride * dst_h);
+    if (out->data == NULL) {
+        goto cleanup;
+    }
+
+    uint8_t *dst_data[4] = { out->data, NULL, NULL, NULL };
+    int dst_linesize[4] = { out->stride, 0, 0, 0 };
+    sws_scale(sws, (const uint8_t *const *)frame->data, frame->linesize, 0, frame->height, dst_data, dst_linesize);
+
+    out->w = dst_w;
+    out->h = dst_h;
+    out->cf = (cf == LV_COLOR_FORMAT_RGB565) ? LV_COLOR_FORMAT_RGB565 : LV_COLOR_FORMAT_ARGB8888;
+    ok = true;
+
+cleanup:
+    if (!ok) {
+        img_decode_free(out);
+        out->permanent = permanent;
+    }
+    sws_freeContext(sws);
+    avcodec_free_context(&ctx);
+    avformat_close_input(&fmt);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    return ok;
+}
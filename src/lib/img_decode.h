@@ -0,0 +1,50 @@
+/**
+ * @file img_decode.h
+ * @brief 基于 FFmpeg 的图片解码头文件
+ *
+ * 将图片文件、音频内嵌封面或视频首帧解码为 LVGL 可直接显示的像素数据。
+ * 解码时按目标尺寸缩放（JPEG 等支持 lowres 的解码器直接在解码阶段降采样），
+ * 只使用 FFmpeg 和 libc，不调用 LVGL 接口，可以在后台线程中使用。
+ */
+
+#ifndef IMG_DECODE_H
+#define IMG_DECODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lvgl/lvgl.h"
+
+/**
+ * @brief 解码结果
+ */
+typedef struct {
+    uint8_t *data;          /**< 像素数据（malloc 分配） */
+    int w;                  /**< 宽度 */
+    int h;                  /**< 高度 */
+    int stride;             /**< 每行字节数 */
+    lv_color_format_t cf;   /**< 颜色格式：RGB565 或 ARGB8888 */
+    bool permanent;         /**< 解码失败时：文件内容无法解码（格式不支持、没有图片、数据损坏），重试不会成功 */
+} img_decode_result_t;
+
+/**
+ * @brief 解码图片
+ * @param path 文件路径（图片、带封面的音频或视频）
+ * @param max_w 最大宽度，<=0 表示不限制
+ * @param max_h 最大高度，<=0 表示不限制
+ * @param cf 输出格式，LV_COLOR_FORMAT_RGB565 或 LV_COLOR_FORMAT_ARGB8888
+ * @param out 输出结果
+ * @return 解码是否成功
+ */
+bool img_decode_file(const char *path, int max_w, int max_h, lv_color_format_t cf, img_decode_result_t *out);
+
+/**
+ * @brief 释放解码结果中的像素数据
+ */
+void img_decode_free(img_decode_result_t *res);
+
+/**
+ * @brief 计算输出格式每像素字节数
+ */
+int img_decode_bpp(lv_color_format_t cf);
+
+#endif /* IMG_DECODE_H */
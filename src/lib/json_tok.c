@@ -0,0 +1,722 @@
+/**
+ * @file json_tok.c
+ * @brief 原地（in-situ）JSON 解析器实现
+ *
+ * 解析分两遍：第一遍跳过字符串统计结构字符，得到 token 数上限，一次分配 token 数组；
+ * 第二遍用显式栈（不递归）生成 token，字符串在原缓冲区中解码并以 '\0' 结尾。
+ * 浅层扫描不生成 token，只配对引号和括号，用于快速定位大文档中的子对象。
+ */
+
+#include "json_tok.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define JSON_BLOCK_MIN  (16 * 1024)     /**< 内存池块最小大小 */
+
+/*=====================
+ * 内存池
+ *====================*/
+
+void *json_arena_alloc(json_doc_t *doc, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    if (size == 0) {
+        size = 8;
+    }
+
+    json_block_t *b = doc->blocks;
+    if (b == NULL || b->size - b->used < size) {
+        size_t block_size = size > JSON_BLOCK_MIN ? size : JSON_BLOCK_MIN;
+        b = (json_block_t *)malloc(sizeof(json_block_t) + block_size);
+        if (b == NULL) {
+            return NULL;
+        }
+        b->used = 0;
+        b->size = block_size;
+
+        // 大块放在链表第二位，当前块剩余空间继续用于小分配
+        if (doc->blocks != NULL && block_size == size) {
+            b->next = doc->blocks->next;
+            doc->blocks->next = b;
+        } else {
+            b->next = doc->blocks;
+            doc->blocks = b;
+        }
+    }
+
+    // json_block_t 大小为8的倍数，数据区保持8字节对齐
+    char *p = (char *)(b + 1) + b->used;
+    b->used += size;
+    memset(p, 0, size);
+    return p;
+}
+
+char *json_arena_strdup(json_doc_t *doc, const char *s) {
+    size_t len = strlen(s) + 1;
+    char *p = (char *)json_arena_alloc(doc, len);
+    if (p != NULL) {
+        memcpy(p, s, len);
+    }
+    return p;
+}
+
+void json_free(json_doc_t *doc) {
+    if (doc == NULL) {
+        return;
+    }
+    json_block_t *b = doc->blocks;
+    while (b != NULL) {
+        json_block_t *next = b->next;
+        free(b);
+        b = next;
+    }
+    memset(doc, 0, sizeof(*doc));
+}
+
+/*=====================
+ * 解析
+ *====================*/
+
+uint32_t json_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static const char *skip_ws(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static long read_hex4(const char *p) {
+    long v = 0;
+    for (int i = 0; i < 4; i++) {
+        int h = hex_value(p[i]);
+        if (h < 0) {
+            return -1;
+        }
+        v = (v << 4) | h;
+    }
+    return v;
+}
+
+static char *put_utf8(char *dst, unsigned long cp) {
+    if (cp < 0x80) {
+        *dst++ = (char)cp;
+    } else if (cp < 0x800) {
+        *dst++ = (char)(0xC0 | (cp >> 6));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *dst++ = (char)(0xE0 | (cp >> 12));
+        *dst++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *dst++ = (char)(0xF0 | (cp >> 18));
+        *dst++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *dst++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return dst;
+}
+
+/**
+ * @brief 原地解码字符串（p 指向开头的引号），解码结果不会比原文长
+ * @return 结束引号之后的位置，格式错误返回NULL
+ */
+static char *parse_string(char *buf, char *p, json_tok_t *t) {
+    char *src = p + 1;
+    char *dst = src;
+    t->type = JSON_STRING;
+    t->start = (uint32_t)(src - buf);
+
+    for (;;) {
+        unsigned char c = (unsigned char)*src;
+        if (c == '"') {
+            break;
+        }
+        if (c < 0x20) {
+            return NULL;    // 控制字符或缓冲区结尾
+        }
+        if (c != '\\') {
+            *dst++ = *src++;
+            continue;
+        }
+
+        src++;
+        switch (*src++) {
+            case '"':  *dst++ = '"';  break;
+            case '\\': *dst++ = '\\'; break;
+            case '/':  *dst++ = '/';  break;
+            case 'b':  *dst++ = '\b'; break;
+            case 'f':  *dst++ = '\f'; break;
+            case 'n':  *dst++ = '\n'; break;
+            case 'r':  *dst++ = '\r'; break;
+            case 't':  *dst++ = '\t'; break;
+            case 'u': {
+                long cp = read_hex4(src);
+                if (cp < 0) {
+                    return NULL;
+                }
+                src += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // 代理对
+                    long lo = (src[0] == '\\' && src[1] == 'u') ? read_hex4(src + 2) : -1;
+                    if (lo < 0xDC00 || lo > 0xDFFF) {
+                        return NULL;
+                    }
+                    src += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return NULL;
+                }
+                dst = put_utf8(dst, (unsigned long)cp);
+                break;
+            }
+            default:
+                return NULL;
+        }
+    }
+
+    *dst = '\0';
+    t->len = (uint32_t)(dst - (buf + t->start));
+    t->hash = json_hash(buf + t->start, t->len);
+    return src + 1;
+}
+
+/**
+ * @brief 校验数字格式：-?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+static const char *scan_number(const char *p) {
+    if (*p == '-') {
+        p++;
+    }
+    if (*p == '0') {
+        p++;
+    } else if (*p >= '1' && *p <= '9') {
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    } else {
+        return NULL;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p < '0' || *p > '9') {
+            return NULL;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-') {
+            p++;
+        }
+        if (*p < '0' || *p > '9') {
+            return NULL;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    return p;
+}
+
+/**
+ * @brief 统计 token 数上限：除根以外，每个值或键前面都有一个 '[' '{' ',' ':'
+ */
+static size_t count_tokens(const char *p, const char *end) {
+    size_t n = 1;
+    while (p < end) {
+        char c = *p++;
+        if (c == '"') {
+            while (p < end && *p != '"') {
+                p += (*p == '\\') ? 2 : 1;
+            }
+            p++;
+        } else if (c == ',' || c == ':' || c == '[' || c == '{') {
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief 报告语法错误位置（字符串已原地解码，行号不再准确，因此报告字节偏移）
+ */
+static void report_error(const char *buf, const char *at) {
+    printf("[json] 语法错误：偏移 %lu 处\n", (unsigned long)(at - buf));
+}
+
+/**
+ * @brief 解析已放入内存池的文本（buf[len] 可写）
+ */
+static bool parse_buffer(json_doc_t *doc, char *buf, size_t len) {
+    if (len >= UINT32_MAX) {
+        return false;
+    }
+    buf[len] = '\0';
+    doc->buf = buf;
+    doc->buf_len = len;
+
+    size_t max = count_tokens(buf, buf + len);
+    json_tok_t *toks = (json_tok_t *)json_arena_alloc(doc, sizeof(json_tok_t) * max);
+    if (toks == NULL) {
+        return false;
+    }
+    doc->toks = toks;
+
+    uint32_t stack[JSON_MAX_DEPTH];
+    int depth = 0;
+    uint32_t count = 0;
+    bool need_key = false;
+    char *p = buf;
+
+    for (;;) {
+        p = (char *)skip_ws(p);
+
+        // 对象成员：先解析键
+        if (need_key) {
+            if (*p != '"' || count >= max) {
+                goto fail;
+            }
+            json_tok_t *key = &toks[count];
+            key->next = count + 1;
+            count++;
+            toks[stack[depth - 1]].size++;
+            char *at = p;
+            p = parse_string(buf, p, key);
+            if (p == NULL) {
+                p = at;
+                goto fail;
+            }
+            p = (char *)skip_ws(p);
+            if (*p != ':') {
+                goto fail;
+            }
+            p = (char *)skip_ws(p + 1);
+            need_key = false;
+        } else if (depth > 0) {
+            toks[stack[depth - 1]].size++;   // 数组元素
+        }
+
+        if (count >= max) {
+            goto fail;
+        }
+        uint32_t idx = count++;
+        json_tok_t *t = &toks[idx];
+        t->start = (uint32_t)(p - buf);
+        t->next = idx + 1;
+
+        switch (*p) {
+            case '{':
+            case '[':
+                if (depth >= JSON_MAX_DEPTH) {
+                    goto fail;
+                }
+                t->type = (*p == '{') ? JSON_OBJECT : JSON_ARRAY;
+                stack[depth++] = idx;
+                p = (char *)skip_ws(p + 1);
+                if (*p == (t->type == JSON_OBJECT ? '}' : ']')) {
+                    depth--;
+                    p++;
+                    break;
+                }
+                need_key = t->type == JSON_OBJECT;
+                continue;
+
+            case '"': {
+                char *at = p;
+                p = parse_string(buf, p, t);
+                if (p == NULL) {
+                    p = at;
+                    goto fail;
+                }
+                break;
+            }
+
+            case 't':
+                if (strncmp(p, "true", 4) != 0) {
+                    goto fail;
+                }
+                t->type = JSON_TRUE;
+                p += 4;
+                break;
+
+            case 'f':
+                if (strncmp(p, "false", 5) != 0) {
+                    goto fail;
+                }
+                t->type = JSON_FALSE;
+                p += 5;
+                break;
+
+            case 'n':
+                if (strncmp(p, "null", 4) != 0) {
+                    goto fail;
+                }
+                t->type = JSON_NULL;
+                p += 4;
+                break;
+
+            default: {
+                const char *end = scan_number(p);
+                if (end == NULL) {
+                    goto fail;
+                }
+                t->type = JSON_NUMBER;
+                t->len = (uint32_t)(end - p);
+                p = (char *)end;
+                break;
+            }
+        }
+
+        // 值结束：处理逗号和容器结尾
+        for (;;) {
+            p = (char *)skip_ws(p);
+            if (depth == 0) {
+                if (p != buf + len) {
+                    goto fail;
+                }
+                doc->count = count;
+                return true;
+            }
+
+            json_tok_t *top = &toks[stack[depth - 1]];
+            if (*p == ',') {
+                p++;
+                need_key = top->type == JSON_OBJECT;
+                break;
+            }
+            if (*p == (top->type == JSON_OBJECT ? '}' : ']')) {
+                p++;
+                top->next = count;
+                depth--;
+                continue;
+            }
+            goto fail;
+        }
+    }
+
+fail:
+    report_error(buf, p);
+    return false;
+}
+
+bool json_parse(json_doc_t *doc, const char *text, size_t len) {
+    memset(doc, 0, sizeof(*doc));
+    char *buf = (char *)json_arena_alloc(doc, len + 1);
+    if (buf == NULL) {
+        return false;
+    }
+    memcpy(buf, text, len);
+    if (!parse_buffer(doc, buf, len)) {
+        json_free(doc);
+        return false;
+    }
+    return true;
+}
+
+bool json_parse_file(json_doc_t *doc, const char *path) {
+    memset(doc, 0, sizeof(*doc));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0 || st.st_size < 0) {
+        fclose(f);
+        return false;
+    }
+    size_t len = (size_t)st.st_size;
+    char *buf = (char *)json_arena_alloc(doc, len + 1);
+    bool ok = buf != NULL && fread(buf, 1, len, f) == len;
+    fclose(f);
+
+    if (!ok || !parse_buffer(doc, buf, len)) {
+        if (ok) {
+            printf("[json] 解析失败: %s\n", path);
+        }
+        json_free(doc);
+        return false;
+    }
+    return true;
+}
+
+/*=====================
+ * 浅层扫描
+ *====================*/
+
+const char *json_skip_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief 跳过字符串（p 指向开头的引号）
+ * @return 结束引号之后的位置，没有结束引号返回NULL
+ */
+static const char *skip_string(const char *p, const char *end) {
+    p++;
+    for (;;) {
+        const char *q = (const char *)memchr(p, '"', (size_t)(end - p));
+        if (q == NULL) {
+            return NULL;
+        }
+        // 前面有奇数个反斜杠时引号是转义的
+        const char *b = q;
+        while (b > p && b[-1] == '\\') {
+            b--;
+        }
+        p = q + 1;
+        if (((q - b) & 1) == 0) {
+            return p;
+        }
+    }
+}
+
+const char *json_skip(const char *p, const char *end) {
+    p = json_skip_ws(p, end);
+    if (p >= end) {
+        return NULL;
+    }
+    if (*p == '"') {
+        return skip_string(p, end);
+    }
+
+    // 数字或字面量：到下一个分隔符为止
+    if (*p != '{' && *p != '[') {
+        const char *start = p;
+        while (p < end && *p != ',' && *p != ':' && *p != ']' && *p != '}' &&
+               *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' && *p != '"') {
+            p++;
+        }
+        return p > start ? p : NULL;
+    }
+
+    // 容器：只关心引号和括号，其它字符直接跳过
+    char stack[JSON_MAX_DEPTH];
+    int depth = 0;
+    do {
+        while (p < end && *p != '"' && *p != '{' && *p != '[' && *p != '}' && *p != ']') {
+            p++;
+        }
+        if (p >= end) {
+            return NULL;
+        }
+        char c = *p;
+        if (c == '"') {
+            p = skip_string(p, end);
+            if (p == NULL) {
+                return NULL;
+            }
+        } else if (c == '{' || c == '[') {
+            if (depth >= JSON_MAX_DEPTH) {
+                return NULL;
+            }
+            stack[depth++] = (c == '{') ? '}' : ']';
+            p++;
+        } else {
+            if (stack[depth - 1] != c) {
+                return NULL;
+            }
+            depth--;
+            p++;
+        }
+    } while (depth > 0);
+    return p;
+}
+
+/**
+ * @brief 跳到容器的下一个成员：跳过空白和分隔的逗号
+ * @return 1 有成员，0 遇到容器结尾（已跳过），-1 格式错误
+ */
+static int scan_next(const char **p, const char *end, char close) {
+    const char *q = json_skip_ws(*p, end);
+    if (q < end && *q == ',') {
+        q = json_skip_ws(q + 1, end);
+    }
+    if (q >= end) {
+        return -1;
+    }
+    if (*q == close) {
+        *p = q + 1;
+        return 0;
+    }
+    *p = q;
+    return 1;
+}
+
+int json_scan_member(const char **p, const char *end, const char **key, size_t *key_len,
+                     const char **value, const char **value_end) {
+    int r = scan_next(p, end, '}');
+    if (r <= 0) {
+        return r;
+    }
+
+    const char *q = *p;
+    if (*q != '"') {
+        return -1;
+    }
+    const char *key_end = skip_string(q, end);
+    if (key_end == NULL) {
+        return -1;
+    }
+    *key = q + 1;
+    *key_len = (size_t)(key_end - q - 2);
+
+    q = json_skip_ws(key_end, end);
+    if (q >= end || *q != ':') {
+        return -1;
+    }
+    *value = json_skip_ws(q + 1, end);
+    *value_end = json_skip(*value, end);
+    if (*value_end == NULL) {
+        return -1;
+    }
+    *p = *value_end;
+    return 1;
+}
+
+int json_scan_element(const char **p, const char *end, const char **value, const char **value_end) {
+    int r = scan_next(p, end, ']');
+    if (r <= 0) {
+        return r;
+    }
+    *value = *p;
+    *value_end = json_skip(*value, end);
+    if (*value_end == NULL) {
+        return -1;
+    }
+    *p = *value_end;
+    return 1;
+}
+
+char *json_arena_string(json_doc_t *doc, const char *p, const char *end) {
+    if (p >= end || *p != '"') {
+        return NULL;
+    }
+    const char *q = skip_string(p, end);
+    if (q == NULL) {
+        return NULL;
+    }
+
+    // 复制原文（含引号）后原地解码，解码结果不会比原文长
+    size_t len = (size_t)(q - p);
+    char *buf = (char *)json_arena_alloc(doc, len + 1);
+    if (buf == NULL) {
+        return NULL;
+    }
+    memcpy(buf, p, len);
+    json_tok_t t;
+    if (parse_string(buf, buf, &t) != buf + len) {
+        return NULL;
+    }
+    return buf + 1;
+}
+
+/*=====================
+ * 访问
+ *====================*/
+
+static const json_tok_t *get_tok(const json_doc_t *doc, int tok) {
+    return (tok >= 0 && (uint32_t)tok < doc->count) ? &doc->toks[tok] : NULL;
+}
+
+json_type_t json_type(const json_doc_t *doc, int tok) {
+    const json_tok_t *t = get_tok(doc, tok);
+    return t ? (json_type_t)t->type : JSON_NULL;
+}
+
+int json_find(const json_doc_t *doc, int obj, json_key_t *key) {
+    const json_tok_t *t = get_tok(doc, obj);
+    if (t == NULL || t->type != JSON_OBJECT) {
+        return -1;
+    }
+    if (key->hash == 0) {
+        key->hash = json_hash(key->name, strlen(key->name));
+    }
+
+    uint32_t k = (uint32_t)obj + 1;
+    for (uint32_t i = 0; i < t->size; i++) {
+        const json_tok_t *kt = &doc->toks[k];
+        if (kt->hash == key->hash && strcmp(doc->buf + kt->start, key->name) == 0) {
+            return (int)k + 1;
+        }
+        k = doc->toks[k + 1].next;
+    }
+    return -1;
+}
+
+int json_first(const json_doc_t *doc, int arr) {
+    const json_tok_t *t = get_tok(doc, arr);
+    return (t != NULL && t->type == JSON_ARRAY && t->size > 0) ? arr + 1 : -1;
+}
+
+int json_next(const json_doc_t *doc, int arr, int tok) {
+    const json_tok_t *a = get_tok(doc, arr);
+    const json_tok_t *t = get_tok(doc, tok);
+    if (a == NULL || t == NULL || t->next >= a->next) {
+        return -1;
+    }
+    return (int)t->next;
+}
+
+int json_size(const json_doc_t *doc, int tok) {
+    const json_tok_t *t = get_tok(doc, tok);
+    return (t != NULL && (t->type == JSON_ARRAY || t->type == JSON_OBJECT)) ? (int)t->size : 0;
+}
+
+const char *json_string(const json_doc_t *doc, int tok, const char *def) {
+    const json_tok_t *t = get_tok(doc, tok);
+    return (t != NULL && t->type == JSON_STRING) ? doc->buf + t->start : def;
+}
+
+double json_number(const json_doc_t *doc, int tok, double def) {
+    const json_tok_t *t = get_tok(doc, tok);
+    // 数字后面总是分隔符或字符串结尾，strtod 会在数字末尾停止
+    return (t != NULL && t->type == JSON_NUMBER) ? strtod(doc->buf + t->start, NULL) : def;
+}
+
+bool json_bool(const json_doc_t *doc, int tok, bool def) {
+    const json_tok_t *t = get_tok(doc, tok);
+    if (t == NULL || (t->type != JSON_TRUE && t->type != JSON_FALSE)) {
+        return def;
+    }
+    return t->type == JSON_TRUE;
+}
+
+const char *json_get_string(const json_doc_t *doc, int obj, json_key_t *key, const char *def) {
+    return json_string(doc, json_find(doc, obj, key), def);
+}
+
+double json_get_number(const json_doc_t *doc, int obj, json_key_t *key, double def) {
+    return json_number(doc, json_find(doc, obj, key), def);
+}
+
+bool json_get_bool(const json_doc_t *doc, int obj, json_key_t *key, bool def) {
+    return json_bool(doc, json_find(doc, obj, key), def);
+}
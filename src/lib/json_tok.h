@@ -0,0 +1,224 @@
+/**
+ * @file json_tok.h
+ * @brief 原地（in-situ）JSON 解析器头文件
+ *
+ * 把 JSON 文本解析为扁平的 token 数组，token 只记录在原缓冲区中的偏移，
+ * 不为每个值分配内存。字符串在缓冲区中原地解码转义（含 \uXXXX 和代理对）
+ * 并以 '\0' 结尾，可以直接作为 C 字符串使用，生命周期与文档相同。
+ * 文档的缓冲区、token 数组和调用方通过 json_arena_alloc 申请的内存都来自
+ * 同一个内存池，json_free 一次释放。
+ *
+ * 对象成员按键的哈希值查找，常用键可以用 JSON_KEY 预先计算哈希。
+ * 不调用 LVGL 接口，可在任意线程使用（同一文档不能被多个线程同时修改）。
+ */
+
+#ifndef JSON_TOK_H
+#define JSON_TOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JSON_MAX_DEPTH  64      /**< 最大嵌套深度 */
+
+/**
+ * @brief JSON 值类型
+ */
+typedef enum {
+    JSON_NULL = 0,
+    JSON_FALSE,
+    JSON_TRUE,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} json_type_t;
+
+/**
+ * @brief token：一个值（或对象的键）
+ */
+typedef struct {
+    uint32_t type;      /**< json_type_t */
+    uint32_t start;     /**< 在缓冲区中的起始偏移（字符串为解码后的内容） */
+    uint32_t len;       /**< 字符串为解码后的字节数，数字为文本长度 */
+    uint32_t size;      /**< 数组元素数或对象成员数 */
+    uint32_t next;      /**< 跳过该值（含所有子值）后的下一个 token 下标 */
+    uint32_t hash;      /**< 字符串的哈希值（用于按键查找） */
+} json_tok_t;
+
+/**
+ * @brief 预先计算哈希的键
+ */
+typedef struct {
+    const char *name;
+    uint32_t hash;
+} json_key_t;
+
+/**
+ * @brief 内存池块
+ */
+typedef struct json_block {
+    struct json_block *next;
+    size_t used;
+    size_t size;
+} json_block_t;
+
+/**
+ * @brief 解析后的文档
+ */
+typedef struct {
+    char *buf;              /**< 原地修改后的 JSON 文本 */
+    size_t buf_len;
+    json_tok_t *toks;       /**< token 数组，0 为根 */
+    uint32_t count;         /**< token 数量 */
+    json_block_t *blocks;   /**< 内存池 */
+} json_doc_t;
+
+/**
+ * @brief 计算字符串哈希（FNV-1a），与 token 中的 hash 一致
+ */
+uint32_t json_hash(const char *s, size_t len);
+
+/**
+ * @brief 初始化预哈希键，例如 static json_key_t k_title = JSON_KEY("title");
+ * 哈希在第一次查找时计算并缓存
+ */
+#define JSON_KEY(name) { name, 0 }
+
+/**
+ * @brief 复制文本到文档内存池后解析
+ * @param doc 文档（输出）
+ * @param text JSON 文本
+ * @param len 文本长度
+ * @return 是否成功
+ */
+bool json_parse(json_doc_t *doc, const char *text, size_t len);
+
+/**
+ * @brief 读取文件并解析
+ * @param doc 文档（输出）
+ * @param path 文件路径
+ * @return 是否成功
+ */
+bool json_parse_file(json_doc_t *doc, const char *path);
+
+/**
+ * @brief 释放文档及其内存池
+ */
+void json_free(json_doc_t *doc);
+
+/**
+ * @brief 从文档内存池分配内存（8字节对齐，随 json_free 一起释放）
+ * @param doc 文档
+ * @param size 字节数
+ * @return 已清零的内存，失败返回NULL
+ */
+void *json_arena_alloc(json_doc_t *doc, size_t size);
+
+/**
+ * @brief 从文档内存池复制字符串
+ */
+char *json_arena_strdup(json_doc_t *doc, const char *s);
+
+/**
+ * @brief 获取值类型，下标无效时返回 JSON_NULL
+ */
+json_type_t json_type(const json_doc_t *doc, int tok);
+
+/**
+ * @brief 按键查找对象成员
+ * @param doc 文档
+ * @param obj 对象 token 下标
+ * @param key 预哈希键
+ * @return 值的 token 下标，未找到或 obj 不是对象时返回-1
+ */
+int json_find(const json_doc_t *doc, int obj, json_key_t *key);
+
+/**
+ * @brief 获取数组的第一个元素，之后用 json_next 遍历
+ * @return 元素下标，空数组或非数组返回-1
+ */
+int json_first(const json_doc_t *doc, int arr);
+
+/**
+ * @brief 获取同一数组中的下一个元素
+ * @param doc 文档
+ * @param arr 数组 token 下标
+ * @param tok 当前元素下标
+ * @return 下一个元素下标，没有时返回-1
+ */
+int json_next(const json_doc_t *doc, int arr, int tok);
+
+/**
+ * @brief 数组元素数或对象成员数，其它类型返回0
+ */
+int json_size(const json_doc_t *doc, int tok);
+
+/**
+ * @brief 字符串值（指向文档缓冲区），非字符串返回 def
+ */
+const char *json_string(const json_doc_t *doc, int tok, const char *def);
+
+/**
+ * @brief 数字值，非数字返回 def
+ */
+double json_number(const json_doc_t *doc, int tok, double def);
+
+/**
+ * @brief 布尔值，非布尔返回 def
+ */
+bool json_bool(const json_doc_t *doc, int tok, bool def);
+
+/**
+ * @brief 按键读取对象中的字符串/数字/布尔值（键不存在或类型不符时返回默认值）
+ */
+const char *json_get_string(const json_doc_t *doc, int obj, json_key_t *key, const char *def);
+double json_get_number(const json_doc_t *doc, int obj, json_key_t *key, double def);
+bool json_get_bool(const json_doc_t *doc, int obj, json_key_t *key, bool def);
+
+/*
+ * 浅层扫描：不生成 token、不解码字符串，只配对引号和括号（不完整校验语法），
+ * 用于在大文档中快速定位子对象，再用 json_parse 解析需要的部分。
+ */
+
+/**
+ * @brief 跳过空白
+ */
+const char *json_skip_ws(const char *p, const char *end);
+
+/**
+ * @brief 跳过一个值（可以有前导空白）
+ * @param p 值的开头
+ * @param end 文本结尾
+ * @return 值之后的位置，引号或括号不匹配时返回NULL
+ */
+const char *json_skip(const char *p, const char *end);
+
+/**
+ * @brief 读取对象的下一个成员
+ * @param p 输入为 '{' 之后或上一个成员之后的位置，返回时更新
+ * @param end 文本结尾
+ * @param key 输出：键的原文（不含引号，未解码）
+ * @param key_len 输出：键的长度
+ * @param value 输出：值的开头
+ * @param value_end 输出：值之后的位置
+ * @return 1 读到成员，0 对象结束（*p 指向 '}' 之后），-1 格式错误
+ */
+int json_scan_member(const char **p, const char *end, const char **key, size_t *key_len,
+                     const char **value, const char **value_end);
+
+/**
+ * @brief 读取数组的下一个元素，参数和返回值同 json_scan_member
+ */
+int json_scan_element(const char **p, const char *end, const char **value, const char **value_end);
+
+/**
+ * @brief 把字符串原文解码到文档内存池
+ * @param doc 文档（只使用其内存池，可以是清零的空文档）
+ * @param p 开头的引号
+ * @param end 文本结尾
+ * @return 解码后的字符串，格式错误返回NULL
+ */
+char *json_arena_string(json_doc_t *doc, const char *p, const char *end);
+
+#endif /* JSON_TOK_H */
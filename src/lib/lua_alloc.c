@@ -0,0 +1,281 @@
+/**
+ * @file lua_alloc.c
+ * @brief Lua 内存分配器实现
+ *
+ * Lua 释放和重新分配时总会传入块原来的大小（osize），所以块不需要头部：
+ * 由 osize 得到大小类别即可放回对应的空闲链表，大对象则直接 free。
+ * 每个类别从自己的 slab 中顺序切分新块，空闲块的第一个字存放链表指针。
+ * slab 只在关闭 lua_State 时释放，空闲块留在链表中供同类别的对象复用。
+ */
+
+#include "lua_alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#if USE_LUA
+
+#include "lauxlib.h"
+
+#define CLASS_COUNT     13
+#define CLASS_LARGE     (-1)
+
+/**
+ * @brief slab 头部（保持对象按 8 字节对齐）
+ */
+typedef union slab {
+    union slab *next;
+    double align;
+    char pad[16];
+} slab_t;
+
+/**
+ * @brief 分配器状态（每个 lua_State 一个）
+ */
+typedef struct {
+    void *free_list[CLASS_COUNT];   /**< 每个类别的空闲块链表 */
+    char *bump[CLASS_COUNT];        /**< 当前 slab 中下一个未使用的块 */
+    char *bump_end[CLASS_COUNT];    /**< 当前 slab 的末尾 */
+    slab_t *slabs;                  /**< 所有 slab（关闭时释放） */
+    size_t live;
+    size_t peak;
+    size_t limit;
+    size_t slab_bytes;
+    size_t large_bytes;
+    uint64_t allocs;
+    uint64_t sample_allocs;         /**< 上次统计时的 allocs */
+    uint64_t sample_ms;             /**< 上次统计的时间 */
+    uint32_t rate;
+    uint32_t limit_hits;
+} lua_pool_t;
+
+static const uint16_t class_size[CLASS_COUNT] = {
+    8, 16, 24, 32, 40, 48, 64, 80, 96, 128, 160, 192, 256
+};
+
+// 按 (size + 7) / 8 查找大小类别
+static const uint8_t class_of[LUA_ALLOC_SMALL_MAX / 8 + 1] = {
+    0, 0, 1, 2, 3, 4, 5, 6, 6, 7, 7, 8, 8,
+    9, 9, 9, 9, 10, 10, 10, 10, 11, 11, 11, 11,
+    12, 12, 12, 12, 12, 12, 12, 12
+};
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static inline int size_class(size_t size) {
+    return size <= LUA_ALLOC_SMALL_MAX ? class_of[(size + 7) >> 3] : CLASS_LARGE;
+}
+
+/**
+ * @brief 为类别申请新的 slab（上一个 slab 剩余不足一块的空间被丢弃）
+ */
+static bool new_slab(lua_pool_t *p, int cls) {
+    slab_t *slab = (slab_t *)malloc(LUA_ALLOC_SLAB_SIZE);
+    if (slab == NULL) {
+        return false;
+    }
+    slab->next = p->slabs;
+    p->slabs = slab;
+    p->slab_bytes += LUA_ALLOC_SLAB_SIZE;
+    p->bump[cls] = (char *)(slab + 1);
+    p->bump_end[cls] = (char *)slab + LUA_ALLOC_SLAB_SIZE;
+    return true;
+}
+
+static void *small_alloc(lua_pool_t *p, int cls) {
+    void *block = p->free_list[cls];
+    if (block != NULL) {
+        p->free_list[cls] = *(void **)block;
+        return block;
+    }
+    size_t size = class_size[cls];
+    if ((size_t)(p->bump_end[cls] - p->bump[cls]) < size && !new_slab(p, cls)) {
+        return NULL;
+    }
+    block = p->bump[cls];
+    p->bump[cls] += size;
+    return block;
+}
+
+static void release(lua_pool_t *p, void *ptr, size_t size) {
+    int cls = size_class(size);
+    if (cls == CLASS_LARGE) {
+        free(ptr);
+        p->large_bytes -= size;
+    } else {
+        *(void **)ptr = p->free_list[cls];
+        p->free_list[cls] = ptr;
+    }
+}
+
+/**
+ * @brief lua_Alloc 实现
+ */
+static void *pool_alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+    lua_pool_t *p = (lua_pool_t *)ud;
+    if (ptr == NULL) {
+        osize = 0;  // 新分配时 osize 是对象类型
+    }
+
+    if (nsize == 0) {
+        if (ptr != NULL) {
+            release(p, ptr, osize);
+            p->live -= osize;
+        }
+        return NULL;
+    }
+
+    // 超过上限时返回NULL，由 Lua 执行紧急回收后重试（缩小不能失败）
+    if (nsize > osize && p->limit != 0 && p->live - osize + nsize > p->limit) {
+        p->limit_hits++;
+        return NULL;
+    }
+
+    int ocls = ptr != NULL ? size_class(osize) : CLASS_LARGE;
+    int ncls = size_class(nsize);
+    void *block;
+    if (ptr != NULL && ocls != CLASS_LARGE && ocls == ncls) {
+        // 同一类别，原来的块就够用
+        block = ptr;
+    } else if (ptr != NULL && ocls == CLASS_LARGE && ncls == CLASS_LARGE) {
+        block = realloc(ptr, nsize);
+        if (block == NULL) {
+            if (nsize > osize) {
+                return NULL;
+            }
+            block = ptr;
+        }
+        p->large_bytes = p->large_bytes - osize + nsize;
+    } else {
+        block = ncls != CLASS_LARGE ? small_alloc(p, ncls) : malloc(nsize);
+        if (block == NULL) {
+            // 缩小时保留原来的块（只在系统内存耗尽时发生，之后按较小的类别回收，
+            // 原来是大对象时这块内存不再归还给系统）
+            if (ptr == NULL || nsize > osize) {
+                return NULL;
+            }
+            if (ocls == CLASS_LARGE) {
+                p->large_bytes -= osize;
+            }
+            p->live = p->live - osize + nsize;
+            return ptr;
+        }
+        if (ncls == CLASS_LARGE) {
+            p->large_bytes += nsize;
+        }
+        if (ptr != NULL) {
+            memcpy(block, ptr, osize < nsize ? osize : nsize);
+            release(p, ptr, osize);
+        } else {
+            p->allocs++;
+        }
+    }
+
+    p->live = p->live - osize + nsize;
+    if (p->live > p->peak) {
+        p->peak = p->live;
+    }
+    return block;
+}
+
+static void destroy_pool(lua_pool_t *p) {
+    slab_t *slab = p->slabs;
+    while (slab != NULL) {
+        slab_t *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    free(p);
+}
+
+static int panic_cb(lua_State *L) {
+    const char *msg = lua_tostring(L, -1);
+    printf("[lua] 未保护的错误: %s\n", msg ? msg : "(错误对象不是字符串)");
+    return 0;
+}
+
+/**
+ * @brief 警告输出（忽略 "@on"/"@off" 等控制消息）
+ */
+static void warn_cb(void *ud, const char *msg, int tocont) {
+    static bool cont = false;
+    (void)ud;
+    if (!cont && msg[0] == '@') {
+        return;
+    }
+    printf("%s%s%s", cont ? "" : "[lua] 警告: ", msg, tocont ? "" : "\n");
+    cont = tocont != 0;
+}
+
+static lua_pool_t *get_pool(lua_State *L) {
+    void *ud = NULL;
+    return lua_getallocf(L, &ud) == pool_alloc ? (lua_pool_t *)ud : NULL;
+}
+
+lua_State *lua_alloc_newstate(size_t limit) {
+    lua_pool_t *p = (lua_pool_t *)calloc(1, sizeof(lua_pool_t));
+    if (p == NULL) {
+        return NULL;
+    }
+    p->limit = limit;
+    p->sample_ms = now_ms();
+
+    lua_State *L = lua_newstate(pool_alloc, p, luaL_makeseed(NULL));
+    if (L == NULL) {
+        destroy_pool(p);
+        return NULL;
+    }
+    lua_atpanic(L, panic_cb);
+    lua_setwarnf(L, warn_cb, NULL);
+    return L;
+}
+
+void lua_alloc_close(lua_State *L) {
+    if (L == NULL) {
+        return;
+    }
+    lua_pool_t *p = get_pool(L);
+    lua_close(L);
+    if (p != NULL) {
+        destroy_pool(p);
+    }
+}
+
+void lua_alloc_set_limit(lua_State *L, size_t limit) {
+    lua_pool_t *p = get_pool(L);
+    if (p != NULL) {
+        p->limit = limit;
+    }
+}
+
+void lua_alloc_get_stats(lua_State *L, lua_alloc_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    lua_pool_t *p = get_pool(L);
+    if (p == NULL) {
+        return;
+    }
+
+    uint64_t now = now_ms();
+    if (now > p->sample_ms) {
+        p->rate = (uint32_t)((p->allocs - p->sample_allocs) * 1000u / (now - p->sample_ms));
+        p->sample_allocs = p->allocs;
+        p->sample_ms = now;
+    }
+
+    stats->live = p->live;
+    stats->peak = p->peak;
+    stats->limit = p->limit;
+    stats->slab_bytes = p->slab_bytes;
+    stats->large_bytes = p->large_bytes;
+    stats->allocs = p->allocs;
+    stats->allocs_per_sec = p->rate;
+    stats->limit_hits = p->limit_hits;
+}
+
+#endif /* USE_LUA */
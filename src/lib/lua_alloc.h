@@ -0,0 +1,73 @@
+/**
+ * @file lua_alloc.h
+ * @brief Lua 内存分配器头文件
+ *
+ * 每个 lua_State 使用自己的分配器：不超过 LUA_ALLOC_SMALL_MAX 字节的对象（表、短字符串、
+ * 闭包、upvalue 等，占 Lua 分配次数的绝大部分）按大小类别从 LUA_ALLOC_SLAB_SIZE 的
+ * slab 中分配，释放的块进入该类别的空闲链表，不经过 libc；更大的对象（数组部分、
+ * 长字符串、栈）直接使用 malloc。slab 在关闭 lua_State 时一起释放，不会与 LVGL 堆
+ * 和其它模块的小块分配交错产生碎片。
+ *
+ * 设置了内存上限时，超过上限的分配返回NULL，Lua 会先执行一次完整的紧急回收再重试，
+ * 仍然不够时以 "not enough memory" 错误结束当前脚本，而不是耗尽系统内存。
+ *
+ * 需要完整的 Lua 运行时（USE_LUA=1）。同一个 lua_State 的接口只能在一个线程中调用。
+ */
+
+#ifndef LUA_ALLOC_H
+#define LUA_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lua.h"
+
+#ifndef USE_LUA
+#define USE_LUA 0
+#endif
+
+#define LUA_ALLOC_SMALL_MAX     256             /**< 从 slab 分配的最大对象（字节） */
+#define LUA_ALLOC_SLAB_SIZE     (16 * 1024)     /**< 每次向系统申请的 slab 大小 */
+#define LUA_ALLOC_DEFAULT_LIMIT (4 * 1024 * 1024)   /**< 默认内存上限 */
+
+/**
+ * @brief 分配器统计
+ */
+typedef struct {
+    size_t live;            /**< 当前分配给 Lua 的字节数 */
+    size_t peak;            /**< live 的峰值 */
+    size_t limit;           /**< 内存上限，0表示不限制 */
+    size_t slab_bytes;      /**< 向系统申请的 slab 总字节数 */
+    size_t large_bytes;     /**< 大对象的字节数 */
+    uint64_t allocs;        /**< 累计分配的新块数 */
+    uint32_t allocs_per_sec;    /**< 每秒分配次数（两次获取统计之间的平均值） */
+    uint32_t limit_hits;    /**< 分配超过上限（触发紧急回收）的次数 */
+} lua_alloc_stats_t;
+
+/**
+ * @brief 创建使用池分配器的 lua_State（与 luaL_newstate 一样设置 panic 和警告输出）
+ * @param limit 内存上限（字节），0表示不限制
+ * @return lua_State，失败返回NULL
+ */
+lua_State *lua_alloc_newstate(size_t limit);
+
+/**
+ * @brief 关闭 lua_State 并释放分配器的所有 slab
+ * @param L lua_alloc_newstate 创建的 lua_State
+ */
+void lua_alloc_close(lua_State *L);
+
+/**
+ * @brief 修改内存上限（小于当前用量时，之后的分配会触发紧急回收）
+ * @param L lua_alloc_newstate 创建的 lua_State
+ * @param limit 内存上限（字节），0表示不限制
+ */
+void lua_alloc_set_limit(lua_State *L, size_t limit);
+
+/**
+ * @brief 获取分配器统计
+ * @param L lua_alloc_newstate 创建的 lua_State
+ * @param stats 输出
+ */
+void lua_alloc_get_stats(lua_State *L, lua_alloc_stats_t *stats);
+
+#endif /* LUA_ALLOC_H */
@@ -0,0 +1,547 @@
+/**
+ * @file lua_app.c
+ * @brief Lua 应用模块加载器实现
+ *
+ * 所有应用共用一个 lua_State（第一次打开应用时创建），模块表保存在注册表中。
+ * 每个应用登记到 app_manager，离开时挂起（模块的 suspend/resume 可选），超出预算时销毁。
+ * 字节码缓存文件为 缓存目录/<路径哈希>.luac，内容为 cache_header_t 加 lua_dump 的输出；
+ * 文件头与源文件的 mtime、大小或 Lua 版本不一致时重新编译并覆盖。
+ */
+
+#include "lua_app.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if USE_LUA
+
+#include <dirent.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "lua.h"
+#include "lauxlib.h"
+#include "lualib.h"
+#include "lv_lua.h"
+#include "lua_sched.h"
+#include "lua_alloc.h"
+#include "lua_idle_gc.h"
+#include "app_manager.h"
+
+#define CACHE_MAGIC     "LAPC"
+
+/**
+ * @brief 应用
+ */
+typedef struct {
+    char name[32];          /**< 文件名（不含 .lua） */
+    char title[48];         /**< 显示名称 */
+    char path[256];         /**< 源文件路径 */
+    int64_t mtime_ns;       /**< 上次加载时源文件的 mtime */
+    int64_t size;           /**< 上次加载时源文件的大小 */
+    int module_ref;         /**< 模块表在注册表中的引用，LUA_NOREF 表示未加载 */
+    int app_id;             /**< app_manager 中的ID */
+    lv_obj_t *root;         /**< 界面容器，未创建时为 NULL */
+} app_t;
+
+/**
+ * @brief 字节码缓存文件头
+ */
+typedef struct {
+    char magic[4];          /**< CACHE_MAGIC */
+    uint32_t version;       /**< LUA_VERSION_NUM */
+    int64_t mtime_ns;       /**< 源文件 mtime */
+    int64_t size;           /**< 源文件大小 */
+} cache_header_t;
+
+/**
+ * @brief lua_load 的文件读取状态
+ */
+typedef struct {
+    FILE *f;
+    char buf[4096];
+} file_reader_t;
+
+static app_t apps[LUA_APP_MAX];
+static int app_count = 0;
+static char cache_dir_buf[256];
+static lua_State *state = NULL;
+static lv_timer_t *watch_timer = NULL;
+static bool scanned = false;
+
+/*=====================
+ * 字节码缓存
+ *====================*/
+
+static bool source_stat(const char *path, int64_t *mtime_ns, int64_t *size) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    *mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    *size = (int64_t)st.st_size;
+    return true;
+}
+
+static void cache_path(const app_t *app, char *out, size_t size) {
+    // FNV-1a 64
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const char *p = app->path; *p != '\0'; p++) {
+        h = (h ^ (uint8_t)*p) * 0x100000001b3ull;
+    }
+    snprintf(out, size, "%s/%016llx.luac", cache_dir_buf, (unsigned long long)h);
+}
+
+static const char *read_chunk(lua_State *L, void *ud, size_t *size) {
+    (void)L;
+    file_reader_t *r = (file_reader_t *)ud;
+    *size = fread(r->buf, 1, sizeof(r->buf), r->f);
+    return *size > 0 ? r->buf : NULL;
+}
+
+static int write_chunk(lua_State *L, const void *p, size_t size, void *ud) {
+    (void)L;
+    return fwrite(p, 1, size, (FILE *)ud) == size ? 0 : 1;
+}
+
+/**
+ * @brief 从缓存加载字节码（文件头与源文件一致时），成功时函数在栈顶
+ */
+static bool load_cached(const app_t *app) {
+    char path[300];
+    cache_path(app, path, sizeof(path));
+    file_reader_t *r = malloc(sizeof(*r));
+    if (r == NULL) {
+        return false;
+    }
+    r->f = fopen(path, "rb");
+    if (r->f == NULL) {
+        free(r);
+        return false;
+    }
+
+    cache_header_t hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, r->f) == 1 && memcmp(hdr.magic, CACHE_MAGIC, 4) == 0 &&
+              hdr.version == LUA_VERSION_NUM && hdr.mtime_ns == app->mtime_ns && hdr.size == app->size;
+    if (ok) {
+        char chunkname[264];
+        snprintf(chunkname, sizeof(chunkname), "@%s", app->path);
+        if (lua_load(state, read_chunk, r, chunkname, "b") != LUA_OK) {
+            printf("[lua] 字节码缓存无效: %s\n", path);
+            lua_pop(state, 1);
+            ok = false;
+        }
+    }
+    fclose(r->f);
+    free(r);
+    return ok;
+}
+
+/**
+ * @brief 把栈顶的函数保存到缓存（临时文件 + rename）
+ */
+static void save_cached(const app_t *app) {
+    char path[300];
+    char tmp[310];
+    cache_path(app, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+        return;
+    }
+
+    cache_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CACHE_MAGIC, 4);
+    hdr.version = LUA_VERSION_NUM;
+    hdr.mtime_ns = app->mtime_ns;
+    hdr.size = app->size;
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 && lua_dump(state, write_chunk, f, 0) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        printf("[lua] 无法写入字节码缓存: %s\n", path);
+    }
+}
+
+/*=====================
+ * 模块
+ *====================*/
+
+/**
+ * @brief 加载模块：编译（或读取缓存）并执行代码块，成功时模块表在栈顶
+ */
+static bool load_module(app_t *app) {
+    // 先记录 mtime，编译失败的版本在文件再次变化之前不会重试
+    if (!source_stat(app->path, &app->mtime_ns, &app->size)) {
+        printf("[lua] 应用文件不存在: %s\n", app->path);
+        return false;
+    }
+    if (!load_cached(app)) {
+        if (luaL_loadfilex(state, app->path, "t") != LUA_OK) {
+            printf("[lua] 应用编译失败: %s\n", lua_tostring(state, -1));
+            lua_pop(state, 1);
+            return false;
+        }
+        save_cached(app);
+    }
+
+    // 独立的全局环境，读取时回退到 _G
+    lua_newtable(state);
+    lua_createtable(state, 0, 1);
+    lua_pushglobaltable(state);
+    lua_setfield(state, -2, "__index");
+    lua_setmetatable(state, -2);
+    if (lua_setupvalue(state, -2, 1) == NULL) {
+        lua_pop(state, 1);
+    }
+
+    if (lua_sched_pcall(state, 0, 1) != LUA_OK) {
+        printf("[lua] 应用 %s 加载失败: %s\n", app->name, lua_tostring(state, -1));
+        lua_pop(state, 1);
+        return false;
+    }
+    bool valid = false;
+    if (lua_istable(state, -1)) {
+        valid = lua_getfield(state, -1, "open") == LUA_TFUNCTION;
+        lua_pop(state, 1);
+    }
+    if (!valid) {
+        printf("[lua] 应用 %s 没有返回带 open 函数的表\n", app->name);
+        lua_pop(state, 1);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 调用 module[fn](root, ...)，参数为栈顶的 nargs 个值
+ * @return 是否成功；结果总是 nres 个（失败时为 nil）
+ */
+static bool call_module(const app_t *app, const char *fn, int nargs, int nres) {
+    int base = lua_gettop(state) - nargs;
+    lua_rawgeti(state, LUA_REGISTRYINDEX, app->module_ref);
+    lua_getfield(state, -1, fn);
+    lua_remove(state, -2);
+    bool ok = false;
+    if (lua_isfunction(state, -1)) {
+        lua_insert(state, base + 1);
+        lv_lua_push_obj(state, app->root);
+        lua_insert(state, base + 2);
+        ok = lua_sched_pcall(state, nargs + 1, nres) == LUA_OK;
+        if (!ok) {
+            printf("[lua] 应用 %s.%s 出错: %s\n", app->name, fn, lua_tostring(state, -1));
+        }
+    }
+    if (!ok) {
+        lua_settop(state, base);
+        for (int i = 0; i < nres; i++) {
+            lua_pushnil(state);
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief 源文件变化时重新加载模块，已创建的应用（运行或挂起）在原容器中重建界面
+ */
+static bool reload(app_t *app) {
+    int64_t mtime_ns, size;
+    if (!source_stat(app->path, &mtime_ns, &size) || (mtime_ns == app->mtime_ns && size == app->size)) {
+        return false;
+    }
+    if (!load_module(app)) {
+        return false;
+    }
+
+    bool is_open = app->root != NULL;
+    if (is_open) {
+        call_module(app, "close", 0, 1);
+        lv_obj_clean(app->root);
+        lua_insert(state, -2);
+    }
+    luaL_unref(state, LUA_REGISTRYINDEX, app->module_ref);
+    app->module_ref = luaL_ref(state, LUA_REGISTRYINDEX);
+    if (is_open) {
+        call_module(app, "open", 1, 0);
+    }
+    printf("[lua] 已重新加载应用: %s\n", app->name);
+    return true;
+}
+
+static void watch_timer_cb(lv_timer_t *t) {
+    (void)t;
+    lua_app_poll();
+}
+
+static void close_async(void *user_data) {
+    (void)user_data;
+    app_manager_close();
+}
+
+/**
+ * @brief apps.close()：在当前事件处理结束后回到主界面（应用挂起）
+ */
+static int l_close(lua_State *L) {
+    (void)L;
+    lv_async_call(close_async, NULL);
+    return 0;
+}
+
+/**
+ * @brief 创建应用共用的 lua_State
+ */
+static bool ensure_state(void) {
+    if (state != NULL) {
+        return true;
+    }
+    state = lua_alloc_newstate(LUA_APP_MEM_LIMIT);
+    if (state == NULL) {
+        return false;
+    }
+
+    luaL_openselectedlibs(state, LUA_GLIBK | LUA_STRLIBK | LUA_MATHLIBK | LUA_TABLIBK | LUA_UTF8LIBK, 0);
+    static const char *const removed[] = { "dofile", "loadfile" };
+    for (size_t i = 0; i < sizeof(removed) / sizeof(removed[0]); i++) {
+        lua_pushnil(state);
+        lua_setglobal(state, removed[i]);
+    }
+    lv_lua_open(state);
+    lua_createtable(state, 0, 1);
+    lua_pushcfunction(state, l_close);
+    lua_setfield(state, -2, "close");
+    lua_setglobal(state, "apps");
+    lua_idle_gc_attach(state);
+
+    watch_timer = lv_timer_create(watch_timer_cb, LUA_APP_WATCH_MS, NULL);
+    return true;
+}
+
+/*=====================
+ * 生命周期回调
+ *====================*/
+
+static bool app_create(lv_obj_t **root, void *user_data) {
+    app_t *app = (app_t *)user_data;
+    if (!ensure_state()) {
+        return false;
+    }
+
+    // 第一次打开时加载模块
+    if (app->module_ref == LUA_NOREF) {
+        if (!load_module(app)) {
+            return false;
+        }
+        app->module_ref = luaL_ref(state, LUA_REGISTRYINDEX);
+    }
+
+    app->root = lv_obj_create(lv_screen_active());
+    lv_obj_set_size(app->root, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_style_border_width(app->root, 0, 0);
+    lv_obj_set_style_radius(app->root, 0, 0);
+    lv_lua_protect(app->root);
+
+    lua_pushnil(state);
+    if (!call_module(app, "open", 1, 0)) {
+        lv_obj_delete(app->root);
+        app->root = NULL;
+        return false;
+    }
+    *root = app->root;
+    return true;
+}
+
+static void app_suspend(lv_obj_t *root, void *user_data) {
+    (void)root;
+    call_module((app_t *)user_data, "suspend", 0, 0);
+}
+
+static void app_resume(lv_obj_t *root, void *user_data) {
+    (void)root;
+    call_module((app_t *)user_data, "resume", 0, 0);
+}
+
+/**
+ * @brief 销毁：调用模块的 close，根对象由 app_manager 删除
+ */
+static void app_destroy(lv_obj_t *root, void *user_data) {
+    (void)root;
+    app_t *app = (app_t *)user_data;
+    if (state != NULL) {
+        call_module(app, "close", 0, 0);
+    }
+    app->root = NULL;
+}
+
+static int compare_app(const void *a, const void *b) {
+    return strcmp(((const app_t *)a)->name, ((const app_t *)b)->name);
+}
+
+/**
+ * @brief 复制标题，超长时截断在 UTF-8 字符边界上
+ */
+static void copy_title(char *dst, size_t size, const char *src) {
+    size_t len = strlen(src);
+    if (len >= size) {
+        len = size - 1;
+        // src[len] 是多字节字符的后续字节时，整个字符都不复制
+        while (len > 0 && ((unsigned char)src[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+/**
+ * @brief 读取第一行的 "-- title: 名称"，没有时使用文件名
+ */
+static void read_title(app_t *app) {
+    copy_title(app->title, sizeof(app->title), app->name);
+    FILE *f = fopen(app->path, "r");
+    if (f == NULL) {
+        return;
+    }
+    char line[128];
+    if (fgets(line, sizeof(line), f) != NULL && strncmp(line, "-- title:", 9) == 0) {
+        char *s = line + 9;
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+        s[strcspn(s, "\r\n")] = '\0';
+        if (*s != '\0') {
+            copy_title(app->title, sizeof(app->title), s);
+        }
+    }
+    fclose(f);
+}
+
+/*=====================
+ * 公共接口
+ *====================*/
+
+int lua_app_init(const char *app_dir, const char *cache_dir) {
+    // 应用登记到 app_manager 后不能注销，只扫描一次
+    if (scanned) {
+        return app_count;
+    }
+    scanned = true;
+    if (app_dir == NULL) {
+        app_dir = LUA_APP_DEFAULT_DIR;
+    }
+    snprintf(cache_dir_buf, sizeof(cache_dir_buf), "%s", cache_dir ? cache_dir : LUA_APP_DEFAULT_CACHE);
+    if (mkdir(cache_dir_buf, 0755) != 0 && errno != EEXIST) {
+        printf("[lua] 无法创建字节码缓存目录 %s: %s\n", cache_dir_buf, strerror(errno));
+    }
+
+    DIR *dir = opendir(app_dir);
+    if (dir == NULL) {
+        printf("[lua] 没有应用目录: %s\n", app_dir);
+        return 0;
+    }
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL && app_count < LUA_APP_MAX) {
+        size_t len = strlen(de->d_name);
+        if (de->d_name[0] == '.' || len <= 4 || strcmp(de->d_name + len - 4, ".lua") != 0) {
+            continue;
+        }
+        app_t *app = &apps[app_count];
+        memset(app, 0, sizeof(*app));
+        snprintf(app->path, sizeof(app->path), "%s/%s", app_dir, de->d_name);
+        if (!source_stat(app->path, &app->mtime_ns, &app->size)) {
+            continue;
+        }
+        snprintf(app->name, sizeof(app->name), "%.*s", (int)(len - 4), de->d_name);
+        read_title(app);
+        app->module_ref = LUA_NOREF;
+        app_count++;
+    }
+    closedir(dir);
+
+    qsort(apps, app_count, sizeof(app_t), compare_app);
+    for (int i = 0; i < app_count; i++) {
+        app_desc_t desc = {
+            .name = apps[i].name, .create = app_create, .suspend = app_suspend, .resume = app_resume,
+            .destroy = app_destroy, .hide_home = true, .user_data = &apps[i],
+        };
+        apps[i].app_id = app_manager_register(&desc);
+    }
+    printf("[lua] 找到 %d 个应用: %s\n", app_count, app_dir);
+    return app_count;
+}
+
+int lua_app_count(void) {
+    return app_count;
+}
+
+const char *lua_app_title(int index) {
+    return index >= 0 && index < app_count ? apps[index].title : NULL;
+}
+
+bool lua_app_open(int index) {
+    return index >= 0 && index < app_count && app_manager_open(apps[index].app_id);
+}
+
+int lua_app_poll(void) {
+    if (state == NULL) {
+        return 0;
+    }
+    int reloaded = 0;
+    for (int i = 0; i < app_count; i++) {
+        if (apps[i].module_ref != LUA_NOREF && reload(&apps[i])) {
+            reloaded++;
+        }
+    }
+    return reloaded;
+}
+
+void lua_app_deinit(void) {
+    for (int i = 0; i < app_count; i++) {
+        app_manager_destroy(apps[i].app_id);
+    }
+    if (watch_timer != NULL) {
+        lv_timer_delete(watch_timer);
+        watch_timer = NULL;
+    }
+    if (state != NULL) {
+        lv_lua_close();
+        lua_idle_gc_detach(state);
+        lua_alloc_close(state);
+        state = NULL;
+    }
+    for (int i = 0; i < app_count; i++) {
+        apps[i].module_ref = LUA_NOREF;
+    }
+}
+
+#else /* !USE_LUA */
+
+int lua_app_init(const char *app_dir, const char *cache_dir) {
+    (void)app_dir;
+    (void)cache_dir;
+    return 0;
+}
+
+int lua_app_count(void) {
+    return 0;
+}
+
+const char *lua_app_title(int index) {
+    (void)index;
+    return NULL;
+}
+
+bool lua_app_open(int index) {
+    (void)index;
+    return false;
+}
+
+int lua_app_poll(void) {
+    return 0;
+}
+
+void lua_app_deinit(void) {
+}
+
+#endif /* USE_LUA */
@@ -0,0 +1,84 @@
+/**
+ * @file lua_app.h
+ * @brief Lua 应用模块加载器头文件
+ *
+ * lua_app_init 只扫描应用目录中的 *.lua 文件（文件名为应用名，第一行 "-- title: 名称"
+ * 为主屏幕上显示的名称），不加载任何模块；lua_State 和模块在第一次打开时才创建和加载。
+ *
+ * 模块是一个返回表的代码块，每个模块有自己的全局环境（读取不到的名称从 _G 查找）：
+ *   -- title: 时钟
+ *   local app = {}
+ *   function app.open(root, state) ... end   -- 在 root 中创建界面（必须）
+ *   function app.close(root) return state end -- 可选，返回值在热重载后传给新的 open
+ *   function app.suspend(root) end             -- 可选，离开应用（界面隐藏但保留）
+ *   function app.resume(root) end              -- 可选，从挂起回到前台
+ *   return app
+ * 脚本可以使用 lv 表（lv_lua.h）、基础库（没有 dofile/loadfile）、string、math、table、utf8，
+ * 以及 apps.close() 回到主界面。模块的函数用 lua_sched_pcall 执行。
+ *
+ * 每个应用登记到 app_manager：离开时挂起，再次打开时直接显示；超出挂起预算被销毁时
+ * 调用 close，下次打开重新调用 open。
+ *
+ * 编译结果用 lua_dump 缓存在缓存目录中，文件名为源文件路径的哈希值，文件头记录
+ * 源文件的 mtime 和大小，一致时直接加载字节码。已加载的模块每 LUA_APP_WATCH_MS
+ * 检查一次源文件，变化后重新加载；已创建的应用先调用旧模块的 close，清空 root
+ * 后用新模块的 open 重建界面，不需要重启程序。
+ *
+ * 未启用 Lua（USE_LUA=0）时没有应用。所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef LUA_APP_H
+#define LUA_APP_H
+
+#include <stdbool.h>
+#include "lvgl/lvgl.h"
+
+#ifndef USE_LUA
+#define USE_LUA 0
+#endif
+
+#define LUA_APP_DEFAULT_DIR     "/mnt/app/apps"
+#define LUA_APP_DEFAULT_CACHE   "/mnt/app/.app_cache"
+#define LUA_APP_MAX             16                  /**< 最多的应用数 */
+#define LUA_APP_MEM_LIMIT       (4 * 1024 * 1024)   /**< 应用 lua_State 的内存上限 */
+#define LUA_APP_WATCH_MS        1000                /**< 检查源文件变化的周期 */
+
+/**
+ * @brief 扫描应用目录（不加载模块）并登记到 app_manager，只在第一次调用时扫描
+ * @param app_dir 应用目录，NULL 使用默认目录
+ * @param cache_dir 字节码缓存目录，NULL 使用默认目录
+ * @return 找到的应用数
+ */
+int lua_app_init(const char *app_dir, const char *cache_dir);
+
+/**
+ * @brief 获取应用数
+ */
+int lua_app_count(void);
+
+/**
+ * @brief 获取应用显示名称
+ * @param index 应用序号
+ * @return 名称，序号无效时返回NULL
+ */
+const char *lua_app_title(int index);
+
+/**
+ * @brief 打开应用（app_manager_open；第一次打开时加载模块），隐藏主界面
+ * @param index 应用序号
+ * @return 是否成功
+ */
+bool lua_app_open(int index);
+
+/**
+ * @brief 检查已加载模块的源文件，重新加载变化的模块（定时器也会调用）
+ * @return 重新加载的模块数
+ */
+int lua_app_poll(void);
+
+/**
+ * @brief 销毁所有应用并释放 lua_State（登记保留，之后还可以打开）
+ */
+void lua_app_deinit(void);
+
+#endif /* LUA_APP_H */
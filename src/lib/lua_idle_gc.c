@@ -0,0 +1,236 @@
+/**
+ * @file lua_idle_gc.c
+ * @brief Lua 空闲时间垃圾回收实现
+ *
+ * LUA_GCSTEP 在回收器被 LUA_GCSTOP 停止时同样有效，所以登记后只有这里（和分配失败时的
+ * 紧急回收）会推进回收。多个 lua_State 在同一帧的空闲时间里轮流各执行一步。
+ *
+ * 每个 lua_State 记录回收欠下的债务：两次调用之间内存的增长（回收器停止时内存只会因分配
+ * 而增长）计入债务，每执行一步偿还 LUA_IDLE_GC_STEP_SIZE，周期结束时清零。
+ * 强制回收时按债务执行相应的步数（最多 LUA_IDLE_GC_FORCE_MAX_US），持续动画期间的回收
+ * 速度跟得上分配速度，不会一直累积到分配器上限触发紧急的完整回收。
+ */
+
+#include "lua_idle_gc.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if USE_LUA
+
+#include "lvgl/lvgl.h"
+
+/**
+ * @brief 登记的 lua_State
+ */
+typedef struct {
+    lua_State *L;       /**< NULL 表示空槽 */
+    bool waiting;       /**< 周期已结束，等待内存增长 */
+    int base_kb;        /**< 上个周期结束时的内存（KB） */
+    int64_t last_bytes; /**< 上次计算债务时的内存（字节） */
+    int64_t debt;       /**< 还没有偿还的分配字节数 */
+} gc_state_t;
+
+static gc_state_t states[LUA_IDLE_GC_MAX_STATES];
+static int state_count = 0;
+static int hold_count = 0;
+static uint64_t last_chance_us = 0;     // 上次可以回收（有空闲时间或没有工作）的时间
+static lua_idle_gc_stats_t gc_stats;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/**
+ * @brief 界面是否在动画或滚动中
+ */
+static bool ui_busy(void) {
+    if (hold_count > 0 || lv_anim_count_running() > 0) {
+        return true;
+    }
+    for (lv_indev_t *indev = lv_indev_get_next(NULL); indev != NULL; indev = lv_indev_get_next(indev)) {
+        if (lv_indev_get_scroll_obj(indev) != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 是否需要回收：周期进行中，或内存已增长到 LUA_IDLE_GC_PAUSE%
+ */
+static bool has_work(gc_state_t *s) {
+    if (!s->waiting) {
+        return true;
+    }
+    if (lua_gc(s->L, LUA_GCCOUNT) * 100 >= s->base_kb * LUA_IDLE_GC_PAUSE) {
+        s->waiting = false;
+    }
+    return !s->waiting;
+}
+
+static int64_t mem_bytes(lua_State *L) {
+    return (int64_t)lua_gc(L, LUA_GCCOUNT) * 1024 + lua_gc(L, LUA_GCCOUNTB);
+}
+
+/**
+ * @brief 把上次以来的内存增长计入债务
+ */
+static void update_debt(gc_state_t *s) {
+    int64_t bytes = mem_bytes(s->L);
+    if (bytes > s->last_bytes) {
+        s->debt += bytes - s->last_bytes;
+    }
+    s->last_bytes = bytes;
+}
+
+static void step(gc_state_t *s) {
+    gc_stats.steps++;
+    s->debt = s->debt > LUA_IDLE_GC_STEP_SIZE ? s->debt - LUA_IDLE_GC_STEP_SIZE : 0;
+    if (lua_gc(s->L, LUA_GCSTEP, (size_t)LUA_IDLE_GC_STEP_SIZE)) {
+        gc_stats.cycles++;
+        s->waiting = true;
+        s->base_kb = lua_gc(s->L, LUA_GCCOUNT);
+        s->debt = 0;
+    }
+    s->last_bytes = mem_bytes(s->L);
+}
+
+bool lua_idle_gc_attach(lua_State *L) {
+    for (int i = 0; i < LUA_IDLE_GC_MAX_STATES; i++) {
+        if (states[i].L == NULL) {
+            lua_gc(L, LUA_GCSTOP);
+            states[i].L = L;
+            states[i].waiting = false;
+            states[i].base_kb = 0;
+            states[i].last_bytes = mem_bytes(L);
+            states[i].debt = 0;
+            if (state_count++ == 0) {
+                last_chance_us = now_us();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void lua_idle_gc_detach(lua_State *L) {
+    for (int i = 0; i < LUA_IDLE_GC_MAX_STATES; i++) {
+        if (states[i].L == L) {
+            lua_gc(L, LUA_GCRESTART);
+            states[i].L = NULL;
+            if (--state_count == 0) {
+                printf("[lua] 空闲回收统计: %u 帧, %u 步, %u 个周期, 强制 %u 次, 跳过 %u 帧, 平均 %u us, 最长 %u us\n",
+                       gc_stats.frames, gc_stats.steps, gc_stats.cycles, gc_stats.forced, gc_stats.held,
+                       gc_stats.frames > 0 ? (uint32_t)(gc_stats.total_us / gc_stats.frames) : 0, gc_stats.max_us);
+            }
+            return;
+        }
+    }
+}
+
+uint32_t lua_idle_gc_run(uint32_t slack_us) {
+    if (state_count == 0) {
+        return 0;
+    }
+
+    uint64_t start = now_us();
+    bool work = false;
+    for (int i = 0; i < LUA_IDLE_GC_MAX_STATES; i++) {
+        if (states[i].L != NULL) {
+            update_debt(&states[i]);
+            if (has_work(&states[i])) {
+                work = true;
+            }
+        }
+    }
+    if (!work) {
+        last_chance_us = start;
+        return 0;
+    }
+
+    // 动画和滚动期间暂停，但最多推迟 LUA_IDLE_GC_FORCE_MS（标签滚动等动画可能一直运行）
+    bool held = ui_busy();
+    bool forced = false;
+    uint64_t deadline;
+    if (!held && slack_us > LUA_IDLE_GC_MARGIN_US) {
+        deadline = start + slack_us - LUA_IDLE_GC_MARGIN_US;
+    } else if (start - last_chance_us >= (uint64_t)LUA_IDLE_GC_FORCE_MS * 1000u) {
+        forced = true;
+        deadline = start + LUA_IDLE_GC_FORCE_MAX_US;
+    } else {
+        if (held) {
+            gc_stats.held++;
+        }
+        return 0;
+    }
+    last_chance_us = start;
+
+    // 轮流为每个需要回收的 lua_State 执行一步；强制时每个 lua_State 至少一步，
+    // 之后只执行到债务还清
+    bool stepped;
+    bool first = true;
+    do {
+        stepped = false;
+        for (int i = 0; i < LUA_IDLE_GC_MAX_STATES; i++) {
+            gc_state_t *s = &states[i];
+            if (s->L != NULL && has_work(s) && (!forced || first || s->debt > 0)) {
+                step(s);
+                stepped = true;
+            }
+        }
+        first = false;
+    } while (stepped && now_us() < deadline);
+
+    uint32_t used = (uint32_t)(now_us() - start);
+    gc_stats.frames++;
+    gc_stats.last_us = used;
+    gc_stats.total_us += used;
+    if (used > gc_stats.max_us) {
+        gc_stats.max_us = used;
+    }
+    if (forced) {
+        gc_stats.forced++;
+    }
+    return used;
+}
+
+void lua_idle_gc_hold(bool busy) {
+    if (busy) {
+        hold_count++;
+    } else if (hold_count > 0) {
+        hold_count--;
+    }
+}
+
+void lua_idle_gc_get_stats(lua_idle_gc_stats_t *stats) {
+    *stats = gc_stats;
+}
+
+#else /* !USE_LUA */
+
+bool lua_idle_gc_attach(lua_State *L) {
+    (void)L;
+    return false;
+}
+
+void lua_idle_gc_detach(lua_State *L) {
+    (void)L;
+}
+
+uint32_t lua_idle_gc_run(uint32_t slack_us) {
+    (void)slack_us;
+    return 0;
+}
+
+void lua_idle_gc_hold(bool busy) {
+    (void)busy;
+}
+
+void lua_idle_gc_get_stats(lua_idle_gc_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif /* USE_LUA */
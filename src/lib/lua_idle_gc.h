@@ -0,0 +1,84 @@
+/**
+ * @file lua_idle_gc.h
+ * @brief Lua 空闲时间垃圾回收头文件
+ *
+ * 登记的 lua_State 停止自动回收（分配累积的债务不会在帧中间触发回收步骤），
+ * 由主循环在 lv_timer_handler() 返回后、下一个定时器到期前的空闲时间里调用
+ * lua_idle_gc_run，以 LUA_IDLE_GC_STEP_SIZE 为单位推进增量回收，直到空闲时间用完。
+ * 一个回收周期结束后，内存增长到上次回收后的 LUA_IDLE_GC_PAUSE% 才开始下一个周期。
+ *
+ * 有 lv_anim 动画运行（如页面切换效果）、正在滚动或调用方用 lua_idle_gc_hold 声明忙碌
+ * （如快进）时不回收。持续没有空闲时间超过 LUA_IDLE_GC_FORCE_MS 时强制回收：按上次以来
+ * 分配的字节数（债务）执行相应的步数，最多 LUA_IDLE_GC_FORCE_MAX_US，回收速度跟上分配速度；
+ * 内存达到分配器上限时 Lua 仍会执行紧急回收（见 lua_alloc.h）。
+ * 最后一个 lua_State 取消登记时输出回收统计。
+ *
+ * 未启用 Lua（USE_LUA=0）时 lua_idle_gc_run 和 lua_idle_gc_hold 什么也不做。
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef LUA_IDLE_GC_H
+#define LUA_IDLE_GC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lua.h"
+
+#ifndef USE_LUA
+#define USE_LUA 0
+#endif
+
+#define LUA_IDLE_GC_MAX_STATES  4           /**< 最多登记的 lua_State 数 */
+#define LUA_IDLE_GC_STEP_SIZE   (4 * 1024)  /**< 每次 LUA_GCSTEP 的工作量（按分配字节计） */
+#define LUA_IDLE_GC_MARGIN_US   500         /**< 空闲时间中留给下一次 lv_timer_handler 的余量 */
+#define LUA_IDLE_GC_PAUSE       150         /**< 内存增长到上次回收后的百分之多少时开始新周期 */
+#define LUA_IDLE_GC_FORCE_MS    500         /**< 超过该时间没有回收机会时强制回收 */
+#define LUA_IDLE_GC_FORCE_MAX_US 2000       /**< 强制回收一次最长执行的时间（微秒） */
+
+/**
+ * @brief 回收统计
+ */
+typedef struct {
+    uint32_t frames;        /**< 执行过回收的帧（主循环迭代）数 */
+    uint32_t steps;         /**< LUA_GCSTEP 次数 */
+    uint32_t cycles;        /**< 完成的回收周期数 */
+    uint32_t forced;        /**< 没有空闲时间时强制执行的次数 */
+    uint32_t held;          /**< 因动画、滚动或忙碌跳过的帧数 */
+    uint32_t last_us;       /**< 上一帧的回收时间 */
+    uint32_t max_us;        /**< 单帧最长回收时间 */
+    uint64_t total_us;      /**< 累计回收时间（除以 frames 为每帧平均） */
+} lua_idle_gc_stats_t;
+
+/**
+ * @brief 登记 lua_State：停止自动回收，改为在空闲时间回收
+ * @param L lua_State
+ * @return 是否成功，登记数已满时返回false（保持自动回收）
+ */
+bool lua_idle_gc_attach(lua_State *L);
+
+/**
+ * @brief 取消登记（在 lua_close 之前调用）
+ * @param L lua_State
+ */
+void lua_idle_gc_detach(lua_State *L);
+
+/**
+ * @brief 在空闲时间中推进回收（主循环在 lv_timer_handler 之后调用）
+ * @param slack_us 到下一个定时器到期的空闲时间（微秒）
+ * @return 用掉的时间（微秒）
+ */
+uint32_t lua_idle_gc_run(uint32_t slack_us);
+
+/**
+ * @brief 声明忙碌开始/结束（可以嵌套），忙碌期间不回收
+ * @param busy true 开始，false 结束
+ */
+void lua_idle_gc_hold(bool busy);
+
+/**
+ * @brief 获取回收统计
+ * @param stats 输出
+ */
+void lua_idle_gc_get_stats(lua_idle_gc_stats_t *stats);
+
+#endif /* LUA_IDLE_GC_H */
@@ -0,0 +1,415 @@
+/**
+ * @file lua_sched.c
+ * @brief Lua 脚本分时调度实现
+ *
+ * 每个任务是一个由主 lua_State 创建的线程，引用保存在注册表中。钩子只在任务线程上
+ * （以及 lua_sched_pcall 执行期间的调用线程上）设置，普通脚本的执行速度不受影响。
+ * 在钩子中挂起时 lua_resume 返回 LUA_YIELD，与脚本调用 sched.yield() 的区别由
+ * preempted 标志记录；被挂起的任务排到本轮最后，下一帧从它后面的任务开始，
+ * 一个一直占满预算的任务不会让其它任务饿死。
+ *
+ * 钩子的检查间隔按估算的执行速度（每毫秒指令数）计算，使下一次检查落在剩余时间的一半处：
+ * 离截止时间远时少检查，接近时间隔缩短到 LUA_SCHED_HOOK_COUNT_MIN 条指令，
+ * 在截止时间之前 LUA_SCHED_HEADROOM_US 挂起，单帧不会因为一次检查间隔太长而超出预算。
+ * 注意只要设置了计数钩子，Lua 虚拟机每条指令都要经过钩子检查（与间隔无关），
+ * 任务的执行速度因此比不设钩子时慢，这部分开销由 lua_sched_bench 单独测量。
+ */
+
+#include "lua_sched.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if USE_LUA
+
+#include "lauxlib.h"
+
+#ifndef LUA_SCHED_STANDALONE
+#include "lvgl/lvgl.h"
+
+#define LUA_SCHED_PERIOD_MS     LV_DEF_REFR_PERIOD  /**< 调度定时器周期，每个显示帧运行一次 */
+#endif
+
+/**
+ * @brief 任务
+ */
+typedef struct {
+    lua_State *co;      /**< 任务线程，NULL 表示空槽 */
+    int ref;            /**< 线程在注册表中的引用 */
+    int id;             /**< 任务ID */
+    int nargs;          /**< 第一次恢复时传给函数的参数个数 */
+    uint64_t wake_us;   /**< sleep 挂起到该时间，0 表示就绪 */
+    bool cancelled;     /**< 已结束，恢复返回后释放 */
+} sched_task_t;
+
+static lua_State *host = NULL;
+static sched_task_t tasks[LUA_SCHED_MAX_TASKS];
+static int task_count = 0;
+static int next_id = 1;
+static int next_slot = 0;                       // 下一帧从这个槽开始轮转
+static uint32_t budget = LUA_SCHED_BUDGET_US;
+static uint64_t deadline = 0;                   // 超过时在钩子中挂起任务
+static uint64_t hard_deadline = 0;              // 不能挂起时超过该时间中止
+static lua_State *running = NULL;               // 正在执行的任务线程
+static bool preempted = false;
+static uint64_t last_check_us = 0;              // 上一次检查时间（或开始执行的时间）
+static uint32_t insts_per_ms = 20000;           // 估算的每毫秒执行指令数
+static lua_sched_stats_t sched_stats;
+#ifndef LUA_SCHED_STANDALONE
+static lv_timer_t *sched_timer = NULL;
+#endif
+
+static void budget_hook(lua_State *L, lua_Debug *ar);
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/**
+ * @brief 距离截止时间还有 remaining_us 时的检查间隔（指令数）：下一次检查落在剩余时间的一半处
+ */
+static int hook_count_for(uint64_t remaining_us) {
+    uint64_t count = (uint64_t)insts_per_ms * remaining_us / 2000u;
+    if (count < LUA_SCHED_HOOK_COUNT_MIN) {
+        return LUA_SCHED_HOOK_COUNT_MIN;
+    }
+    return count > LUA_SCHED_HOOK_COUNT_MAX ? LUA_SCHED_HOOK_COUNT_MAX : (int)count;
+}
+
+/**
+ * @brief 在 L 上设置钩子，从现在开始计时
+ */
+static void arm_hook(lua_State *L, uint64_t now, uint64_t limit) {
+    last_check_us = now;
+    lua_sethook(L, budget_hook, LUA_MASKCOUNT, hook_count_for(limit > now ? limit - now : 0));
+}
+
+/**
+ * @brief 指令计数钩子：预算快用完时挂起任务，无法挂起且超过上限时中止，否则调整下一次检查的间隔
+ */
+static void budget_hook(lua_State *L, lua_Debug *ar) {
+    (void)ar;
+    uint64_t now = now_us();
+    int count = lua_gethookcount(L);
+
+    // 更新执行速度的估算（间隔中包含 C 函数的时间，估算偏慢，检查只会更频繁）
+    uint64_t elapsed = now - last_check_us;
+    if (elapsed > 0) {
+        uint64_t rate = (uint64_t)count * 1000u / elapsed;
+        rate = (insts_per_ms * 3u + rate) / 4u;
+        insts_per_ms = rate > 0 ? (rate < UINT32_MAX ? (uint32_t)rate : UINT32_MAX) : 1;
+    }
+    last_check_us = now;
+
+    bool can_yield = L == running && lua_isyieldable(L);
+    uint64_t limit = can_yield ? deadline - LUA_SCHED_HEADROOM_US : hard_deadline;
+    if (now < limit) {
+        int next = hook_count_for(limit - now);
+        if (next != count) {
+            lua_sethook(L, budget_hook, LUA_MASKCOUNT, next);
+        }
+        return;
+    }
+    // 钩子中挂起必须是钩子的最后一个调用
+    if (can_yield) {
+        preempted = true;
+        lua_yield(L, 0);
+        return;
+    }
+    sched_stats.aborts++;
+    luaL_error(L, "脚本执行超过 %d 毫秒，已中止", LUA_SCHED_CALL_LIMIT_US / 1000);
+}
+
+static sched_task_t *find_task(lua_State *co) {
+    for (int i = 0; i < LUA_SCHED_MAX_TASKS; i++) {
+        if (tasks[i].co != NULL && tasks[i].co == co) {
+            return &tasks[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 有任务时运行定时器，没有任务时暂停
+ */
+static void update_timer(void) {
+#ifndef LUA_SCHED_STANDALONE
+    if (sched_timer == NULL) {
+        return;
+    }
+    if (task_count > 0) {
+        lv_timer_resume(sched_timer);
+    } else {
+        lv_timer_pause(sched_timer);
+    }
+#endif
+}
+
+static void free_task(sched_task_t *t) {
+    luaL_unref(host, LUA_REGISTRYINDEX, t->ref);
+    memset(t, 0, sizeof(*t));
+    task_count--;
+}
+
+/**
+ * @brief 恢复任务一次，结束或出错时释放
+ */
+static void resume_task(sched_task_t *t) {
+    int nres = 0;
+    running = t->co;
+    preempted = false;
+    arm_hook(t->co, now_us(), deadline - LUA_SCHED_HEADROOM_US);
+    int status = lua_resume(t->co, host, t->nargs, &nres);
+    running = NULL;
+    t->nargs = 0;
+    sched_stats.slices++;
+
+    if (status == LUA_YIELD) {
+        lua_pop(t->co, nres);
+        if (preempted) {
+            sched_stats.preempts++;
+        }
+        if (!t->cancelled) {
+            return;
+        }
+    } else if (status != LUA_OK) {
+        const char *msg = lua_tostring(t->co, -1);
+        luaL_traceback(host, t->co, msg ? msg : "(错误对象不是字符串)", 0);
+        printf("[lua] 任务 %d 出错: %s\n", t->id, lua_tostring(host, -1));
+        lua_pop(host, 1);
+    }
+    free_task(t);
+}
+
+/*=====================
+ * sched 表
+ *====================*/
+
+static int l_spawn(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    int id = lua_sched_spawn(L, lua_gettop(L) - 1);
+    if (id < 0) {
+        return luaL_error(L, "任务数已达上限（%d）", LUA_SCHED_MAX_TASKS);
+    }
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+static int l_yield(lua_State *L) {
+    if (find_task(L) == NULL) {
+        return luaL_error(L, "sched.yield 只能在任务中调用");
+    }
+    return lua_yield(L, 0);
+}
+
+static int l_sleep(lua_State *L) {
+    lua_Integer ms = luaL_checkinteger(L, 1);
+    sched_task_t *t = find_task(L);
+    if (t == NULL) {
+        return luaL_error(L, "sched.sleep 只能在任务中调用");
+    }
+    // wake_us 为0表示就绪，至少挂起到下一帧
+    t->wake_us = now_us() + (uint64_t)(ms > 0 ? ms : 0) * 1000u + 1;
+    return lua_yield(L, 0);
+}
+
+static int l_cancel(lua_State *L) {
+    int id = (int)luaL_checkinteger(L, 1);
+    bool found = lua_sched_cancel(id);
+    // 结束自身时立即挂起，不再继续执行
+    sched_task_t *self = find_task(L);
+    if (self != NULL && self->cancelled) {
+        return lua_yield(L, 0);
+    }
+    lua_pushboolean(L, found);
+    return 1;
+}
+
+static const luaL_Reg sched_funcs[] = {
+    { "spawn", l_spawn },
+    { "yield", l_yield },
+    { "sleep", l_sleep },
+    { "cancel", l_cancel },
+    { NULL, NULL }
+};
+
+/*=====================
+ * 接口
+ *====================*/
+
+#ifndef LUA_SCHED_STANDALONE
+static void sched_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    lua_sched_run();
+}
+#endif
+
+bool lua_sched_init(lua_State *L, uint32_t budget_us) {
+    lua_sched_deinit();
+    host = L;
+    lua_sched_set_budget(budget_us);
+    memset(&sched_stats, 0, sizeof(sched_stats));
+
+    luaL_newlib(L, sched_funcs);
+    lua_setglobal(L, "sched");
+
+#ifndef LUA_SCHED_STANDALONE
+    sched_timer = lv_timer_create(sched_timer_cb, LUA_SCHED_PERIOD_MS, NULL);
+    if (sched_timer == NULL) {
+        host = NULL;
+        return false;
+    }
+    lv_timer_pause(sched_timer);
+#endif
+    return true;
+}
+
+void lua_sched_set_budget(uint32_t budget_us) {
+    budget = budget_us > 0 ? budget_us : LUA_SCHED_BUDGET_US;
+}
+
+int lua_sched_spawn(lua_State *L, int nargs) {
+    sched_task_t *t = NULL;
+    for (int i = 0; host != NULL && i < LUA_SCHED_MAX_TASKS; i++) {
+        if (tasks[i].co == NULL) {
+            t = &tasks[i];
+            break;
+        }
+    }
+    if (t == NULL) {
+        lua_pop(L, nargs + 1);
+        return -1;
+    }
+
+    // 线程放到函数下面，函数和参数移到新线程，线程本身存入注册表
+    lua_State *co = lua_newthread(L);
+    lua_insert(L, -(nargs + 2));
+    lua_xmove(L, co, nargs + 1);
+    lua_sethook(co, budget_hook, LUA_MASKCOUNT, LUA_SCHED_HOOK_COUNT_MAX);
+
+    t->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    t->co = co;
+    t->id = next_id;
+    t->nargs = nargs;
+    t->wake_us = 0;
+    t->cancelled = false;
+    next_id = next_id < INT32_MAX ? next_id + 1 : 1;
+    task_count++;
+    update_timer();
+    return t->id;
+}
+
+bool lua_sched_cancel(int id) {
+    for (int i = 0; i < LUA_SCHED_MAX_TASKS; i++) {
+        sched_task_t *t = &tasks[i];
+        if (t->co == NULL || t->id != id || t->cancelled) {
+            continue;
+        }
+        // 正在执行的任务在恢复返回后释放
+        if (t->co == running) {
+            t->cancelled = true;
+        } else {
+            free_task(t);
+            update_timer();
+        }
+        return true;
+    }
+    return false;
+}
+
+int lua_sched_count(void) {
+    return task_count;
+}
+
+uint32_t lua_sched_run(void) {
+    if (host == NULL || task_count == 0) {
+        return 0;
+    }
+
+    uint64_t start = now_us();
+    deadline = start + budget;
+    hard_deadline = deadline + LUA_SCHED_CALL_LIMIT_US;
+
+    int slot = next_slot;
+    for (int i = 0; i < LUA_SCHED_MAX_TASKS && task_count > 0; i++) {
+        sched_task_t *t = &tasks[slot];
+        slot = (slot + 1) % LUA_SCHED_MAX_TASKS;
+        if (t->co == NULL) {
+            continue;
+        }
+        if (t->wake_us != 0) {
+            if (start < t->wake_us) {
+                continue;
+            }
+            t->wake_us = 0;
+        }
+        if (now_us() >= deadline) {
+            // 这个任务本帧没有轮到，下一帧从它开始
+            slot = (int)(t - tasks);
+            break;
+        }
+        resume_task(t);
+        if (preempted) {
+            break;
+        }
+    }
+    next_slot = slot;
+    preempted = false;
+
+    uint32_t used = (uint32_t)(now_us() - start);
+    sched_stats.frames++;
+    sched_stats.last_us = used;
+    sched_stats.total_us += used;
+    if (used > sched_stats.max_us) {
+        sched_stats.max_us = used;
+    }
+    update_timer();
+    return used;
+}
+
+int lua_sched_pcall(lua_State *L, int nargs, int nresults) {
+    lua_Hook old_hook = lua_gethook(L);
+    int old_mask = lua_gethookmask(L);
+    int old_count = lua_gethookcount(L);
+    uint64_t old_deadline = deadline;
+    uint64_t old_hard = hard_deadline;
+    uint64_t old_check = last_check_us;
+
+    uint64_t now = now_us();
+    deadline = now + LUA_SCHED_CALL_LIMIT_US;
+    hard_deadline = deadline;
+    arm_hook(L, now, hard_deadline);
+    int status = lua_pcall(L, nargs, nresults, 0);
+    lua_sethook(L, old_hook, old_mask, old_count);
+
+    deadline = old_deadline;
+    hard_deadline = old_hard;
+    last_check_us = old_check;
+    return status;
+}
+
+void lua_sched_get_stats(lua_sched_stats_t *stats) {
+    *stats = sched_stats;
+}
+
+void lua_sched_deinit(void) {
+    for (int i = 0; host != NULL && i < LUA_SCHED_MAX_TASKS; i++) {
+        if (tasks[i].co != NULL) {
+            free_task(&tasks[i]);
+        }
+    }
+    memset(tasks, 0, sizeof(tasks));
+    task_count = 0;
+    next_slot = 0;
+#ifndef LUA_SCHED_STANDALONE
+    if (sched_timer != NULL) {
+        lv_timer_delete(sched_timer);
+        sched_timer = NULL;
+    }
+#endif
+    host = NULL;
+}
+
+#endif /* USE_LUA */
@@ -0,0 +1,113 @@
+/**
+ * @file lua_sched.h
+ * @brief Lua 脚本分时调度头文件
+ *
+ * 长时间运行的脚本作为协程任务执行：LVGL 定时器每个显示帧恢复一次就绪的任务，
+ * 每帧的执行时间不超过预算（默认 LUA_SCHED_BUDGET_US）。任务线程上设置了指令计数钩子，
+ * 离截止时间越近检查时间越频繁（每 LUA_SCHED_HOOK_COUNT_MAX 到 LUA_SCHED_HOOK_COUNT_MIN
+ * 条指令一次），剩余时间不足 LUA_SCHED_HEADROOM_US 时在钩子中挂起任务，
+ * 下一帧从挂起处继续，脚本不需要主动让出。没有任务时定时器暂停，不占用帧时间。
+ *
+ * 脚本可以使用的函数（sched 表）：
+ *   sched.spawn(f, ...)  创建任务，返回任务ID
+ *   sched.yield()        让出本帧剩余的时间
+ *   sched.sleep(ms)      挂起指定毫秒数
+ *   sched.cancel(id)     结束任务
+ *
+ * 不能挂起的同步调用（页面脚本、条件表达式）用 lua_sched_pcall 执行，
+ * 超过 LUA_SCHED_CALL_LIMIT_US 时报错中止；任务在不能挂起的位置（如 table.sort 的比较函数中）
+ * 超出预算同样的时间时也会被中止。
+ *
+ * 需要完整的 Lua 运行时，编译时定义 USE_LUA=1 才可用（CMake 选项 V833_ENABLE_LUA）。
+ * 所有接口只能在 LVGL 主线程调用。定义 LUA_SCHED_STANDALONE 时不使用 LVGL
+ * （由调用方调用 lua_sched_run，用于 tools/lua_sched_bench）。
+ */
+
+#ifndef LUA_SCHED_H
+#define LUA_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lua.h"
+
+#ifndef USE_LUA
+#define USE_LUA 0
+#endif
+
+#define LUA_SCHED_BUDGET_US     2000    /**< 默认每帧预算（微秒） */
+#define LUA_SCHED_HOOK_COUNT_MAX 5000   /**< 离截止时间较远时每多少条指令检查一次时间 */
+#define LUA_SCHED_HOOK_COUNT_MIN 50     /**< 接近截止时间时每多少条指令检查一次时间 */
+#define LUA_SCHED_HEADROOM_US   100     /**< 距截止时间不足该值时挂起（下一次检查前的余量） */
+#define LUA_SCHED_CALL_LIMIT_US 50000   /**< 同步调用最长执行时间（微秒），超过时中止 */
+#define LUA_SCHED_MAX_TASKS     32      /**< 最多同时存在的任务数 */
+
+/**
+ * @brief 调度统计
+ */
+typedef struct {
+    uint32_t frames;        /**< 运行过任务的帧数 */
+    uint32_t slices;        /**< 恢复任务的次数 */
+    uint32_t preempts;      /**< 因预算用完被挂起的次数 */
+    uint32_t aborts;        /**< 超时被中止的任务和同步调用数 */
+    uint32_t last_us;       /**< 上一帧的执行时间 */
+    uint32_t max_us;        /**< 单帧最长执行时间 */
+    uint64_t total_us;      /**< 累计执行时间 */
+} lua_sched_stats_t;
+
+/**
+ * @brief 初始化调度器：在 L 中注册 sched 表并创建帧定时器（初始暂停）
+ * @param L 主 lua_State，任务线程由它创建
+ * @param budget_us 每帧预算（微秒），0 使用 LUA_SCHED_BUDGET_US
+ * @return 是否成功
+ */
+bool lua_sched_init(lua_State *L, uint32_t budget_us);
+
+/**
+ * @brief 设置每帧预算
+ * @param budget_us 预算（微秒），0 使用 LUA_SCHED_BUDGET_US
+ */
+void lua_sched_set_budget(uint32_t budget_us);
+
+/**
+ * @brief 创建任务：栈顶为函数和 nargs 个参数，调用后从栈上弹出
+ * @param L 主 lua_State 或任务线程
+ * @param nargs 参数个数
+ * @return 任务ID（大于0），任务数已满时返回-1（函数和参数同样被弹出）
+ */
+int lua_sched_spawn(lua_State *L, int nargs);
+
+/**
+ * @brief 结束任务（可以在任务自身中调用，任务挂起后不再恢复）
+ * @param id 任务ID
+ * @return 任务是否存在
+ */
+bool lua_sched_cancel(int id);
+
+/**
+ * @brief 获取未结束的任务数
+ */
+int lua_sched_count(void);
+
+/**
+ * @brief 执行一帧：按轮转顺序恢复就绪的任务，直到全部让出或预算用完（定时器回调中调用）
+ * @return 本帧的执行时间（微秒）
+ */
+uint32_t lua_sched_run(void);
+
+/**
+ * @brief 带时间上限的 lua_pcall（参数同 lua_pcall），超过 LUA_SCHED_CALL_LIMIT_US 时以错误返回
+ */
+int lua_sched_pcall(lua_State *L, int nargs, int nresults);
+
+/**
+ * @brief 获取调度统计
+ * @param stats 输出
+ */
+void lua_sched_get_stats(lua_sched_stats_t *stats);
+
+/**
+ * @brief 结束所有任务并删除定时器（在 lua_close 之前调用）
+ */
+void lua_sched_deinit(void);
+
+#endif /* LUA_SCHED_H */
@@ -0,0 +1,430 @@
+/**
+ * @file lv_lua.c
+ * @brief LVGL 的 Lua 绑定实现
+ *
+ * lv_lua.def 被包含两次：第一次展开为绑定函数，第二次展开为注册表。绑定函数的
+ * upvalue 1 为对象元表，upvalue 2 为对象缓存表（lv_obj_t 指针 -> userdata，强引用，
+ * 对象删除时移除）。userdata 只包含一个 lv_obj_t 指针，user value 1 为事件处理函数表。
+ *
+ * 所有对象共用一个元表，label_set_text 等类专用函数也是所有对象的方法，参数类型
+ * LABEL/IMAGE 在调用时用 lv_obj_check_type 检查对象的类，不匹配时报错而不是把按钮
+ * 当成标签写内存。屏幕和 lv_lua_protect 标记的对象（应用的根对象）不能在脚本中删除。
+ */
+
+#include "lv_lua.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if USE_LUA
+
+#include "lauxlib.h"
+#include "lua_sched.h"
+
+#define UV_META     lua_upvalueindex(1)
+#define UV_CACHE    lua_upvalueindex(2)
+
+static lua_State *bind_state = NULL;
+static int meta_ref = LUA_NOREF;
+static int cache_ref = LUA_NOREF;
+static int protect_ref = LUA_NOREF;     /**< 受保护对象表（lv_obj_t 指针 -> true） */
+
+static void event_cb(lv_event_t *e);
+static void delete_cb(lv_event_t *e);
+
+/**
+ * @brief 压入对象的 userdata，没有时创建并放入缓存
+ * @param meta 元表的栈下标（或 upvalue 下标）
+ * @param cache 缓存表的栈下标（或 upvalue 下标）
+ */
+static void push_obj(lua_State *L, lv_obj_t *obj, int meta, int cache) {
+    if (obj == NULL) {
+        lua_pushnil(L);
+        return;
+    }
+    if (lua_rawgetp(L, cache, obj) != LUA_TNIL) {
+        return;
+    }
+    lua_pop(L, 1);
+
+    lv_obj_t **ud = (lv_obj_t **)lua_newuserdatauv(L, sizeof(lv_obj_t *), 1);
+    *ud = obj;
+    lua_pushvalue(L, meta);
+    lua_setmetatable(L, -2);
+    lua_pushvalue(L, -1);
+    lua_rawsetp(L, cache, obj);
+    lv_obj_add_event_cb(obj, delete_cb, LV_EVENT_DELETE, NULL);
+}
+
+/**
+ * @brief 检查参数是对象（元表与 upvalue 中的元表相同）且未删除
+ */
+static lv_obj_t *check_obj(lua_State *L, int idx) {
+    lv_obj_t **ud = (lv_obj_t **)lua_touserdata(L, idx);
+    if (ud == NULL || !lua_getmetatable(L, idx)) {
+        luaL_typeerror(L, idx, LV_LUA_TYPE);
+    }
+    bool same = lua_rawequal(L, -1, UV_META);
+    lua_pop(L, 1);
+    if (!same) {
+        luaL_typeerror(L, idx, LV_LUA_TYPE);
+    }
+    if (*ud == NULL) {
+        luaL_argerror(L, idx, "对象已删除");
+    }
+    return *ud;
+}
+
+static lv_obj_t *opt_obj(lua_State *L, int idx) {
+    return lua_isnoneornil(L, idx) ? NULL : check_obj(L, idx);
+}
+
+/**
+ * @brief 检查参数是指定类的对象（label_set_text 只能用于标签）
+ */
+static lv_obj_t *check_class(lua_State *L, int idx, const lv_obj_class_t *cls, const char *msg) {
+    lv_obj_t *obj = check_obj(L, idx);
+    if (!lv_obj_check_type(obj, cls)) {
+        luaL_argerror(L, idx, msg);
+    }
+    return obj;
+}
+
+/**
+ * @brief 检查参数是可以删除的对象：不是屏幕，也不是受保护的对象
+ */
+static lv_obj_t *check_deletable(lua_State *L, int idx) {
+    lv_obj_t *obj = check_obj(L, idx);
+    if (lv_obj_get_parent(obj) == NULL) {
+        luaL_argerror(L, idx, "不能删除屏幕");
+    }
+    lua_rawgeti(L, LUA_REGISTRYINDEX, protect_ref);
+    bool protect = lua_rawgetp(L, -1, obj) != LUA_TNIL;
+    lua_pop(L, 2);
+    if (protect) {
+        luaL_argerror(L, idx, "不能删除应用的根对象");
+    }
+    return obj;
+}
+
+/*=====================
+ * 生成的绑定函数
+ *====================*/
+
+#define ARG_OBJ(L, i)       check_obj(L, i)
+#define ARG_LABEL(L, i)     check_class(L, i, &lv_label_class, "不是标签")
+#define ARG_IMAGE(L, i)     check_class(L, i, &lv_image_class, "不是图片")
+#define ARG_DELETABLE(L, i) check_deletable(L, i)
+#define ARG_INT(L, i)       ((int32_t)luaL_checkinteger(L, i))
+#define ARG_U32(L, i)       ((uint32_t)luaL_checkinteger(L, i))
+#define ARG_BOOL(L, i)      (lua_toboolean(L, i) != 0)
+#define ARG_STR(L, i)       luaL_checkstring(L, i)
+#define ARG_COLOR(L, i)     lv_color_hex((uint32_t)luaL_checkinteger(L, i))
+
+#define RET_VOID(L, call)   call; return 0
+#define RET_INT(L, call)    lua_pushinteger(L, (lua_Integer)(call)); return 1
+#define RET_BOOL(L, call)   lua_pushboolean(L, (call)); return 1
+#define RET_STR(L, call)    lua_pushstring(L, (call)); return 1
+#define RET_OBJ(L, call)    push_obj(L, (call), UV_META, UV_CACHE); return 1
+
+#define LV_LUA_NEW(t) \
+    static int l_##t##_create(lua_State *L) { RET_OBJ(L, lv_##t##_create(opt_obj(L, 1))); }
+#define LV_LUA_FN0(n, r) \
+    static int l_##n(lua_State *L) { RET_##r(L, lv_##n()); }
+#define LV_LUA_FN1(n, r, a) \
+    static int l_##n(lua_State *L) { RET_##r(L, lv_##n(ARG_##a(L, 1))); }
+#define LV_LUA_FN2(n, r, a, b) \
+    static int l_##n(lua_State *L) { RET_##r(L, lv_##n(ARG_##a(L, 1), ARG_##b(L, 2))); }
+#define LV_LUA_FN3(n, r, a, b, c) \
+    static int l_##n(lua_State *L) { RET_##r(L, lv_##n(ARG_##a(L, 1), ARG_##b(L, 2), ARG_##c(L, 3))); }
+#define LV_LUA_FN4(n, r, a, b, c, d) \
+    static int l_##n(lua_State *L) { \
+        RET_##r(L, lv_##n(ARG_##a(L, 1), ARG_##b(L, 2), ARG_##c(L, 3), ARG_##d(L, 4))); \
+    }
+#define LV_LUA_CONST(n)
+
+#include "lv_lua.def"
+
+#undef LV_LUA_NEW
+#undef LV_LUA_FN0
+#undef LV_LUA_FN1
+#undef LV_LUA_FN2
+#undef LV_LUA_FN3
+#undef LV_LUA_FN4
+#undef LV_LUA_CONST
+
+/**
+ * @brief 注册项
+ */
+typedef struct {
+    const char *name;       /**< lv 表中的名称 */
+    lua_CFunction fn;
+    bool method;            /**< 同时作为对象方法 */
+} lv_lua_reg_t;
+
+#define IS_OBJ_OBJ          true
+#define IS_OBJ_LABEL        true
+#define IS_OBJ_IMAGE        true
+#define IS_OBJ_DELETABLE    true
+#define IS_OBJ_INT          false
+#define IS_OBJ_U32          false
+#define IS_OBJ_BOOL         false
+#define IS_OBJ_STR          false
+#define IS_OBJ_COLOR        false
+
+#define LV_LUA_NEW(t)                   { #t "_create", l_##t##_create, false },
+#define LV_LUA_FN0(n, r)                { #n, l_##n, false },
+#define LV_LUA_FN1(n, r, a)             { #n, l_##n, IS_OBJ_##a },
+#define LV_LUA_FN2(n, r, a, b)          { #n, l_##n, IS_OBJ_##a },
+#define LV_LUA_FN3(n, r, a, b, c)       { #n, l_##n, IS_OBJ_##a },
+#define LV_LUA_FN4(n, r, a, b, c, d)    { #n, l_##n, IS_OBJ_##a },
+#define LV_LUA_CONST(n)
+
+static const lv_lua_reg_t lv_funcs[] = {
+#include "lv_lua.def"
+};
+
+#undef LV_LUA_NEW
+#undef LV_LUA_FN0
+#undef LV_LUA_FN1
+#undef LV_LUA_FN2
+#undef LV_LUA_FN3
+#undef LV_LUA_FN4
+#undef LV_LUA_CONST
+
+#define LV_LUA_NEW(t)
+#define LV_LUA_FN0(n, r)
+#define LV_LUA_FN1(n, r, a)
+#define LV_LUA_FN2(n, r, a, b)
+#define LV_LUA_FN3(n, r, a, b, c)
+#define LV_LUA_FN4(n, r, a, b, c, d)
+#define LV_LUA_CONST(n)                 { #n, (lua_Integer)LV_##n },
+
+static const struct {
+    const char *name;
+    lua_Integer value;
+} lv_consts[] = {
+#include "lv_lua.def"
+};
+
+#undef LV_LUA_NEW
+#undef LV_LUA_FN0
+#undef LV_LUA_FN1
+#undef LV_LUA_FN2
+#undef LV_LUA_FN3
+#undef LV_LUA_FN4
+#undef LV_LUA_CONST
+
+/*=====================
+ * 事件
+ *====================*/
+
+/**
+ * @brief o:on(code, fn)：设置事件处理函数，fn 为 nil 时取消
+ */
+static int l_on(lua_State *L) {
+    lv_obj_t *obj = check_obj(L, 1);
+    lua_Integer code = luaL_checkinteger(L, 2);
+    if (lua_isnoneornil(L, 3)) {
+        lv_obj_remove_event_cb_with_user_data(obj, event_cb, (void *)(intptr_t)code);
+        if (lua_getiuservalue(L, 1, 1) == LUA_TTABLE) {
+            lua_pushnil(L);
+            lua_rawseti(L, -2, code);
+        }
+        return 0;
+    }
+    luaL_checktype(L, 3, LUA_TFUNCTION);
+
+    if (lua_getiuservalue(L, 1, 1) != LUA_TTABLE) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setiuservalue(L, 1, 1);
+    }
+    // 每种事件只注册一次 LVGL 回调，事件码放在 user_data 中
+    if (lua_rawgeti(L, -1, code) == LUA_TNIL) {
+        lv_obj_add_event_cb(obj, event_cb, (lv_event_code_t)code, (void *)(intptr_t)code);
+    }
+    lua_pop(L, 1);
+    lua_pushvalue(L, 3);
+    lua_rawseti(L, -2, code);
+    return 0;
+}
+
+static int l_off(lua_State *L) {
+    lua_settop(L, 2);
+    return l_on(L);
+}
+
+static int l_tostring(lua_State *L) {
+    lv_obj_t **ud = (lv_obj_t **)lua_touserdata(L, 1);
+    lua_pushfstring(L, LV_LUA_TYPE ": %p", ud != NULL ? (void *)*ud : NULL);
+    return 1;
+}
+
+static void event_cb(lv_event_t *e) {
+    lua_State *L = bind_state;
+    if (L == NULL) {
+        return;
+    }
+    lv_obj_t *obj = (lv_obj_t *)lv_event_get_current_target(e);
+    lua_Integer code = (lua_Integer)(intptr_t)lv_event_get_user_data(e);
+    int top = lua_gettop(L);
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, cache_ref);
+    if (lua_rawgetp(L, -1, obj) == LUA_TUSERDATA &&
+        lua_getiuservalue(L, -1, 1) == LUA_TTABLE &&
+        lua_rawgeti(L, -1, code) == LUA_TFUNCTION) {
+        lua_pushvalue(L, top + 2);
+        lua_pushinteger(L, (lua_Integer)lv_event_get_code(e));
+        if (lua_sched_pcall(L, 2, 0) != LUA_OK) {
+            printf("[lua] 事件处理出错: %s\n", lua_tostring(L, -1));
+        }
+    }
+    lua_settop(L, top);
+}
+
+/**
+ * @brief 对象删除时清空 userdata 中的指针并移出缓存
+ */
+static void delete_cb(lv_event_t *e) {
+    lua_State *L = bind_state;
+    if (L == NULL) {
+        return;
+    }
+    lv_obj_t *obj = (lv_obj_t *)lv_event_get_target(e);
+    int top = lua_gettop(L);
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, cache_ref);
+    if (lua_rawgetp(L, -1, obj) == LUA_TUSERDATA) {
+        *(lv_obj_t **)lua_touserdata(L, -1) = NULL;
+        lua_pushnil(L);
+        lua_rawsetp(L, top + 1, obj);
+    }
+    lua_rawgeti(L, LUA_REGISTRYINDEX, protect_ref);
+    lua_pushnil(L);
+    lua_rawsetp(L, -2, obj);
+    lua_settop(L, top);
+}
+
+/*=====================
+ * 接口
+ *====================*/
+
+bool lv_lua_open(lua_State *L) {
+    lv_lua_close();
+
+    // 对象元表，方法表作为 __index
+    luaL_newmetatable(L, LV_LUA_TYPE);
+    lua_newtable(L);
+    lua_newtable(L);
+
+    // 栈: 元表 方法表 缓存表
+    int meta = lua_absindex(L, -3);
+    int methods = lua_absindex(L, -2);
+    int cache = lua_absindex(L, -1);
+    size_t count = sizeof(lv_funcs) / sizeof(lv_funcs[0]);
+    lua_createtable(L, 0, (int)(count + sizeof(lv_consts) / sizeof(lv_consts[0])));
+    int lv = lua_absindex(L, -1);
+
+    for (size_t i = 0; i < count; i++) {
+        lua_pushvalue(L, meta);
+        lua_pushvalue(L, cache);
+        lua_pushcclosure(L, lv_funcs[i].fn, 2);
+        if (lv_funcs[i].method) {
+            // obj_set_pos -> set_pos
+            const char *method = strchr(lv_funcs[i].name, '_');
+            lua_pushvalue(L, -1);
+            lua_setfield(L, methods, method != NULL ? method + 1 : lv_funcs[i].name);
+        }
+        lua_setfield(L, lv, lv_funcs[i].name);
+    }
+
+    static const char *const handlers[] = { "on", "off" };
+    const lua_CFunction handler_fns[] = { l_on, l_off };
+    for (size_t i = 0; i < 2; i++) {
+        lua_pushvalue(L, meta);
+        lua_pushvalue(L, cache);
+        lua_pushcclosure(L, handler_fns[i], 2);
+        lua_setfield(L, methods, handlers[i]);
+    }
+
+    for (size_t i = 0; i < sizeof(lv_consts) / sizeof(lv_consts[0]); i++) {
+        lua_pushinteger(L, lv_consts[i].value);
+        lua_setfield(L, lv, lv_consts[i].name);
+    }
+    lua_setglobal(L, "lv");
+
+    lua_pushvalue(L, methods);
+    lua_setfield(L, meta, "__index");
+    lua_pushcfunction(L, l_tostring);
+    lua_setfield(L, meta, "__tostring");
+
+    cache_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_pop(L, 1);
+    meta_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_newtable(L);
+    protect_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    bind_state = L;
+    return true;
+}
+
+void lv_lua_push_obj(lua_State *L, lv_obj_t *obj) {
+    lua_rawgeti(L, LUA_REGISTRYINDEX, meta_ref);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, cache_ref);
+    int top = lua_gettop(L);
+    push_obj(L, obj, top - 1, top);
+    lua_replace(L, top - 1);
+    lua_pop(L, 1);
+}
+
+void lv_lua_protect(lv_obj_t *obj) {
+    lua_State *L = bind_state;
+    if (L == NULL || obj == NULL) {
+        return;
+    }
+    // 放入缓存以注册 delete_cb，对象删除时移出受保护表
+    lv_lua_push_obj(L, obj);
+    lua_pop(L, 1);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, protect_ref);
+    lua_pushboolean(L, 1);
+    lua_rawsetp(L, -2, obj);
+    lua_pop(L, 1);
+}
+
+lv_obj_t *lv_lua_to_obj(lua_State *L, int idx) {
+    lv_obj_t **ud = (lv_obj_t **)luaL_testudata(L, idx, LV_LUA_TYPE);
+    return ud != NULL ? *ud : NULL;
+}
+
+void lv_lua_close(void) {
+    lua_State *L = bind_state;
+    if (L == NULL) {
+        return;
+    }
+
+    // 仍然存在的对象上移除回调，之后删除对象不再访问 lua_State
+    lua_rawgeti(L, LUA_REGISTRYINDEX, cache_ref);
+    lua_pushnil(L);
+    while (lua_next(L, -2) != 0) {
+        lv_obj_t *obj = *(lv_obj_t **)lua_touserdata(L, -1);
+        if (obj != NULL) {
+            while (lv_obj_remove_event_cb(obj, delete_cb)) {
+            }
+            while (lv_obj_remove_event_cb(obj, event_cb)) {
+            }
+        }
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+
+    luaL_unref(L, LUA_REGISTRYINDEX, cache_ref);
+    luaL_unref(L, LUA_REGISTRYINDEX, meta_ref);
+    luaL_unref(L, LUA_REGISTRYINDEX, protect_ref);
+    cache_ref = LUA_NOREF;
+    meta_ref = LUA_NOREF;
+    protect_ref = LUA_NOREF;
+    bind_state = NULL;
+}
+
+#endif /* USE_LUA */
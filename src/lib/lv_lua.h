@@ -0,0 +1,67 @@
+/**
+ * @file lv_lua.h
+ * @brief LVGL 的 Lua 绑定头文件
+ *
+ * 绑定函数由 lv_lua.def 中的函数列表用宏展开生成，脚本中为 lv 表中的函数
+ * （lv.obj_set_pos(o, x, y)），第一个参数为对象的函数同时是对象方法（o:set_pos(x, y)）。
+ *
+ * 每个 lv_obj_t 在第一次传给脚本时创建一个 userdata，之后按指针缓存，同一个对象
+ * 在脚本中总是同一个值，传入和返回对象都不再分配内存。对象的元表保存在每个绑定函数的
+ * upvalue 中，检查参数类型只是一次 lua_rawequal，不按名称查找注册表。对象删除时
+ * （LV_EVENT_DELETE）userdata 中的指针被清空，之后再使用会报错而不是访问已释放的内存。
+ * 标签、图片专用的函数检查对象的类，用在其他对象上会报错。
+ *
+ * 事件：o:on(lv.EVENT_CLICKED, function(o, code) ... end) 设置处理函数（同一事件只保留一个），
+ * o:off(code) 取消。处理函数用 lua_sched_pcall 执行，超时会被中止。
+ *
+ * 同一时间只绑定一个 lua_State。需要完整的 Lua 运行时（USE_LUA=1），
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef LV_LUA_H
+#define LV_LUA_H
+
+#include <stdbool.h>
+#include "lvgl/lvgl.h"
+#include "lua.h"
+
+#ifndef USE_LUA
+#define USE_LUA 0
+#endif
+
+#define LV_LUA_TYPE     "lv_obj"    /**< 对象的类型名（出错信息和 __name） */
+
+/**
+ * @brief 在 L 中注册全局表 lv（函数、常量和对象元表）
+ * @param L lua_State
+ * @return 是否成功
+ */
+bool lv_lua_open(lua_State *L);
+
+/**
+ * @brief 把对象传给脚本（第一次时创建 userdata）
+ * @param L lv_lua_open 绑定的 lua_State 或其中的线程
+ * @param obj 对象，NULL 时压入 nil
+ */
+void lv_lua_push_obj(lua_State *L, lv_obj_t *obj);
+
+/**
+ * @brief 标记对象为受保护：脚本不能用 obj_delete 删除（应用的根对象），对象删除时自动取消
+ * @param obj 对象
+ */
+void lv_lua_protect(lv_obj_t *obj);
+
+/**
+ * @brief 取出栈上的对象
+ * @param L lua_State
+ * @param idx 栈下标
+ * @return 对象，不是对象或对象已删除时返回NULL
+ */
+lv_obj_t *lv_lua_to_obj(lua_State *L, int idx);
+
+/**
+ * @brief 解除绑定：移除对象上的事件回调（在 lua_close 之前调用）
+ */
+void lv_lua_close(void);
+
+#endif /* LV_LUA_H */
@@ -0,0 +1,813 @@
+/**
+ * @file media_library.c
+ * @brief 媒体库索引实现
+ *
+ * 索引文件布局（本机字节序，偏移按 8 字节对齐）：
+ *   ml_header_t | ml_record_t[count] | uint32_t sorted[MEDIA_FIELD_COUNT][count] | 字符串表
+ * 字符串表中相同的艺术家/专辑只保存一次，偏移 0 固定为空串。
+ * 扫描线程写入临时文件后 rename 替换，主线程在定时器中重新 mmap。
+ */
+
+#include "media_library.h"
+#include "lvgl/lvgl.h"
+#include <libavformat/avformat.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#define ML_MAGIC        0x58494c4du    /* "MLIX" */
+#define ML_VERSION      1
+#define ML_MAX_DEPTH    16
+#define ML_TAG_MAX      256
+#define ML_POLL_MS      500
+
+/**
+ * @brief 索引文件头
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;                         /**< 曲目数量 */
+    uint32_t strtab_size;                   /**< 字符串表大小 */
+    uint32_t records_off;                   /**< 记录数组偏移 */
+    uint32_t sorted_off[MEDIA_FIELD_COUNT]; /**< 各字段排序数组偏移 */
+    uint32_t strtab_off;                    /**< 字符串表偏移 */
+    uint32_t file_size;                     /**< 文件总大小（用于校验） */
+} ml_header_t;
+
+/**
+ * @brief 定长曲目记录，字符串均为字符串表偏移
+ */
+typedef struct {
+    uint32_t path;
+    uint32_t title;
+    uint32_t artist;
+    uint32_t album;
+    uint32_t duration_ms;
+    uint32_t reserved;
+    int64_t mtime;
+    int64_t size;
+} ml_record_t;
+
+/**
+ * @brief 已映射的索引
+ */
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    const ml_header_t *hdr;
+    const ml_record_t *recs;
+    const uint32_t *sorted[MEDIA_FIELD_COUNT];
+    const char *strtab;
+} ml_index_t;
+
+/**
+ * @brief 扫描时构建中的索引
+ */
+typedef struct {
+    ml_record_t *recs;
+    int count;
+    int cap;
+    char *strtab;
+    uint32_t str_len;
+    uint32_t str_cap;
+    uint32_t *intern;       /**< 字符串去重哈希表，保存 偏移+1，0 为空位 */
+    uint32_t intern_mask;
+    uint32_t intern_count;
+} ml_builder_t;
+
+/**
+ * @brief 扫描上下文（仅扫描线程访问）
+ */
+typedef struct {
+    ml_builder_t b;
+    ml_index_t old;
+    uint32_t *old_hash;     /**< 旧索引 path -> 记录编号+1 */
+    uint32_t old_mask;
+    int reused;
+    int probed;
+} ml_scan_t;
+
+static const char *const audio_exts[] = { ".mp3", ".wav", ".flac", ".aac", ".ogg", ".m4a" };
+
+static ml_index_t current;
+static char roots_buf[PATH_MAX];
+static char index_path_buf[PATH_MAX];
+static pthread_t scan_tid;
+static bool scanning = false;      /* 只在主线程访问 */
+/* 主线程与扫描线程共享的标志，用 __atomic 访问 */
+static int scan_cancel = 0;
+static int scan_finished = 0;
+static lv_timer_t *poll_timer = NULL;
+static media_library_updated_cb_t updated_cb = NULL;
+static void *updated_user_data = NULL;
+
+/* qsort 没有上下文参数，排序只在扫描线程中进行，用静态变量传递 */
+static const ml_builder_t *sort_builder;
+static media_field_t sort_field;
+
+static uint32_t str_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool media_library_is_audio_path(const char *path) {
+    if (path == NULL) {
+        return false;
+    }
+
+    size_t len = strlen(path);
+    for (size_t i = 0; i < sizeof(audio_exts) / sizeof(audio_exts[0]); i++) {
+        size_t elen = strlen(audio_exts[i]);
+        if (len > elen && strcasecmp(path + len - elen, audio_exts[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*=====================
+ * 索引映射
+ *====================*/
+
+static void unmap_index(ml_index_t *idx) {
+    if (idx->base != NULL) {
+        munmap(idx->base, idx->size);
+    }
+    memset(idx, 0, sizeof(*idx));
+}
+
+static bool map_index(const char *path, ml_index_t *idx) {
+    memset(idx, 0, sizeof(*idx));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ml_header_t)) {
+        close(fd);
+        return false;
+    }
+
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+
+    const ml_header_t *hdr = (const ml_header_t *)base;
+    size_t size = (size_t)st.st_size;
+    // 偏移和大小都是 32 位，用 64 位计算，32 位平台上 count * sizeof 不会回绕
+    uint64_t recs_end = (uint64_t)hdr->records_off + (uint64_t)hdr->count * sizeof(ml_record_t);
+    bool ok = hdr->magic == ML_MAGIC && hdr->version == ML_VERSION &&
+              hdr->file_size == size && recs_end <= size &&
+              (uint64_t)hdr->strtab_off + hdr->strtab_size <= size && hdr->strtab_size > 0;
+    ok = ok && hdr->records_off % 8 == 0;
+    for (int f = 0; ok && f < MEDIA_FIELD_COUNT; f++) {
+        ok = (uint64_t)hdr->sorted_off[f] + (uint64_t)hdr->count * sizeof(uint32_t) <= size &&
+             hdr->sorted_off[f] % sizeof(uint32_t) == 0;
+    }
+    if (ok) {
+        // 字符串表必须以 '\0' 结尾，防止越界读取
+        ok = ((const char *)base)[hdr->strtab_off + hdr->strtab_size - 1] == '\0';
+    }
+    // 排序数组中的记录下标都必须小于 count，查询时直接用它们访问记录
+    for (int f = 0; ok && f < MEDIA_FIELD_COUNT; f++) {
+        const uint32_t *ids = (const uint32_t *)((const uint8_t *)base + hdr->sorted_off[f]);
+        for (uint32_t i = 0; ok && i < hdr->count; i++) {
+            ok = ids[i] < hdr->count;
+        }
+    }
+
+    if (!ok) {
+        printf("[media] Ignoring invalid index %s\n", path);
+        munmap(base, size);
+        return false;
+    }
+
+    idx->base = base;
+    idx->size = size;
+    idx->hdr = hdr;
+    idx->recs = (const ml_record_t *)((uint8_t *)base + hdr->records_off);
+    for (int f = 0; f < MEDIA_FIELD_COUNT; f++) {
+        idx->sorted[f] = (const uint32_t *)((uint8_t *)base + hdr->sorted_off[f]);
+    }
+    idx->strtab = (const char *)base + hdr->strtab_off;
+    return true;
+}
+
+static const char *idx_str(const ml_index_t *idx, uint32_t off) {
+    return off < idx->hdr->strtab_size ? idx->strtab + off : "";
+}
+
+static uint32_t field_offset(const ml_record_t *r, media_field_t field) {
+    switch (field) {
+        case MEDIA_FIELD_ARTIST: return r->artist;
+        case MEDIA_FIELD_ALBUM:  return r->album;
+        default:                 return r->title;
+    }
+}
+
+/*=====================
+ * 索引构建
+ *====================*/
+
+static bool builder_init(ml_builder_t *b) {
+    memset(b, 0, sizeof(*b));
+    b->str_cap = 4096;
+    b->strtab = malloc(b->str_cap);
+    b->intern_mask = 255;
+    b->intern = calloc(b->intern_mask + 1, sizeof(uint32_t));
+    if (b->strtab == NULL || b->intern == NULL) {
+        free(b->strtab);
+        free(b->intern);
+        return false;
+    }
+    b->strtab[0] = '\0';
+    b->str_len = 1;
+    return true;
+}
+
+static void builder_free(ml_builder_t *b) {
+    free(b->recs);
+    free(b->strtab);
+    free(b->intern);
+    memset(b, 0, sizeof(*b));
+}
+
+static bool intern_grow(ml_builder_t *b) {
+    uint32_t new_mask = b->intern_mask * 2 + 1;
+    uint32_t *table = calloc(new_mask + 1, sizeof(uint32_t));
+    if (table == NULL) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i <= b->intern_mask; i++) {
+        uint32_t v = b->intern[i];
+        if (v == 0) {
+            continue;
+        }
+        uint32_t h = str_hash(b->strtab + v - 1) & new_mask;
+        while (table[h] != 0) {
+            h = (h + 1) & new_mask;
+        }
+        table[h] = v;
+    }
+
+    free(b->intern);
+    b->intern = table;
+    b->intern_mask = new_mask;
+    return true;
+}
+
+/**
+ * @brief 将字符串加入字符串表（去重）
+ * @return 字符串偏移，失败返回 0（空串）
+ */
+static uint32_t builder_intern(ml_builder_t *b, const char *s) {
+    if (s == NULL || s[0] == '\0') {
+        return 0;
+    }
+
+    if ((b->intern_count + 1) * 2 > b->intern_mask && !intern_grow(b)) {
+        return 0;
+    }
+
+    uint32_t h = str_hash(s) & b->intern_mask;
+    while (b->intern[h] != 0) {
+        if (strcmp(b->strtab + b->intern[h] - 1, s) == 0) {
+            return b->intern[h] - 1;
+        }
+        h = (h + 1) & b->intern_mask;
+    }
+
+    uint32_t len = (uint32_t)strlen(s) + 1;
+    if (b->str_len + len > b->str_cap) {
+        uint32_t cap = b->str_cap;
+        while (b->str_len + len > cap) {
+            cap *= 2;
+        }
+        char *grown = realloc(b->strtab, cap);
+        if (grown == NULL) {
+            return 0;
+        }
+        b->strtab = grown;
+        b->str_cap = cap;
+    }
+
+    uint32_t off = b->str_len;
+    memcpy(b->strtab + off, s, len);
+    b->str_len += len;
+    b->intern[h] = off + 1;
+    b->intern_count++;
+    return off;
+}
+
+static ml_record_t *builder_add(ml_builder_t *b) {
+    if (b->count == b->cap) {
+        int cap = b->cap ? b->cap * 2 : 256;
+        ml_record_t *grown = realloc(b->recs, sizeof(ml_record_t) * cap);
+        if (grown == NULL) {
+            return NULL;
+        }
+        b->recs = grown;
+        b->cap = cap;
+    }
+    ml_record_t *r = &b->recs[b->count++];
+    memset(r, 0, sizeof(*r));
+    return r;
+}
+
+static int sort_compare(const void *a, const void *b) {
+    const ml_record_t *ra = &sort_builder->recs[*(const uint32_t *)a];
+    const ml_record_t *rb = &sort_builder->recs[*(const uint32_t *)b];
+    const char *st = sort_builder->strtab;
+
+    int r = strcasecmp(st + field_offset(ra, sort_field), st + field_offset(rb, sort_field));
+    if (r == 0 && sort_field != MEDIA_FIELD_TITLE) {
+        r = strcasecmp(st + ra->title, st + rb->title);
+    }
+    if (r == 0) {
+        r = strcmp(st + ra->path, st + rb->path);
+    }
+    return r;
+}
+
+static bool write_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return true;
+}
+
+static size_t align8(size_t v) {
+    return (v + 7) & ~(size_t)7;
+}
+
+/**
+ * @brief 排序并原子地写出索引文件
+ */
+static bool builder_write(ml_builder_t *b, const char *path) {
+    uint32_t count = (uint32_t)b->count;
+    uint32_t *sorted = malloc(sizeof(uint32_t) * (count ? count : 1) * MEDIA_FIELD_COUNT);
+    if (sorted == NULL) {
+        return false;
+    }
+
+    sort_builder = b;
+    for (int f = 0; f < MEDIA_FIELD_COUNT; f++) {
+        uint32_t *arr = sorted + (size_t)f * count;
+        for (uint32_t i = 0; i < count; i++) {
+            arr[i] = i;
+        }
+        sort_field = (media_field_t)f;
+        qsort(arr, count, sizeof(uint32_t), sort_compare);
+    }
+
+    ml_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = ML_MAGIC;
+    hdr.version = ML_VERSION;
+    hdr.count = count;
+    hdr.records_off = (uint32_t)align8(sizeof(hdr));
+    size_t off = hdr.records_off + sizeof(ml_record_t) * count;
+    for (int f = 0; f < MEDIA_FIELD_COUNT; f++) {
+        hdr.sorted_off[f] = (uint32_t)off;
+        off += sizeof(uint32_t) * count;
+    }
+    hdr.strtab_off = (uint32_t)align8(off);
+    hdr.strtab_size = b->str_len;
+    hdr.file_size = hdr.strtab_off + hdr.strtab_size;
+
+    char tmp_path[PATH_MAX + 4];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        printf("[media] Failed to create %s: %s\n", tmp_path, strerror(errno));
+        free(sorted);
+        return false;
+    }
+
+    static const uint8_t zeros[8] = {0};
+    size_t pad_hdr = hdr.records_off - sizeof(hdr);
+    size_t pad_str = hdr.strtab_off - off;
+    bool ok = write_all(fd, &hdr, sizeof(hdr)) &&
+              write_all(fd, zeros, pad_hdr) &&
+              write_all(fd, b->recs, sizeof(ml_record_t) * count) &&
+              write_all(fd, sorted, sizeof(uint32_t) * count * MEDIA_FIELD_COUNT) &&
+              write_all(fd, zeros, pad_str) &&
+              write_all(fd, b->strtab, b->str_len) &&
+              fsync(fd) == 0;
+    close(fd);
+    free(sorted);
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        printf("[media] Failed to write index %s\n", path);
+        unlink(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+/*=====================
+ * 扫描
+ *====================*/
+
+static void build_old_hash(ml_scan_t *s) {
+    uint32_t count = s->old.hdr ? s->old.hdr->count : 0;
+    if (count == 0) {
+        return;
+    }
+
+    uint32_t size = 16;
+    while (size < count * 2) {
+        size *= 2;
+    }
+    s->old_hash = calloc(size, sizeof(uint32_t));
+    if (s->old_hash == NULL) {
+        return;
+    }
+    s->old_mask = size - 1;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t h = str_hash(idx_str(&s->old, s->old.recs[i].path)) & s->old_mask;
+        while (s->old_hash[h] != 0) {
+            h = (h + 1) & s->old_mask;
+        }
+        s->old_hash[h] = i + 1;
+    }
+}
+
+static const ml_record_t *find_old(const ml_scan_t *s, const char *path) {
+    if (s->old_hash == NULL) {
+        return NULL;
+    }
+
+    uint32_t h = str_hash(path) & s->old_mask;
+    while (s->old_hash[h] != 0) {
+        const ml_record_t *r = &s->old.recs[s->old_hash[h] - 1];
+        if (strcmp(idx_str(&s->old, r->path), path) == 0) {
+            return r;
+        }
+        h = (h + 1) & s->old_mask;
+    }
+    return NULL;
+}
+
+static void copy_tag(AVFormatContext *fmt, const char *key, char *out, size_t out_size) {
+    if (out[0] != '\0') {
+        return;
+    }
+
+    AVDictionaryEntry *e = av_dict_get(fmt->metadata, key, NULL, 0);
+    // OGG/FLAC 的 Vorbis 注释保存在流元数据中
+    for (unsigned i = 0; e == NULL && i < fmt->nb_streams; i++) {
+        e = av_dict_get(fmt->streams[i]->metadata, key, NULL, 0);
+    }
+    if (e != NULL && e->value != NULL) {
+        snprintf(out, out_size, "%s", e->value);
+    }
+}
+
+/**
+ * @brief 只读取容器头部获取标签和时长，不调用 avformat_find_stream_info，不解码
+ */
+static void probe_file(const char *path, char *title, char *artist, char *album, int *duration_ms) {
+    AVFormatContext *fmt = NULL;
+    if (avformat_open_input(&fmt, path, NULL, NULL) != 0) {
+        return;
+    }
+
+    copy_tag(fmt, "title", title, ML_TAG_MAX);
+    copy_tag(fmt, "artist", artist, ML_TAG_MAX);
+    copy_tag(fmt, "album_artist", artist, ML_TAG_MAX);
+    copy_tag(fmt, "album", album, ML_TAG_MAX);
+
+    if (fmt->duration != AV_NOPTS_VALUE && fmt->duration > 0) {
+        *duration_ms = (int)(fmt->duration / 1000);
+    } else {
+        for (unsigned i = 0; i < fmt->nb_streams; i++) {
+            AVStream *st = fmt->streams[i];
+            if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && st->duration != AV_NOPTS_VALUE) {
+                *duration_ms = (int)av_rescale_q(st->duration, st->time_base, (AVRational){1, 1000});
+                break;
+            }
+        }
+    }
+
+    avformat_close_input(&fmt);
+}
+
+static void add_file(ml_scan_t *s, const char *path, const struct stat *st) {
+    ml_builder_t *b = &s->b;
+    const ml_record_t *old = find_old(s, path);
+    ml_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+
+    if (old != NULL && old->mtime == (int64_t)st->st_mtime && old->size == (int64_t)st->st_size) {
+        rec.title = builder_intern(b, idx_str(&s->old, old->title));
+        rec.artist = builder_intern(b, idx_str(&s->old, old->artist));
+        rec.album = builder_intern(b, idx_str(&s->old, old->album));
+        rec.duration_ms = old->duration_ms;
+        s->reused++;
+    } else {
+        char title[ML_TAG_MAX] = {0};
+        char artist[ML_TAG_MAX] = {0};
+        char album[ML_TAG_MAX] = {0};
+        int duration_ms = 0;
+
+        probe_file(path, title, artist, album, &duration_ms);
+        if (title[0] == '\0') {
+            // 没有标题标签时使用去掉扩展名的文件名
+            const char *name = strrchr(path, '/');
+            snprintf(title, sizeof(title), "%s", name ? name + 1 : path);
+            char *dot = strrchr(title, '.');
+            if (dot != NULL && dot != title) {
+                *dot = '\0';
+            }
+        }
+
+        rec.title = builder_intern(b, title);
+        rec.artist = builder_intern(b, artist);
+        rec.album = builder_intern(b, album);
+        rec.duration_ms = duration_ms > 0 ? (uint32_t)duration_ms : 0;
+        s->probed++;
+    }
+
+    rec.path = builder_intern(b, path);
+    rec.mtime = (int64_t)st->st_mtime;
+    rec.size = (int64_t)st->st_size;
+
+    ml_record_t *r = builder_add(b);
+    if (r != NULL) {
+        *r = rec;
+    }
+}
+
+static void walk_dir(ml_scan_t *s, char *path, size_t len, int depth) {
+    if (depth > ML_MAX_DEPTH || __atomic_load_n(&scan_cancel, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    DIR *dp = opendir(path);
+    if (dp == NULL) {
+        return;
+    }
+
+    struct dirent *de;
+    while (!__atomic_load_n(&scan_cancel, __ATOMIC_RELAXED) && (de = readdir(dp)) != NULL) {
+        // 跳过隐藏文件（包括 . 和 ..，以及索引文件本身）
+        if (de->d_name[0] == '.') {
+            continue;
+        }
+
+        size_t nlen = strlen(de->d_name);
+        if (len + 1 + nlen + 1 > PATH_MAX) {
+            continue;
+        }
+        path[len] = '/';
+        memcpy(path + len + 1, de->d_name, nlen + 1);
+
+        bool is_dir = de->d_type == DT_DIR;
+        bool is_audio = !is_dir && media_library_is_audio_path(de->d_name);
+        if (de->d_type == DT_UNKNOWN || de->d_type == DT_LNK || is_audio) {
+            struct stat st;
+            if (stat(path, &st) != 0) {
+                path[len] = '\0';
+                continue;
+            }
+            is_dir = S_ISDIR(st.st_mode);
+            if (!is_dir && S_ISREG(st.st_mode) && media_library_is_audio_path(de->d_name)) {
+                add_file(s, path, &st);
+            }
+        }
+
+        if (is_dir) {
+            walk_dir(s, path, len + 1 + nlen, depth + 1);
+        }
+        path[len] = '\0';
+    }
+
+    closedir(dp);
+}
+
+static void *scan_thread(void *arg) {
+    (void)arg;
+
+    // 降低扫描线程优先级，避免与界面和音频线程争抢 CPU
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+
+    ml_scan_t s;
+    memset(&s, 0, sizeof(s));
+    if (!builder_init(&s.b)) {
+        __atomic_store_n(&scan_finished, 1, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    map_index(index_path_buf, &s.old);
+    build_old_hash(&s);
+
+    char roots[PATH_MAX];
+    snprintf(roots, sizeof(roots), "%s", roots_buf);
+    char *save = NULL;
+    for (char *root = strtok_r(roots, ":", &save); root != NULL; root = strtok_r(NULL, ":", &save)) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s", root);
+        size_t len = strlen(path);
+        while (len > 1 && path[len - 1] == '/') {
+            path[--len] = '\0';
+        }
+        walk_dir(&s, path, len, 0);
+    }
+
+    if (!__atomic_load_n(&scan_cancel, __ATOMIC_RELAXED)) {
+        if (builder_write(&s.b, index_path_buf)) {
+            printf("[media] Indexed %d tracks (%d reused, %d probed)\n", s.b.count, s.reused, s.probed);
+        }
+    }
+
+    free(s.old_hash);
+    unmap_index(&s.old);
+    builder_free(&s.b);
+    __atomic_store_n(&scan_finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void poll_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    if (!scanning || !__atomic_load_n(&scan_finished, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    pthread_join(scan_tid, NULL);
+    scanning = false;
+    __atomic_store_n(&scan_finished, 0, __ATOMIC_RELAXED);
+
+    ml_index_t fresh;
+    if (map_index(index_path_buf, &fresh)) {
+        unmap_index(&current);
+        current = fresh;
+        if (updated_cb != NULL) {
+            updated_cb(updated_user_data);
+        }
+    }
+}
+
+/*=====================
+ * 公共接口
+ *====================*/
+
+bool media_library_init(const char *roots, const char *index_path) {
+    if (poll_timer != NULL) {
+        return true;
+    }
+
+    snprintf(roots_buf, sizeof(roots_buf), "%s", roots ? roots : MEDIA_LIBRARY_DEFAULT_ROOTS);
+    snprintf(index_path_buf, sizeof(index_path_buf), "%s", index_path ? index_path : MEDIA_LIBRARY_DEFAULT_INDEX);
+
+    if (map_index(index_path_buf, &current)) {
+        printf("[media] Loaded index with %u tracks\n", current.hdr->count);
+    }
+
+    poll_timer = lv_timer_create(poll_timer_cb, ML_POLL_MS, NULL);
+    media_library_rescan();
+    return poll_timer != NULL;
+}
+
+void media_library_set_updated_cb(media_library_updated_cb_t cb, void *user_data) {
+    updated_cb = cb;
+    updated_user_data = user_data;
+}
+
+void media_library_rescan(void) {
+    if (scanning) {
+        return;
+    }
+
+    __atomic_store_n(&scan_cancel, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&scan_finished, 0, __ATOMIC_RELAXED);
+    if (pthread_create(&scan_tid, NULL, scan_thread, NULL) != 0) {
+        printf("[media] Failed to start scan thread\n");
+        return;
+    }
+    scanning = true;
+}
+
+bool media_library_is_scanning(void) {
+    return scanning;
+}
+
+int media_library_count(void) {
+    return current.hdr ? (int)current.hdr->count : 0;
+}
+
+bool media_library_get(int id, media_track_t *out) {
+    if (out == NULL || id < 0 || id >= media_library_count()) {
+        return false;
+    }
+
+    const ml_record_t *r = &current.recs[id];
+    out->path = idx_str(&current, r->path);
+    out->title = idx_str(&current, r->title);
+    out->artist = idx_str(&current, r->artist);
+    out->album = idx_str(&current, r->album);
+    out->duration_ms = (int)r->duration_ms;
+    out->mtime = r->mtime;
+    out->size = r->size;
+    return true;
+}
+
+/**
+ * @brief 在排序数组中查找第一个满足 cmp(key, prefix) >= bias 的位置
+ */
+static uint32_t bound(const uint32_t *arr, uint32_t count, media_field_t field,
+                      const char *prefix, size_t plen, int bias) {
+    uint32_t lo = 0;
+    uint32_t hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const char *key = idx_str(&current, field_offset(&current.recs[arr[mid]], field));
+        if (strncasecmp(key, prefix, plen) < bias) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int media_library_search(media_field_t field, const char *prefix, int *ids, int max_ids) {
+    if (current.hdr == NULL || field >= MEDIA_FIELD_COUNT) {
+        return 0;
+    }
+    if (prefix == NULL) {
+        prefix = "";
+    }
+
+    const uint32_t *arr = current.sorted[field];
+    uint32_t count = current.hdr->count;
+    size_t plen = strlen(prefix);
+
+    // [first, last) 为前缀相同的连续区间
+    uint32_t first = bound(arr, count, field, prefix, plen, 0);
+    uint32_t last = bound(arr, count, field, prefix, plen, 1);
+
+    for (uint32_t i = first; ids != NULL && i < last && (int)(i - first) < max_ids; i++) {
+        ids[i - first] = (int)arr[i];
+    }
+    return (int)(last - first);
+}
+
+int media_library_browse(media_field_t field, int offset, int *ids, int max_ids) {
+    if (current.hdr == NULL || field >= MEDIA_FIELD_COUNT || offset < 0 || ids == NULL) {
+        return 0;
+    }
+
+    int n = 0;
+    for (uint32_t i = (uint32_t)offset; i < current.hdr->count && n < max_ids; i++) {
+        ids[n++] = (int)current.sorted[field][i];
+    }
+    return n;
+}
+
+void media_library_deinit(void) {
+    if (scanning) {
+        __atomic_store_n(&scan_cancel, 1, __ATOMIC_RELAXED);
+        pthread_join(scan_tid, NULL);
+        scanning = false;
+        __atomic_store_n(&scan_finished, 0, __ATOMIC_RELAXED);
+    }
+
+    if (poll_timer != NULL) {
+        lv_timer_delete(poll_timer);
+        poll_timer = NULL;
+    }
+
+    unmap_index(&current);
+}
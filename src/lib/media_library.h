@@ -0,0 +1,115 @@
+/**
+ * @file media_library.h
+ * @brief 媒体库索引头文件
+ *
+ * 后台线程遍历配置的根目录，通过 libavformat 读取音频文件的标签和时长（不解码），
+ * 写入可直接 mmap 的紧凑二进制索引；再次扫描时按 mtime/大小增量复用旧记录。
+ * 索引中预先保存按 艺术家/专辑/标题 排序的数组，前缀查询为两次二分查找。
+ *
+ * 除 media_library_is_audio_path 外，所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef MEDIA_LIBRARY_H
+#define MEDIA_LIBRARY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MEDIA_LIBRARY_DEFAULT_ROOTS  "/mnt/app"
+#define MEDIA_LIBRARY_DEFAULT_INDEX  "/mnt/app/.media_library.idx"
+
+/**
+ * @brief 可排序/检索的字段
+ */
+typedef enum {
+    MEDIA_FIELD_ARTIST,     /**< 艺术家 */
+    MEDIA_FIELD_ALBUM,      /**< 专辑 */
+    MEDIA_FIELD_TITLE,      /**< 标题 */
+    MEDIA_FIELD_COUNT
+} media_field_t;
+
+/**
+ * @brief 曲目信息（字符串指向 mmap 的索引，索引更新后失效）
+ */
+typedef struct {
+    const char *path;       /**< 文件路径 */
+    const char *title;      /**< 标题（无标签时为文件名） */
+    const char *artist;     /**< 艺术家，可能为空串 */
+    const char *album;      /**< 专辑，可能为空串 */
+    int duration_ms;        /**< 时长（毫秒），未知为 0 */
+    int64_t mtime;          /**< 文件修改时间 */
+    int64_t size;           /**< 文件大小 */
+} media_track_t;
+
+/**
+ * @brief 索引更新回调（在 LVGL 主线程中调用），之前取得的 media_track_t 已失效
+ */
+typedef void (*media_library_updated_cb_t)(void *user_data);
+
+/**
+ * @brief 初始化媒体库：加载已有索引并启动后台增量扫描
+ * @param roots 以 ':' 分隔的扫描根目录
+ * @param index_path 索引文件路径
+ * @return 初始化是否成功
+ */
+bool media_library_init(const char *roots, const char *index_path);
+
+/**
+ * @brief 设置索引更新回调
+ */
+void media_library_set_updated_cb(media_library_updated_cb_t cb, void *user_data);
+
+/**
+ * @brief 启动一次后台增量扫描（已在扫描时忽略）
+ */
+void media_library_rescan(void);
+
+/**
+ * @brief 是否正在后台扫描
+ */
+bool media_library_is_scanning(void);
+
+/**
+ * @brief 当前索引中的曲目数量
+ */
+int media_library_count(void);
+
+/**
+ * @brief 获取曲目信息
+ * @param id 曲目编号 [0, count)
+ * @param out 输出
+ * @return 是否成功
+ */
+bool media_library_get(int id, media_track_t *out);
+
+/**
+ * @brief 按字段前缀检索（ASCII 不区分大小写），结果按该字段排序
+ * @param field 检索字段
+ * @param prefix 前缀，空串匹配全部
+ * @param ids 输出曲目编号数组
+ * @param max_ids 数组容量
+ * @return 匹配总数（可能大于 max_ids）
+ */
+int media_library_search(media_field_t field, const char *prefix, int *ids, int max_ids);
+
+/**
+ * @brief 按字段排序浏览
+ * @param field 排序字段
+ * @param offset 起始位置
+ * @param ids 输出曲目编号数组
+ * @param max_ids 数组容量
+ * @return 实际写入数量
+ */
+int media_library_browse(media_field_t field, int offset, int *ids, int max_ids);
+
+/**
+ * @brief 根据扩展名判断是否为支持的音频文件（线程安全）
+ */
+bool media_library_is_audio_path(const char *path);
+
+/**
+ * @brief 停止扫描并释放索引
+ */
+void media_library_deinit(void);
+
+#endif /* MEDIA_LIBRARY_H */
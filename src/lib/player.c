@@ -1,5 +1,32 @@
 #include "player.h"
+#include "thumb_cache.h"
+#include "worker_pool.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLAYER_COVER_SIZE 40
+
+static void set_cover(player_t *player, lv_image_dsc_t *img) {
+    lv_image_dsc_t *old = player->cover_img;
+    player->cover_img = img;
+    if (img) {
+        lv_image_set_src(player->cover, img);
+        lv_obj_clear_flag(player->cover, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(player->cover, LV_OBJ_FLAG_HIDDEN);
+    }
+    if (old) {
+        lv_image_cache_drop(old);
+        thumb_cache_free(old);
+    }
+}
+
+// 封面缩略图完成回调（主线程）
+static void cover_ready_cb(const char *path, lv_image_dsc_t *thumb, void *user_data) {
+    (void)path;
+    set_cover((player_t *)user_data, thumb);
+}
 
 static void update_time_label(player_t *player) {
     if (!player || !player->audio) return;
@@ -85,6 +112,17 @@ player_t *player_create(lv_obj_t *parent) {
     lv_obj_set_style_border_width(top_row, 0, 0);
     lv_obj_set_style_bg_opa(top_row, LV_OPA_TRANSP, 0);
 
+    // 封面（没有封面时隐藏）
+    player->cover = lv_image_create(top_row);
+    if (!player->cover) {
+        lv_obj_del(player->cont);
+        free(player);
+        return NULL;
+    }
+    lv_obj_set_size(player->cover, PLAYER_COVER_SIZE, PLAYER_COVER_SIZE);
+    lv_image_set_inner_align(player->cover, LV_IMAGE_ALIGN_CENTER);
+    lv_obj_add_flag(player->cover, LV_OBJ_FLAG_HIDDEN);
+
     // 标题标签
     player->title_label = lv_label_create(top_row);
     if (!player->title_label) {
@@ -173,36 +211,171 @@ player_t *player_create(lv_obj_t *parent) {
     return player;
 }
 
-void player_set_file(player_t *player, const char *file_path) {
-    if (!player || !file_path) return;
+/**
+ * @brief 后台打开文件的任务
+ */
+typedef struct {
+    player_t *player;
+    char *path;
+    lv_obj_t *volume_slider;
+    audio_player_t *audio;      // 工作线程创建的播放器（在主线程释放）
+    bool opened;                // 文件是否打开成功
+} open_job_t;
 
-    player_stop(player);
+// 同一时间只有一个打开任务：被取消的任务在完成回调前仍然持有 ALSA PCM，
+// 下一个任务要等它释放后再开始
+static bool open_busy;
+static player_t *open_queue;    // 等待打开的播放器，要打开的文件在 next_file
+
+static void open_kick(void);
+
+// 工作线程：初始化 ALSA PCM 并探测文件（avformat_open_input 等会阻塞）
+static void open_work(void *arg) {
+    open_job_t *job = (open_job_t *)arg;
 
-    // 初始化音频播放器（使用 libavdevice 进行音频输出）
     printf("[player] Initializing audio player...\n");
-    player->audio = audio_player_init(player->volume_slider);
-    if (!player->audio) {
+    job->audio = audio_player_init(job->volume_slider);
+    if (!job->audio) {
         printf("[player] Failed to initialize audio player\n");
-        player->state = PLAYER_STATE_STOPPED;
         return;
     }
-    printf("[player] Audio player initialized\n");
-
-    if (audio_player_open(player->audio, file_path) == 0) {
-        lv_label_set_text(player->title_label, file_path);
-        lv_slider_set_value(player->progress_slider, 0, LV_ANIM_OFF);
-        update_time_label(player);
-    } else {
+    // 失败时不在这里释放：audio_player_deinit 会停止播放，只能在主线程调用
+    job->opened = audio_player_open(job->audio, job->path) == 0;
+    if (!job->opened) {
         printf("[player] Failed to open audio file\n");
+    }
+}
+
+// 主线程：播放器被销毁时任务已取消，不能再访问 player
+static void open_done(void *arg, bool cancelled) {
+    open_job_t *job = (open_job_t *)arg;
+    player_t *player = job->player;
+
+    if (!cancelled) {
+        player->open_job = 0;
+    }
+    // 打开期间又选择了其他文件时丢弃这次的结果，先释放 PCM 再打开下一个
+    if (!cancelled && !player->next_file) {
+        if (job->opened) {
+            player->audio = job->audio;
+            job->audio = NULL;
+            printf("[player] Audio player initialized\n");
+
+            lv_label_set_text(player->title_label, job->path);
+            lv_slider_set_value(player->progress_slider, 0, LV_ANIM_OFF);
+            update_time_label(player);
+
+            // 异步加载内嵌封面，旧封面保留到新封面就绪
+            thumb_cache_cancel(player);
+            thumb_cache_request(job->path, PLAYER_COVER_SIZE, PLAYER_COVER_SIZE,
+                                LV_COLOR_FORMAT_ARGB8888, cover_ready_cb, player);
+
+            if (player->play_on_open) {
+                player->play_on_open = false;
+                player_toggle_play_pause(player);
+            }
+        } else {
+            player->play_on_open = false;
+            player->state = PLAYER_STATE_STOPPED;
+        }
+    }
+
+    if (job->audio) {
+        audio_player_deinit(job->audio);
+    }
+    free(job->path);
+    free(job);
+
+    open_busy = false;
+    open_kick();
+}
+
+static void submit_open(player_t *player, const char *file_path) {
+    open_job_t *job = calloc(1, sizeof(open_job_t));
+    if (!job) return;
+    job->path = strdup(file_path);
+    if (!job->path) {
+        free(job);
+        return;
+    }
+    job->player = player;
+    job->volume_slider = player->volume_slider;
+
+    open_busy = true;
+    player->open_job = worker_pool_submit(WORKER_PRIO_HIGH, open_work, open_done, job);
+    if (player->open_job == 0) {
+        // 线程池未启动时同步打开
+        open_work(job);
+        open_done(job, false);
+    }
+}
+
+// 没有打开任务时打开队列中的下一个文件
+static void open_kick(void) {
+    while (!open_busy && open_queue) {
+        player_t *player = open_queue;
+        open_queue = player->open_next;
+        player->open_next = NULL;
+
+        char *path = player->next_file;
+        player->next_file = NULL;
+        if (path) {
+            submit_open(player, path);
+            free(path);
+        }
+    }
+}
+
+static void open_queue_push(player_t *player) {
+    player_t **pp = &open_queue;
+    while (*pp) {
+        if (*pp == player) return;  // 已经在排队，只更新 next_file
+        pp = &(*pp)->open_next;
+    }
+    *pp = player;
+    player->open_next = NULL;
+}
+
+static void open_queue_remove(player_t *player) {
+    for (player_t **pp = &open_queue; *pp; pp = &(*pp)->open_next) {
+        if (*pp == player) {
+            *pp = player->open_next;
+            player->open_next = NULL;
+            return;
+        }
+    }
+}
+
+void player_set_file(player_t *player, const char *file_path) {
+    if (!player || !file_path) return;
+
+    player_stop(player);
+    player->play_on_open = false;
+
+    char *path = strdup(file_path);
+    if (!path) return;
+    free(player->next_file);
+    player->next_file = path;
+
+    // 释放上一个文件的播放器（ALSA PCM 同一时间只打开一次）
+    if (player->audio) {
         audio_player_deinit(player->audio);
         player->audio = NULL;
-        player->state = PLAYER_STATE_STOPPED;
     }
+
+    // 正在打开的文件不能中途停止，排队等它完成后再打开最后选择的文件
+    open_queue_push(player);
+    open_kick();
 }
 
 void player_toggle_play_pause(player_t *player) {
     if (!player) return;
     if (!player->audio) {
+        if (player->open_job || player->next_file) {
+            // 文件还在后台打开，完成后再开始播放
+            player->play_on_open = !player->play_on_open;
+            return;
+        }
         printf("[player] Audio player not initialized\n");
         return;
     }
@@ -232,6 +405,7 @@ void player_stop(player_t *player) {
     if (player->audio) {
         audio_player_stop(player->audio);
     }
+    player->play_on_open = false;
     player->state = PLAYER_STATE_STOPPED;
     lv_obj_t *btn_label = lv_obj_get_child(player->control_btn, 0);
     if (btn_label) {
@@ -264,7 +438,16 @@ void player_destroy(player_t *player) {
     if (player->audio) {
         audio_player_deinit(player->audio);
     }
+    // 打开中的文件由任务的完成回调释放
+    worker_pool_cancel(player->open_job);
+    open_queue_remove(player);
+    free(player->next_file);
+    thumb_cache_cancel(player);
     lv_obj_del(player->cont);
+    if (player->cover_img) {
+        lv_image_cache_drop(player->cover_img);
+        thumb_cache_free(player->cover_img);
+    }
     free(player);
 }
 
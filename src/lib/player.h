@@ -10,8 +10,10 @@ typedef enum {
     PLAYER_STATE_PAUSED
 } player_state_t;
 
-typedef struct {
+typedef struct player_s {
     lv_obj_t *cont;
+    lv_obj_t *cover;            // 封面图（异步加载）
+    lv_image_dsc_t *cover_img;  // 当前封面缩略图
     lv_obj_t *title_label;
     lv_obj_t *progress_slider;
     lv_obj_t *time_label;
@@ -20,9 +22,14 @@ typedef struct {
     audio_player_t *audio;
     player_state_t state;
     lv_timer_t *timer;
+    uint32_t open_job;          // 后台打开文件的任务（worker_pool），0 表示没有
+    char *next_file;            // 等待打开的文件（同一时间只有一个打开任务）
+    struct player_s *open_next; // 打开队列中的下一个播放器
+    bool play_on_open;          // 打开完成后开始播放
 } player_t;
 
 player_t *player_create(lv_obj_t *parent);
+// 在后台线程打开文件（全局串行），完成前的播放请求在打开后执行
 void player_set_file(player_t *player, const char *file_path);
 void player_toggle_play_pause(player_t *player);
 void player_stop(player_t *player);
@@ -0,0 +1,415 @@
+/**
+ * @file thumb_cache.c
+ * @brief 缩略图缓存实现
+ *
+ * 磁盘缓存文件：<cache_dir>/<64 位键>.thm，内容为 thumb_file_header_t + 像素数据；
+ * w/h 为 0 的文件表示该文件没有可用的缩略图，避免每次都重新探测；只在文件内容无法解码时
+ * 写入（img_decode_result_t.permanent），内存不足、I/O 错误等暂时的失败下次请求时重试。
+ * 缩略图的 lv_image_dsc_t 与像素数据在同一块 malloc 内存中，不占用 LVGL 堆。
+ */
+
+#include "thumb_cache.h"
+#include "img_decode.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#define THUMB_MAGIC     0x424d4854u    /* "THMB" */
+#define THUMB_VERSION   2               /* 2: 不再缓存暂时性失败 */
+#define THUMB_MAX_DIM   512
+#define THUMB_FILE_MAX  (PATH_MAX + 32) /* 缓存目录 + "/<16位十六进制>.thm" */
+
+/**
+ * @brief 磁盘缓存文件头
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t w;
+    uint32_t h;
+    uint32_t cf;
+    uint32_t stride;
+} thumb_file_header_t;
+
+/**
+ * @brief 缩略图请求
+ */
+typedef struct thumb_job {
+    struct thumb_job *next;
+    char *path;
+    int max_w;
+    int max_h;
+    lv_color_format_t cf;
+    thumb_cache_ready_cb_t cb;
+    void *user_data;
+    lv_image_dsc_t *result;
+} thumb_job_t;
+
+static char cache_dir_buf[PATH_MAX];
+static pthread_t worker_tid;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static thumb_job_t *pending = NULL;         /**< 待处理（栈，后进先出） */
+static int pending_count = 0;
+static thumb_job_t *done_head = NULL;       /**< 已完成（队列） */
+static thumb_job_t *done_tail = NULL;
+static void *running_user_data = NULL;      /**< 正在处理的请求的 user_data */
+static volatile int running_cancelled = 0;
+static volatile int worker_quit = 0;
+static bool worker_started = false;
+static lv_timer_t *poll_timer = NULL;
+
+static void job_free(thumb_job_t *job) {
+    if (job == NULL) {
+        return;
+    }
+    thumb_cache_free(job->result);
+    free(job->path);
+    free(job);
+}
+
+/**
+ * @brief 计算缓存键（FNV-1a 64）
+ */
+static uint64_t thumb_key(const thumb_job_t *job, const struct stat *st) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const char *p = job->path; *p; p++) {
+        h = (h ^ (uint8_t)*p) * 0x100000001b3ull;
+    }
+
+    int64_t vals[5] = { (int64_t)st->st_mtime, (int64_t)st->st_size, job->max_w, job->max_h, job->cf };
+    const uint8_t *b = (const uint8_t *)vals;
+    for (size_t i = 0; i < sizeof(vals); i++) {
+        h = (h ^ b[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+/**
+ * @brief 分配 lv_image_dsc_t，像素数据紧跟在结构体之后
+ */
+static lv_image_dsc_t *dsc_alloc(int w, int h, int stride, lv_color_format_t cf) {
+    size_t data_size = (size_t)stride * h;
+    lv_image_dsc_t *dsc = malloc(sizeof(lv_image_dsc_t) + data_size);
+    if (dsc == NULL) {
+        return NULL;
+    }
+
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
+    dsc->header.cf = cf;
+    dsc->header.w = w;
+    dsc->header.h = h;
+    dsc->header.stride = stride;
+    dsc->data_size = data_size;
+    dsc->data = (const uint8_t *)(dsc + 1);
+    return dsc;
+}
+
+/**
+ * @brief 读取磁盘缓存
+ * @return 1 命中，0 命中但无缩略图，-1 未命中
+ */
+static int cache_load(const char *file, lv_image_dsc_t **out) {
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int ret = -1;
+    thumb_file_header_t hdr;
+    if (read(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+        hdr.magic == THUMB_MAGIC && hdr.version == THUMB_VERSION) {
+        bool cf_ok = hdr.cf == LV_COLOR_FORMAT_RGB565 || hdr.cf == LV_COLOR_FORMAT_ARGB8888;
+        if (hdr.w == 0 || hdr.h == 0) {
+            ret = 0;
+        } else if (cf_ok && hdr.w <= THUMB_MAX_DIM && hdr.h <= THUMB_MAX_DIM &&
+                   hdr.stride >= hdr.w * (uint32_t)img_decode_bpp((lv_color_format_t)hdr.cf) &&
+                   hdr.stride <= THUMB_MAX_DIM * 4) {
+            lv_image_dsc_t *dsc = dsc_alloc((int)hdr.w, (int)hdr.h, (int)hdr.stride, (lv_color_format_t)hdr.cf);
+            if (dsc != NULL) {
+                if (read(fd, (void *)dsc->data, dsc->data_size) == (ssize_t)dsc->data_size) {
+                    *out = dsc;
+                    ret = 1;
+                } else {
+                    free(dsc);
+                }
+            }
+        }
+    }
+
+    close(fd);
+    return ret;
+}
+
+/**
+ * @brief 写入磁盘缓存（先写临时文件再 rename，避免读到半个文件）
+ */
+static void cache_store(const char *file, const lv_image_dsc_t *dsc) {
+    char tmp[THUMB_FILE_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+
+    thumb_file_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = THUMB_MAGIC;
+    hdr.version = THUMB_VERSION;
+    if (dsc != NULL) {
+        hdr.w = dsc->header.w;
+        hdr.h = dsc->header.h;
+        hdr.cf = dsc->header.cf;
+        hdr.stride = dsc->header.stride;
+    }
+
+    bool ok = write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr);
+    if (ok && dsc != NULL) {
+        ok = write(fd, dsc->data, dsc->data_size) == (ssize_t)dsc->data_size;
+    }
+    close(fd);
+
+    if (!ok || rename(tmp, file) != 0) {
+        unlink(tmp);
+    }
+}
+
+/**
+ * @brief 处理一个请求：先查磁盘缓存，未命中再解码
+ */
+static lv_image_dsc_t *process_job(const thumb_job_t *job) {
+    struct stat st;
+    if (stat(job->path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return NULL;
+    }
+
+    char file[THUMB_FILE_MAX];
+    snprintf(file, sizeof(file), "%s/%016llx.thm", cache_dir_buf, (unsigned long long)thumb_key(job, &st));
+
+    lv_image_dsc_t *dsc = NULL;
+    if (cache_load(file, &dsc) >= 0) {
+        return dsc;
+    }
+
+    img_decode_result_t res;
+    bool permanent = false;
+    if (img_decode_file(job->path, job->max_w, job->max_h, job->cf, &res)) {
+        dsc = dsc_alloc(res.w, res.h, res.stride, res.cf);
+        if (dsc != NULL) {
+            memcpy((void *)dsc->data, res.data, dsc->data_size);
+        }
+        img_decode_free(&res);
+    } else {
+        permanent = res.permanent;
+    }
+
+    // 暂时的失败不写入缓存，下次请求时重新解码
+    if (dsc != NULL || permanent) {
+        cache_store(file, dsc);
+    }
+    return dsc;
+}
+
+static void *worker_thread(void *arg) {
+    (void)arg;
+
+    // 降低优先级，避免与界面和音频线程争抢 CPU
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+
+    pthread_mutex_lock(&lock);
+    while (!worker_quit) {
+        if (pending == NULL) {
+            pthread_cond_wait(&cond, &lock);
+            continue;
+        }
+
+        thumb_job_t *job = pending;
+        pending = job->next;
+        pending_count--;
+        job->next = NULL;
+        running_user_data = job->user_data;
+        running_cancelled = 0;
+        pthread_mutex_unlock(&lock);
+
+        job->result = process_job(job);
+
+        pthread_mutex_lock(&lock);
+        running_user_data = NULL;
+        if (running_cancelled) {
+            job_free(job);
+            continue;
+        }
+        if (done_tail) {
+            done_tail->next = job;
+        } else {
+            done_head = job;
+        }
+        done_tail = job;
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+static void poll_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+
+    pthread_mutex_lock(&lock);
+    thumb_job_t *list = done_head;
+    done_head = done_tail = NULL;
+    pthread_mutex_unlock(&lock);
+
+    while (list != NULL) {
+        thumb_job_t *job = list;
+        list = job->next;
+
+        // 回调接管缩略图所有权
+        job->cb(job->path, job->result, job->user_data);
+        job->result = NULL;
+        job_free(job);
+    }
+}
+
+/**
+ * @brief 从链表中移除 user_data 匹配的请求，返回新的尾节点
+ */
+static thumb_job_t *remove_matching(thumb_job_t **head, void *user_data, int *count) {
+    thumb_job_t *tail = NULL;
+    thumb_job_t **pp = head;
+    while (*pp != NULL) {
+        thumb_job_t *job = *pp;
+        if (job->user_data == user_data) {
+            *pp = job->next;
+            job_free(job);
+            if (count != NULL) {
+                (*count)--;
+            }
+        } else {
+            tail = job;
+            pp = &job->next;
+        }
+    }
+    return tail;
+}
+
+/*=====================
+ * 公共接口
+ *====================*/
+
+bool thumb_cache_init(const char *cache_dir) {
+    if (worker_started) {
+        return true;
+    }
+
+    snprintf(cache_dir_buf, sizeof(cache_dir_buf), "%s", cache_dir ? cache_dir : THUMB_CACHE_DEFAULT_DIR);
+    if (mkdir(cache_dir_buf, 0755) != 0 && errno != EEXIST) {
+        printf("[thumb] Cannot create cache dir %s: %s\n", cache_dir_buf, strerror(errno));
+    }
+
+    worker_quit = 0;
+    if (pthread_create(&worker_tid, NULL, worker_thread, NULL) != 0) {
+        printf("[thumb] Failed to start worker thread\n");
+        return false;
+    }
+    worker_started = true;
+
+    poll_timer = lv_timer_create(poll_timer_cb, THUMB_CACHE_POLL_MS, NULL);
+    return poll_timer != NULL;
+}
+
+bool thumb_cache_request(const char *path, int max_w, int max_h, lv_color_format_t cf,
+                         thumb_cache_ready_cb_t cb, void *user_data) {
+    if (!worker_started || path == NULL || cb == NULL ||
+        max_w <= 0 || max_h <= 0 || max_w > THUMB_MAX_DIM || max_h > THUMB_MAX_DIM) {
+        return false;
+    }
+
+    thumb_job_t *job = calloc(1, sizeof(thumb_job_t));
+    if (job == NULL) {
+        return false;
+    }
+    job->path = strdup(path);
+    if (job->path == NULL) {
+        free(job);
+        return false;
+    }
+    job->max_w = max_w;
+    job->max_h = max_h;
+    job->cf = (cf == LV_COLOR_FORMAT_RGB565) ? LV_COLOR_FORMAT_RGB565 : LV_COLOR_FORMAT_ARGB8888;
+    job->cb = cb;
+    job->user_data = user_data;
+
+    pthread_mutex_lock(&lock);
+    // 快速滚动时请求堆积，栈底是最早的请求（多半已经离开可视区域），超过上限时丢弃
+    thumb_job_t *dropped = NULL;
+    if (pending_count >= THUMB_CACHE_PENDING_MAX) {
+        thumb_job_t **pp = &pending;
+        while ((*pp)->next != NULL) {
+            pp = &(*pp)->next;
+        }
+        dropped = *pp;
+        *pp = NULL;
+        pending_count--;
+    }
+    job->next = pending;
+    pending = job;
+    pending_count++;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+    job_free(dropped);
+    return true;
+}
+
+void thumb_cache_cancel(void *user_data) {
+    pthread_mutex_lock(&lock);
+    remove_matching(&pending, user_data, &pending_count);
+    done_tail = remove_matching(&done_head, user_data, NULL);
+    if (running_user_data == user_data) {
+        running_cancelled = 1;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void thumb_cache_free(lv_image_dsc_t *thumb) {
+    free(thumb);
+}
+
+void thumb_cache_deinit(void) {
+    if (!worker_started) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    worker_quit = 1;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+    pthread_join(worker_tid, NULL);
+    worker_started = false;
+
+    while (pending != NULL) {
+        thumb_job_t *job = pending;
+        pending = job->next;
+        job_free(job);
+    }
+    pending_count = 0;
+    while (done_head != NULL) {
+        thumb_job_t *job = done_head;
+        done_head = job->next;
+        job_free(job);
+    }
+    done_tail = NULL;
+
+    if (poll_timer) {
+        lv_timer_delete(poll_timer);
+        poll_timer = NULL;
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file thumb_cache.h
+ * @brief 缩略图缓存头文件
+ *
+ * 后台线程提取音频内嵌封面、视频首帧或图片，按目标尺寸解码为 RGB565/ARGB8888 缩略图，
+ * 并以 路径+mtime+大小+尺寸 为键持久化到磁盘缓存目录，再次请求时直接读取。
+ * 请求按后进先出处理，最近进入可视区域的条目优先；排队的请求超过 THUMB_CACHE_PENDING_MAX
+ * 时丢弃最早的请求（不回调）。完成结果由 LVGL 定时器在主线程回调。
+ *
+ * 除 thumb_cache_free 外，所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef THUMB_CACHE_H
+#define THUMB_CACHE_H
+
+#include <stdbool.h>
+#include "lvgl/lvgl.h"
+
+#define THUMB_CACHE_DEFAULT_DIR  "/mnt/app/.thumbs"
+#define THUMB_CACHE_POLL_MS      50      /**< 完成队列轮询周期 */
+#define THUMB_CACHE_PENDING_MAX  96      /**< 排队请求上限，超过时丢弃最早的请求 */
+
+/**
+ * @brief 缩略图完成回调（LVGL 主线程）
+ * @param path 请求的文件路径
+ * @param thumb 缩略图，失败为 NULL；由调用方持有，用 thumb_cache_free 释放
+ * @param user_data 请求时传入的用户数据
+ */
+typedef void (*thumb_cache_ready_cb_t)(const char *path, lv_image_dsc_t *thumb, void *user_data);
+
+/**
+ * @brief 初始化缩略图服务：创建缓存目录、后台线程和轮询定时器
+ * @param cache_dir 磁盘缓存目录，NULL 使用默认目录
+ * @return 初始化是否成功
+ */
+bool thumb_cache_init(const char *cache_dir);
+
+/**
+ * @brief 请求缩略图（异步）
+ * @param path 文件路径
+ * @param max_w 最大宽度
+ * @param max_h 最大高度
+ * @param cf LV_COLOR_FORMAT_RGB565 或 LV_COLOR_FORMAT_ARGB8888
+ * @param cb 完成回调
+ * @param user_data 用户数据，同时作为 thumb_cache_cancel 的分组标识
+ * @return 是否成功加入队列（之后因队列已满被丢弃的请求不会回调，与取消相同）
+ */
+bool thumb_cache_request(const char *path, int max_w, int max_h, lv_color_format_t cf,
+                         thumb_cache_ready_cb_t cb, void *user_data);
+
+/**
+ * @brief 取消 user_data 对应的所有未完成请求，之后不会再回调
+ */
+void thumb_cache_cancel(void *user_data);
+
+/**
+ * @brief 释放缩略图（如已显示，先调用 lv_image_cache_drop）
+ */
+void thumb_cache_free(lv_image_dsc_t *thumb);
+
+/**
+ * @brief 停止后台线程并释放所有请求
+ */
+void thumb_cache_deinit(void);
+
+#endif /* THUMB_CACHE_H */
@@ -2,827 +2,1050 @@
  * @file data_parser.c
  * @brief JSON数据解析器实现
  *
- * 负责解析JSON配置文件，提取页面信息
+ * 负责解析JSON配置文件，提取页面信息；以及加载编译后的二进制故事。
+ * JSON 由 json_tok 原地解析，故事中的字符串直接指向文档缓冲区，
+ * 页面、角色数组和索引也从文档内存池分配，释放故事时一次释放。
+ * 按需解析时 mmap 整个文件并浅层扫描出每个页面对象的位置和ID，页面被访问时
+ * 再用 json_parse 单独解析该页面的文本，解析结果保存在 LRU 页面缓存中。
  */
 
 #include "data_parser.h"
+#include "story_binary.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <ctype.h>
 #include <stdbool.h>
-
-// 简单JSON解析器的实现
-// 这个解析器仅支持我们需要的JSON格式，不支持完整的JSON规范
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /**
- * @brief JSON值类型枚举
+ * @brief 按需解析时一个页面在文本中的位置
  */
-typedef enum {
-    JSON_TYPE_NULL,
-    JSON_TYPE_BOOL,
-    JSON_TYPE_NUMBER,
-    JSON_TYPE_STRING,
-    JSON_TYPE_ARRAY,
-    JSON_TYPE_OBJECT
-} json_type_t;
+typedef struct {
+    uint32_t off;           /**< 页面对象在文本中的偏移 */
+    uint32_t len;           /**< 页面对象的长度 */
+    const char *id;         /**< 页面ID（位于 story->json 内存池） */
+} lazy_page_t;
 
 /**
- * @brief JSON值结构体
+ * @brief 页面缓存项
  */
-typedef struct json_value {
-    json_type_t type;
-    union {
-        bool boolean;
-        double number;
-        char *string;
-        struct json_array *array;
-        struct json_object *object;
-    } value;
-} json_value_t;
+typedef struct {
+    int index;              /**< 页面索引，-1为空 */
+    uint32_t last_used;     /**< 最近使用时间（访问计数） */
+    json_doc_t doc;         /**< 页面的JSON文档，page 中的字符串指向其缓冲区 */
+    page_config_t page;
+} page_cache_entry_t;
 
 /**
- * @brief JSON数组结构体
+ * @brief 按需解析状态
  */
-typedef struct json_array {
-    json_value_t **items;
-    int count;
-} json_array_t;
+struct story_lazy {
+    const char *text;       /**< mmap 映射的JSON文本 */
+    size_t size;
+    lazy_page_t *pages;     /**< 每个页面的位置和ID */
+    int pinned;             /**< 固定的页面索引，-1表示没有 */
+    uint32_t clock;         /**< 访问计数 */
+    page_cache_entry_t cache[STORY_PAGE_CACHE];
+};
 
 /**
- * @brief JSON对象键值对结构体
+ * @brief 获取页面ID（按需解析时页面可能尚未解析）
  */
-typedef struct json_pair {
-    char *key;
-    json_value_t *value;
-} json_pair_t;
+static const char *page_id_at(const story_config_t *story, int index) {
+    return story->lazy != NULL ? story->lazy->pages[index].id : story->pages[index].id;
+}
 
 /**
- * @brief JSON对象结构体
+ * @brief 计算页面ID哈希值（FNV-1a）
+ * @param id 页面ID
+ * @return 哈希值
  */
-typedef struct json_object {
-    json_pair_t **pairs;
-    int count;
-} json_object_t;
+static uint32_t page_id_hash(const char *id) {
+    uint32_t h = 2166136261u;
+    while (*id) {
+        h ^= (uint8_t)*id++;
+        h *= 16777619u;
+    }
+    return h;
+}
 
 /**
- * @brief 跳过空白字符
- * @param json JSON字符串
- * @return 跳过空白字符后的位置
+ * @brief 把页面和选项的跳转目标（next_page）解析为页面索引
+ * @param story 故事配置（页面索引已建立）
+ * @param page 页面配置
+ * @return 是否全部找到，找不到的目标索引为-1
  */
-static const char *skip_whitespace(const char *json) {
-    while (*json && isspace(*json)) {
-        json++;
+static bool resolve_page_links(const story_config_t *story, page_config_t *page) {
+    bool ok = true;
+    page->next_index = -1;
+    if (page->next_page != NULL) {
+        page->next_index = find_page_index(story, page->next_page);
+        if (page->next_index < 0) {
+            printf("页面 %s 的 next_page 指向不存在的页面: %s\n", page->id, page->next_page);
+            ok = false;
+        }
+    }
+    for (int i = 0; i < page->choice_count; i++) {
+        choice_config_t *choice = &page->choices[i];
+        choice->next_index = -1;
+        if (choice->next_page == NULL) {
+            continue;
+        }
+        choice->next_index = find_page_index(story, choice->next_page);
+        if (choice->next_index < 0) {
+            printf("页面 %s 的选项 %d 指向不存在的页面: %s\n", page->id, i, choice->next_page);
+            ok = false;
+        }
     }
-    return json;
+    return ok;
 }
 
 /**
- * @brief 解析JSON字符串
- * @param json JSON字符串
- * @param result 解析结果
- * @return 解析后的位置
+ * @brief 建立页面ID哈希索引，并把 next_page 解析为页面索引
+ * （按需解析时跳转目标在页面解析时再查找）
+ * @param story 故事配置
+ * @return 是否成功，页面ID重复或跳转目标不存在时返回false
  */
-static const char *parse_string(const char *json, char **result) {
-    json++; // 跳过引号
-    
-    const char *start = json;
-    while (*json && *json != '"') {
-        if (*json == '\\') {
-            json++; // 跳过转义字符
+static bool build_page_index(story_config_t *story) {
+    // 哈希表大小取不小于页面数两倍的2的幂，保证装载率不超过50%
+    int size = 16;
+    while (size < story->page_count * 2) {
+        size <<= 1;
+    }
+
+    story->page_index = (int *)json_arena_alloc(&story->json, sizeof(int) * size);
+    story->page_hash = (uint32_t *)json_arena_alloc(&story->json, sizeof(uint32_t) * (story->page_count > 0 ? story->page_count : 1));
+    if (story->page_index == NULL || story->page_hash == NULL) {
+        return false;
+    }
+    memset(story->page_index, 0xff, sizeof(int) * size);
+    story->page_index_mask = size - 1;
+
+    for (int i = 0; i < story->page_count; i++) {
+        const char *id = page_id_at(story, i);
+        uint32_t h = page_id_hash(id);
+        story->page_hash[i] = h;
+        if (id[0] == '\0') {
+            continue;   // 没有ID的页面不能作为跳转目标，不加入索引
+        }
+
+        int slot = (int)(h & (uint32_t)story->page_index_mask);
+        while (story->page_index[slot] >= 0) {
+            int other = story->page_index[slot];
+            if (story->page_hash[other] == h && strcmp(page_id_at(story, other), id) == 0) {
+                printf("页面ID重复: %s\n", id);
+                return false;
+            }
+            slot = (slot + 1) & story->page_index_mask;
         }
-        json++;
+        story->page_index[slot] = i;
     }
-    
-    if (*json != '"') {
-        return NULL; // 字符串未正确结束
+
+    if (story->lazy != NULL) {
+        return true;
     }
-    
-    int len = json - start;
-    *result = (char *)malloc(len + 1);
-    if (*result == NULL) {
-        return NULL;
+
+    // 加载时解析跳转目标，翻页时无需再比较字符串
+    for (int i = 0; i < story->page_count; i++) {
+        if (!resolve_page_links(story, &story->pages[i])) {
+            return false;
+        }
     }
-    
-    strncpy(*result, start, len);
-    (*result)[len] = '\0';
-    
-    return json + 1; // 跳过结束引号
+
+    return true;
 }
 
 /**
- * @brief 解析JSON数字
- * @param json JSON字符串
- * @param result 解析结果
- * @return 解析后的位置
+ * @brief 查找或加入资源表
+ * @param story 故事配置
+ * @param slots 路径哈希表
+ * @param mask 哈希表大小减一
+ * @param path 图片路径
+ * @return 资源ID，空路径返回-1
  */
-static const char *parse_number(const char *json, double *result) {
-    char *end;
-    *result = strtod(json, &end);
-    if (end == json) {
-        return NULL; // 不是有效的数字
+static int intern_asset(story_config_t *story, int *slots, int mask, const char *path) {
+    if (path == NULL || path[0] == '\0') {
+        return -1;
     }
-    return end;
+
+    int slot = (int)(page_id_hash(path) & (uint32_t)mask);
+    while (slots[slot] >= 0) {
+        if (strcmp(story->assets[slots[slot]], path) == 0) {
+            return slots[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    slots[slot] = story->asset_count;
+    story->assets[story->asset_count] = path;
+    return story->asset_count++;
 }
 
 /**
- * @brief 解析JSON数组
- * @param json JSON字符串
- * @param result 解析结果
- * @return 解析后的位置
+ * @brief 为背景和角色图片分配资源ID（相同路径共用一个ID），建立资源表
+ * @param story 故事配置
+ * @return 是否成功
  */
-static const char *parse_array(const char *json, json_array_t **result);
+static bool build_asset_table(story_config_t *story) {
+    int total = 0;
+    for (int i = 0; i < story->page_count; i++) {
+        total += 1 + story->pages[i].character_count;
+    }
+
+    int size = 16;
+    while (size < total * 2) {
+        size <<= 1;
+    }
+    int *slots = (int *)malloc(sizeof(int) * size);
+    story->assets = (const char **)json_arena_alloc(&story->json, sizeof(const char *) * (total > 0 ? total : 1));
+    if (slots == NULL || story->assets == NULL) {
+        free(slots);
+        return false;
+    }
+    memset(slots, 0xff, sizeof(int) * size);
+
+    story->asset_count = 0;
+    for (int i = 0; i < story->page_count; i++) {
+        page_config_t *page = &story->pages[i];
+        page->background_asset = intern_asset(story, slots, size - 1, page->background);
+        for (int j = 0; j < page->character_count; j++) {
+            page->characters[j].image_asset = intern_asset(story, slots, size - 1, page->characters[j].image);
+        }
+    }
+
+    free(slots);
+    return true;
+}
 
 /**
- * @brief 解析JSON对象
- * @param json JSON字符串
- * @param result 解析结果
- * @return 解析后的位置
+ * @brief 解析文本框配置，缺少的字段使用默认值
+ * @param doc JSON文档
+ * @param obj 文本框对象下标，-1表示全部使用默认值
+ * @param tb 输出的文本框配置
  */
-static const char *parse_object(const char *json, json_object_t **result);
+static void parse_textbox(const json_doc_t *doc, int obj, textbox_config_t *tb) {
+    static json_key_t k_visible = JSON_KEY("visible");
+    static json_key_t k_x = JSON_KEY("x");
+    static json_key_t k_y = JSON_KEY("y");
+    static json_key_t k_width = JSON_KEY("width");
+    static json_key_t k_height = JSON_KEY("height");
+    static json_key_t k_bg_color = JSON_KEY("bg_color");
+    static json_key_t k_text_color = JSON_KEY("text_color");
+    static json_key_t k_font = JSON_KEY("font");
+    static json_key_t k_font_size = JSON_KEY("font_size");
+
+    tb->visible = json_get_bool(doc, obj, &k_visible, true);
+    tb->x = (int)json_get_number(doc, obj, &k_x, 50);
+    tb->y = (int)json_get_number(doc, obj, &k_y, 400);
+    tb->width = (int)json_get_number(doc, obj, &k_width, 700);
+    tb->height = (int)json_get_number(doc, obj, &k_height, 150);
+    tb->bg_color = json_get_string(doc, obj, &k_bg_color, "#000000");
+    tb->text_color = json_get_string(doc, obj, &k_text_color, "#FFFFFF");
+    tb->font = json_get_string(doc, obj, &k_font, NULL);
+    tb->font_size = (int)json_get_number(doc, obj, &k_font_size, 16);
+}
 
 /**
- * @brief 释放JSON值
- * @param value JSON值
+ * @brief 按名称查找枚举值
+ * @return 下标，未找到返回-1
  */
-static void free_json_value(json_value_t *value);
+static int name_index(const char *name, const char *const *names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
 
 /**
- * @brief 解析JSON值
- * @param json JSON字符串
- * @param result 解析结果
- * @return 解析后的位置
+ * @brief 解析切换效果：字符串（效果名）或 {"type", "duration", "curve"} 对象
+ * @param doc JSON文档
+ * @param tok 值下标，-1表示没有切换效果
+ * @param tr 输出的切换效果配置
  */
-static const char *parse_value(const char *json, json_value_t **result) {
-    json = skip_whitespace(json);
-    if (!*json) {
-        return NULL;
+static void parse_transition(const json_doc_t *doc, int tok, transition_config_t *tr) {
+    static const char *const types[] = { "none", "fade", "slide", "wipe" };
+    static const char *const curves[] = { "linear", "ease_in", "ease_out", "ease_in_out" };
+    static json_key_t k_type = JSON_KEY("type");
+    static json_key_t k_duration = JSON_KEY("duration");
+    static json_key_t k_curve = JSON_KEY("curve");
+
+    tr->type = TRANSITION_NONE;
+    tr->duration = TRANSITION_DEFAULT_DURATION;
+    tr->curve = TRANSITION_CURVE_EASE_IN_OUT;
+
+    const char *type = NULL;
+    if (json_type(doc, tok) == JSON_STRING) {
+        type = json_string(doc, tok, NULL);
+    } else if (json_type(doc, tok) == JSON_OBJECT) {
+        type = json_get_string(doc, tok, &k_type, NULL);
+        tr->duration = (int)json_get_number(doc, tok, &k_duration, TRANSITION_DEFAULT_DURATION);
+        const char *curve = json_get_string(doc, tok, &k_curve, NULL);
+        if (curve != NULL) {
+            int c = name_index(curve, curves, (int)(sizeof(curves) / sizeof(curves[0])));
+            if (c < 0) {
+                printf("未知的切换曲线: %s\n", curve);
+            } else {
+                tr->curve = (transition_curve_t)c;
+            }
+        }
     }
-    
-    *result = (json_value_t *)malloc(sizeof(json_value_t));
-    if (*result == NULL) {
-        return NULL;
+    if (type == NULL) {
+        return;
     }
-    
-    switch (*json) {
-        case '{':
-            (*result)->type = JSON_TYPE_OBJECT;
-            return parse_object(json, &(*result)->value.object);
-            
-        case '[':
-            (*result)->type = JSON_TYPE_ARRAY;
-            return parse_array(json, &(*result)->value.array);
-            
-        case '"':
-            (*result)->type = JSON_TYPE_STRING;
-            return parse_string(json, &(*result)->value.string);
-            
-        case 't':
-            if (strncmp(json, "true", 4) == 0) {
-                (*result)->type = JSON_TYPE_BOOL;
-                (*result)->value.boolean = true;
-                return json + 4;
-            }
-            break;
-            
-        case 'f':
-            if (strncmp(json, "false", 5) == 0) {
-                (*result)->type = JSON_TYPE_BOOL;
-                (*result)->value.boolean = false;
-                return json + 5;
-            }
-            break;
-            
-        case 'n':
-            if (strncmp(json, "null", 4) == 0) {
-                (*result)->type = JSON_TYPE_NULL;
-                return json + 4;
-            }
-            break;
-            
-        default:
-            if (isdigit(*json) || *json == '-') {
-                (*result)->type = JSON_TYPE_NUMBER;
-                return parse_number(json, &(*result)->value.number);
-            }
-            break;
+
+    int t = name_index(type, types, (int)(sizeof(types) / sizeof(types[0])));
+    if (t < 0) {
+        printf("未知的切换效果: %s\n", type);
+        return;
+    }
+    tr->type = (transition_type_t)t;
+    if (tr->duration <= 0) {
+        tr->type = TRANSITION_NONE;
     }
-    
-    free(*result);
-    return NULL;
 }
 
 /**
- * @brief 解析JSON数组
- * @param json JSON字符串
- * @param result 解析结果
- * @return 解析后的位置
+ * @brief 解析选项数组：[{"text", "next_page", "condition", "script"}, ...]
+ * @param doc JSON文档（选项数组从其内存池分配）
+ * @param arr 数组下标，-1表示没有选项
+ * @param page 输出到页面配置
+ * @return 是否成功
  */
-static const char *parse_array(const char *json, json_array_t **result) {
-    json++; // 跳过 '['
-    json = skip_whitespace(json);
-    
-    *result = (json_array_t *)malloc(sizeof(json_array_t));
-    if (*result == NULL) {
-        return NULL;
+static bool parse_choices(json_doc_t *doc, int arr, page_config_t *page) {
+    static json_key_t k_text = JSON_KEY("text");
+    static json_key_t k_next_page = JSON_KEY("next_page");
+    static json_key_t k_condition = JSON_KEY("condition");
+    static json_key_t k_script = JSON_KEY("script");
+
+    page->choice_count = json_type(doc, arr) == JSON_ARRAY ? json_size(doc, arr) : 0;
+    page->choices = NULL;
+    if (page->choice_count == 0) {
+        return true;
     }
-    
-    (*result)->items = NULL;
-    (*result)->count = 0;
-    
-    if (*json == ']') {
-        return json + 1; // 空数组
+
+    page->choices = (choice_config_t *)json_arena_alloc(doc, sizeof(choice_config_t) * page->choice_count);
+    if (page->choices == NULL) {
+        return false;
     }
-    
-    while (1) {
-        json_value_t *value;
-        json = parse_value(json, &value);
-        if (!json) {
-            free(*result);
-            return NULL;
-        }
-        
-        // 扩展数组
-        (*result)->items = (json_value_t **)realloc((*result)->items, sizeof(json_value_t *) * ((*result)->count + 1));
-        if ((*result)->items == NULL) {
-            free(value);
-            free(*result);
-            return NULL;
-        }
-        
-        (*result)->items[(*result)->count++] = value;
-        
-        json = skip_whitespace(json);
-        if (*json == ']') {
-            return json + 1;
+
+    int j = 0;
+    for (int c = json_first(doc, arr); c >= 0; c = json_next(doc, arr, c), j++) {
+        if (json_type(doc, c) != JSON_OBJECT) {
+            printf("选项 %d 不是有效的对象\n", j);
+            return false;
         }
-        
-        if (*json != ',') {
-            // 数组项之间必须用逗号分隔
-            for (int i = 0; i < (*result)->count; i++) {
-                free_json_value((*result)->items[i]);
-            }
-            free((*result)->items);
-            free(*result);
-            return NULL;
+
+        choice_config_t *choice = &page->choices[j];
+        choice->text = json_get_string(doc, c, &k_text, "");
+        choice->next_page = json_get_string(doc, c, &k_next_page, NULL);
+        choice->next_index = -1;
+        choice->condition = json_get_string(doc, c, &k_condition, NULL);
+        choice->script = json_get_string(doc, c, &k_script, NULL);
+    }
+    return true;
+}
+
+/**
+ * @brief 解析一个页面对象
+ * @param doc JSON文档（角色数组从其内存池分配）
+ * @param obj 页面对象下标
+ * @param page 输出的页面配置
+ * @return 是否成功
+ */
+static bool parse_page(json_doc_t *doc, int obj, page_config_t *page) {
+    static json_key_t k_id = JSON_KEY("id");
+    static json_key_t k_background = JSON_KEY("background");
+    static json_key_t k_text = JSON_KEY("text");
+    static json_key_t k_next_page = JSON_KEY("next_page");
+    static json_key_t k_textbox = JSON_KEY("textbox");
+    static json_key_t k_transition = JSON_KEY("transition");
+    static json_key_t k_script = JSON_KEY("script");
+    static json_key_t k_jump = JSON_KEY("jump");
+    static json_key_t k_choices = JSON_KEY("choices");
+    static json_key_t k_characters = JSON_KEY("characters");
+    static json_key_t k_image = JSON_KEY("image");
+    static json_key_t k_x = JSON_KEY("x");
+    static json_key_t k_y = JSON_KEY("y");
+    static json_key_t k_scale = JSON_KEY("scale");
+    static json_key_t k_visible = JSON_KEY("visible");
+
+    page->id = json_get_string(doc, obj, &k_id, "");
+    page->background = json_get_string(doc, obj, &k_background, "");
+    page->text = json_get_string(doc, obj, &k_text, "");
+
+    // null 和字符串 "null" 都表示故事结束
+    page->next_page = json_get_string(doc, obj, &k_next_page, NULL);
+    if (page->next_page != NULL && strcmp(page->next_page, "null") == 0) {
+        page->next_page = NULL;
+    }
+
+    int textbox = json_find(doc, obj, &k_textbox);
+    parse_textbox(doc, json_type(doc, textbox) == JSON_OBJECT ? textbox : -1, &page->textbox);
+    parse_transition(doc, json_find(doc, obj, &k_transition), &page->transition);
+
+    // 脚本只保存源码，由 vn_script 在执行时编译（或从字节码缓存取出）
+    page->script = json_get_string(doc, obj, &k_script, NULL);
+    page->jump = json_get_string(doc, obj, &k_jump, NULL);
+    if (!parse_choices(doc, json_find(doc, obj, &k_choices), page)) {
+        return false;
+    }
+
+    // 解析角色配置
+    int characters = json_find(doc, obj, &k_characters);
+    page->character_count = json_type(doc, characters) == JSON_ARRAY ? json_size(doc, characters) : 0;
+    page->characters = NULL;
+    if (page->character_count == 0) {
+        return true;
+    }
+
+    page->characters = (character_config_t *)json_arena_alloc(doc, sizeof(character_config_t) * page->character_count);
+    if (page->characters == NULL) {
+        return false;
+    }
+
+    int j = 0;
+    for (int c = json_first(doc, characters); c >= 0; c = json_next(doc, characters, c), j++) {
+        if (json_type(doc, c) != JSON_OBJECT) {
+            printf("角色 %d 不是有效的对象\n", j);
+            return false;
         }
-        
-        json++; // 跳过逗号
+
+        character_config_t *ch = &page->characters[j];
+        ch->id = json_get_string(doc, c, &k_id, "");
+        ch->image = json_get_string(doc, c, &k_image, "");
+        ch->x = (int)json_get_number(doc, c, &k_x, 0);
+        ch->y = (int)json_get_number(doc, c, &k_y, 0);
+        ch->scale = (float)json_get_number(doc, c, &k_scale, 1.0);
+        ch->visible = json_get_bool(doc, c, &k_visible, true);
     }
+    return true;
 }
 
 /**
- * @brief 解析JSON对象
- * @param json JSON字符串
- * @param result 解析结果
- * @return 解析后的位置
+ * @brief 解析JSON配置文件
+ * @param json_path JSON文件路径
+ * @return 故事配置结构体指针，如果解析失败返回NULL
  */
-static const char *parse_object(const char *json, json_object_t **result) {
-    json++; // 跳过 '{'
-    json = skip_whitespace(json);
-    
-    *result = (json_object_t *)malloc(sizeof(json_object_t));
-    if (*result == NULL) {
+story_config_t *parse_story_json(const char *json_path) {
+    static json_key_t k_title = JSON_KEY("title");
+    static json_key_t k_author = JSON_KEY("author");
+    static json_key_t k_pages = JSON_KEY("pages");
+
+    story_config_t *story = (story_config_t *)calloc(1, sizeof(story_config_t));
+    if (story == NULL) {
         return NULL;
     }
-    
-    (*result)->pairs = NULL;
-    (*result)->count = 0;
-    
-    if (*json == '}') {
-        return json + 1; // 空对象
+
+    // 读取并原地解析JSON，之后故事中的字符串都指向文档缓冲区
+    json_doc_t *doc = &story->json;
+    if (!json_parse_file(doc, json_path)) {
+        printf("无法解析JSON文件: %s\n", json_path);
+        free(story);
+        return NULL;
     }
-    
-    while (1) {
-        json = skip_whitespace(json);
-        if (*json != '"') {
-            // 对象键必须是字符串
-            for (int i = 0; i < (*result)->count; i++) {
-                free((*result)->pairs[i]->key);
-                free_json_value((*result)->pairs[i]->value);
-                free((*result)->pairs[i]);
-            }
-            free((*result)->pairs);
-            free(*result);
-            return NULL;
-        }
-        
-        // 解析键
-        char *key;
-        json = parse_string(json, &key);
-        if (!json) {
-            for (int i = 0; i < (*result)->count; i++) {
-                free((*result)->pairs[i]->key);
-                free_json_value((*result)->pairs[i]->value);
-                free((*result)->pairs[i]);
-            }
-            free((*result)->pairs);
-            free(*result);
+    if (json_type(doc, 0) != JSON_OBJECT) {
+        printf("JSON根节点不是对象\n");
+        free_story_config(story);
+        return NULL;
+    }
+
+    // 设置故事基本信息
+    story->title = json_get_string(doc, 0, &k_title, "未命名故事");
+    story->author = json_get_string(doc, 0, &k_author, "未知作者");
+
+    // 获取页面数组
+    int pages = json_find(doc, 0, &k_pages);
+    if (json_type(doc, pages) != JSON_ARRAY) {
+        printf("找不到pages数组\n");
+        free_story_config(story);
+        return NULL;
+    }
+
+    story->page_count = json_size(doc, pages);
+    story->pages = (page_config_t *)json_arena_alloc(doc, sizeof(page_config_t) * (story->page_count > 0 ? story->page_count : 1));
+    if (story->pages == NULL) {
+        free_story_config(story);
+        return NULL;
+    }
+
+    // 解析每个页面
+    int i = 0;
+    for (int p = json_first(doc, pages); p >= 0; p = json_next(doc, pages, p), i++) {
+        if (json_type(doc, p) != JSON_OBJECT) {
+            printf("页面 %d 不是有效的对象\n", i);
+            free_story_config(story);
             return NULL;
         }
-        
-        // 解析冒号
-        json = skip_whitespace(json);
-        if (*json != ':') {
-            free(key);
-            for (int i = 0; i < (*result)->count; i++) {
-                free((*result)->pairs[i]->key);
-                free_json_value((*result)->pairs[i]->value);
-                free((*result)->pairs[i]);
-            }
-            free((*result)->pairs);
-            free(*result);
+        if (!parse_page(doc, p, &story->pages[i])) {
+            free_story_config(story);
             return NULL;
         }
-        json++; // 跳过冒号
-        
-        // 解析值
-        json_value_t *value;
-        json = parse_value(json, &value);
-        if (!json) {
-            free(key);
-            for (int i = 0; i < (*result)->count; i++) {
-                free((*result)->pairs[i]->key);
-                free_json_value((*result)->pairs[i]->value);
-                free((*result)->pairs[i]);
-            }
-            free((*result)->pairs);
-            free(*result);
-            return NULL;
+    }
+
+    // 建立页面索引并校验跳转目标
+    if (!build_page_index(story) || !build_asset_table(story)) {
+        free_story_config(story);
+        return NULL;
+    }
+
+    return story;
+}
+
+/**
+ * @brief 比较浅层扫描得到的键（未解码的原文）
+ */
+static bool key_is(const char *key, size_t len, const char *name) {
+    return strlen(name) == len && memcmp(key, name, len) == 0;
+}
+
+/**
+ * @brief 扫描 pages 数组，记录每个页面对象的位置和ID
+ * @param story 故事配置
+ * @param p '[' 之后的位置
+ * @param end 数组之后的位置
+ * @return 是否成功
+ */
+static bool scan_pages(story_config_t *story, const char *p, const char *end) {
+    struct story_lazy *lazy = story->lazy;
+    const char *value;
+    const char *value_end;
+    int cap = 0;
+    int r;
+
+    while ((r = json_scan_element(&p, end, &value, &value_end)) > 0) {
+        if (*value != '{') {
+            printf("页面 %d 不是有效的对象\n", story->page_count);
+            return false;
         }
-        
-        // 扩展对象
-        (*result)->pairs = (json_pair_t **)realloc((*result)->pairs, sizeof(json_pair_t *) * ((*result)->count + 1));
-        if ((*result)->pairs == NULL) {
-            free(key);
-            free(value);
-            for (int i = 0; i < (*result)->count; i++) {
-                free((*result)->pairs[i]->key);
-                free_json_value((*result)->pairs[i]->value);
-                free((*result)->pairs[i]);
+        if (story->page_count == cap) {
+            cap = cap ? cap * 2 : 256;
+            lazy_page_t *pages = (lazy_page_t *)realloc(lazy->pages, sizeof(lazy_page_t) * cap);
+            if (pages == NULL) {
+                return false;
             }
-            free((*result)->pairs);
-            free(*result);
-            return NULL;
+            lazy->pages = pages;
         }
-        
-        (*result)->pairs[(*result)->count] = (json_pair_t *)malloc(sizeof(json_pair_t));
-        if ((*result)->pairs[(*result)->count] == NULL) {
-            free(key);
-            free(value);
-            for (int i = 0; i < (*result)->count; i++) {
-                free((*result)->pairs[i]->key);
-                free_json_value((*result)->pairs[i]->value);
-                free((*result)->pairs[i]);
+
+        lazy_page_t *lp = &lazy->pages[story->page_count++];
+        lp->off = (uint32_t)(value - lazy->text);
+        lp->len = (uint32_t)(value_end - value);
+        lp->id = "";
+
+        // 只找ID，id 通常是第一个成员
+        const char *q = value + 1;
+        const char *key;
+        size_t key_len;
+        const char *v;
+        const char *v_end;
+        int m;
+        while ((m = json_scan_member(&q, value_end, &key, &key_len, &v, &v_end)) > 0) {
+            if (key_is(key, key_len, "id")) {
+                if (*v == '"') {
+                    lp->id = json_arena_string(&story->json, v, v_end);
+                    if (lp->id == NULL) {
+                        return false;
+                    }
+                }
+                break;
             }
-            free((*result)->pairs);
-            free(*result);
-            return NULL;
-        }
-        
-        (*result)->pairs[(*result)->count]->key = key;
-        (*result)->pairs[(*result)->count]->value = value;
-        (*result)->count++;
-        
-        json = skip_whitespace(json);
-        if (*json == '}') {
-            return json + 1;
         }
-        
-        if (*json != ',') {
-            // 对象键值对之间必须用逗号分隔
-            free(key);
-            free(value);
-            for (int i = 0; i < (*result)->count; i++) {
-                free((*result)->pairs[i]->key);
-                free_json_value((*result)->pairs[i]->value);
-                free((*result)->pairs[i]);
-            }
-            free((*result)->pairs);
-            free(*result);
-            return NULL;
+        if (m < 0) {
+            return false;
         }
-        
-        json++; // 跳过逗号
     }
+    return r == 0;
 }
 
 /**
- * @brief 从JSON对象中获取字符串值
- * @param object JSON对象
- * @param key 键名
- * @param default_value 默认值
- * @return 字符串值，如果不存在或类型错误则返回默认值
+ * @brief 浅层扫描故事：标题、作者和页面位置
+ * @param story 故事配置
+ * @return 是否成功
  */
-static const char *json_object_get_string(const json_object_t *object, const char *key, const char *default_value) {
-    if (!object) {
-        return default_value;
+static bool scan_story(story_config_t *story) {
+    struct story_lazy *lazy = story->lazy;
+    const char *end = lazy->text + lazy->size;
+    const char *p = json_skip_ws(lazy->text, end);
+    if (p >= end || *p != '{') {
+        printf("JSON根节点不是对象\n");
+        return false;
     }
-    
-    for (int i = 0; i < object->count; i++) {
-        if (strcmp(object->pairs[i]->key, key) == 0) {
-            if (object->pairs[i]->value->type == JSON_TYPE_STRING) {
-                return object->pairs[i]->value->value.string;
+    p++;
+
+    const char *key;
+    size_t key_len;
+    const char *value;
+    const char *value_end;
+    bool have_pages = false;
+    int r;
+    while ((r = json_scan_member(&p, end, &key, &key_len, &value, &value_end)) > 0) {
+        if (*value == '"' && key_is(key, key_len, "title")) {
+            story->title = json_arena_string(&story->json, value, value_end);
+        } else if (*value == '"' && key_is(key, key_len, "author")) {
+            story->author = json_arena_string(&story->json, value, value_end);
+        } else if (*value == '[' && key_is(key, key_len, "pages") && !have_pages) {
+            if (!scan_pages(story, value + 1, value_end)) {
+                return false;
             }
-            break;
+            have_pages = true;
         }
     }
-    
-    return default_value;
+    if (r < 0 || json_skip_ws(p, end) != end) {
+        printf("JSON格式错误：偏移 %lu 处\n", (unsigned long)(p - lazy->text));
+        return false;
+    }
+    if (!have_pages) {
+        printf("找不到pages数组\n");
+        return false;
+    }
+
+    if (story->title == NULL) {
+        story->title = "未命名故事";
+    }
+    if (story->author == NULL) {
+        story->author = "未知作者";
+    }
+    return true;
 }
 
 /**
- * @brief 从JSON对象中获取数字值
- * @param object JSON对象
- * @param key 键名
- * @param default_value 默认值
- * @return 数字值，如果不存在或类型错误则返回默认值
+ * @brief 按需解析JSON故事
+ * @param json_path JSON文件路径
+ * @return 故事配置结构体指针，如果解析失败返回NULL
  */
-static double json_object_get_number(const json_object_t *object, const char *key, double default_value) {
-    if (!object) {
-        return default_value;
+story_config_t *load_story_lazy(const char *json_path) {
+    int fd = open(json_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("无法读取JSON文件: %s\n", json_path);
+        return NULL;
     }
-    
-    for (int i = 0; i < object->count; i++) {
-        if (strcmp(object->pairs[i]->key, key) == 0) {
-            if (object->pairs[i]->value->type == JSON_TYPE_NUMBER) {
-                return object->pairs[i]->value->value.number;
-            }
-            break;
-        }
+
+    // 页面偏移用32位保存
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size >= UINT32_MAX) {
+        close(fd);
+        printf("无法读取JSON文件: %s\n", json_path);
+        return NULL;
     }
-    
-    return default_value;
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    story_config_t *story = (story_config_t *)calloc(1, sizeof(story_config_t));
+    struct story_lazy *lazy = story ? (struct story_lazy *)json_arena_alloc(&story->json, sizeof(struct story_lazy)) : NULL;
+    if (lazy == NULL) {
+        free(story);
+        munmap(map, size);
+        return NULL;
+    }
+    lazy->text = (const char *)map;
+    lazy->size = size;
+    lazy->pinned = -1;
+    for (int i = 0; i < STORY_PAGE_CACHE; i++) {
+        lazy->cache[i].index = -1;
+    }
+    story->lazy = lazy;
+
+    if (!scan_story(story) || !build_page_index(story)) {
+        printf("JSON解析失败: %s\n", json_path);
+        free_story_config(story);
+        return NULL;
+    }
+
+    // 扫描读入了整个文件，之后只按需读取页面文本，提示内核回收这些页
+    madvise(map, size, MADV_DONTNEED);
+    return story;
 }
 
 /**
- * @brief 从JSON对象中获取布尔值
- * @param object JSON对象
- * @param key 键名
- * @param default_value 默认值
- * @return 布尔值，如果不存在或类型错误则返回默认值
+ * @brief 解析页面到缓存项
+ * @param story 故事配置
+ * @param e 缓存项（原有内容被替换）
+ * @param index 页面索引
+ * @return 是否成功
  */
-static bool json_object_get_bool(const json_object_t *object, const char *key, bool default_value) {
-    if (!object) {
-        return default_value;
+static bool materialize_page(story_config_t *story, page_cache_entry_t *e, int index) {
+    struct story_lazy *lazy = story->lazy;
+    const lazy_page_t *lp = &lazy->pages[index];
+
+    json_free(&e->doc);
+    e->index = -1;
+    if (!json_parse(&e->doc, lazy->text + lp->off, lp->len) || !parse_page(&e->doc, 0, &e->page)) {
+        printf("页面 %d 解析失败\n", index);
+        json_free(&e->doc);
+        return false;
     }
-    
-    for (int i = 0; i < object->count; i++) {
-        if (strcmp(object->pairs[i]->key, key) == 0) {
-            if (object->pairs[i]->value->type == JSON_TYPE_BOOL) {
-                return object->pairs[i]->value->value.boolean;
-            }
-            break;
-        }
+
+    // 按需解析时没有资源表
+    page_config_t *page = &e->page;
+    page->id = lp->id;
+    page->background_asset = -1;
+    for (int i = 0; i < page->character_count; i++) {
+        page->characters[i].image_asset = -1;
     }
-    
-    return default_value;
+
+    resolve_page_links(story, page);
+
+    e->index = index;
+    return true;
 }
 
 /**
- * @brief 从JSON对象中获取数组
- * @param object JSON对象
- * @param key 键名
- * @return 数组，如果不存在或类型错误则返回NULL
+ * @brief 获取页面配置
+ * @param story 故事配置
+ * @param index 页面索引
+ * @return 页面配置结构体指针，索引无效或页面解析失败返回NULL
  */
-static const json_array_t *json_object_get_array(const json_object_t *object, const char *key) {
-    if (!object) {
+page_config_t *story_get_page(story_config_t *story, int index) {
+    if (story == NULL || index < 0 || index >= story->page_count) {
         return NULL;
     }
-    
-    for (int i = 0; i < object->count; i++) {
-        if (strcmp(object->pairs[i]->key, key) == 0) {
-            if (object->pairs[i]->value->type == JSON_TYPE_ARRAY) {
-                return object->pairs[i]->value->value.array;
-            }
-            break;
+    struct story_lazy *lazy = story->lazy;
+    if (lazy == NULL) {
+        return &story->pages[index];
+    }
+
+    // 查找缓存，同时选出最久未使用的未固定项（空项 last_used 为0，优先使用）
+    lazy->clock++;
+    page_cache_entry_t *victim = NULL;
+    for (int i = 0; i < STORY_PAGE_CACHE; i++) {
+        page_cache_entry_t *e = &lazy->cache[i];
+        if (e->index == index) {
+            e->last_used = lazy->clock;
+            return &e->page;
+        }
+        if (e->index >= 0 && e->index == lazy->pinned) {
+            continue;
+        }
+        if (victim == NULL || e->last_used < victim->last_used) {
+            victim = e;
         }
     }
-    
-    return NULL;
+
+    if (!materialize_page(story, victim, index)) {
+        victim->last_used = 0;
+        return NULL;
+    }
+    victim->last_used = lazy->clock;
+    return &victim->page;
 }
 
 /**
- * @brief 从JSON对象中获取对象
- * @param object JSON对象
- * @param key 键名
- * @return 对象，如果不存在或类型错误则返回NULL
+ * @brief 固定页面，使其不被页面缓存淘汰
+ * @param story 故事配置
+ * @param index 页面索引，-1表示取消固定
  */
-static const json_object_t *json_object_get_object(const json_object_t *object, const char *key) {
-    if (!object) {
-        return NULL;
-    }
-    
-    for (int i = 0; i < object->count; i++) {
-        if (strcmp(object->pairs[i]->key, key) == 0) {
-            if (object->pairs[i]->value->type == JSON_TYPE_OBJECT) {
-                return object->pairs[i]->value->value.object;
-            }
-            break;
-        }
+void story_pin_page(story_config_t *story, int index) {
+    if (story != NULL && story->lazy != NULL) {
+        story->lazy->pinned = index;
     }
-    
-    return NULL;
 }
 
 /**
- * @brief 释放JSON值
- * @param value JSON值
+ * @brief 检查 [off, off + count * elem) 是否在文件范围内且4字节对齐
  */
-static void free_json_value(json_value_t *value) {
-    if (!value) {
-        return;
-    }
-    
-    switch (value->type) {
-        case JSON_TYPE_STRING:
-            free(value->value.string);
-            break;
-            
-        case JSON_TYPE_ARRAY:
-            if (value->value.array) {
-                for (int i = 0; i < value->value.array->count; i++) {
-                    free_json_value(value->value.array->items[i]);
-                }
-                free(value->value.array->items);
-                free(value->value.array);
-            }
-            break;
-            
-        case JSON_TYPE_OBJECT:
-            if (value->value.object) {
-                for (int i = 0; i < value->value.object->count; i++) {
-                    free(value->value.object->pairs[i]->key);
-                    free_json_value(value->value.object->pairs[i]->value);
-                    free(value->value.object->pairs[i]);
-                }
-                free(value->value.object->pairs);
-                free(value->value.object);
-            }
-            break;
-            
-        default:
-            break;
-    }
-    
-    free(value);
+static bool vnb_range(size_t size, uint32_t off, uint32_t count, size_t elem) {
+    return off % 4 == 0 && (uint64_t)off + (uint64_t)count * elem <= size;
 }
 
 /**
- * @brief 读取文件内容
- * @param path 文件路径
- * @param size 文件大小（输出）
- * @return 文件内容，如果读取失败返回NULL
+ * @brief 检查字符串偏移
+ * @param hdr 文件头
+ * @param off 字符串偏移
+ * @param allow_none 是否允许 VNB_NONE
  */
-static char *read_file(const char *path, size_t *size) {
-    FILE *file = fopen(path, "rb");
-    if (!file) {
-        return NULL;
+static bool vnb_string_ok(const vnb_header_t *hdr, uint32_t off, bool allow_none) {
+    return off == VNB_NONE ? allow_none : off < hdr->strings_size;
+}
+
+/**
+ * @brief 校验二进制故事文件，之后加载时不再做边界检查
+ * @param base 映射起始地址
+ * @param size 文件大小
+ * @return 是否有效
+ */
+static bool vnb_validate(const uint8_t *base, size_t size) {
+    const vnb_header_t *hdr = (const vnb_header_t *)base;
+    if (size < sizeof(vnb_header_t) || memcmp(hdr->magic, VNB_MAGIC, 4) != 0 ||
+        hdr->version != VNB_VERSION || hdr->header_size != sizeof(vnb_header_t) || hdr->file_size != size) {
+        return false;
     }
-    
-    // 获取文件大小
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    // 分配内存
-    char *content = (char *)malloc(*size + 1);
-    if (!content) {
-        fclose(file);
-        return NULL;
+
+    // 哈希表至少留一个空槽，保证查找能够结束
+    if (hdr->index_size == 0 || (hdr->index_size & (hdr->index_size - 1)) != 0 ||
+        hdr->index_size <= hdr->page_count) {
+        return false;
     }
-    
-    // 读取文件内容
-    size_t read_size = fread(content, 1, *size, file);
-    if (read_size != *size) {
-        free(content);
-        fclose(file);
-        return NULL;
+
+    if (!vnb_range(size, hdr->pages_off, hdr->page_count, sizeof(vnb_page_t)) ||
+        !vnb_range(size, hdr->characters_off, hdr->character_count, sizeof(vnb_character_t)) ||
+        !vnb_range(size, hdr->choices_off, hdr->choice_count, sizeof(vnb_choice_t)) ||
+        !vnb_range(size, hdr->index_off, hdr->index_size, sizeof(int32_t)) ||
+        !vnb_range(size, hdr->hash_off, hdr->page_count, sizeof(uint32_t)) ||
+        !vnb_range(size, hdr->assets_off, hdr->asset_count, sizeof(uint32_t)) ||
+        !vnb_range(size, hdr->strings_off, hdr->strings_size, 1)) {
+        return false;
     }
-    
-    content[*size] = '\0'; // 确保字符串结束
-    
-    fclose(file);
-    return content;
+
+    const char *strings = (const char *)base + hdr->strings_off;
+    if (hdr->strings_size == 0 || strings[hdr->strings_size - 1] != '\0' ||
+        !vnb_string_ok(hdr, hdr->title, false) || !vnb_string_ok(hdr, hdr->author, false)) {
+        return false;
+    }
+
+    const vnb_page_t *pages = (const vnb_page_t *)(base + hdr->pages_off);
+    for (uint32_t i = 0; i < hdr->page_count; i++) {
+        const vnb_page_t *p = &pages[i];
+        if (!vnb_string_ok(hdr, p->id, false) || !vnb_string_ok(hdr, p->background, false) ||
+            !vnb_string_ok(hdr, p->text, false) || !vnb_string_ok(hdr, p->next_page, true) ||
+            !vnb_string_ok(hdr, p->tb_bg_color, false) || !vnb_string_ok(hdr, p->tb_text_color, false) ||
+            !vnb_string_ok(hdr, p->tb_font, true) ||
+            !vnb_string_ok(hdr, p->script, true) || !vnb_string_ok(hdr, p->jump, true) ||
+            p->transition < TRANSITION_NONE || p->transition > TRANSITION_WIPE ||
+            p->transition_curve < TRANSITION_CURVE_LINEAR || p->transition_curve > TRANSITION_CURVE_EASE_IN_OUT ||
+            p->next_index < -1 || p->next_index >= (int32_t)hdr->page_count ||
+            (p->background_asset != VNB_NONE && p->background_asset >= hdr->asset_count) ||
+            (uint64_t)p->first_character + p->character_count > hdr->character_count ||
+            (uint64_t)p->first_choice + p->choice_count > hdr->choice_count) {
+            return false;
+        }
+    }
+
+    const vnb_character_t *chars = (const vnb_character_t *)(base + hdr->characters_off);
+    for (uint32_t i = 0; i < hdr->character_count; i++) {
+        if (!vnb_string_ok(hdr, chars[i].id, false) || !vnb_string_ok(hdr, chars[i].image, false) ||
+            (chars[i].image_asset != VNB_NONE && chars[i].image_asset >= hdr->asset_count)) {
+            return false;
+        }
+    }
+
+    const vnb_choice_t *choices = (const vnb_choice_t *)(base + hdr->choices_off);
+    for (uint32_t i = 0; i < hdr->choice_count; i++) {
+        const vnb_choice_t *c = &choices[i];
+        if (!vnb_string_ok(hdr, c->text, false) || !vnb_string_ok(hdr, c->next_page, true) ||
+            !vnb_string_ok(hdr, c->condition, true) || !vnb_string_ok(hdr, c->script, true) ||
+            c->next_index < -1 || c->next_index >= (int32_t)hdr->page_count) {
+            return false;
+        }
+    }
+
+    const int32_t *index = (const int32_t *)(base + hdr->index_off);
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < hdr->index_size; i++) {
+        if (index[i] < -1 || index[i] >= (int32_t)hdr->page_count) {
+            return false;
+        }
+        used += index[i] >= 0;
+    }
+    if (used >= hdr->index_size) {
+        return false;
+    }
+
+    const uint32_t *assets = (const uint32_t *)(base + hdr->assets_off);
+    for (uint32_t i = 0; i < hdr->asset_count; i++) {
+        if (!vnb_string_ok(hdr, assets[i], false)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 /**
- * @brief 解析JSON配置文件
- * @param json_path JSON文件路径
- * @return 故事配置结构体指针，如果解析失败返回NULL
+ * @brief 加载编译后的二进制故事
+ * @param vnb_path .vnb 文件路径
+ * @return 故事配置结构体指针，如果文件无效返回NULL
  */
-story_config_t *parse_story_json(const char *json_path) {
-    // 读取JSON文件
-    size_t json_size;
-    char *json_content = read_file(json_path, &json_size);
-    if (!json_content) {
-        printf("无法读取JSON文件: %s\n", json_path);
+story_config_t *load_story_binary(const char *vnb_path) {
+    int fd = open(vnb_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
         return NULL;
     }
-    
-    // 解析JSON
-    json_value_t *json_value;
-    const char *json_end = parse_value(json_content, &json_value);
-    if (!json_end || json_value->type != JSON_TYPE_OBJECT) {
-        printf("JSON解析失败\n");
-        free(json_content);
-        if (json_value) {
-            free_json_value(json_value);
-        }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(vnb_header_t)) {
+        close(fd);
+        printf("二进制故事文件无效: %s\n", vnb_path);
         return NULL;
     }
-    
-    json_object_t *root = json_value->value.object;
-    
-    // 分配故事配置结构体
-    story_config_t *story = (story_config_t *)malloc(sizeof(story_config_t));
-    if (story == NULL) {
-        free(json_content);
-        free_json_value(json_value);
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
         return NULL;
     }
-    
-    // 设置故事基本信息
-    story->title = strdup(json_object_get_string(root, "title", "未命名故事"));
-    story->author = strdup(json_object_get_string(root, "author", "未知作者"));
-    
-    // 获取页面数组
-    const json_array_t *pages_array = json_object_get_array(root, "pages");
-    if (!pages_array) {
-        printf("找不到pages数组\n");
-        free((char *)story->title);
-        free((char *)story->author);
-        free(story);
-        free(json_content);
-        free_json_value(json_value);
+
+    const uint8_t *base = (const uint8_t *)map;
+    const vnb_header_t *hdr = (const vnb_header_t *)base;
+    if (!vnb_validate(base, size)) {
+        printf("二进制故事文件无效: %s\n", vnb_path);
+        munmap(map, size);
         return NULL;
     }
-    
-    // 分配页面数组
-    story->page_count = pages_array->count;
-    story->pages = (page_config_t *)malloc(sizeof(page_config_t) * story->page_count);
-    if (story->pages == NULL) {
-        free((char *)story->title);
-        free((char *)story->author);
-        free(story);
-        free(json_content);
-        free_json_value(json_value);
+
+    // 故事、页面、角色、选项和资源表放在同一块内存中，字符串直接指向映射
+    size_t block = sizeof(story_config_t) +
+                   sizeof(page_config_t) * hdr->page_count +
+                   sizeof(character_config_t) * hdr->character_count +
+                   sizeof(choice_config_t) * hdr->choice_count +
+                   sizeof(const char *) * hdr->asset_count;
+    story_config_t *story = (story_config_t *)calloc(1, block);
+    if (story == NULL) {
+        munmap(map, size);
         return NULL;
     }
-    
-    // 解析每个页面
-    for (int i = 0; i < story->page_count; i++) {
-        if (pages_array->items[i]->type != JSON_TYPE_OBJECT) {
-            printf("页面 %d 不是有效的对象\n", i);
-            // 释放已分配的资源
-            for (int j = 0; j < i; j++) {
-                if (story->pages[j].characters != NULL) {
-                    free(story->pages[j].characters);
-                }
-                free((char *)story->pages[j].id);
-                free((char *)story->pages[j].background);
-                free((char *)story->pages[j].text);
-                if (story->pages[j].next_page) {
-                    free((char *)story->pages[j].next_page);
-                }
-            }
-            free(story->pages);
-            free((char *)story->title);
-            free((char *)story->author);
-            free(story);
-            free(json_content);
-            free_json_value(json_value);
-            return NULL;
-        }
-        
-        json_object_t *page_obj = pages_array->items[i]->value.object;
-        
-        // 设置页面基本信息
-        story->pages[i].id = strdup(json_object_get_string(page_obj, "id", ""));
-        story->pages[i].background = strdup(json_object_get_string(page_obj, "background", ""));
-        story->pages[i].text = strdup(json_object_get_string(page_obj, "text", ""));
-        story->pages[i].next_page = NULL;
-        
-        const char *next_page = json_object_get_string(page_obj, "next_page", NULL);
-        if (next_page && strcmp(next_page, "null") != 0) {
-            story->pages[i].next_page = strdup(next_page);
-        }
-        
-        // 解析文本框配置
-        const json_object_t *textbox_obj = json_object_get_object(page_obj, "textbox");
-        if (textbox_obj) {
-            story->pages[i].textbox.visible = json_object_get_bool(textbox_obj, "visible", true);
-            story->pages[i].textbox.x = (int)json_object_get_number(textbox_obj, "x", 50);
-            story->pages[i].textbox.y = (int)json_object_get_number(textbox_obj, "y", 400);
-            story->pages[i].textbox.width = (int)json_object_get_number(textbox_obj, "width", 700);
-            story->pages[i].textbox.height = (int)json_object_get_number(textbox_obj, "height", 150);
-            story->pages[i].textbox.bg_color = strdup(json_object_get_string(textbox_obj, "bg_color", "#000000"));
-            story->pages[i].textbox.text_color = strdup(json_object_get_string(textbox_obj, "text_color", "#FFFFFF"));
-            story->pages[i].textbox.font = NULL;
-            
-            const char *font = json_object_get_string(textbox_obj, "font", NULL);
-            if (font) {
-                story->pages[i].textbox.font = strdup(font);
-            }
-            
-            story->pages[i].textbox.font_size = (int)json_object_get_number(textbox_obj, "font_size", 16);
-        } else {
-            // 默认文本框配置
-            story->pages[i].textbox.visible = true;
-            story->pages[i].textbox.x = 50;
-            story->pages[i].textbox.y = 400;
-            story->pages[i].textbox.width = 700;
-            story->pages[i].textbox.height = 150;
-            story->pages[i].textbox.bg_color = strdup("#000000");
-            story->pages[i].textbox.text_color = strdup("#FFFFFF");
-            story->pages[i].textbox.font = NULL;
-            story->pages[i].textbox.font_size = 16;
-        }
-        
-        // 解析角色数组
-        const json_array_t *characters_array = json_object_get_array(page_obj, "characters");
-        if (characters_array) {
-            story->pages[i].character_count = characters_array->count;
-            story->pages[i].characters = (character_config_t *)malloc(sizeof(character_config_t) * story->pages[i].character_count);
-            if (story->pages[i].characters == NULL) {
-                // 释放已分配的资源
-                for (int j = 0; j <= i; j++) {
-                    if (story->pages[j].characters != NULL) {
-                        free(story->pages[j].characters);
-                    }
-                    free((char *)story->pages[j].id);
-                    free((char *)story->pages[j].background);
-                    free((char *)story->pages[j].text);
-                    if (story->pages[j].next_page) {
-                        free((char *)story->pages[j].next_page);
-                    }
-                    free((char *)story->pages[j].textbox.bg_color);
-                    free((char *)story->pages[j].textbox.text_color);
-                    if (story->pages[j].textbox.font) {
-                        free((char *)story->pages[j].textbox.font);
-                    }
-                }
-                free(story->pages);
-                free((char *)story->title);
-                free((char *)story->author);
-                free(story);
-                free(json_content);
-                free_json_value(json_value);
-                return NULL;
-            }
-            
-            // 解析每个角色
-            for (int j = 0; j < story->pages[i].character_count; j++) {
-                if (characters_array->items[j]->type != JSON_TYPE_OBJECT) {
-                    printf("角色 %d 不是有效的对象\n", j);
-                    // 释放已分配的资源
-                    free(story->pages[i].characters);
-                    for (int k = 0; k <= i; k++) {
-                        if (k < i && story->pages[k].characters != NULL) {
-                            free(story->pages[k].characters);
-                        }
-                        free((char *)story->pages[k].id);
-                        free((char *)story->pages[k].background);
-                        free((char *)story->pages[k].text);
-                        if (story->pages[k].next_page) {
-                            free((char *)story->pages[k].next_page);
-                        }
-                        free((char *)story->pages[k].textbox.bg_color);
-                        free((char *)story->pages[k].textbox.text_color);
-                        if (story->pages[k].textbox.font) {
-                            free((char *)story->pages[k].textbox.font);
-                        }
-                    }
-                    free(story->pages);
-                    free((char *)story->title);
-                    free((char *)story->author);
-                    free(story);
-                    free(json_content);
-                    free_json_value(json_value);
-                    return NULL;
-                }
-                
-                json_object_t *char_obj = characters_array->items[j]->value.object;
-                
-                // 设置角色信息
-                story->pages[i].characters[j].id = strdup(json_object_get_string(char_obj, "id", ""));
-                story->pages[i].characters[j].image = strdup(json_object_get_string(char_obj, "image", ""));
-                story->pages[i].characters[j].x = (int)json_object_get_number(char_obj, "x", 0);
-                story->pages[i].characters[j].y = (int)json_object_get_number(char_obj, "y", 0);
-                story->pages[i].characters[j].scale = (float)json_object_get_number(char_obj, "scale", 1.0);
-                story->pages[i].characters[j].visible = json_object_get_bool(char_obj, "visible", true);
+    page_config_t *pages = (page_config_t *)(story + 1);
+    character_config_t *characters = (character_config_t *)(pages + hdr->page_count);
+    choice_config_t *choices = (choice_config_t *)(characters + hdr->character_count);
+    const char **assets = (const char **)(choices + hdr->choice_count);
+
+    const char *strings = (const char *)base + hdr->strings_off;
+#define VNB_STR(off) ((off) == VNB_NONE ? NULL : strings + (off))
+#define VNB_ASSET(id) ((id) == VNB_NONE ? -1 : (int)(id))
+
+    const vnb_character_t *src_chars = (const vnb_character_t *)(base + hdr->characters_off);
+    for (uint32_t i = 0; i < hdr->character_count; i++) {
+        character_config_t *c = &characters[i];
+        c->id = VNB_STR(src_chars[i].id);
+        c->image = VNB_STR(src_chars[i].image);
+        c->image_asset = VNB_ASSET(src_chars[i].image_asset);
+        c->x = src_chars[i].x;
+        c->y = src_chars[i].y;
+        c->scale = src_chars[i].scale;
+        c->visible = src_chars[i].visible != 0;
+    }
+
+    const vnb_choice_t *src_choices = (const vnb_choice_t *)(base + hdr->choices_off);
+    for (uint32_t i = 0; i < hdr->choice_count; i++) {
+        choice_config_t *c = &choices[i];
+        c->text = VNB_STR(src_choices[i].text);
+        c->next_page = VNB_STR(src_choices[i].next_page);
+        c->next_index = src_choices[i].next_index;
+        c->condition = VNB_STR(src_choices[i].condition);
+        c->script = VNB_STR(src_choices[i].script);
+    }
+
+    const vnb_page_t *src_pages = (const vnb_page_t *)(base + hdr->pages_off);
+    for (uint32_t i = 0; i < hdr->page_count; i++) {
+        const vnb_page_t *sp = &src_pages[i];
+        page_config_t *p = &pages[i];
+        p->id = VNB_STR(sp->id);
+        p->background = VNB_STR(sp->background);
+        p->background_asset = VNB_ASSET(sp->background_asset);
+        p->characters = sp->character_count ? &characters[sp->first_character] : NULL;
+        p->character_count = (int)sp->character_count;
+        p->text = VNB_STR(sp->text);
+        p->next_page = VNB_STR(sp->next_page);
+        p->next_index = sp->next_index;
+        p->textbox.visible = sp->tb_visible != 0;
+        p->textbox.x = sp->tb_x;
+        p->textbox.y = sp->tb_y;
+        p->textbox.width = sp->tb_width;
+        p->textbox.height = sp->tb_height;
+        p->textbox.bg_color = VNB_STR(sp->tb_bg_color);
+        p->textbox.text_color = VNB_STR(sp->tb_text_color);
+        p->textbox.font = VNB_STR(sp->tb_font);
+        p->textbox.font_size = sp->tb_font_size;
+        p->transition.type = (transition_type_t)sp->transition;
+        p->transition.duration = sp->transition_duration;
+        p->transition.curve = (transition_curve_t)sp->transition_curve;
+        p->script = VNB_STR(sp->script);
+        p->jump = VNB_STR(sp->jump);
+        p->choices = sp->choice_count ? &choices[sp->first_choice] : NULL;
+        p->choice_count = (int)sp->choice_count;
+    }
+
+    const uint32_t *src_assets = (const uint32_t *)(base + hdr->assets_off);
+    for (uint32_t i = 0; i < hdr->asset_count; i++) {
+        assets[i] = strings + src_assets[i];
+    }
+
+    story->title = VNB_STR(hdr->title);
+    story->author = VNB_STR(hdr->author);
+#undef VNB_STR
+#undef VNB_ASSET
+
+    story->pages = pages;
+    story->page_count = (int)hdr->page_count;
+    // 哈希表直接使用映射中的数组（只读映射，加载后不再修改）
+    story->page_index = (int *)(base + hdr->index_off);
+    story->page_hash = (uint32_t *)(base + hdr->hash_off);
+    story->page_index_mask = (int)hdr->index_size - 1;
+    story->assets = assets;
+    story->asset_count = (int)hdr->asset_count;
+    story->mapping = map;
+    story->mapping_size = size;
+    return story;
+}
+
+/**
+ * @brief 获取 JSON 路径对应的二进制故事路径
+ * @param json_path JSON文件路径
+ * @param out 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 是否成功
+ */
+bool story_binary_path(const char *json_path, char *out, size_t size) {
+    return story_sibling_path(json_path, VNB_EXTENSION, out, size);
+}
+
+/**
+ * @brief 获取故事文件的同名文件路径
+ * @param json_path JSON文件路径
+ * @param ext 新扩展名
+ * @param out 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 是否成功
+ */
+bool story_sibling_path(const char *json_path, const char *ext, char *out, size_t size) {
+    size_t len = strlen(json_path);
+    const char *dot = strrchr(json_path, '.');
+    const char *slash = strrchr(json_path, '/');
+    if (dot != NULL && (slash == NULL || dot > slash)) {
+        len = (size_t)(dot - json_path);
+    }
+    int n = snprintf(out, size, "%.*s%s", (int)len, json_path, ext);
+    return n > 0 && (size_t)n < size;
+}
+
+/**
+ * @brief 加载故事，优先使用编译后的二进制文件
+ * @param json_path JSON文件路径
+ * @return 故事配置结构体指针，如果加载失败返回NULL
+ */
+story_config_t *load_story(const char *json_path) {
+    size_t len = strlen(json_path);
+    size_t ext_len = strlen(VNB_EXTENSION);
+    if (len > ext_len && strcmp(json_path + len - ext_len, VNB_EXTENSION) == 0) {
+        return load_story_binary(json_path);
+    }
+
+    char vnb_path[512];
+    struct stat vnb_st;
+    struct stat json_st;
+    if (story_binary_path(json_path, vnb_path, sizeof(vnb_path)) && stat(vnb_path, &vnb_st) == 0) {
+        // JSON 修改后未重新编译时使用 JSON，避免加载过期内容
+        if (stat(json_path, &json_st) != 0 || vnb_st.st_mtime >= json_st.st_mtime) {
+            story_config_t *story = load_story_binary(vnb_path);
+            if (story != NULL) {
+                return story;
             }
+            printf("改用JSON文件: %s\n", json_path);
         } else {
-            story->pages[i].character_count = 0;
-            story->pages[i].characters = NULL;
+            printf("%s 比JSON文件旧，改用JSON文件\n", vnb_path);
         }
     }
-    
-    // 释放JSON内容和解析结果
-    free(json_content);
-    free_json_value(json_value);
-    
-    return story;
+
+    // 大文件只扫描页面位置，页面在访问时再解析
+    if (stat(json_path, &json_st) == 0 && json_st.st_size >= STORY_LAZY_MIN_SIZE) {
+        return load_story_lazy(json_path);
+    }
+    return parse_story_json(json_path);
 }
 
 /**
@@ -831,18 +1054,32 @@ story_config_t *parse_story_json(const char *json_path) {
  * @param page_id 页面ID
  * @return 页面配置结构体指针，如果未找到返回NULL
  */
-page_config_t *find_page_by_id(const story_config_t *story, const char *page_id) {
-    if (story == NULL || page_id == NULL) {
-        return NULL;
+page_config_t *find_page_by_id(story_config_t *story, const char *page_id) {
+    return story_get_page(story, find_page_index(story, page_id));
+}
+
+/**
+ * @brief 根据页面ID查找页面索引（哈希表查找）
+ * @param story 故事配置
+ * @param page_id 页面ID
+ * @return 页面索引，如果未找到返回-1
+ */
+int find_page_index(const story_config_t *story, const char *page_id) {
+    if (story == NULL || page_id == NULL || story->page_index == NULL) {
+        return -1;
     }
     
-    for (int i = 0; i < story->page_count; i++) {
-        if (strcmp(story->pages[i].id, page_id) == 0) {
-            return &story->pages[i];
+    uint32_t h = page_id_hash(page_id);
+    int slot = (int)(h & (uint32_t)story->page_index_mask);
+    while (story->page_index[slot] >= 0) {
+        int index = story->page_index[slot];
+        if (story->page_hash[index] == h && strcmp(page_id_at(story, index), page_id) == 0) {
+            return index;
         }
+        slot = (slot + 1) & story->page_index_mask;
     }
     
-    return NULL;
+    return -1;
 }
 
 /**
@@ -854,58 +1091,23 @@ void free_story_config(story_config_t *story) {
         return;
     }
     
-    // 释放故事基本信息
-    if (story->title) {
-        free((char *)story->title);
-    }
-    if (story->author) {
-        free((char *)story->author);
+    // 二进制故事：字符串位于映射中，页面/角色/选项数组与故事结构体在同一块内存
+    if (story->mapping != NULL) {
+        munmap(story->mapping, story->mapping_size);
+        free(story);
+        return;
     }
     
-    // 释放每个页面的配置
-    for (int i = 0; i < story->page_count; i++) {
-        // 释放页面基本信息
-        if (story->pages[i].id) {
-            free((char *)story->pages[i].id);
-        }
-        if (story->pages[i].background) {
-            free((char *)story->pages[i].background);
-        }
-        if (story->pages[i].text) {
-            free((char *)story->pages[i].text);
-        }
-        if (story->pages[i].next_page) {
-            free((char *)story->pages[i].next_page);
-        }
-        
-        // 释放文本框配置
-        if (story->pages[i].textbox.bg_color) {
-            free((char *)story->pages[i].textbox.bg_color);
-        }
-        if (story->pages[i].textbox.text_color) {
-            free((char *)story->pages[i].textbox.text_color);
-        }
-        if (story->pages[i].textbox.font) {
-            free((char *)story->pages[i].textbox.font);
-        }
-        
-        // 释放角色配置
-        if (story->pages[i].characters != NULL) {
-            for (int j = 0; j < story->pages[i].character_count; j++) {
-                if (story->pages[i].characters[j].id) {
-                    free((char *)story->pages[i].characters[j].id);
-                }
-                if (story->pages[i].characters[j].image) {
-                    free((char *)story->pages[i].characters[j].image);
-                }
-            }
-            free(story->pages[i].characters);
+    // 按需解析：释放缓存的页面文档和映射，其余状态在故事的内存池中
+    if (story->lazy != NULL) {
+        for (int i = 0; i < STORY_PAGE_CACHE; i++) {
+            json_free(&story->lazy->cache[i].doc);
         }
+        free(story->lazy->pages);
+        munmap((void *)story->lazy->text, story->lazy->size);
     }
     
-    // 释放页面数组
-    free(story->pages);
-    
-    // 释放故事配置
+    // JSON 故事：字符串、页面/角色数组和索引都在文档内存池中
+    json_free(&story->json);
     free(story);
 }
\ No newline at end of file
@@ -2,14 +2,56 @@
  * @file data_parser.h
  * @brief JSON数据解析器头文件
  *
- * 负责解析JSON配置文件，提取页面信息
+ * 负责解析JSON配置文件，提取页面信息。
+ * 也可以加载由 tools/vn_storyc 编译的二进制故事（.vnb，见 story_binary.h），
+ * 此时字符串直接指向 mmap 映射的文件，不再逐字段分配内存。
+ * 较大的 JSON 故事按需解析：打开时只记录每个页面的位置和ID，页面在第一次
+ * 访问（或被预取）时才解析，保存在容量为 STORY_PAGE_CACHE 的缓存中。
+ * 页面可以带有 Lua 脚本（script）、计算跳转（jump）和选项（choices），
+ * 由 vn_script 模块执行，这里只保存源码。
  */
 
 #ifndef DATA_PARSER_H
 #define DATA_PARSER_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "../json_tok.h"
+
+#define STORY_LAZY_MIN_SIZE     (1024 * 1024)   /**< JSON 文件不小于该大小时按需解析页面 */
+#define STORY_PAGE_CACHE        8               /**< 按需解析时缓存的页面数 */
+#define STORY_GLYPHS_EXTENSION  ".glyphs"       /**< 与故事同名的字形集文件（tools/font_bake 生成） */
+#define TRANSITION_DEFAULT_DURATION 300         /**< 页面切换效果的默认时长（毫秒） */
+
+/**
+ * @brief 页面切换效果
+ */
+typedef enum {
+    TRANSITION_NONE = 0,    /**< 直接切换 */
+    TRANSITION_FADE,        /**< 淡入淡出 */
+    TRANSITION_SLIDE,       /**< 新页面从右侧推入 */
+    TRANSITION_WIPE         /**< 从左到右擦除 */
+} transition_type_t;
+
+/**
+ * @brief 切换效果的时间曲线
+ */
+typedef enum {
+    TRANSITION_CURVE_LINEAR = 0,
+    TRANSITION_CURVE_EASE_IN,
+    TRANSITION_CURVE_EASE_OUT,
+    TRANSITION_CURVE_EASE_IN_OUT
+} transition_curve_t;
+
+/**
+ * @brief 页面切换效果配置（进入该页面时使用）
+ */
+typedef struct {
+    transition_type_t type;     /**< 效果 */
+    int duration;               /**< 时长（毫秒） */
+    transition_curve_t curve;   /**< 时间曲线 */
+} transition_config_t;
 
 /**
  * @brief 文本框配置结构体
@@ -32,33 +74,65 @@ typedef struct {
 typedef struct {
     const char *id;     /**< 角色ID */
     const char *image;  /**< 角色图片路径 */
+    int image_asset;    /**< 图片资源ID（资源表下标），-1表示无图片 */
     int x;              /**< X坐标 */
     int y;              /**< Y坐标 */
     float scale;        /**< 缩放比例 */
     bool visible;       /**< 是否可见 */
 } character_config_t;
 
+/**
+ * @brief 选项配置结构体
+ */
+typedef struct {
+    const char *text;       /**< 选项文字 */
+    const char *next_page;  /**< 选择后跳转的页面ID，NULL表示使用页面的下一页 */
+    int next_index;         /**< 跳转页面索引（加载时解析），-1表示使用页面的下一页 */
+    const char *condition;  /**< 显示条件（Lua 表达式），NULL表示总是显示 */
+    const char *script;     /**< 选择时执行的 Lua 代码，NULL表示没有 */
+} choice_config_t;
+
 /**
  * @brief 页面配置结构体
  */
 typedef struct {
     const char *id;                 /**< 页面ID */
     const char *background;         /**< 背景图片路径 */
+    int background_asset;           /**< 背景资源ID（资源表下标），-1表示无背景 */
     character_config_t *characters; /**< 角色数组 */
     int character_count;            /**< 角色数量 */
     const char *text;               /**< 页面文字内容 */
     textbox_config_t textbox;       /**< 文本框配置 */
+    transition_config_t transition; /**< 进入本页时的切换效果 */
     const char *next_page;          /**< 下一页ID，NULL表示故事结束 */
+    int next_index;                 /**< 下一页索引（加载时解析），-1表示故事结束 */
+    const char *script;             /**< 进入页面时执行的 Lua 代码，NULL表示没有 */
+    const char *jump;               /**< 计算下一页ID的 Lua 表达式，结果为 nil 时使用 next_page */
+    choice_config_t *choices;       /**< 选项数组，有选项时点击不翻页 */
+    int choice_count;               /**< 选项数量 */
 } page_config_t;
 
+struct story_lazy;
+
 /**
  * @brief 故事配置结构体
+ *
+ * 页面通过 story_get_page 访问；按需解析的故事 pages 为NULL。
  */
 typedef struct {
     const char *title;      /**< 故事标题 */
     const char *author;     /**< 作者信息 */
-    page_config_t *pages;   /**< 页面数组 */
+    page_config_t *pages;   /**< 页面数组（按需解析时为NULL） */
     int page_count;         /**< 页面数量 */
+    int *page_index;        /**< 页面ID哈希表（开放寻址），存放页面索引，-1为空槽 */
+    uint32_t *page_hash;    /**< 每个页面ID的哈希值 */
+    int page_index_mask;    /**< 哈希表大小减一（大小为2的幂） */
+    const char **assets;    /**< 资源表：去重后的图片路径，下标为资源ID */
+    int asset_count;        /**< 资源数量 */
+    json_doc_t json;        /**< JSON 文档：字符串和数组都位于其缓冲区和内存池中（二进制加载时为空） */
+    void *mapping;          /**< 二进制故事的 mmap 映射，JSON 加载时为NULL */
+    size_t mapping_size;    /**< 映射大小 */
+    struct story_lazy *lazy;    /**< 按需解析状态，NULL表示页面已全部解析 */
 } story_config_t;
 
 /**
@@ -68,13 +142,80 @@ typedef struct {
  */
 story_config_t *parse_story_json(const char *json_path);
 
+/**
+ * @brief 加载编译后的二进制故事（mmap 映射，只分配一块页面/角色数组）
+ * @param vnb_path .vnb 文件路径
+ * @return 故事配置结构体指针，如果文件无效返回NULL
+ */
+story_config_t *load_story_binary(const char *vnb_path);
+
+/**
+ * @brief 按需解析JSON故事：只扫描页面的位置和ID，页面在 story_get_page 时才解析
+ * @param json_path JSON文件路径
+ * @return 故事配置结构体指针，如果解析失败返回NULL
+ */
+story_config_t *load_story_lazy(const char *json_path);
+
+/**
+ * @brief 加载故事：同目录下存在不比 JSON 旧的同名 .vnb 文件时加载二进制，否则解析JSON
+ * （文件不小于 STORY_LAZY_MIN_SIZE 时按需解析）
+ * @param json_path JSON文件路径
+ * @return 故事配置结构体指针，如果加载失败返回NULL
+ */
+story_config_t *load_story(const char *json_path);
+
+/**
+ * @brief 获取 JSON 路径对应的二进制故事路径（把 .json 扩展名替换为 .vnb）
+ * @param json_path JSON文件路径
+ * @param out 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 是否成功
+ */
+bool story_binary_path(const char *json_path, char *out, size_t size);
+
+/**
+ * @brief 获取故事文件的同名文件路径（替换扩展名）
+ * @param json_path JSON文件路径
+ * @param ext 新扩展名（含 '.'）
+ * @param out 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 是否成功
+ */
+bool story_sibling_path(const char *json_path, const char *ext, char *out, size_t size);
+
+/**
+ * @brief 获取页面配置，按需解析的故事在此时解析页面并放入缓存
+ *
+ * 按需解析时返回的指针在之后 STORY_PAGE_CACHE 次获取其它页面后可能失效，
+ * 用 story_pin_page 固定的页面不会被淘汰。只能在主线程调用。
+ * @param story 故事配置
+ * @param index 页面索引
+ * @return 页面配置结构体指针，索引无效或页面解析失败返回NULL
+ */
+page_config_t *story_get_page(story_config_t *story, int index);
+
+/**
+ * @brief 固定页面（通常是当前页面），使其不被页面缓存淘汰，同一时间只固定一个页面
+ * @param story 故事配置
+ * @param index 页面索引，-1表示取消固定
+ */
+void story_pin_page(story_config_t *story, int index);
+
+/**
+ * @brief 根据页面ID查找页面索引（哈希表查找）
+ * @param story 故事配置
+ * @param page_id 页面ID
+ * @return 页面索引，如果未找到返回-1
+ */
+int find_page_index(const story_config_t *story, const char *page_id);
+
 /**
  * @brief 根据页面ID查找页面配置
  * @param story 故事配置
  * @param page_id 页面ID
  * @return 页面配置结构体指针，如果未找到返回NULL
  */
-page_config_t *find_page_by_id(const story_config_t *story, const char *page_id);
+page_config_t *find_page_by_id(story_config_t *story, const char *page_id);
 
 /**
  * @brief 释放故事配置
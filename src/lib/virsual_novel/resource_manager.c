@@ -2,104 +2,551 @@
  * @file resource_manager.c
  * @brief 资源管理器实现
  *
- * 负责图片资源的加载和释放
+ * 资源节点同时挂在两个结构上：
+ *   - 哈希桶链表（按ID查找，O(1)）
+ *   - 双向LRU链表（仅包含引用计数为0的资源，表头为最久未使用）
+ * 图片像素数据用 malloc 分配（与描述符在同一块内存），不占用 LVGL 堆。
+ * 字体由 font_atlas 加载（字形位图在共享图集中，不计入图片预算），加载后一直保留到释放所有资源。
+ *
+ * 未缓存的本地图片在获取时同步解码；网络图片不在 LVGL 线程下载，获取时返回NULL并把
+ * 下载和解码提交给 worker_pool，完成后在主线程以未引用状态放入缓存并调用就绪回调，
+ * 由调用方重新获取并替换占位。
  */
 
 #include "resource_manager.h"
+#include "../img_decode.h"
+#include "../http_fetch.h"
+#include "../font_atlas.h"
+#include "../worker_pool.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#define RESOURCE_MIN_BUCKETS  64
 
 /**
  * @brief 资源节点结构体
  */
 typedef struct resource_node {
     resource_t resource;
-    struct resource_node *next;
+    uint32_t hash;
+    struct resource_node *hash_next;    /**< 哈希桶链表 */
+    struct resource_node *lru_prev;     /**< LRU链表（仅未引用的资源） */
+    struct resource_node *lru_next;
+    bool in_lru;
 } resource_node_t;
 
-static resource_node_t *resource_list = NULL;  /**< 资源链表 */
+static resource_node_t **buckets = NULL;   /**< 哈希桶 */
+static uint32_t bucket_count = 0;          /**< 哈希桶数量（2的幂） */
+static resource_node_t *lru_head = NULL;   /**< 最久未使用 */
+static resource_node_t *lru_tail = NULL;   /**< 最近释放 */
+static resource_stats_t stats;
+
+/**
+ * @brief 后台加载的网络图片
+ */
+typedef struct load_job {
+    struct load_job *next;
+    uint32_t id;                        /**< worker_pool 任务ID */
+    char *path;
+    int max_w;
+    int max_h;
+    lv_image_dsc_t *dsc;                /**< 工作线程的结果 */
+    size_t bytes;
+} load_job_t;
+
+static load_job_t *loading = NULL;          /**< 加载中的任务（主线程访问） */
+static resource_ready_cb_t ready_cb = NULL;
+static void *ready_user_data = NULL;
+
+/**
+ * @brief 计算资源ID哈希值（FNV-1a）
+ */
+static uint32_t resource_hash(const char *id) {
+    uint32_t h = 2166136261u;
+    while (*id) {
+        h ^= (uint8_t)*id++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief 从LRU链表中移除
+ */
+static void lru_remove(resource_node_t *node) {
+    if (!node->in_lru) {
+        return;
+    }
+    if (node->lru_prev) {
+        node->lru_prev->lru_next = node->lru_next;
+    } else {
+        lru_head = node->lru_next;
+    }
+    if (node->lru_next) {
+        node->lru_next->lru_prev = node->lru_prev;
+    } else {
+        lru_tail = node->lru_prev;
+    }
+    node->lru_prev = node->lru_next = NULL;
+    node->in_lru = false;
+}
+
+/**
+ * @brief 加入LRU链表尾部（最近使用）
+ */
+static void lru_append(resource_node_t *node) {
+    node->lru_prev = lru_tail;
+    node->lru_next = NULL;
+    if (lru_tail) {
+        lru_tail->lru_next = node;
+    } else {
+        lru_head = node;
+    }
+    lru_tail = node;
+    node->in_lru = true;
+}
 
 /**
  * @brief 查找资源节点
  * @param id 资源ID
+ * @param hash ID哈希值
  * @return 资源节点，如果未找到返回NULL
  */
-static resource_node_t *find_resource_node(const char *id) {
-    resource_node_t *node = resource_list;
+static resource_node_t *find_resource_node(const char *id, uint32_t hash) {
+    if (buckets == NULL) {
+        return NULL;
+    }
+    resource_node_t *node = buckets[hash & (bucket_count - 1)];
     while (node != NULL) {
-        if (strcmp(node->resource.id, id) == 0) {
+        if (node->hash == hash && strcmp(node->resource.id, id) == 0) {
             return node;
         }
-        node = node->next;
+        node = node->hash_next;
     }
     return NULL;
 }
 
 /**
- * @brief 创建新的资源节点
- * @param id 资源ID
- * @param type 资源类型
- * @param data 资源数据
- * @return 资源节点
+ * @brief 资源数量超过桶数量时扩容
  */
-static resource_node_t *create_resource_node(const char *id, resource_type_t type, void *data) {
-    resource_node_t *node = (resource_node_t *)malloc(sizeof(resource_node_t));
-    if (node == NULL) {
+static void maybe_grow(void) {
+    if ((uint32_t)stats.entries < bucket_count) {
+        return;
+    }
+
+    uint32_t new_count = bucket_count * 2;
+    resource_node_t **new_buckets = (resource_node_t **)calloc(new_count, sizeof(resource_node_t *));
+    if (new_buckets == NULL) {
+        return;  // 扩容失败只影响查找效率
+    }
+
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        resource_node_t *node = buckets[i];
+        while (node != NULL) {
+            resource_node_t *next = node->hash_next;
+            uint32_t b = node->hash & (new_count - 1);
+            node->hash_next = new_buckets[b];
+            new_buckets[b] = node;
+            node = next;
+        }
+    }
+
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = new_count;
+}
+
+/**
+ * @brief 释放资源数据
+ */
+static void free_resource_data(resource_t *res) {
+    if (res->type == RESOURCE_TYPE_IMAGE && res->data != NULL) {
+        // 通知 LVGL 图片缓存该描述符即将失效
+        lv_image_cache_drop(res->data);
+        free(res->data);
+    } else if (res->type == RESOURCE_TYPE_FONT && res->data != NULL) {
+        font_atlas_unload((lv_font_t *)res->data);
+    }
+    res->data = NULL;
+}
+
+/**
+ * @brief 从哈希表和LRU链表中删除并释放节点
+ */
+static void destroy_node(resource_node_t *node) {
+    resource_node_t **pp = &buckets[node->hash & (bucket_count - 1)];
+    while (*pp != NULL && *pp != node) {
+        pp = &(*pp)->hash_next;
+    }
+    if (*pp == node) {
+        *pp = node->hash_next;
+    }
+    lru_remove(node);
+
+    stats.bytes_used -= node->resource.bytes;
+    stats.entries--;
+
+    free_resource_data(&node->resource);
+    free((char *)node->resource.id);
+    free(node);
+}
+
+/**
+ * @brief 从最久未使用的资源开始淘汰，直到可以容纳 incoming 字节
+ */
+static void evict_for(size_t incoming) {
+    while (lru_head != NULL && stats.bytes_used + incoming > stats.bytes_budget) {
+        destroy_node(lru_head);
+        stats.evictions++;
+    }
+}
+
+/**
+ * @brief 将 X:/ 形式的 LVGL 盘符路径转换为系统路径，其它路径（含URL）原样返回
+ */
+static const char *real_path(const char *path) {
+    if (isupper((unsigned char)path[0]) && path[1] == ':' && path[2] == '/') {
+        return path + 2;
+    }
+    return path;
+}
+
+/**
+ * @brief 解码图片为 lv_image_dsc_t（描述符与像素数据在同一块内存）
+ * @param path 图片路径
+ * @param max_w 最大宽度
+ * @param max_h 最大高度
+ * @param bytes 占用字节数（输出）
+ * @return 图片描述符，失败返回NULL
+ */
+lv_image_dsc_t *resource_manager_decode_image(const char *path, int max_w, int max_h, size_t *bytes) {
+    // 网络图片先下载到本地缓存；缓存键仍然是URL
+    char local[PATH_MAX];
+    const char *file = real_path(path);
+    if (http_fetch_is_url(path)) {
+        if (http_fetch_sync(path, local, sizeof(local)) == HTTP_FETCH_ERROR) {
+            printf("[vn] 图片下载失败: %s\n", path);
+            return NULL;
+        }
+        file = local;
+    }
+
+    // 角色立绘需要透明通道，统一使用 ARGB8888
+    img_decode_result_t res;
+    if (!img_decode_file(file, max_w, max_h, LV_COLOR_FORMAT_ARGB8888, &res)) {
+        printf("[vn] 图片解码失败: %s\n", path);
+        return NULL;
+    }
+
+    size_t data_size = (size_t)res.stride * res.h;
+    lv_image_dsc_t *dsc = (lv_image_dsc_t *)malloc(sizeof(lv_image_dsc_t) + data_size);
+    if (dsc == NULL) {
+        img_decode_free(&res);
+        return NULL;
+    }
+
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
+    dsc->header.cf = res.cf;
+    dsc->header.w = res.w;
+    dsc->header.h = res.h;
+    dsc->header.stride = res.stride;
+    dsc->data_size = data_size;
+    dsc->data = (const uint8_t *)(dsc + 1);
+    memcpy((void *)dsc->data, res.data, data_size);
+    img_decode_free(&res);
+
+    *bytes = sizeof(lv_image_dsc_t) + data_size;
+    return dsc;
+}
+
+/**
+ * @brief 创建节点并插入哈希表
+ */
+static resource_node_t *insert_node(const char *path, uint32_t hash, resource_type_t type, void *data, size_t bytes) {
+    resource_node_t *node = (resource_node_t *)calloc(1, sizeof(resource_node_t));
+    char *id = strdup(path);
+    if (node == NULL || id == NULL) {
+        free(node);
+        free(id);
         return NULL;
     }
-    
-    node->resource.id = strdup(id);
+
+    node->resource.id = id;
     node->resource.type = type;
     node->resource.data = data;
-    node->resource.ref_count = 1;
-    node->next = NULL;
-    
+    node->resource.bytes = bytes;
+    node->hash = hash;
+
+    uint32_t b = hash & (bucket_count - 1);
+    node->hash_next = buckets[b];
+    buckets[b] = node;
+
+    stats.entries++;
+    stats.bytes_used += bytes;
+    maybe_grow();
     return node;
 }
 
+/**
+ * @brief 从加载列表中移除任务（deinit 后列表已清空时忽略）
+ */
+static void loading_remove(load_job_t *job) {
+    for (load_job_t **pp = &loading; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == job) {
+            *pp = job->next;
+            return;
+        }
+    }
+}
+
+static void load_work(void *arg) {
+    load_job_t *job = (load_job_t *)arg;
+    job->dsc = resource_manager_decode_image(job->path, job->max_w, job->max_h, &job->bytes);
+}
+
+/**
+ * @brief 加载完成（主线程）：以未引用状态放入缓存，通知调用方重新获取
+ */
+static void load_done(void *arg, bool cancelled) {
+    load_job_t *job = (load_job_t *)arg;
+    loading_remove(job);
+
+    if (!cancelled && job->dsc != NULL && buckets != NULL) {
+        uint32_t hash = resource_hash(job->path);
+        if (find_resource_node(job->path, hash) == NULL) {
+            // 正在显示的图片允许暂时超出预算，回调中没有被获取的在之后淘汰
+            evict_for(job->bytes);
+            resource_node_t *node = insert_node(job->path, hash, RESOURCE_TYPE_IMAGE, job->dsc, job->bytes);
+            if (node != NULL) {
+                lru_append(node);
+                job->dsc = NULL;   // 已由缓存接管
+            }
+        }
+        if (ready_cb != NULL) {
+            ready_cb(job->path, ready_user_data);
+        }
+        evict_for(0);
+    }
+
+    free(job->dsc);
+    free(job->path);
+    free(job);
+}
+
+/**
+ * @brief 在后台下载并解码网络图片，已在加载中时不重复提交
+ */
+static void load_async(const char *path, int max_w, int max_h) {
+    for (load_job_t *job = loading; job != NULL; job = job->next) {
+        if (strcmp(job->path, path) == 0) {
+            return;
+        }
+    }
+
+    load_job_t *job = (load_job_t *)calloc(1, sizeof(load_job_t));
+    if (job == NULL || (job->path = strdup(path)) == NULL) {
+        free(job);
+        return;
+    }
+    job->max_w = max_w;
+    job->max_h = max_h;
+    job->id = worker_pool_submit(WORKER_PRIO_HIGH, load_work, load_done, job);
+    if (job->id == 0) {
+        printf("[vn] 无法提交图片下载: %s\n", path);
+        free(job->path);
+        free(job);
+        return;
+    }
+    job->next = loading;
+    loading = job;
+}
+
 /**
  * @brief 初始化资源管理器
  */
 void resource_manager_init(void) {
-    resource_list = NULL;
+    if (buckets != NULL) {
+        return;
+    }
+
+    bucket_count = RESOURCE_MIN_BUCKETS;
+    buckets = (resource_node_t **)calloc(bucket_count, sizeof(resource_node_t *));
+    lru_head = lru_tail = NULL;
+    memset(&stats, 0, sizeof(stats));
+    stats.bytes_budget = RESOURCE_MANAGER_DEFAULT_BUDGET;
 }
 
 /**
- * @brief 加载图片资源
- * @param id 资源ID
+ * @brief 设置图片缓存的字节预算
+ * @param bytes 字节数
+ */
+void resource_manager_set_budget(size_t bytes) {
+    stats.bytes_budget = bytes;
+    evict_for(0);
+}
+
+/**
+ * @brief 获取图片资源并增加引用计数，未缓存的本地图片同步解码，网络图片在后台加载
  * @param path 图片路径
- * @return 图片对象，如果加载失败返回NULL
+ * @return 资源，解码失败或网络图片加载中返回NULL
  */
-lv_obj_t *resource_manager_load_image(const char *id, const char *path) {
-    // 查找是否已加载该资源
-    resource_node_t *node = find_resource_node(id);
+resource_t *resource_manager_acquire_image(const char *path) {
+    if (buckets == NULL || path == NULL || path[0] == '\0') {
+        return NULL;
+    }
+
+    uint32_t hash = resource_hash(path);
+    resource_node_t *node = find_resource_node(path, hash);
     if (node != NULL) {
-        // 增加引用计数
-        node->resource.ref_count++;
-        return (lv_obj_t *)node->resource.data;
+        stats.hits++;
+        lru_remove(node);
+        if (node->resource.ref_count++ == 0) {
+            stats.pinned++;
+        }
+        return &node->resource;
+    }
+
+    stats.misses++;
+
+    // 不超过屏幕尺寸
+    lv_display_t *disp = lv_display_get_default();
+    int max_w = disp ? lv_display_get_horizontal_resolution(disp) : 0;
+    int max_h = disp ? lv_display_get_vertical_resolution(disp) : 0;
+
+    // 不在 LVGL 线程下载，完成后由就绪回调通知
+    if (http_fetch_is_url(path)) {
+        load_async(path, max_w, max_h);
+        return NULL;
     }
-    
-    // 创建图片对象
-    lv_obj_t *img = lv_img_create(lv_scr_act());
-    if (img == NULL) {
+
+    size_t bytes = 0;
+    lv_image_dsc_t *dsc = resource_manager_decode_image(path, max_w, max_h, &bytes);
+    if (dsc == NULL) {
         return NULL;
     }
-    
-    // 设置图片源
-    lv_img_set_src(img, path);
-    
-    // 创建资源节点并添加到链表
-    node = create_resource_node(id, RESOURCE_TYPE_IMAGE, img);
+
+    // 先淘汰再插入；所有资源都被固定时允许暂时超出预算
+    evict_for(bytes);
+    if (stats.bytes_used + bytes > stats.bytes_budget) {
+        printf("[vn] 图片缓存超出预算: %zu/%zu 字节\n", stats.bytes_used + bytes, stats.bytes_budget);
+    }
+
+    node = insert_node(path, hash, RESOURCE_TYPE_IMAGE, dsc, bytes);
     if (node == NULL) {
-        lv_obj_del(img);
+        free(dsc);
         return NULL;
     }
-    
-    // 添加到链表头部
-    node->next = resource_list;
-    resource_list = node;
-    
-    return img;
+    node->resource.ref_count = 1;
+    stats.pinned++;
+
+    return &node->resource;
+}
+
+/**
+ * @brief 图片是否已在缓存中
+ * @param path 图片路径
+ * @return 是否已缓存
+ */
+bool resource_manager_contains(const char *path) {
+    if (path == NULL || path[0] == '\0') {
+        return false;
+    }
+    return find_resource_node(path, resource_hash(path)) != NULL;
+}
+
+/**
+ * @brief 把已解码的图片以未引用状态放入缓存
+ * @param path 图片路径
+ * @param dsc 图片描述符
+ * @param bytes 占用字节数
+ * @return 是否放入缓存
+ */
+bool resource_manager_insert_image(const char *path, lv_image_dsc_t *dsc, size_t bytes) {
+    if (buckets == NULL || path == NULL || dsc == NULL) {
+        return false;
+    }
+
+    uint32_t hash = resource_hash(path);
+    if (find_resource_node(path, hash) != NULL) {
+        return false;
+    }
+
+    // 预取的图片不允许超出预算
+    evict_for(bytes);
+    if (stats.bytes_used + bytes > stats.bytes_budget) {
+        return false;
+    }
+
+    resource_node_t *node = insert_node(path, hash, RESOURCE_TYPE_IMAGE, dsc, bytes);
+    if (node == NULL) {
+        return false;
+    }
+    lru_append(node);
+    return true;
+}
+
+/**
+ * @brief 网络图片是否正在后台加载
+ * @param path 图片路径
+ * @return 是否加载中
+ */
+bool resource_manager_is_loading(const char *path) {
+    if (path == NULL) {
+        return false;
+    }
+    for (load_job_t *job = loading; job != NULL; job = job->next) {
+        if (strcmp(job->path, path) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 设置后台加载完成的回调
+ * @param cb 回调，NULL 表示取消
+ * @param user_data 用户数据
+ */
+void resource_manager_set_ready_cb(resource_ready_cb_t cb, void *user_data) {
+    ready_cb = cb;
+    ready_user_data = user_data;
+}
+
+/**
+ * @brief 增加一次引用
+ * @param res 资源
+ */
+void resource_manager_retain(resource_t *res) {
+    if (res == NULL) {
+        return;
+    }
+    if (res->ref_count++ == 0) {
+        lru_remove((resource_node_t *)res);
+        stats.pinned++;
+    }
+}
+
+/**
+ * @brief 释放一次引用
+ * @param res 资源
+ */
+void resource_manager_release(resource_t *res) {
+    if (res == NULL || res->ref_count <= 0) {
+        return;
+    }
+
+    // resource_t 是节点的第一个成员
+    resource_node_t *node = (resource_node_t *)res;
+    if (--res->ref_count == 0) {
+        stats.pinned--;
+        lru_append(node);
+        evict_for(0);
+    }
 }
 
 /**
@@ -110,86 +557,46 @@ lv_obj_t *resource_manager_load_image(const char *id, const char *path) {
  * @return 字体对象，如果加载失败返回NULL
  */
 lv_font_t *resource_manager_load_font(const char *id, const char *path, int size) {
+    if (buckets == NULL || path == NULL || path[0] == '\0') {
+        return NULL;
+    }
+    if (id == NULL) {
+        id = path;
+    }
+
     // 查找是否已加载该资源
-    resource_node_t *node = find_resource_node(id);
-    if (node != NULL) {
-        // 增加引用计数
+    uint32_t hash = resource_hash(id);
+    resource_node_t *node = find_resource_node(id, hash);
+    if (node != NULL && node->resource.type == RESOURCE_TYPE_FONT) {
         node->resource.ref_count++;
         return (lv_font_t *)node->resource.data;
     }
-    
-    // TODO: 实现字体加载
-    // 这里简化处理，实际应用中需要根据LVGL的字体加载机制实现
-    lv_font_t *font = NULL;
-    
+    if (node != NULL) {
+        printf("[vn] 资源ID已被其它类型的资源使用: %s\n", id);
+        return NULL;
+    }
+
+    lv_font_t *font = font_atlas_load(real_path(path), size);
     if (font == NULL) {
         return NULL;
     }
-    
-    // 创建资源节点并添加到链表
-    node = create_resource_node(id, RESOURCE_TYPE_FONT, font);
+    node = insert_node(id, hash, RESOURCE_TYPE_FONT, font, 0);
     if (node == NULL) {
-        // 释放字体资源
+        font_atlas_unload(font);
         return NULL;
     }
-    
-    // 添加到链表头部
-    node->next = resource_list;
-    resource_list = node;
-    
+    node->resource.ref_count = 1;
+    stats.pinned++;
     return font;
 }
 
 /**
- * @brief 增加资源引用计数
- * @param id 资源ID
- */
-void resource_manager_ref(const char *id) {
-    resource_node_t *node = find_resource_node(id);
-    if (node != NULL) {
-        node->resource.ref_count++;
-    }
-}
-
-/**
- * @brief 减少资源引用计数，如果引用计数为0则释放资源
- * @param id 资源ID
+ * @brief 获取缓存统计
+ * @param out 输出
  */
-void resource_manager_unref(const char *id) {
-    resource_node_t *node = find_resource_node(id);
-    if (node == NULL) {
-        return;
-    }
-    
-    // 减少引用计数
-    node->resource.ref_count--;
-    
-    // 如果引用计数为0，释放资源
-    if (node->resource.ref_count <= 0) {
-        // 从链表中删除节点
-        if (node == resource_list) {
-            resource_list = node->next;
-        } else {
-            resource_node_t *prev = resource_list;
-            while (prev != NULL && prev->next != node) {
-                prev = prev->next;
-            }
-            if (prev != NULL) {
-                prev->next = node->next;
-            }
-        }
-        
-        // 释放资源数据
-        if (node->resource.type == RESOURCE_TYPE_IMAGE) {
-            lv_obj_del((lv_obj_t *)node->resource.data);
-        }
-        // TODO: 处理其他类型资源的释放
-        
-        // 释放资源ID
-        free((char *)node->resource.id);
-        
-        // 释放节点
-        free(node);
+void resource_manager_get_stats(resource_stats_t *out) {
+    if (out != NULL) {
+        *out = stats;
     }
 }
 
@@ -197,38 +604,8 @@ void resource_manager_unref(const char *id) {
  * @brief 释放所有未使用的资源（引用计数为0的资源）
  */
 void resource_manager_free_unused(void) {
-    resource_node_t *node = resource_list;
-    while (node != NULL) {
-        resource_node_t *next = node->next;
-        
-        if (node->resource.ref_count <= 0) {
-            // 从链表中删除节点
-            if (node == resource_list) {
-                resource_list = node->next;
-            } else {
-                resource_node_t *prev = resource_list;
-                while (prev != NULL && prev->next != node) {
-                    prev = prev->next;
-                }
-                if (prev != NULL) {
-                    prev->next = node->next;
-                }
-            }
-            
-            // 释放资源数据
-            if (node->resource.type == RESOURCE_TYPE_IMAGE) {
-                lv_obj_del((lv_obj_t *)node->resource.data);
-            }
-            // TODO: 处理其他类型资源的释放
-            
-            // 释放资源ID
-            free((char *)node->resource.id);
-            
-            // 释放节点
-            free(node);
-        }
-        
-        node = next;
+    while (lru_head != NULL) {
+        destroy_node(lru_head);
     }
 }
 
@@ -236,31 +613,39 @@ void resource_manager_free_unused(void) {
  * @brief 释放所有资源
  */
 void resource_manager_free_all(void) {
-    resource_node_t *node = resource_list;
-    while (node != NULL) {
-        resource_node_t *next = node->next;
-        
-        // 释放资源数据
-        if (node->resource.type == RESOURCE_TYPE_IMAGE) {
-            lv_obj_del((lv_obj_t *)node->resource.data);
+    if (buckets == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        while (buckets[i] != NULL) {
+            destroy_node(buckets[i]);
         }
-        // TODO: 处理其他类型资源的释放
-        
-        // 释放资源ID
-        free((char *)node->resource.id);
-        
-        // 释放节点
-        free(node);
-        
-        node = next;
     }
-    
-    resource_list = NULL;
+    stats.pinned = 0;
 }
 
 /**
  * @brief 反初始化资源管理器
  */
 void resource_manager_deinit(void) {
+    if (buckets == NULL) {
+        return;
+    }
+
+    printf("[vn] 资源缓存统计: 命中 %u, 未命中 %u, 淘汰 %u, 当前占用 %zu 字节\n",
+           stats.hits, stats.misses, stats.evictions, stats.bytes_used);
+
+    // 加载中的任务取消后由 worker_pool 调用 done 释放
+    while (loading != NULL) {
+        load_job_t *job = loading;
+        loading = job->next;
+        worker_pool_cancel(job->id);
+    }
+    ready_cb = NULL;
+    ready_user_data = NULL;
     resource_manager_free_all();
-}
\ No newline at end of file
+    free(buckets);
+    buckets = NULL;
+    bucket_count = 0;
+}
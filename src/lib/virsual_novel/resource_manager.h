@@ -2,13 +2,24 @@
  * @file resource_manager.h
  * @brief 资源管理器头文件
  *
- * 负责图片资源的加载和释放
+ * 按路径缓存解码后的图片描述符（lv_image_dsc_t），而不是图片控件。
+ * 资源通过哈希表查找，引用计数为0的资源进入LRU链表，
+ * 总字节数超过预算时从最久未使用的资源开始释放。
+ * 引擎在切换页面时先获取（固定）新页面的资源，再释放旧页面的资源，
+ * 相邻页面共用的图片不会被重新解码。
+ * 网络图片不在 LVGL 线程下载：获取时返回NULL并在 worker_pool 中下载解码，
+ * 完成后调用就绪回调，调用方先显示占位，回调中重新获取。
  */
 
 #ifndef RESOURCE_MANAGER_H
 #define RESOURCE_MANAGER_H
 
 #include "lvgl/lvgl.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RESOURCE_MANAGER_DEFAULT_BUDGET  (8 * 1024 * 1024)  /**< 默认图片缓存预算（字节） */
 
 /**
  * @brief 资源类型枚举
@@ -23,45 +34,122 @@ typedef enum {
  * @brief 资源结构体
  */
 typedef struct {
-    const char *id;           /**< 资源ID */
+    const char *id;           /**< 资源ID（图片为路径） */
     resource_type_t type;     /**< 资源类型 */
-    void *data;               /**< 资源数据 */
-    int ref_count;            /**< 引用计数 */
+    void *data;               /**< 资源数据（图片为 lv_image_dsc_t*，字体为 lv_font_t*） */
+    int ref_count;            /**< 引用计数（固定数），为0时可被淘汰 */
+    size_t bytes;             /**< 占用字节数 */
 } resource_t;
 
+/**
+ * @brief 后台加载的图片已放入缓存（LVGL 主线程）
+ * @param path 图片路径
+ * @param user_data 用户数据
+ */
+typedef void (*resource_ready_cb_t)(const char *path, void *user_data);
+
+/**
+ * @brief 资源缓存统计
+ */
+typedef struct {
+    uint32_t hits;            /**< 命中次数 */
+    uint32_t misses;          /**< 未命中（解码）次数 */
+    uint32_t evictions;       /**< 淘汰次数 */
+    size_t bytes_used;        /**< 当前占用字节数 */
+    size_t bytes_budget;      /**< 字节预算 */
+    int entries;              /**< 缓存的资源数量 */
+    int pinned;               /**< 被固定（引用计数大于0）的资源数量 */
+} resource_stats_t;
+
 /**
  * @brief 初始化资源管理器
  */
 void resource_manager_init(void);
 
 /**
- * @brief 加载图片资源
- * @param id 资源ID
+ * @brief 设置图片缓存的字节预算，超出时立即淘汰未使用的资源
+ * @param bytes 字节数
+ */
+void resource_manager_set_budget(size_t bytes);
+
+/**
+ * @brief 获取图片资源并增加引用计数
+ *
+ * 未缓存的本地图片同步解码；未缓存的URL返回NULL并在后台下载解码，
+ * 完成后调用 resource_manager_set_ready_cb 设置的回调。
+ * @param path 图片路径（本地路径、X:/ 盘符路径或URL）
+ * @return 资源，data 为 lv_image_dsc_t*；解码失败或加载中返回NULL
+ */
+resource_t *resource_manager_acquire_image(const char *path);
+
+/**
+ * @brief 网络图片是否正在后台加载
  * @param path 图片路径
- * @return 图片对象，如果加载失败返回NULL
+ * @return 是否加载中
  */
-lv_obj_t *resource_manager_load_image(const char *id, const char *path);
+bool resource_manager_is_loading(const char *path);
 
 /**
- * @brief 加载字体资源
- * @param id 资源ID
- * @param path 字体路径
- * @param size 字体大小
- * @return 字体对象，如果加载失败返回NULL
+ * @brief 设置后台加载完成的回调（同一时间只有一个）
+ * @param cb 回调，NULL 表示取消
+ * @param user_data 用户数据
  */
-lv_font_t *resource_manager_load_font(const char *id, const char *path, int size);
+void resource_manager_set_ready_cb(resource_ready_cb_t cb, void *user_data);
 
 /**
- * @brief 增加资源引用计数
- * @param id 资源ID
+ * @brief 增加一次引用（已持有的资源，不查找、不解码）
+ * @param res 资源，NULL 时忽略
  */
-void resource_manager_ref(const char *id);
+void resource_manager_retain(resource_t *res);
+
+/**
+ * @brief 释放一次引用，引用计数为0后资源保留在缓存中，直到预算不足时被淘汰
+ * @param res 资源
+ */
+void resource_manager_release(resource_t *res);
+
+/**
+ * @brief 图片是否已在缓存中（不改变引用计数和LRU顺序）
+ * @param path 图片路径
+ * @return 是否已缓存
+ */
+bool resource_manager_contains(const char *path);
+
+/**
+ * @brief 解码图片为描述符（线程安全，不调用 LVGL 接口，供预取线程使用）
+ *
+ * URL 会先通过 http_fetch 同步下载到磁盘缓存，因此预取线程同时负责下载。
+ * @param path 图片路径
+ * @param max_w 最大宽度，<=0 表示不限制
+ * @param max_h 最大高度，<=0 表示不限制
+ * @param bytes 占用字节数（输出）
+ * @return 图片描述符（malloc 分配），失败返回NULL
+ */
+lv_image_dsc_t *resource_manager_decode_image(const char *path, int max_w, int max_h, size_t *bytes);
+
+/**
+ * @brief 把已解码的图片以未引用状态放入缓存（最近使用端）
+ * @param path 图片路径
+ * @param dsc resource_manager_decode_image 返回的描述符，成功后由缓存接管
+ * @param bytes 占用字节数
+ * @return 是否放入缓存；已存在或预算不足时返回false，调用方负责 free(dsc)
+ */
+bool resource_manager_insert_image(const char *path, lv_image_dsc_t *dsc, size_t bytes);
+
+/**
+ * @brief 加载 TTF/OTF 字体资源并增加引用计数，字形缓存在 font_atlas 的共享图集中
+ * @param id 资源ID（同一字体的不同字号应使用不同ID），NULL 表示使用路径
+ * @param path 字体路径（本地路径或 X:/ 盘符路径）
+ * @param size 字体大小（像素）
+ * @return 字体对象（fallback 由调用方设置），如果加载失败返回NULL
+ */
+lv_font_t *resource_manager_load_font(const char *id, const char *path, int size);
 
 /**
- * @brief 减少资源引用计数，如果引用计数为0则释放资源
- * @param id 资源ID
+ * @brief 获取缓存统计
+ * @param stats 输出
  */
-void resource_manager_unref(const char *id);
+void resource_manager_get_stats(resource_stats_t *stats);
 
 /**
  * @brief 释放所有未使用的资源（引用计数为0的资源）
@@ -78,4 +166,4 @@ void resource_manager_free_all(void);
  */
 void resource_manager_deinit(void);
 
-#endif /* RESOURCE_MANAGER_H */
\ No newline at end of file
+#endif /* RESOURCE_MANAGER_H */
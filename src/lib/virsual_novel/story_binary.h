@@ -0,0 +1,109 @@
+/**
+ * @file story_binary.h
+ * @brief 编译后的故事二进制格式（.vnb）
+ *
+ * 由 tools/vn_storyc 从 story.json 生成，引擎用 mmap 直接读取，不再逐字段分配内存。
+ * 所有整数为小端序，偏移量从文件开头计算并按4字节对齐；字符串以偏移量引用字符串表
+ * （以 '\0' 结尾，相同字符串只保存一份），VNB_NONE 表示空。
+ *
+ * 文件布局：
+ *   vnb_header_t
+ *   vnb_page_t[page_count]            定长页面记录，跳转目标已解析为页面索引
+ *   vnb_character_t[character_count]  定长角色记录，按页面顺序连续存放
+ *   vnb_choice_t[choice_count]        定长选项记录，按页面顺序连续存放
+ *   int32_t[index_size]               页面ID哈希表（开放寻址，-1为空槽）
+ *   uint32_t[page_count]              每个页面ID的哈希值
+ *   uint32_t[asset_count]             资源表：图片路径的字符串偏移，下标即资源ID
+ *   char[strings_size]                字符串表
+ */
+
+#ifndef STORY_BINARY_H
+#define STORY_BINARY_H
+
+#include <stdint.h>
+
+#define VNB_MAGIC       "VNB1"
+#define VNB_VERSION     3
+#define VNB_NONE        0xFFFFFFFFu     /**< 空字符串/无资源 */
+#define VNB_EXTENSION   ".vnb"
+
+/**
+ * @brief 文件头
+ */
+typedef struct {
+    char magic[4];              /**< "VNB1" */
+    uint16_t version;           /**< 格式版本 */
+    uint16_t header_size;       /**< sizeof(vnb_header_t) */
+    uint32_t file_size;         /**< 文件总大小 */
+    uint32_t title;             /**< 故事标题（字符串偏移） */
+    uint32_t author;            /**< 作者（字符串偏移） */
+    uint32_t page_count;
+    uint32_t pages_off;
+    uint32_t character_count;
+    uint32_t characters_off;
+    uint32_t choice_count;
+    uint32_t choices_off;
+    uint32_t index_size;        /**< 哈希表大小（2的幂） */
+    uint32_t index_off;
+    uint32_t hash_off;
+    uint32_t asset_count;
+    uint32_t assets_off;
+    uint32_t strings_size;
+    uint32_t strings_off;
+} vnb_header_t;
+
+/**
+ * @brief 页面记录
+ */
+typedef struct {
+    uint32_t id;                /**< 页面ID */
+    uint32_t background;        /**< 背景图片路径 */
+    uint32_t text;              /**< 页面文字 */
+    uint32_t next_page;         /**< 下一页ID */
+    int32_t next_index;         /**< 下一页索引，-1表示故事结束 */
+    uint32_t background_asset;  /**< 背景资源ID */
+    uint32_t first_character;   /**< 第一个角色在角色数组中的下标 */
+    uint32_t character_count;
+    int32_t tb_visible;         /**< 文本框配置 */
+    int32_t tb_x;
+    int32_t tb_y;
+    int32_t tb_width;
+    int32_t tb_height;
+    uint32_t tb_bg_color;
+    uint32_t tb_text_color;
+    uint32_t tb_font;
+    int32_t tb_font_size;
+    int32_t transition;         /**< 切换效果（transition_type_t） */
+    int32_t transition_duration;
+    int32_t transition_curve;   /**< transition_curve_t */
+    uint32_t script;            /**< 进入页面时执行的 Lua 代码 */
+    uint32_t jump;              /**< 计算下一页ID的 Lua 表达式 */
+    uint32_t first_choice;      /**< 第一个选项在选项数组中的下标 */
+    uint32_t choice_count;
+} vnb_page_t;
+
+/**
+ * @brief 角色记录
+ */
+typedef struct {
+    uint32_t id;                /**< 角色ID */
+    uint32_t image;             /**< 角色图片路径 */
+    uint32_t image_asset;       /**< 图片资源ID */
+    int32_t x;
+    int32_t y;
+    float scale;
+    int32_t visible;
+} vnb_character_t;
+
+/**
+ * @brief 选项记录
+ */
+typedef struct {
+    uint32_t text;              /**< 选项文字 */
+    uint32_t next_page;         /**< 跳转页面ID */
+    int32_t next_index;         /**< 跳转页面索引，-1表示使用页面的下一页 */
+    uint32_t condition;         /**< 显示条件（Lua 表达式） */
+    uint32_t script;            /**< 选择时执行的 Lua 代码 */
+} vnb_choice_t;
+
+#endif /* STORY_BINARY_H */
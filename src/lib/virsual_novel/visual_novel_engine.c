@@ -8,11 +8,41 @@
 #include "visual_novel_engine.h"
 #include "resource_manager.h"
 #include "data_parser.h"
+#include "vn_prefetch.h"
+#include "vn_sprite_pool.h"
+#include "vn_text_layout.h"
+#include "vn_transition.h"
+#include "vn_history.h"
+#include "vn_save.h"
+#include "vn_script.h"
+#include "../lua_idle_gc.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 static vn_engine_t engine;  /**< 视觉小说引擎实例 */
 
+static bool show_page(int index, bool record, bool run_script);
+
+/**
+ * @brief 文本对象绘制回调：按预先排好的行绘制
+ * @param e 事件对象
+ */
+static void text_draw_event_cb(lv_event_t *e) {
+    if (engine.text_layout == NULL) {
+        return;
+    }
+    lv_area_t coords;
+    lv_obj_get_content_coords(engine.text_obj, &coords);
+    // 只绘制文本框内可见的行（超出文本框高度的行被父对象裁剪）
+    lv_area_t clip = coords;
+    if (!lv_obj_area_is_visible(engine.text_obj, &clip)) {
+        return;
+    }
+    vn_text_layout_draw(lv_event_get_layer(e), engine.text_layout, &coords, &clip,
+                        lv_color_hex(0xFFFFFF), LV_OPA_COVER);
+}
+
 /**
  * @brief 更新文本框
  * @param text 文本内容
@@ -28,9 +58,11 @@ static void update_textbox(const char *text, const textbox_config_t *textbox) {
         if (engine.textbox_bg != NULL) {
             lv_obj_add_flag(engine.textbox_bg, LV_OBJ_FLAG_HIDDEN);
         }
-        if (engine.text_label != NULL) {
-            lv_obj_add_flag(engine.text_label, LV_OBJ_FLAG_HIDDEN);
+        if (engine.text_obj != NULL) {
+            lv_obj_add_flag(engine.text_obj, LV_OBJ_FLAG_HIDDEN);
         }
+        vn_text_layout_release(engine.text_layout);
+        engine.text_layout = NULL;
         return;
     }
 
@@ -50,30 +82,199 @@ static void update_textbox(const char *text, const textbox_config_t *textbox) {
     lv_obj_set_style_bg_opa(engine.textbox_bg, 180, 0);  // 设置半透明
     lv_obj_clear_flag(engine.textbox_bg, LV_OBJ_FLAG_HIDDEN);
 
-    // 如果文本标签不存在，创建文本标签
-    if (engine.text_label == NULL) {
-        engine.text_label = lv_label_create(engine.textbox_bg);
-        if (engine.text_label == NULL) {
+    // 如果文本对象不存在，创建文本对象（不使用标签，由绘制回调直接画排好的行）
+    if (engine.text_obj == NULL) {
+        engine.text_obj = lv_obj_create(engine.textbox_bg);
+        if (engine.text_obj == NULL) {
             return;
         }
+        lv_obj_remove_style_all(engine.text_obj);
+        lv_obj_clear_flag(engine.text_obj, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_add_event_cb(engine.text_obj, text_draw_event_cb, LV_EVENT_DRAW_MAIN, NULL);
     }
 
-    // 设置文本标签属性
-    lv_obj_set_size(engine.text_label, textbox->width - 20, textbox->height - 20);
-    lv_obj_set_pos(engine.text_label, 10, 10);
-    lv_label_set_text(engine.text_label, text);
-    lv_obj_set_style_text_color(engine.text_label, lv_color_hex(0xFFFFFF), 0);
-    lv_obj_set_style_text_font(engine.text_label, NULL, 0);
-    // 应用字体大小缩放（基于默认字体 10px，计算缩放比例）
-    int font_scale = (textbox->font_size * 256) / 10;  // LVGL 使用 256 作为基准
-    lv_obj_set_style_text_font(engine.text_label, NULL, 0);
-    lv_obj_set_style_transform_scale(engine.text_label, font_scale, 0);
-    lv_label_set_long_mode(engine.text_label, LV_LABEL_LONG_WRAP);
-    lv_obj_clear_flag(engine.text_label, LV_OBJ_FLAG_HIDDEN);
+    // 获取排版结果（通常已由预取模块算好），替换上一页的排版
+    vn_text_style_t style;
+    vn_text_style_from_textbox(&style, textbox);
+    vn_text_layout_t *layout = vn_text_layout_acquire(text, &style);
+    vn_text_layout_release(engine.text_layout);
+    engine.text_layout = layout;
+
+    // 设置文本对象属性
+    lv_obj_set_size(engine.text_obj, textbox->width - 2 * VN_TEXTBOX_PADDING, textbox->height - 2 * VN_TEXTBOX_PADDING);
+    lv_obj_set_pos(engine.text_obj, VN_TEXTBOX_PADDING, VN_TEXTBOX_PADDING);
+    lv_obj_clear_flag(engine.text_obj, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_invalidate(engine.text_obj);
+}
+
+/**
+ * @brief 释放一组页面资源的引用
+ * @param resources 资源数组
+ * @param count 数量
+ */
+static void release_resources(resource_t **resources, int count) {
+    for (int i = 0; i < count; i++) {
+        resource_manager_release(resources[i]);
+    }
+}
+
+/**
+ * @brief 计算页面的下一页：有跳转表达式且结果为页面ID时跳转到该页，否则使用 next_page
+ * @param page 页面配置
+ * @return 页面索引，-1表示故事结束
+ */
+static int next_page_index(const page_config_t *page) {
+    if (page->jump != NULL) {
+        int index = vn_script_jump(page->jump, page->id);
+        if (index >= 0) {
+            return index;
+        }
+    }
+    return page->next_index;
+}
+
+/**
+ * @brief 选择选项（在点击事件之后执行，此时可以删除选项按钮）
+ * @param data 选项下标
+ */
+static void choose_async_cb(void *data) {
+    vn_engine_choose((int)(intptr_t)data);
+}
+
+/**
+ * @brief 选项按钮点击回调
+ * @param e 事件对象
+ */
+static void choice_event_cb(lv_event_t *e) {
+    if (engine.state == VN_ENGINE_STATE_RUNNING) {
+        lv_async_call(choose_async_cb, lv_event_get_user_data(e));
+    }
+}
+
+/**
+ * @brief 把当前页面的图片设置到背景和角色上（未加载的图片为空，作为占位）
+ * @param page 页面配置
+ */
+static void show_images(const page_config_t *page) {
+    // 设置背景图片（解码时已限制在屏幕尺寸内），相同图片不再重绘
+    const void *bg_src = engine.page_resources[0] ? engine.page_resources[0]->data : NULL;
+    if (lv_image_get_src(engine.background_img) != bg_src) {
+        lv_image_set_src(engine.background_img, bg_src);
+    }
+    lv_image_set_scale(engine.background_img, 256);  // 默认缩放
+    
+    // 更新角色：同一角色复用原来的对象，只更新变化的属性
+    vn_sprite_pool_begin();
+    for (int i = 0; i < engine.page_resource_count - 1; i++) {
+        const character_config_t *char_config = &page->characters[i];
+        resource_t *res = engine.page_resources[i + 1];
+        vn_sprite_pool_show(char_config->id[0] ? char_config->id : char_config->image,
+                            res ? res->data : NULL, char_config->x, char_config->y,
+                            (int)(char_config->scale * 256), char_config->visible);
+    }
+    vn_sprite_pool_end();
+}
+
+/**
+ * @brief 后台加载的网络图片已放入缓存：当前页面还在等待它时获取并替换占位
+ */
+static void image_ready_cb(const char *path, void *user_data) {
+    (void)user_data;
+    const page_config_t *page = engine.current_page;
+    if (page == NULL || engine.page_resource_count == 0) {
+        return;
+    }
+    
+    bool changed = false;
+    for (int i = 0; i < engine.page_resource_count; i++) {
+        const char *image = i == 0 ? page->background : page->characters[i - 1].image;
+        if (engine.page_resources[i] == NULL && image != NULL && strcmp(image, path) == 0) {
+            engine.page_resources[i] = resource_manager_acquire_image(path);
+            changed = changed || engine.page_resources[i] != NULL;
+        }
+    }
+    if (changed) {
+        show_images(page);
+    }
+}
+
+/**
+ * @brief 回退后重新固定进入最近范围的历史记录：只获取仍在缓存中的图片和排版，
+ * 不在主线程解码或排版，已被淘汰的部分在回退到该页时再加载
+ * @param entry 只有页面索引的历史记录
+ */
+static void history_pin_cb(vn_history_entry_t *entry) {
+    const page_config_t *page = story_get_page(engine.story, entry->page_index);
+    if (page == NULL) {
+        return;
+    }
+    
+    int char_count = page->character_count < VN_SPRITE_POOL_MAX ? page->character_count : VN_SPRITE_POOL_MAX;
+    for (int i = 0; i <= char_count; i++) {
+        const char *image = i == 0 ? page->background : page->characters[i - 1].image;
+        entry->resources[i] = resource_manager_contains(image) ? resource_manager_acquire_image(image) : NULL;
+    }
+    entry->resource_count = char_count + 1;
+    
+    if (page->textbox.visible) {
+        vn_text_style_t style;
+        vn_text_style_from_textbox(&style, &page->textbox);
+        if (vn_text_layout_contains(page->text, &style)) {
+            entry->layout = vn_text_layout_acquire(page->text, &style);
+        }
+    }
+}
+
+/**
+ * @brief 显示页面的选项：只显示条件成立的选项，没有可选的选项时隐藏
+ * @param page 页面配置，NULL表示隐藏选项
+ */
+static void update_choices(const page_config_t *page) {
+    engine.choice_shown = 0;
+    if (engine.choice_box != NULL) {
+        lv_obj_clean(engine.choice_box);
+        lv_obj_add_flag(engine.choice_box, LV_OBJ_FLAG_HIDDEN);
+    }
+    if (page == NULL || page->choice_count == 0) {
+        return;
+    }
+    
+    // 选项容器位于屏幕中部偏上、文本框之上，按钮纵向排列
+    if (engine.choice_box == NULL) {
+        engine.choice_box = lv_obj_create(engine.screen);
+        if (engine.choice_box == NULL) {
+            return;
+        }
+        lv_obj_remove_style_all(engine.choice_box);
+        lv_obj_set_size(engine.choice_box, lv_obj_get_width(engine.screen) * 2 / 3, LV_SIZE_CONTENT);
+        lv_obj_set_flex_flow(engine.choice_box, LV_FLEX_FLOW_COLUMN);
+        lv_obj_set_style_pad_row(engine.choice_box, 10, 0);
+        lv_obj_align(engine.choice_box, LV_ALIGN_CENTER, 0, -lv_obj_get_height(engine.screen) / 6);
+    }
+    
+    // 选项文字使用文本框的字体
+    const lv_font_t *font = vn_text_font(page->textbox.font, page->textbox.font_size);
+    for (int i = 0; i < page->choice_count; i++) {
+        const choice_config_t *choice = &page->choices[i];
+        if (!vn_script_test(choice->condition, page->id)) {
+            continue;
+        }
+        lv_obj_t *btn = lv_button_create(engine.choice_box);
+        lv_obj_set_width(btn, lv_pct(100));
+        lv_obj_add_event_cb(btn, choice_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)i);
+        lv_obj_t *label = lv_label_create(btn);
+        lv_label_set_text(label, choice->text);
+        lv_obj_set_style_text_font(label, font, 0);
+        lv_obj_center(label);
+        engine.choice_shown++;
+    }
+    if (engine.choice_shown > 0) {
+        lv_obj_clear_flag(engine.choice_box, LV_OBJ_FLAG_HIDDEN);
+    }
 }
 
 /**
- * @brief 屏幕点击事件回调函数
+ * @brief 屏幕点击事件回调函数：点击翻页（快进时点击停止快进），长按快进，松开停止，向右滑动回退
  * @param e 事件对象
  */
 static void screen_click_event_handler(lv_event_t *e) {
@@ -82,30 +283,229 @@ static void screen_click_event_handler(lv_event_t *e) {
         return;
     }
     
-    // 加载下一页
-    vn_engine_load_next_page();
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_PRESSED:
+            engine.gesture_handled = false;
+            break;
+        case LV_EVENT_GESTURE:
+            // 向右滑动回退一页
+            if (lv_indev_get_gesture_dir(lv_indev_active()) == LV_DIR_RIGHT) {
+                engine.gesture_handled = true;
+                vn_engine_rollback();
+            }
+            break;
+        case LV_EVENT_LONG_PRESSED:
+            if (engine.skip_mode == VN_SKIP_OFF) {
+                vn_engine_set_skip(VN_SKIP_ALL);
+                engine.skip_hold = engine.skip_mode != VN_SKIP_OFF;
+            }
+            break;
+        case LV_EVENT_RELEASED:
+        case LV_EVENT_PRESS_LOST:
+            if (engine.skip_hold) {
+                vn_engine_set_skip(VN_SKIP_OFF);
+            }
+            break;
+        case LV_EVENT_SHORT_CLICKED:
+            // 长按后不会收到短按点击，松开时不会多翻一页；滑动回退后同样不翻页
+            if (engine.gesture_handled) {
+                engine.gesture_handled = false;
+            } else if (engine.skip_mode != VN_SKIP_OFF) {
+                vn_engine_set_skip(VN_SKIP_OFF);
+            } else {
+                vn_engine_load_next_page();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 标记页面为已读
+ */
+static void mark_page_read(int index) {
+    if (engine.read_pages != NULL) {
+        engine.read_pages[index >> 3] |= (uint8_t)(1u << (index & 7));
+    }
+}
+
+/**
+ * @brief 快进定时器回调：按速度计算本帧要前进的页数，沿 next_page 跳过中间页面，
+ * 只加载最后到达的一页（加载耗时越长，下一帧前进的页数越多，速度保持不变）
+ * @param timer 定时器
+ */
+static void skip_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+    if (engine.state == VN_ENGINE_STATE_PAUSED) {
+        engine.skip_last_tick = lv_tick_get();
+        return;
+    }
+    if (engine.state != VN_ENGINE_STATE_RUNNING || engine.current_page == NULL) {
+        vn_engine_set_skip(VN_SKIP_OFF);
+        return;
+    }
+    
+    uint32_t now = lv_tick_get();
+    uint32_t budget = UINT32_MAX;
+    if (engine.skip_rate > 0) {
+        // 最多累计1秒，长时间卡顿后不会一次跳过太多页
+        engine.skip_credit += lv_tick_elaps(engine.skip_last_tick) * (uint32_t)engine.skip_rate;
+        if (engine.skip_credit > (uint32_t)engine.skip_rate * 1000) {
+            engine.skip_credit = (uint32_t)engine.skip_rate * 1000;
+        }
+        budget = engine.skip_credit / 1000;
+        engine.skip_credit -= budget * 1000;
+    }
+    engine.skip_last_tick = now;
+    
+    int target = engine.current_page_index;
+    const page_config_t *page = engine.current_page;
+    uint32_t advanced = 0;
+    bool stop = false;
+    bool entered = false;   // 目标页面的脚本已在跳过时执行
+    while (advanced < budget) {
+        // 选项需要玩家选择，停在有选项的页面（当前页面按实际显示的选项判断）
+        if (advanced == 0 ? engine.choice_shown > 0 : page->choice_count > 0) {
+            stop = true;
+            break;
+        }
+        // 跳过的页面同样执行脚本，变量与逐页阅读时一致
+        if (advanced > 0) {
+            vn_script_enter(page);
+            entered = true;
+        }
+        int next = next_page_index(page);
+        if (next < 0 || (engine.skip_mode == VN_SKIP_READ && !vn_engine_is_page_read(next))) {
+            stop = true;
+            break;
+        }
+        // 按需解析的故事只解析页面，不解码图片
+        page = story_get_page(engine.story, next);
+        if (page == NULL) {
+            stop = true;
+            break;
+        }
+        // 跳过的页面同样算作已读，之后只快进已读页面时不会停在这里
+        mark_page_read(next);
+        target = next;
+        entered = false;
+        advanced++;
+        if (engine.skip_rate <= 0 && lv_tick_elaps(now) >= VN_SKIP_WALK_MS) {
+            break;
+        }
+    }
+    
+    if (advanced > 0) {
+        engine.skip_stats.pages += advanced;
+        engine.skip_stats.frames++;
+        show_page(target, true, !entered);
+    }
+    if (stop) {
+        vn_engine_set_skip(VN_SKIP_OFF);
+    }
+}
+
+void vn_engine_set_skip(vn_skip_mode_t mode) {
+    if (mode == engine.skip_mode) {
+        return;
+    }
+    
+    if (mode == VN_SKIP_OFF) {
+        if (engine.skip_timer != NULL) {
+            lv_timer_delete(engine.skip_timer);
+            engine.skip_timer = NULL;
+            lua_idle_gc_hold(false);
+        }
+        engine.skip_mode = VN_SKIP_OFF;
+        engine.skip_hold = false;
+        engine.skip_stats.elapsed_ms = lv_tick_elaps(engine.skip_start_tick);
+        uint32_t ms = engine.skip_stats.elapsed_ms ? engine.skip_stats.elapsed_ms : 1;
+        printf("[vn] 快进 %u 页（显示 %u 页），%u ms，%.1f 页/秒\n",
+               (unsigned)engine.skip_stats.pages, (unsigned)engine.skip_stats.frames,
+               (unsigned)engine.skip_stats.elapsed_ms, engine.skip_stats.pages * 1000.0 / ms);
+        
+        // 恢复预取当前页面之后的页面
+        if (engine.state == VN_ENGINE_STATE_RUNNING && engine.current_page_index >= 0) {
+            vn_prefetch_set_page(engine.current_page_index);
+        }
+        return;
+    }
+    
+    if (engine.state != VN_ENGINE_STATE_RUNNING) {
+        return;
+    }
+    if (engine.skip_mode == VN_SKIP_OFF) {
+        engine.skip_timer = lv_timer_create(skip_timer_cb, VN_SKIP_TICK_MS, NULL);
+        if (engine.skip_timer == NULL) {
+            return;
+        }
+        // 快进期间每帧都在解析页面，脚本的垃圾回收推迟到快进结束后
+        lua_idle_gc_hold(true);
+        vn_transition_finish();
+        memset(&engine.skip_stats, 0, sizeof(engine.skip_stats));
+        engine.skip_credit = 0;
+        engine.skip_start_tick = lv_tick_get();
+        engine.skip_last_tick = engine.skip_start_tick;
+        
+        // 快进时后续页面大多不会显示，取消预取
+        vn_prefetch_set_page(-1);
+    }
+    engine.skip_mode = mode;
+}
+
+vn_skip_mode_t vn_engine_get_skip(void) {
+    return engine.skip_mode;
+}
+
+void vn_engine_set_skip_rate(int pages_per_sec) {
+    engine.skip_rate = pages_per_sec > 0 ? pages_per_sec : 0;
+}
+
+void vn_engine_get_skip_stats(vn_skip_stats_t *stats) {
+    *stats = engine.skip_stats;
+    if (engine.skip_mode != VN_SKIP_OFF) {
+        stats->elapsed_ms = lv_tick_elaps(engine.skip_start_tick);
+    }
+}
+
+bool vn_engine_is_page_read(int index) {
+    if (engine.read_pages == NULL || engine.story == NULL || index < 0 || index >= engine.story->page_count) {
+        return false;
+    }
+    return (engine.read_pages[index >> 3] >> (index & 7)) & 1;
 }
 
 /**
  * @brief 初始化视觉小说引擎
- * @param json_path JSON配置文件路径
+ * @param json_path JSON配置文件路径（同名 .vnb 存在且不比 JSON 旧时加载编译后的故事）
  * @return 初始化是否成功
  */
 bool vn_engine_init(const char *json_path) {
     // 初始化引擎状态
     memset(&engine, 0, sizeof(vn_engine_t));
     engine.state = VN_ENGINE_STATE_INIT;
+    engine.current_page_index = -1;
+    engine.skip_rate = VN_SKIP_RATE;
     
-    // 初始化资源管理器
+    // 初始化资源管理器，网络图片在后台加载完成后替换占位
     resource_manager_init();
+    resource_manager_set_ready_cb(image_ready_cb, NULL);
+    vn_history_set_pin_cb(history_pin_cb);
     
-    // 解析JSON配置文件
-    engine.story = parse_story_json(json_path);
+    // 加载故事（存在编译后的 .vnb 时直接映射）
+    engine.story = load_story(json_path);
     if (engine.story == NULL) {
         engine.state = VN_ENGINE_STATE_IDLE;
         return false;
     }
     
+    // 与故事同名的字形集（tools/font_bake 生成），加载 TTF 字体时预先光栅化
+    char glyph_path[512];
+    if (story_sibling_path(json_path, STORY_GLYPHS_EXTENSION, glyph_path, sizeof(glyph_path))) {
+        vn_text_set_glyph_set(glyph_path);
+    }
+    
     // 获取屏幕对象
     engine.screen = lv_scr_act();
     if (engine.screen == NULL) {
@@ -114,8 +514,16 @@ bool vn_engine_init(const char *json_path) {
         return false;
     }
     
+    // 跟踪屏幕刷新，存档时直接使用最近刷新的画面作为缩略图
+    vn_save_track_screen(engine.screen);
+    
     // 注册屏幕点击事件
-    lv_obj_add_event_cb(engine.screen, screen_click_event_handler, LV_EVENT_CLICKED, NULL);
+    lv_obj_add_event_cb(engine.screen, screen_click_event_handler, LV_EVENT_PRESSED, NULL);
+    lv_obj_add_event_cb(engine.screen, screen_click_event_handler, LV_EVENT_GESTURE, NULL);
+    lv_obj_add_event_cb(engine.screen, screen_click_event_handler, LV_EVENT_SHORT_CLICKED, NULL);
+    lv_obj_add_event_cb(engine.screen, screen_click_event_handler, LV_EVENT_LONG_PRESSED, NULL);
+    lv_obj_add_event_cb(engine.screen, screen_click_event_handler, LV_EVENT_RELEASED, NULL);
+    lv_obj_add_event_cb(engine.screen, screen_click_event_handler, LV_EVENT_PRESS_LOST, NULL);
     
     // 创建背景图片对象
     engine.background_img = lv_img_create(engine.screen);
@@ -130,6 +538,25 @@ bool vn_engine_init(const char *json_path) {
     lv_obj_set_pos(engine.background_img, 0, 0);
     lv_obj_set_style_bg_color(engine.screen, lv_color_hex(0x000000), 0);
     
+    // 创建角色对象池（位于背景之上、文本框之下），翻页时复用
+    if (!vn_sprite_pool_init(engine.screen)) {
+        lv_obj_del(engine.background_img);
+        engine.background_img = NULL;
+        free_story_config(engine.story);
+        engine.state = VN_ENGINE_STATE_IDLE;
+        return false;
+    }
+    
+    // 已读页面位图，存档路径按故事文件名生成
+    engine.read_pages = (uint8_t *)calloc((size_t)engine.story->page_count / 8 + 1, 1);
+    engine.story_path = strdup(json_path);
+    
+    // 脚本（未启用 Lua 或故事没有脚本时不影响运行）
+    vn_script_init(engine.story, json_path);
+    
+    // 启动后台预取
+    vn_prefetch_init(engine.story);
+    
     // 初始化完成，设置状态为空闲
     engine.state = VN_ENGINE_STATE_IDLE;
     
@@ -144,8 +571,11 @@ void vn_engine_start(void) {
     if (engine.state == VN_ENGINE_STATE_IDLE) {
         // 加载第一页
         if (engine.story != NULL && engine.story->page_count > 0) {
-            vn_engine_load_page(engine.story->pages[0].id);
-            engine.state = VN_ENGINE_STATE_RUNNING;
+            // 有自动存档时从上次退出的页面继续
+            if (!vn_engine_load_slot(VN_SAVE_AUTO_SLOT)) {
+                engine.state = VN_ENGINE_STATE_RUNNING;
+                vn_engine_load_page_index(0);
+            }
         }
     } else if (engine.state == VN_ENGINE_STATE_PAUSED) {
         // 恢复运行
@@ -176,6 +606,10 @@ void vn_engine_resume(void) {
  */
 void vn_engine_stop(void) {
     if (engine.state == VN_ENGINE_STATE_RUNNING || engine.state == VN_ENGINE_STATE_PAUSED) {
+        // 停止快进，释放历史记录固定的资源
+        vn_engine_set_skip(VN_SKIP_OFF);
+        vn_history_clear();
+        
         // 释放当前页面资源
         vn_engine_free_current_resources();
         
@@ -190,88 +624,276 @@ void vn_engine_stop(void) {
  * @return 加载是否成功
  */
 bool vn_engine_load_page(const char *page_id) {
+    // 通过哈希索引查找页面
+    int index = find_page_index(engine.story, page_id);
+    if (index < 0) {
+        return false;
+    }
+    
+    return vn_engine_load_page_index(index);
+}
+
+/**
+ * @brief 保存进入当前页面后的脚本变量，离开页面时随历史记录保存，回退时恢复
+ */
+static void snapshot_page_vars(void) {
+    free(engine.page_vars);
+    engine.page_vars = vn_script_save_vars(&engine.page_vars_size);
+    // 没有变量时保存空串，和没有快照（NULL）区分开
+    if (engine.page_vars == NULL) {
+        engine.page_vars = strdup("");
+    }
+}
+
+/**
+ * @brief 显示页面
+ * @param index 页面索引
+ * @param record 是否把离开的页面记入历史（回退时为false，也不播放切换效果）
+ * @param run_script 是否执行页面脚本（回退和读档时调用方已恢复进入页面之后的变量）
+ * @return 加载是否成功
+ */
+static bool show_page(int index, bool record, bool run_script) {
     // 如果引擎未初始化或已结束，直接返回
     if (engine.state == VN_ENGINE_STATE_IDLE || engine.state == VN_ENGINE_STATE_FINISHED) {
         return false;
     }
     
-    // 查找页面配置
-    page_config_t *page = find_page_by_id(engine.story, page_id);
+    // 按需解析的故事在这里解析页面
+    page_config_t *page = story_get_page(engine.story, index);
     if (page == NULL) {
         return false;
     }
     
-    // 释放当前页面资源
-    vn_engine_free_current_resources();
+    // 有切换效果时先保存旧页面的画面（第一页、回退和快进时直接显示）
+    vn_transition_finish();
+    bool transition = record && engine.current_page != NULL && page->transition.type != TRANSITION_NONE &&
+                      engine.skip_mode == VN_SKIP_OFF && vn_transition_begin(engine.screen);
+    
+    // 记录离开的页面，最近几页的图片和排版保持固定
+    if (record) {
+        vn_history_push(engine.current_page_index, engine.page_resources, engine.page_resource_count,
+                        engine.text_layout, engine.page_vars, engine.page_vars_size);
+        engine.page_vars = NULL;
+        engine.page_vars_size = 0;
+    }
+    
+    // 先获取（固定）新页面的图片，再释放旧页面的，相邻页面共用的图片直接命中缓存
+    // （未缓存的网络图片返回NULL，在后台下载，不阻塞界面）
+    int char_count = page->character_count;
+    if (char_count > VN_SPRITE_POOL_MAX) {
+        printf("[vn] 页面 %s 有 %d 个角色，只显示前 %d 个\n", page->id, char_count, VN_SPRITE_POOL_MAX);
+        char_count = VN_SPRITE_POOL_MAX;
+    }
+    resource_t *old_resources[1 + VN_SPRITE_POOL_MAX];
+    int old_count = engine.page_resource_count;
+    memcpy(old_resources, engine.page_resources, sizeof(resource_t *) * old_count);
+    
+    engine.page_resources[0] = resource_manager_acquire_image(page->background);
+    for (int i = 0; i < char_count; i++) {
+        engine.page_resources[i + 1] = resource_manager_acquire_image(page->characters[i].image);
+    }
+    engine.page_resource_count = char_count + 1;
     
-    // 保存当前页面ID
-    engine.current_page_id = strdup(page_id);
+    // 保存当前页面
+    engine.current_page_id = page->id;
     engine.current_page = page;
+    engine.current_page_index = index;
+    story_pin_page(engine.story, index);
+    mark_page_read(index);
     
-    // 加载背景图片
-    if (page->background != NULL) {
-        lv_img_set_src(engine.background_img, page->background);
-        // 设置背景图片缩放以适应屏幕大小
-        // 计算缩放比例：屏幕宽度 / 图片原始宽度
-        // 这里使用 256 作为基准缩放值
-        lv_image_set_scale(engine.background_img, 256);  // 默认缩放
+    // 先执行页面脚本，选项的条件使用脚本修改后的变量
+    if (run_script) {
+        vn_script_enter(page);
     }
+    snapshot_page_vars();
     
-    // 加载角色图片
-    if (page->character_count > 0) {
-        engine.character_imgs = (lv_obj_t **)malloc(sizeof(lv_obj_t *) * page->character_count);
-        if (engine.character_imgs == NULL) {
-            return false;
-        }
-        
-        for (int i = 0; i < page->character_count; i++) {
-            character_config_t *char_config = &page->characters[i];
-            
-            // 创建角色图片对象
-            engine.character_imgs[i] = lv_img_create(engine.screen);
-            if (engine.character_imgs[i] == NULL) {
-                // 释放已创建的角色图片
-                for (int j = 0; j < i; j++) {
-                    lv_obj_del(engine.character_imgs[j]);
-                }
-                free(engine.character_imgs);
-                engine.character_imgs = NULL;
-                return false;
-            }
-
-            // 设置角色图片属性
-            lv_img_set_src(engine.character_imgs[i], char_config->image);
-            lv_obj_set_pos(engine.character_imgs[i], char_config->x, char_config->y);
-            // 应用缩放（LVGL 9.x 支持 transform_scale）
-            lv_obj_set_style_transform_scale(engine.character_imgs[i], (int)(char_config->scale * 256), 0);
-            if (char_config->visible) {
-                lv_obj_clear_flag(engine.character_imgs[i], LV_OBJ_FLAG_HIDDEN);
-            } else {
-                lv_obj_add_flag(engine.character_imgs[i], LV_OBJ_FLAG_HIDDEN);
-            }
-        }
+    // 设置背景和角色，网络图片加载中时先不显示，完成后由 image_ready_cb 补上
+    show_images(page);
+    
+    // 控件已指向新图片，可以释放旧页面的引用
+    release_resources(old_resources, old_count);
+    
+    // 在后台解码后续页面的图片（快进时不预取，停止快进后再开始）
+    if (engine.skip_mode == VN_SKIP_OFF) {
+        vn_prefetch_set_page(index);
     }
     
-    // 更新文本框
+    // 更新文本框和选项
     update_textbox(page->text, &page->textbox);
+    update_choices(page);
+    
+    if (transition) {
+        vn_transition_start(engine.screen, &page->transition);
+    }
     
     return true;
 }
 
+/**
+ * @brief 按索引加载页面（无需查找）
+ * @param index 页面索引
+ * @return 加载是否成功
+ */
+bool vn_engine_load_page_index(int index) {
+    return show_page(index, true, true);
+}
+
+/**
+ * @brief 回退到上一页
+ * @return 是否回退
+ */
+bool vn_engine_rollback(void) {
+    if (engine.state != VN_ENGINE_STATE_RUNNING) {
+        return false;
+    }
+    vn_engine_set_skip(VN_SKIP_OFF);
+    
+    vn_history_entry_t entry;
+    if (!vn_history_pop(&entry)) {
+        return false;
+    }
+    // 恢复进入该页面后的变量，读档恢复的历史没有快照，保留当前变量
+    if (entry.vars != NULL) {
+        vn_script_load_vars(entry.vars, entry.vars_size);
+        free(entry.vars);
+    }
+    // 先显示页面（图片和排版仍被历史记录固定，直接命中缓存），再释放历史记录的引用
+    bool ok = show_page(entry.page_index, false, false);
+    vn_history_release(&entry);
+    return ok;
+}
+
+/**
+ * @brief 跳转到页面，索引小于0时故事结束
+ * @param index 页面索引
+ * @return 是否跳转
+ */
+static bool go_to_page(int index) {
+    if (index < 0) {
+        // 故事结束，停止引擎，下次从头开始
+        if (engine.story_path != NULL) {
+            vn_save_remove(engine.story_path, VN_SAVE_AUTO_SLOT);
+        }
+        vn_engine_stop();
+        return false;
+    }
+    return vn_engine_load_page_index(index);
+}
+
 /**
  * @brief 加载下一页
  * @return 加载是否成功，如果没有下一页返回false
  */
 bool vn_engine_load_next_page(void) {
-    // 如果当前页面为空或没有下一页，直接返回
-    if (engine.current_page == NULL || engine.current_page->next_page == NULL) {
-        // 故事结束，停止引擎
-        vn_engine_stop();
+    // 有选项时等待玩家选择
+    if (engine.current_page == NULL || engine.choice_shown > 0) {
         return false;
     }
     
-    // 加载下一页
-    return vn_engine_load_page(engine.current_page->next_page);
+    // 加载下一页（next_page 已在解析时转换为索引，有跳转表达式时先计算）
+    return go_to_page(next_page_index(engine.current_page));
+}
+
+/**
+ * @brief 选择当前页面的选项
+ * @param choice 选项下标
+ * @return 是否跳转
+ */
+bool vn_engine_choose(int choice) {
+    const page_config_t *page = engine.current_page;
+    if (engine.state != VN_ENGINE_STATE_RUNNING || page == NULL || choice < 0 || choice >= page->choice_count) {
+        return false;
+    }
+    
+    const choice_config_t *c = &page->choices[choice];
+    vn_script_run(c->script, page->id);
+    return go_to_page(c->next_index >= 0 ? c->next_index : next_page_index(page));
+}
+
+/**
+ * @brief 保存到存档槽
+ * @param slot 槽号（0 ~ VN_SAVE_SLOTS-1，VN_SAVE_AUTO_SLOT 为自动存档）
+ * @return 是否已提交写入
+ */
+bool vn_engine_save(int slot) {
+    if (engine.current_page == NULL || engine.story_path == NULL) {
+        return false;
+    }
+    // 缩略图截取完整的当前页面，而不是切换效果的中间帧
+    vn_transition_finish();
+    
+    int32_t history[VN_HISTORY_MAX];
+    size_t vars_size;
+    char *vars = vn_script_save_vars(&vars_size);
+    vn_save_state_t state = {
+        .page_index = engine.current_page_index,
+        .page_id = engine.current_page_id,
+        .read_pages = engine.read_pages,
+        .page_count = engine.story->page_count,
+        .history = history,
+        .history_count = vn_history_get(history, VN_HISTORY_MAX),
+        .vars = vars,
+        .vars_size = vars_size,
+    };
+    bool ok = vn_save_write(engine.story_path, slot, &state, engine.screen);
+    free(vars);
+    return ok;
+}
+
+/**
+ * @brief 从存档槽恢复：直接显示保存的页面，并恢复已读记录和历史
+ * @param slot 槽号
+ * @return 是否成功，存档不存在或页面已不在故事中时返回false
+ */
+bool vn_engine_load_slot(int slot) {
+    if (engine.story == NULL || engine.story_path == NULL || engine.state == VN_ENGINE_STATE_INIT) {
+        return false;
+    }
+    vn_save_header_t *save = vn_save_read(engine.story_path, slot);
+    if (save == NULL) {
+        return false;
+    }
+    
+    // 按索引定位页面，故事修改过导致ID不一致时按ID查找
+    int page_count = engine.story->page_count;
+    int index = save->page_index;
+    const page_config_t *page = story_get_page(engine.story, index);
+    if (page == NULL || strncmp(page->id, save->page_id, VN_SAVE_PAGE_ID_MAX - 1) != 0) {
+        index = find_page_index(engine.story, save->page_id);
+    }
+    if (index < 0) {
+        printf("[vn] 存档页面 %s 不在故事中\n", save->page_id);
+        free(save);
+        return false;
+    }
+    
+    // 恢复脚本变量
+    size_t vars_size;
+    const char *vars = vn_save_vars(save, &vars_size);
+    vn_script_load_vars(vars, vars_size);
+    
+    // 页数不变时恢复已读记录和历史（只恢复页面索引，不固定资源）
+    vn_history_clear();
+    if ((int)save->page_count == page_count) {
+        const uint8_t *read = vn_save_read_pages(save);
+        size_t read_size = (size_t)page_count / 8 + 1;
+        if (read != NULL && engine.read_pages != NULL && save->read_size == read_size) {
+            memcpy(engine.read_pages, read, read_size);
+        }
+        const int32_t *history = vn_save_history(save);
+        for (uint32_t i = 0; i < save->history_count; i++) {
+            if (history[i] >= 0 && history[i] < page_count) {
+                vn_history_push(history[i], NULL, 0, NULL, NULL, 0);
+            }
+        }
+    }
+    free(save);
+    
+    vn_engine_set_skip(VN_SKIP_OFF);
+    if (engine.state != VN_ENGINE_STATE_PAUSED) {
+        engine.state = VN_ENGINE_STATE_RUNNING;
+    }
+    return show_page(index, false, false);
 }
 
 /**
@@ -286,51 +908,93 @@ vn_engine_state_t vn_engine_get_state(void) {
  * @brief 释放当前页面资源
  */
 void vn_engine_free_current_resources(void) {
-    // 释放角色图片
-    if (engine.character_imgs != NULL && engine.current_page != NULL) {
-        for (int i = 0; i < engine.current_page->character_count; i++) {
-            if (engine.character_imgs[i] != NULL) {
-                lv_obj_del(engine.character_imgs[i]);
-            }
-        }
-        free(engine.character_imgs);
-        engine.character_imgs = NULL;
-    }
+    // 隐藏角色（对象保留在池中）和选项
+    vn_sprite_pool_hide_all();
+    update_choices(NULL);
     
-    // 释放当前页面ID
-    if (engine.current_page_id != NULL) {
-        free(engine.current_page_id);
-        engine.current_page_id = NULL;
+    // 释放当前页面固定的图片（保留在缓存中，预算不足时才会淘汰）
+    if (engine.page_resource_count > 0 && engine.background_img != NULL) {
+        lv_image_set_src(engine.background_img, NULL);
     }
+    release_resources(engine.page_resources, engine.page_resource_count);
+    engine.page_resource_count = 0;
+    story_pin_page(engine.story, -1);
+    
+    free(engine.page_vars);
+    engine.page_vars = NULL;
+    engine.page_vars_size = 0;
     
     // 清空当前页面
+    engine.current_page_id = NULL;
     engine.current_page = NULL;
+    engine.current_page_index = -1;
 }
 
 /**
  * @brief 反初始化视觉小说引擎
  */
 void vn_engine_deinit(void) {
+    // 自动保存当前位置，下次启动时继续
+    vn_engine_save(VN_SAVE_AUTO_SLOT);
+    
     // 停止引擎
     vn_engine_stop();
     
+    // 移除 init 时在屏幕上注册的点击、手势和长按回调（屏幕不属于引擎，不会随引擎删除）
+    if (engine.screen != NULL) {
+        while (lv_obj_remove_event_cb(engine.screen, screen_click_event_handler)) {
+        }
+    }
+    
+    // 停止预取（预取线程引用故事配置）
+    vn_prefetch_deinit();
+    
+    // 关闭脚本（visited 引用故事配置）
+    vn_script_deinit();
+    
     // 释放故事配置
     if (engine.story != NULL) {
         free_story_config(engine.story);
         engine.story = NULL;
     }
+    free(engine.read_pages);
+    engine.read_pages = NULL;
+    
+    // 等待存档写入完成
+    vn_save_deinit();
+    free(engine.story_path);
+    engine.story_path = NULL;
+    
+    // 结束切换效果并释放离屏缓冲
+    vn_transition_deinit();
+    
+    // 释放历史记录固定的资源和排版
+    vn_history_clear();
+    vn_history_set_pin_cb(NULL);
+    
+    // 删除角色对象池
+    vn_sprite_pool_deinit();
     
     // 释放文本框
-    if (engine.text_label != NULL) {
-        lv_obj_del(engine.text_label);
-        engine.text_label = NULL;
+    if (engine.text_obj != NULL) {
+        lv_obj_del(engine.text_obj);
+        engine.text_obj = NULL;
     }
+    vn_text_layout_release(engine.text_layout);
+    engine.text_layout = NULL;
+    vn_text_layout_cache_clear();
     
     if (engine.textbox_bg != NULL) {
         lv_obj_del(engine.textbox_bg);
         engine.textbox_bg = NULL;
     }
     
+    // 删除选项容器
+    if (engine.choice_box != NULL) {
+        lv_obj_del(engine.choice_box);
+        engine.choice_box = NULL;
+    }
+    
     // 释放背景图片
     if (engine.background_img != NULL) {
         lv_obj_del(engine.background_img);
@@ -341,5 +1005,6 @@ void vn_engine_deinit(void) {
     resource_manager_deinit();
     
     // 重置引擎状态
+    engine.screen = NULL;
     engine.state = VN_ENGINE_STATE_IDLE;
 }
\ No newline at end of file
@@ -10,6 +10,13 @@
 
 #include "lvgl/lvgl.h"
 #include "data_parser.h"
+#include "resource_manager.h"
+#include "vn_sprite_pool.h"
+#include "vn_text_layout.h"
+
+#define VN_SKIP_RATE        30                  /**< 快进默认速度（页/秒） */
+#define VN_SKIP_TICK_MS     LV_DEF_REFR_PERIOD  /**< 快进定时器周期，每个显示帧最多应用一页 */
+#define VN_SKIP_WALK_MS     10                  /**< 不限速快进时每帧用于跳过页面的时间 */
 
 /**
  * @brief 视觉小说引擎状态枚举
@@ -22,6 +29,24 @@ typedef enum {
     VN_ENGINE_STATE_FINISHED   /**< 结束状态 */
 } vn_engine_state_t;
 
+/**
+ * @brief 快进模式
+ */
+typedef enum {
+    VN_SKIP_OFF,    /**< 不快进 */
+    VN_SKIP_READ,   /**< 只快进已读页面，遇到未读页面时停止 */
+    VN_SKIP_ALL     /**< 快进所有页面（长按屏幕时使用） */
+} vn_skip_mode_t;
+
+/**
+ * @brief 快进统计（最近一次快进）
+ */
+typedef struct {
+    uint32_t pages;         /**< 前进的页数 */
+    uint32_t frames;        /**< 实际加载并显示的页数 */
+    uint32_t elapsed_ms;    /**< 持续时间 */
+} vn_skip_stats_t;
+
 /**
  * @brief 视觉小说引擎结构体
  */
@@ -29,17 +54,35 @@ typedef struct {
     vn_engine_state_t state;        /**< 引擎状态 */
     story_config_t *story;          /**< 故事配置 */
     page_config_t *current_page;    /**< 当前页面 */
+    int current_page_index;         /**< 当前页面索引，-1表示无 */
     lv_obj_t *screen;               /**< 屏幕对象 */
     lv_obj_t *background_img;       /**< 背景图片对象 */
-    lv_obj_t **character_imgs;      /**< 角色图片对象数组 */
     lv_obj_t *textbox_bg;           /**< 文本框背景对象 */
-    lv_obj_t *text_label;           /**< 文本标签对象 */
-    char *current_page_id;          /**< 当前页面ID */
+    lv_obj_t *text_obj;             /**< 文本对象（绘制 text_layout） */
+    lv_obj_t *choice_box;           /**< 选项容器 */
+    int choice_shown;               /**< 显示的选项数，大于0时点击不翻页 */
+    vn_text_layout_t *text_layout;  /**< 当前页面文本的排版结果 */
+    const char *current_page_id;    /**< 当前页面ID（指向故事配置） */
+    resource_t *page_resources[1 + VN_SPRITE_POOL_MAX]; /**< 当前页面固定的图片资源（背景 + 每个角色） */
+    int page_resource_count;        /**< 固定的资源数量 */
+    char *page_vars;                /**< 进入当前页面后的脚本变量，离开时存入历史记录 */
+    size_t page_vars_size;          /**< 变量长度 */
+    char *story_path;               /**< 故事文件路径（生成存档路径） */
+    uint8_t *read_pages;            /**< 已读页面位图（按页面索引） */
+    vn_skip_mode_t skip_mode;       /**< 快进模式 */
+    bool skip_hold;                 /**< 快进由长按开始，松开时停止 */
+    bool gesture_handled;           /**< 本次按下已作为滑动处理，不再翻页 */
+    int skip_rate;                  /**< 快进速度（页/秒），0表示不限速 */
+    uint32_t skip_credit;           /**< 累计的可前进页数（千分之一页） */
+    uint32_t skip_last_tick;        /**< 上次快进定时器运行的时间 */
+    uint32_t skip_start_tick;       /**< 本次快进开始的时间 */
+    lv_timer_t *skip_timer;         /**< 快进定时器 */
+    vn_skip_stats_t skip_stats;     /**< 快进统计 */
 } vn_engine_t;
 
 /**
  * @brief 初始化视觉小说引擎
- * @param json_path JSON配置文件路径
+ * @param json_path JSON配置文件路径（同名 .vnb 存在且不比 JSON 旧时加载编译后的故事）
  * @return 初始化是否成功
  */
 bool vn_engine_init(const char *json_path);
@@ -71,12 +114,77 @@ void vn_engine_stop(void);
  */
 bool vn_engine_load_page(const char *page_id);
 
+/**
+ * @brief 按索引加载页面（无需查找）
+ * @param index 页面索引
+ * @return 加载是否成功
+ */
+bool vn_engine_load_page_index(int index);
+
 /**
  * @brief 加载下一页
  * @return 加载是否成功，如果没有下一页返回false
  */
 bool vn_engine_load_next_page(void);
 
+/**
+ * @brief 选择当前页面的选项：执行选项脚本后跳转到选项的页面（未指定时与点击翻页相同）
+ * @param choice 选项在页面选项数组中的下标
+ * @return 是否跳转
+ */
+bool vn_engine_choose(int choice);
+
+/**
+ * @brief 回退到上一页（最多 VN_HISTORY_MAX 页），屏幕上向右滑动同样回退
+ * @return 是否回退，没有历史记录时返回false
+ */
+bool vn_engine_rollback(void);
+
+/**
+ * @brief 设置快进模式：每个显示帧沿 next_page 跳过若干页，只加载并显示最后一页，
+ * 中间页面的图片不会解码（脚本照常执行）。到达最后一页、遇到有选项的页面、
+ * （VN_SKIP_READ 时）遇到未读页面或点击屏幕时停止
+ * @param mode 快进模式
+ */
+void vn_engine_set_skip(vn_skip_mode_t mode);
+
+/**
+ * @brief 获取快进模式
+ */
+vn_skip_mode_t vn_engine_get_skip(void);
+
+/**
+ * @brief 设置快进速度
+ * @param pages_per_sec 每秒前进的页数，0表示不限速（每帧用 VN_SKIP_WALK_MS 跳过页面，用于测量吞吐量）
+ */
+void vn_engine_set_skip_rate(int pages_per_sec);
+
+/**
+ * @brief 获取最近一次快进的统计
+ * @param stats 输出
+ */
+void vn_engine_get_skip_stats(vn_skip_stats_t *stats);
+
+/**
+ * @brief 页面是否已读（本次运行中显示过）
+ * @param index 页面索引
+ */
+bool vn_engine_is_page_read(int index);
+
+/**
+ * @brief 保存到存档槽（截取缩略图后在后台写入，退出时自动保存到 VN_SAVE_AUTO_SLOT）
+ * @param slot 槽号（0 ~ VN_SAVE_SLOTS-1）
+ * @return 是否已提交写入
+ */
+bool vn_engine_save(int slot);
+
+/**
+ * @brief 从存档槽恢复，直接显示保存的页面（启动时自动恢复 VN_SAVE_AUTO_SLOT）
+ * @param slot 槽号
+ * @return 是否成功
+ */
+bool vn_engine_load_slot(int slot);
+
 /**
  * @brief 获取当前引擎状态
  * @return 引擎状态
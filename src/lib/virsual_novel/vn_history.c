@@ -0,0 +1,116 @@
+/**
+ * @file vn_history.c
+ * @brief 视觉小说页面历史（回退）实现
+ *
+ * 环形缓冲满时覆盖最早的记录。压入新记录后，从栈顶数第 VN_HISTORY_PIN+1 条
+ * 释放其引用，因此固定的资源始终只有最近几页。弹出后更早的记录进入固定范围，
+ * 由引擎的回调重新获取引用，连续回退时每一页都能直接命中缓存。
+ */
+
+#include "vn_history.h"
+#include <stdlib.h>
+#include <string.h>
+
+static vn_history_entry_t ring[VN_HISTORY_MAX];
+static int head = 0;        /**< 下一条记录的位置 */
+static int count = 0;
+static vn_history_pin_cb_t pin_cb = NULL;
+
+static vn_history_entry_t *entry_at(int depth) {
+    return &ring[(head - 1 - depth + VN_HISTORY_MAX) % VN_HISTORY_MAX];
+}
+
+void vn_history_release(vn_history_entry_t *entry) {
+    for (int i = 0; i < entry->resource_count; i++) {
+        resource_manager_release(entry->resources[i]);
+    }
+    entry->resource_count = 0;
+    vn_text_layout_release(entry->layout);
+    entry->layout = NULL;
+}
+
+// 释放记录的全部内容（被覆盖或清空时）
+static void entry_free(vn_history_entry_t *entry) {
+    vn_history_release(entry);
+    free(entry->vars);
+    entry->vars = NULL;
+    entry->vars_size = 0;
+}
+
+void vn_history_push(int page_index, resource_t *const *resources, int n, vn_text_layout_t *layout,
+                     char *vars, size_t vars_size) {
+    if (page_index < 0) {
+        free(vars);
+        return;
+    }
+
+    vn_history_entry_t *entry = &ring[head];
+    if (count == VN_HISTORY_MAX) {
+        entry_free(entry);
+    } else {
+        count++;
+    }
+    head = (head + 1) % VN_HISTORY_MAX;
+
+    entry->page_index = page_index;
+    entry->resource_count = 0;
+    if (n > 1 + VN_SPRITE_POOL_MAX) {
+        n = 1 + VN_SPRITE_POOL_MAX;
+    }
+    for (int i = 0; i < n; i++) {
+        resource_manager_retain(resources[i]);
+        entry->resources[entry->resource_count++] = resources[i];
+    }
+    vn_text_layout_retain(layout);
+    entry->layout = layout;
+    entry->vars = vars;
+    entry->vars_size = vars_size;
+
+    // 超出固定范围的记录只保留页面索引和变量
+    if (count > VN_HISTORY_PIN) {
+        vn_history_release(entry_at(VN_HISTORY_PIN));
+    }
+}
+
+void vn_history_set_pin_cb(vn_history_pin_cb_t cb) {
+    pin_cb = cb;
+}
+
+bool vn_history_pop(vn_history_entry_t *entry) {
+    if (count == 0) {
+        return false;
+    }
+    head = (head - 1 + VN_HISTORY_MAX) % VN_HISTORY_MAX;
+    count--;
+    *entry = ring[head];
+    memset(&ring[head], 0, sizeof(ring[head]));
+
+    // 重新固定进入最近范围的记录（读档恢复的记录一开始都没有固定）
+    for (int i = 0; pin_cb != NULL && i < count && i < VN_HISTORY_PIN; i++) {
+        vn_history_entry_t *e = entry_at(i);
+        if (e->resource_count == 0 && e->layout == NULL) {
+            pin_cb(e);
+        }
+    }
+    return true;
+}
+
+int vn_history_count(void) {
+    return count;
+}
+
+int vn_history_get(int32_t *indices, int max) {
+    int n = count < max ? count : max;
+    for (int i = 0; i < n; i++) {
+        indices[i] = entry_at(n - 1 - i)->page_index;
+    }
+    return n;
+}
+
+void vn_history_clear(void) {
+    for (int i = 0; i < count; i++) {
+        entry_free(entry_at(i));
+    }
+    head = 0;
+    count = 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file vn_history.h
+ * @brief 视觉小说页面历史（回退）头文件
+ *
+ * 每次离开一个页面时把它的状态压入容量为 VN_HISTORY_MAX 的环形缓冲，
+ * 回退时弹出最近的状态并重新显示，不需要重新查找或解析页面ID。
+ * 每条记录还保存进入该页面后的脚本变量（vn_script_save_vars 的结果），回退时一起恢复。
+ * 最近 VN_HISTORY_PIN 页额外持有图片资源和文本排版的引用，
+ * 它们不会被缓存淘汰，回退和前进一样直接命中缓存；更早的记录只保存页面索引。
+ * 回退弹出记录后，用 vn_history_set_pin_cb 设置的回调重新固定进入最近范围的记录。
+ *
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef VN_HISTORY_H
+#define VN_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "resource_manager.h"
+#include "vn_sprite_pool.h"
+#include "vn_text_layout.h"
+
+#define VN_HISTORY_MAX  64      /**< 可回退的页数 */
+#define VN_HISTORY_PIN  3       /**< 固定资源的最近页数 */
+
+/**
+ * @brief 一页的状态
+ */
+typedef struct {
+    int page_index;                                     /**< 页面索引 */
+    resource_t *resources[1 + VN_SPRITE_POOL_MAX];      /**< 固定的图片资源（背景 + 每个角色） */
+    int resource_count;                                 /**< 固定的资源数，0表示未固定 */
+    vn_text_layout_t *layout;                           /**< 固定的文本排版，可以为NULL */
+    char *vars;                                         /**< 进入页面后的脚本变量，NULL表示没有快照 */
+    size_t vars_size;                                   /**< 变量长度，0表示没有变量 */
+} vn_history_entry_t;
+
+/**
+ * @brief 重新固定记录的回调：为只有页面索引的记录获取资源和排版的引用
+ * （填写 resources、resource_count 和 layout，由 vn_history_release 释放）
+ * @param entry 记录
+ */
+typedef void (*vn_history_pin_cb_t)(vn_history_entry_t *entry);
+
+/**
+ * @brief 设置重新固定记录的回调
+ * @param cb 回调，NULL 表示不重新固定
+ */
+void vn_history_set_pin_cb(vn_history_pin_cb_t cb);
+
+/**
+ * @brief 记录离开的页面，并为其增加资源和排版的引用
+ * @param page_index 页面索引
+ * @param resources 页面当前使用的图片资源
+ * @param count 资源数量
+ * @param layout 页面当前使用的文本排版
+ * @param vars 进入页面后的脚本变量（malloc 分配，所有权转移给历史记录），NULL表示没有快照
+ * @param vars_size 变量长度
+ */
+void vn_history_push(int page_index, resource_t *const *resources, int count, vn_text_layout_t *layout,
+                     char *vars, size_t vars_size);
+
+/**
+ * @brief 弹出最近的页面状态，引用和变量转移给调用方，之后重新固定最近 VN_HISTORY_PIN 条记录
+ * @param entry 输出，显示该页面后用 vn_history_release 释放其引用，用 free() 释放 vars
+ * @return 是否有可回退的页面
+ */
+bool vn_history_pop(vn_history_entry_t *entry);
+
+/**
+ * @brief 释放页面状态持有的资源和排版引用（不释放 vars）
+ */
+void vn_history_release(vn_history_entry_t *entry);
+
+/**
+ * @brief 可回退的页数
+ */
+int vn_history_count(void);
+
+/**
+ * @brief 获取历史记录中的页面索引（用于存档）
+ * @param indices 输出，从旧到新
+ * @param max 最多获取的数量
+ * @return 获取的数量
+ */
+int vn_history_get(int32_t *indices, int max);
+
+/**
+ * @brief 清空历史并释放所有引用
+ */
+void vn_history_clear(void);
+
+#endif /* VN_HISTORY_H */
@@ -0,0 +1,342 @@
+/**
+ * @file vn_prefetch.c
+ * @brief 视觉小说页面预取实现
+ *
+ * 队列按页面距离排序（最近的页面先解码），选项的目标页排在 next_page 链之后。
+ * 每次 vn_prefetch_set_page 都会用新队列替换旧队列，工作线程完成的图片进入完成队列，
+ * 定时器在主线程中把它们插入资源管理器（已存在或超出预算时直接丢弃）。
+ *
+ * 后续页面的文本排版也由该定时器在主线程中完成（每次一页）：
+ * 测量字宽会访问字体的字形缓存，不能放到工作线程。
+ */
+
+#include "vn_prefetch.h"
+#include "resource_manager.h"
+#include "vn_text_layout.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief 预取请求
+ */
+typedef struct prefetch_job {
+    struct prefetch_job *next;
+    char *path;
+    lv_image_dsc_t *dsc;
+    size_t bytes;
+} prefetch_job_t;
+
+static story_config_t *story = NULL;
+static pthread_t worker_tid;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static prefetch_job_t *queue_head = NULL;   /**< 待解码（FIFO，按页面距离排序） */
+static prefetch_job_t *queue_tail = NULL;
+static prefetch_job_t *done_list = NULL;    /**< 已解码 */
+static const char *running_path = NULL;     /**< 正在解码的路径 */
+static volatile int worker_quit = 0;
+static bool worker_started = false;
+static int max_w = 0;
+static int max_h = 0;
+static lv_timer_t *poll_timer = NULL;
+static char *text_jobs[VN_PREFETCH_DEPTH + VN_PREFETCH_BRANCHES];   /**< 待排版的文本，按页面距离排序 */
+static vn_text_style_t text_styles[VN_PREFETCH_DEPTH + VN_PREFETCH_BRANCHES];
+static int text_job_count = 0;
+static int text_job_next = 0;
+
+static void job_free(prefetch_job_t *job) {
+    free(job->dsc);
+    free(job->path);
+    free(job);
+}
+
+static void *worker_thread(void *arg) {
+    (void)arg;
+
+    // 预取优先级低于界面线程
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 5);
+
+    pthread_mutex_lock(&lock);
+    while (!worker_quit) {
+        if (queue_head == NULL) {
+            pthread_cond_wait(&cond, &lock);
+            continue;
+        }
+
+        prefetch_job_t *job = queue_head;
+        queue_head = job->next;
+        if (queue_head == NULL) {
+            queue_tail = NULL;
+        }
+        running_path = job->path;
+        pthread_mutex_unlock(&lock);
+
+        job->dsc = resource_manager_decode_image(job->path, max_w, max_h, &job->bytes);
+
+        pthread_mutex_lock(&lock);
+        running_path = NULL;
+        job->next = done_list;
+        done_list = job;
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+static void poll_timer_cb(lv_timer_t *timer) {
+    (void)timer;
+
+    pthread_mutex_lock(&lock);
+    prefetch_job_t *list = done_list;
+    done_list = NULL;
+    pthread_mutex_unlock(&lock);
+
+    while (list != NULL) {
+        prefetch_job_t *job = list;
+        list = job->next;
+        if (job->dsc != NULL && resource_manager_insert_image(job->path, job->dsc, job->bytes)) {
+            job->dsc = NULL;   // 已由缓存接管
+        }
+        job_free(job);
+    }
+
+    // 每次只排版一页，避免占用过多主线程时间
+    if (text_job_next < text_job_count) {
+        int i = text_job_next++;
+        if (!vn_text_layout_contains(text_jobs[i], &text_styles[i])) {
+            vn_text_layout_t *layout = vn_text_layout_create(text_jobs[i], &text_styles[i]);
+            if (layout != NULL && !vn_text_layout_insert(layout)) {
+                vn_text_layout_free(layout);
+            }
+        }
+    }
+}
+
+static void clear_text_jobs(void) {
+    for (int i = 0; i < text_job_count; i++) {
+        free(text_jobs[i]);
+    }
+    text_job_count = 0;
+    text_job_next = 0;
+}
+
+/**
+ * @brief 把页面文本追加到待排版列表
+ */
+static void append_text(const page_config_t *cfg) {
+    if (!cfg->textbox.visible || cfg->text == NULL ||
+        text_job_count >= VN_PREFETCH_DEPTH + VN_PREFETCH_BRANCHES) {
+        return;
+    }
+    vn_text_style_t *style = &text_styles[text_job_count];
+    vn_text_style_from_textbox(style, &cfg->textbox);
+    if (vn_text_layout_contains(cfg->text, style)) {
+        return;
+    }
+    // 按需解析的故事中页面可能被淘汰，保存文本副本
+    text_jobs[text_job_count] = strdup(cfg->text);
+    if (text_jobs[text_job_count] != NULL) {
+        text_job_count++;
+    }
+}
+
+/**
+ * @brief 路径是否需要预取（未缓存且不在新队列中）
+ */
+static bool want_path(const char *path, prefetch_job_t *head) {
+    if (path == NULL || path[0] == '\0' || resource_manager_contains(path)) {
+        return false;
+    }
+    for (prefetch_job_t *job = head; job != NULL; job = job->next) {
+        if (strcmp(job->path, path) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 把路径追加到新队列
+ */
+static void append_path(const char *path, prefetch_job_t **head, prefetch_job_t **tail) {
+    if (!want_path(path, *head)) {
+        return;
+    }
+
+    prefetch_job_t *job = (prefetch_job_t *)calloc(1, sizeof(prefetch_job_t));
+    if (job == NULL) {
+        return;
+    }
+    job->path = strdup(path);
+    if (job->path == NULL) {
+        free(job);
+        return;
+    }
+
+    if (*tail) {
+        (*tail)->next = job;
+    } else {
+        *head = job;
+    }
+    *tail = job;
+}
+
+/**
+ * @brief 把页面的图片和文本追加到新队列
+ */
+static void append_page(const page_config_t *cfg, prefetch_job_t **head, prefetch_job_t **tail) {
+    append_path(cfg->background, head, tail);
+    for (int i = 0; i < cfg->character_count; i++) {
+        append_path(cfg->characters[i].image, head, tail);
+    }
+    append_text(cfg);
+}
+
+/**
+ * @brief 记录页面选项的目标页（去重，最多 VN_PREFETCH_BRANCHES 个）
+ *
+ * 先复制索引：按需解析的故事在获取目标页时可能淘汰 cfg。
+ */
+static void collect_branches(const page_config_t *cfg, int *branches, int *count) {
+    for (int i = 0; i < cfg->choice_count && *count < VN_PREFETCH_BRANCHES; i++) {
+        int target = cfg->choices[i].next_index;
+        // 没有指定目标的选项走页面的下一页，已在 next_page 链中
+        if (target < 0 || target == cfg->next_index) {
+            continue;
+        }
+        bool dup = false;
+        for (int j = 0; j < *count && !dup; j++) {
+            dup = branches[j] == target;
+        }
+        if (!dup) {
+            branches[(*count)++] = target;
+        }
+    }
+}
+
+/*=====================
+ * 公共接口
+ *====================*/
+
+bool vn_prefetch_init(story_config_t *cfg) {
+    if (worker_started) {
+        story = cfg;
+        return true;
+    }
+
+    story = cfg;
+
+    // 与同步加载使用相同的尺寸上限（主线程中读取）
+    lv_display_t *disp = lv_display_get_default();
+    max_w = disp ? lv_display_get_horizontal_resolution(disp) : 0;
+    max_h = disp ? lv_display_get_vertical_resolution(disp) : 0;
+
+    worker_quit = 0;
+    if (pthread_create(&worker_tid, NULL, worker_thread, NULL) != 0) {
+        printf("[vn] 预取线程启动失败\n");
+        return false;
+    }
+    worker_started = true;
+
+    poll_timer = lv_timer_create(poll_timer_cb, VN_PREFETCH_POLL_MS, NULL);
+    return poll_timer != NULL;
+}
+
+void vn_prefetch_set_page(int index) {
+    if (!worker_started || story == NULL) {
+        return;
+    }
+
+    // 沿 next_page 收集后续页面的图片，最近的页面排在前面（按需解析的故事同时预先解析这些页面）
+    prefetch_job_t *head = NULL;
+    prefetch_job_t *tail = NULL;
+    int branches[VN_PREFETCH_BRANCHES];
+    int branch_count = 0;
+    clear_text_jobs();
+    const page_config_t *cfg = story_get_page(story, index);
+    for (int depth = 0; depth < VN_PREFETCH_DEPTH && cfg != NULL; depth++) {
+        collect_branches(cfg, branches, &branch_count);
+        cfg = story_get_page(story, cfg->next_index);
+        if (cfg == NULL) {
+            break;
+        }
+        append_page(cfg, &head, &tail);
+    }
+
+    // 选项的目标页优先级较低，每个只预取一页（玩家选择后从目标页重新预取）
+    for (int i = 0; i < branch_count; i++) {
+        cfg = story_get_page(story, branches[i]);
+        if (cfg != NULL) {
+            append_page(cfg, &head, &tail);
+        }
+    }
+
+    // 替换旧队列：跳转后不再解码已经用不到的页面
+    pthread_mutex_lock(&lock);
+    prefetch_job_t *old = queue_head;
+
+    // 正在解码或已解码待插入的图片不再重复请求
+    prefetch_job_t **pp = &head;
+    tail = NULL;
+    while (*pp != NULL) {
+        prefetch_job_t *job = *pp;
+        bool busy = running_path != NULL && strcmp(running_path, job->path) == 0;
+        for (prefetch_job_t *d = done_list; d != NULL && !busy; d = d->next) {
+            busy = strcmp(d->path, job->path) == 0;
+        }
+        if (busy) {
+            *pp = job->next;
+            job->next = old;
+            old = job;
+        } else {
+            tail = job;
+            pp = &job->next;
+        }
+    }
+
+    queue_head = head;
+    queue_tail = tail;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+
+    while (old != NULL) {
+        prefetch_job_t *next = old->next;
+        job_free(old);
+        old = next;
+    }
+}
+
+void vn_prefetch_deinit(void) {
+    if (!worker_started) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    worker_quit = 1;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+    pthread_join(worker_tid, NULL);
+    worker_started = false;
+
+    prefetch_job_t *lists[2] = { queue_head, done_list };
+    for (int i = 0; i < 2; i++) {
+        while (lists[i] != NULL) {
+            prefetch_job_t *next = lists[i]->next;
+            job_free(lists[i]);
+            lists[i] = next;
+        }
+    }
+    queue_head = queue_tail = NULL;
+    done_list = NULL;
+
+    if (poll_timer) {
+        lv_timer_delete(poll_timer);
+        poll_timer = NULL;
+    }
+    clear_text_jobs();
+    story = NULL;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file vn_prefetch.h
+ * @brief 视觉小说页面预取头文件
+ *
+ * 沿 next_page 向后预取 VN_PREFETCH_DEPTH 页，之后再预取这些页面上选项的目标页
+ * （每个目标只预取一页，最多 VN_PREFETCH_BRANCHES 个），在后台线程中解码背景和角色图片，
+ * 由 LVGL 定时器放入资源管理器的图片缓存，翻页时直接命中缓存。
+ * 这些页面的文本也由该定时器提前排版，放入 vn_text_layout 缓存。
+ * 每次翻页或跳转都会替换预取队列，已过期的请求不再解码。
+ * Lua 计算的跳转（jump）和选项条件要执行脚本才能知道结果，不做预测。
+ *
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef VN_PREFETCH_H
+#define VN_PREFETCH_H
+
+#include <stdbool.h>
+#include "data_parser.h"
+
+#define VN_PREFETCH_DEPTH    3      /**< 预取的页数 */
+#define VN_PREFETCH_BRANCHES 4      /**< 预取的选项目标页数（排在 next_page 链之后） */
+#define VN_PREFETCH_POLL_MS  30     /**< 完成队列轮询周期 */
+
+/**
+ * @brief 启动预取线程
+ * @param story 故事配置（在 vn_prefetch_deinit 之前保持有效）
+ * @return 是否成功
+ */
+bool vn_prefetch_init(story_config_t *story);
+
+/**
+ * @brief 通知当前页面已切换，重新计算预取队列
+ * @param index 当前页面索引
+ */
+void vn_prefetch_set_page(int index);
+
+/**
+ * @brief 停止预取线程并丢弃未完成的结果
+ */
+void vn_prefetch_deinit(void);
+
+#endif /* VN_PREFETCH_H */
@@ -0,0 +1,565 @@
+/**
+ * @file vn_save.c
+ * @brief 视觉小说存档实现
+ *
+ * 写入线程按提交顺序处理存档和删除，同一存档槽连续保存时后提交的总是最后写入。
+ * 主线程上的工作只有复制缩略图和打包，fsync 等耗时操作都在写入线程中。
+ *
+ * 缩略图在显示的 LV_EVENT_FLUSH_START 事件中更新：刷新的区域覆盖某个缩略图像素的
+ * 采样点时读取该点，因此缩略图始终是最近渲染的画面，不需要另外渲染一次屏幕。
+ */
+
+#include "vn_save.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief 写入请求
+ */
+typedef struct save_job {
+    char path[PATH_MAX];
+    void *data;                 /**< 存档内容，NULL 表示删除存档 */
+    size_t size;
+    struct save_job *next;
+} save_job_t;
+
+static char save_dir[PATH_MAX] = VN_SAVE_DEFAULT_DIR;
+
+static pthread_t writer_tid;
+static bool writer_started = false;
+static int writer_quit = 0;
+static save_job_t *running_job = NULL; /**< 正在写入的请求 */
+static save_job_t *queue_head = NULL;
+static save_job_t *queue_tail = NULL;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+
+static lv_display_t *frame_disp = NULL;     /**< 采样缩略图的显示 */
+static uint16_t *frame_thumb = NULL;        /**< 最近渲染画面的缩略图（RGB565） */
+static uint8_t *frame_seen = NULL;          /**< 采样点是否已写入过 */
+static int32_t frame_missing = 0;           /**< 还没有写入过的采样点数 */
+static int32_t frame_tw = 0;
+static int32_t frame_th = 0;
+
+static size_t align4(size_t n) {
+    return (n + 3) & ~(size_t)3;
+}
+
+#define FNV1A_INIT  2166136261u
+
+static uint32_t fnv1a(uint32_t h, const uint8_t *p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief 存档校验和：整个文件，checksum 字段按0计算（版本2只计算文件头之后的内容）
+ */
+static uint32_t save_checksum(const uint8_t *data, size_t size) {
+    vn_save_header_t hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+    uint32_t h = FNV1A_INIT;
+    if (hdr.version != 2) {
+        hdr.checksum = 0;
+        h = fnv1a(h, (const uint8_t *)&hdr, sizeof(hdr));
+    }
+    return fnv1a(h, data + sizeof(hdr), size - sizeof(hdr));
+}
+
+static bool write_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = (const uint8_t *)buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief 写入一个存档：临时文件 + fsync + rename，再 fsync 目录使 rename 落盘
+ */
+static void write_save_file(const save_job_t *job) {
+    mkdir(save_dir, 0755);
+
+    char tmp[PATH_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", job->path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        printf("[vn] 无法创建存档 %s: %s\n", tmp, strerror(errno));
+        return;
+    }
+    bool ok = write_all(fd, job->data, job->size) && fsync(fd) == 0;
+    close(fd);
+
+    if (!ok || rename(tmp, job->path) != 0) {
+        printf("[vn] 存档写入失败 %s\n", job->path);
+        unlink(tmp);
+        return;
+    }
+
+    int dir_fd = open(save_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+}
+
+/**
+ * @brief 删除一个存档（结束故事时调用，不需要 fsync）
+ */
+static void remove_save_file(const save_job_t *job) {
+    if (unlink(job->path) != 0 && errno != ENOENT) {
+        printf("[vn] 无法删除存档 %s: %s\n", job->path, strerror(errno));
+    }
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&lock);
+    while (1) {
+        while (queue_head == NULL && !writer_quit) {
+            pthread_cond_wait(&cond, &lock);
+        }
+        if (queue_head == NULL) {
+            break;
+        }
+        save_job_t *job = queue_head;
+        queue_head = job->next;
+        if (queue_head == NULL) {
+            queue_tail = NULL;
+        }
+        running_job = job;
+        pthread_mutex_unlock(&lock);
+
+        if (job->data != NULL) {
+            write_save_file(job);
+        } else {
+            remove_save_file(job);
+        }
+
+        pthread_mutex_lock(&lock);
+        running_job = NULL;
+        if (queue_head == NULL) {
+            pthread_cond_broadcast(&idle_cond);
+        }
+        pthread_mutex_unlock(&lock);
+        free(job->data);
+        free(job);
+        pthread_mutex_lock(&lock);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+static bool submit(save_job_t *job) {
+    if (!writer_started) {
+        writer_quit = 0;
+        if (pthread_create(&writer_tid, NULL, writer_thread, NULL) != 0) {
+            printf("[vn] 存档线程启动失败\n");
+            return false;
+        }
+        writer_started = true;
+    }
+
+    pthread_mutex_lock(&lock);
+    job->next = NULL;
+    if (queue_tail != NULL) {
+        queue_tail->next = job;
+    } else {
+        queue_head = job;
+    }
+    queue_tail = job;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+    return true;
+}
+
+/**
+ * @brief 显示刷新时把刷新区域内的采样点写入缩略图（主线程）
+ *
+ * 局部渲染时缓冲区只包含刷新的区域，直接/全屏渲染时是整个屏幕。
+ */
+static void frame_flush_cb(lv_event_t *e) {
+    const lv_area_t *area = (const lv_area_t *)lv_event_get_param(e);
+    lv_draw_buf_t *buf = lv_display_get_buf_active(frame_disp);
+    if (area == NULL || buf == NULL || buf->data == NULL || frame_thumb == NULL) {
+        return;
+    }
+    uint32_t px_size = lv_color_format_get_size(buf->header.cf);
+    if (px_size < 2) {
+        return;
+    }
+    int32_t w = lv_display_get_horizontal_resolution(frame_disp);
+    int32_t h = lv_display_get_vertical_resolution(frame_disp);
+    bool partial = lv_display_get_render_mode(frame_disp) == LV_DISPLAY_RENDER_MODE_PARTIAL;
+    int32_t ox = partial ? area->x1 : 0;
+    int32_t oy = partial ? area->y1 : 0;
+
+    for (int32_t ty = 0; ty < frame_th; ty++) {
+        int32_t y = (2 * ty + 1) * h / (2 * frame_th);
+        if (y < area->y1 || y > area->y2) {
+            continue;
+        }
+        const uint8_t *row = buf->data + (size_t)buf->header.stride * (size_t)(y - oy);
+        for (int32_t tx = 0; tx < frame_tw; tx++) {
+            int32_t x = (2 * tx + 1) * w / (2 * frame_tw);
+            if (x < area->x1 || x > area->x2) {
+                continue;
+            }
+            const uint8_t *p = row + (size_t)(x - ox) * px_size;
+            uint16_t c;
+            if (px_size == 2) {
+                memcpy(&c, p, sizeof(c));
+            } else {
+                // RGB888 / XRGB8888 / ARGB8888：内存中依次为 B G R
+                c = (uint16_t)(((p[2] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[0] >> 3));
+            }
+            int32_t i = ty * frame_tw + tx;
+            frame_thumb[i] = c;
+            if (!frame_seen[i]) {
+                frame_seen[i] = 1;
+                frame_missing--;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 在显示上注册刷新事件，之后每次刷新都更新缩略图
+ */
+static bool attach_display(lv_display_t *disp, int32_t tw, int32_t th) {
+    if (frame_disp == disp && frame_tw == tw && frame_th == th) {
+        return true;
+    }
+    size_t count = (size_t)tw * (size_t)th;
+    uint16_t *thumb = (uint16_t *)calloc(count, sizeof(uint16_t));
+    uint8_t *seen = (uint8_t *)calloc(count, 1);
+    if (thumb == NULL || seen == NULL) {
+        free(thumb);
+        free(seen);
+        return false;
+    }
+    if (frame_disp != NULL) {
+        lv_display_remove_event_cb_with_user_data(frame_disp, frame_flush_cb, NULL);
+    }
+    free(frame_thumb);
+    free(frame_seen);
+    frame_thumb = thumb;
+    frame_seen = seen;
+    frame_missing = (int32_t)count;
+    frame_tw = tw;
+    frame_th = th;
+    frame_disp = disp;
+    lv_display_add_event_cb(disp, frame_flush_cb, LV_EVENT_FLUSH_START, NULL);
+    return true;
+}
+
+/**
+ * @brief 缩略图尺寸：宽 VN_SAVE_THUMB_W，高按显示比例
+ */
+static bool thumb_size(lv_display_t *disp, int32_t *tw, int32_t *th) {
+    if (disp == NULL || lv_display_get_horizontal_resolution(disp) <= 0) {
+        return false;
+    }
+    *tw = VN_SAVE_THUMB_W;
+    *th = lv_display_get_vertical_resolution(disp) * VN_SAVE_THUMB_W / lv_display_get_horizontal_resolution(disp);
+    return *th > 0;
+}
+
+/**
+ * @brief 复制最近刷新的画面的缩略图
+ *
+ * 不重绘也不立即刷新屏幕：采样在每次刷新时完成，这里只复制结果。
+ * 注册之后还没有完整刷新过一次屏幕时（所有采样点都写入过之前）不保存缩略图。
+ * @param screen 显示中的屏幕对象
+ * @param out 输出（tw * th 个像素）
+ */
+static bool capture_thumbnail(lv_obj_t *screen, uint16_t *out, int32_t tw, int32_t th) {
+    lv_display_t *disp = lv_obj_get_display(screen);
+    if (disp == NULL || !attach_display(disp, tw, th) || frame_missing > 0) {
+        return false;
+    }
+    memcpy(out, frame_thumb, sizeof(uint16_t) * (size_t)tw * (size_t)th);
+    return true;
+}
+
+void vn_save_track_screen(lv_obj_t *screen) {
+    lv_display_t *disp = screen != NULL ? lv_obj_get_display(screen) : NULL;
+    int32_t tw, th;
+    if (thumb_size(disp, &tw, &th)) {
+        attach_display(disp, tw, th);
+    }
+}
+
+void vn_save_set_dir(const char *dir) {
+    if (dir != NULL && dir[0] != '\0') {
+        snprintf(save_dir, sizeof(save_dir), "%s", dir);
+    }
+}
+
+bool vn_save_path(const char *story_path, int slot, char *out, size_t size) {
+    const char *name = strrchr(story_path, '/');
+    name = name ? name + 1 : story_path;
+    const char *dot = strrchr(name, '.');
+    int name_len = dot && dot != name ? (int)(dot - name) : (int)strlen(name);
+    int n = snprintf(out, size, "%s/%.*s.%d%s", save_dir, name_len, name, slot, VN_SAVE_EXTENSION);
+    return n > 0 && (size_t)n < size;
+}
+
+bool vn_save_write(const char *story_path, int slot, const vn_save_state_t *state, lv_obj_t *screen) {
+    if (slot < 0 || slot >= VN_SAVE_SLOTS || state->page_index < 0) {
+        return false;
+    }
+
+    save_job_t *job = (save_job_t *)calloc(1, sizeof(save_job_t));
+    if (job == NULL) {
+        return false;
+    }
+    if (!vn_save_path(story_path, slot, job->path, sizeof(job->path))) {
+        free(job);
+        return false;
+    }
+
+    // 缩略图尺寸按显示比例
+    int32_t tw = 0;
+    int32_t th = 0;
+    if (!thumb_size(screen != NULL ? lv_obj_get_display(screen) : NULL, &tw, &th)) {
+        tw = th = 0;
+    }
+
+    size_t read_size = state->read_pages ? (size_t)state->page_count / 8 + 1 : 0;
+    size_t read_off = sizeof(vn_save_header_t);
+    size_t history_off = align4(read_off + read_size);
+    size_t vars_off = history_off + sizeof(int32_t) * (size_t)state->history_count;
+    size_t vars_size = state->vars ? state->vars_size : 0;
+    size_t thumb_off = align4(vars_off + vars_size);
+    size_t file_size = thumb_off + sizeof(uint16_t) * (size_t)tw * (size_t)th;
+
+    uint8_t *data = (uint8_t *)calloc(1, file_size);
+    if (data == NULL) {
+        free(job);
+        return false;
+    }
+    vn_save_header_t *hdr = (vn_save_header_t *)data;
+    memcpy(hdr->magic, VN_SAVE_MAGIC, 4);
+    hdr->version = VN_SAVE_VERSION;
+    hdr->header_size = sizeof(vn_save_header_t);
+    hdr->file_size = (uint32_t)file_size;
+    hdr->saved_at = (int64_t)time(NULL);
+    hdr->page_index = state->page_index;
+    snprintf(hdr->page_id, sizeof(hdr->page_id), "%s", state->page_id ? state->page_id : "");
+    hdr->page_count = (uint32_t)state->page_count;
+    hdr->read_off = (uint32_t)read_off;
+    hdr->read_size = (uint32_t)read_size;
+    hdr->history_off = (uint32_t)history_off;
+    hdr->history_count = (uint32_t)state->history_count;
+    hdr->vars_off = (uint32_t)vars_off;
+    hdr->vars_size = (uint32_t)vars_size;
+    hdr->thumb_off = (uint32_t)thumb_off;
+
+    if (read_size > 0) {
+        memcpy(data + read_off, state->read_pages, read_size);
+    }
+    if (state->history_count > 0) {
+        memcpy(data + history_off, state->history, sizeof(int32_t) * (size_t)state->history_count);
+    }
+    if (vars_size > 0) {
+        memcpy(data + vars_off, state->vars, vars_size);
+    }
+    if (tw > 0 && th > 0 && capture_thumbnail(screen, (uint16_t *)(data + thumb_off), tw, th)) {
+        hdr->thumb_w = (uint16_t)tw;
+        hdr->thumb_h = (uint16_t)th;
+    } else {
+        hdr->file_size = (uint32_t)thumb_off;
+        file_size = thumb_off;
+    }
+    hdr->checksum = save_checksum(data, file_size);
+
+    job->data = data;
+    job->size = file_size;
+    if (!submit(job)) {
+        free(data);
+        free(job);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 检查文件头和各段范围
+ */
+static bool save_valid(const vn_save_header_t *hdr, size_t size) {
+    if (size < sizeof(vn_save_header_t) || memcmp(hdr->magic, VN_SAVE_MAGIC, 4) != 0 ||
+        (hdr->version != VN_SAVE_VERSION && hdr->version != 2) ||
+        hdr->header_size != sizeof(vn_save_header_t) || hdr->file_size != size ||
+        hdr->page_id[VN_SAVE_PAGE_ID_MAX - 1] != '\0') {
+        return false;
+    }
+    if ((uint64_t)hdr->read_off + hdr->read_size > size ||
+        (uint64_t)hdr->history_off + (uint64_t)hdr->history_count * sizeof(int32_t) > size ||
+        (uint64_t)hdr->vars_off + hdr->vars_size > size ||
+        (uint64_t)hdr->thumb_off + (uint64_t)hdr->thumb_w * hdr->thumb_h * sizeof(uint16_t) > size ||
+        (hdr->history_off & 3) != 0 || (hdr->thumb_off & 1) != 0) {
+        return false;
+    }
+    return save_checksum((const uint8_t *)hdr, size) == hdr->checksum;
+}
+
+vn_save_header_t *vn_save_read(const char *story_path, int slot) {
+    char path[PATH_MAX];
+    if (slot < 0 || slot >= VN_SAVE_SLOTS || !vn_save_path(story_path, slot, path, sizeof(path))) {
+        return NULL;
+    }
+
+    // 同一存档还在写入队列中时直接复制最新提交的内容，不等待 fsync；最后提交的是删除时存档已不存在
+    uint8_t *pending = NULL;
+    bool removed = false;
+    if (writer_started) {
+        pthread_mutex_lock(&lock);
+        const save_job_t *latest = running_job && strcmp(running_job->path, path) == 0 ? running_job : NULL;
+        for (const save_job_t *job = queue_head; job != NULL; job = job->next) {
+            if (strcmp(job->path, path) == 0) {
+                latest = job;
+            }
+        }
+        if (latest != NULL && latest->data == NULL) {
+            removed = true;
+        } else if (latest != NULL && (pending = (uint8_t *)malloc(latest->size)) != NULL) {
+            memcpy(pending, latest->data, latest->size);
+        }
+        pthread_mutex_unlock(&lock);
+    }
+    if (removed || pending != NULL) {
+        return (vn_save_header_t *)pending;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(vn_save_header_t) || st.st_size > (1 << 24)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    uint8_t *data = (uint8_t *)malloc(size);
+    size_t got = 0;
+    while (data != NULL && got < size) {
+        ssize_t n = read(fd, data + got, size - got);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        got += (size_t)n;
+    }
+    close(fd);
+
+    if (data == NULL || got != size || !save_valid((const vn_save_header_t *)data, size)) {
+        if (data != NULL) {
+            printf("[vn] 存档无效: %s\n", path);
+        }
+        free(data);
+        return NULL;
+    }
+    return (vn_save_header_t *)data;
+}
+
+const uint8_t *vn_save_read_pages(const vn_save_header_t *save) {
+    return save->read_size ? (const uint8_t *)save + save->read_off : NULL;
+}
+
+const int32_t *vn_save_history(const vn_save_header_t *save) {
+    return (const int32_t *)((const uint8_t *)save + save->history_off);
+}
+
+const char *vn_save_vars(const vn_save_header_t *save, size_t *size) {
+    *size = save->vars_size;
+    return save->vars_size ? (const char *)save + save->vars_off : NULL;
+}
+
+bool vn_save_thumbnail(const vn_save_header_t *save, lv_image_dsc_t *dsc) {
+    if (save->thumb_w == 0 || save->thumb_h == 0) {
+        return false;
+    }
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
+    dsc->header.cf = LV_COLOR_FORMAT_RGB565;
+    dsc->header.w = save->thumb_w;
+    dsc->header.h = save->thumb_h;
+    dsc->header.stride = save->thumb_w * sizeof(uint16_t);
+    dsc->data_size = (uint32_t)save->thumb_w * save->thumb_h * sizeof(uint16_t);
+    dsc->data = (const uint8_t *)save + save->thumb_off;
+    return true;
+}
+
+bool vn_save_remove(const char *story_path, int slot) {
+    if (slot < 0 || slot >= VN_SAVE_SLOTS) {
+        return false;
+    }
+    save_job_t *job = (save_job_t *)calloc(1, sizeof(save_job_t));
+    if (job == NULL) {
+        return false;
+    }
+    if (!vn_save_path(story_path, slot, job->path, sizeof(job->path)) || !submit(job)) {
+        free(job);
+        return false;
+    }
+    return true;
+}
+
+void vn_save_flush(void) {
+    if (!writer_started) {
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    while (queue_head != NULL || running_job != NULL) {
+        pthread_cond_wait(&idle_cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void vn_save_deinit(void) {
+    if (frame_disp != NULL) {
+        lv_display_remove_event_cb_with_user_data(frame_disp, frame_flush_cb, NULL);
+        frame_disp = NULL;
+    }
+    free(frame_thumb);
+    free(frame_seen);
+    frame_thumb = NULL;
+    frame_seen = NULL;
+    frame_missing = 0;
+    frame_tw = frame_th = 0;
+
+    if (!writer_started) {
+        return;
+    }
+    // 写入线程处理完队列中的存档后退出
+    pthread_mutex_lock(&lock);
+    writer_quit = 1;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+    pthread_join(writer_tid, NULL);
+    writer_started = false;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file vn_save.h
+ * @brief 视觉小说存档头文件
+ *
+ * 每个存档槽是一个小的二进制文件（.vns），保存当前页面、已读页面位图、
+ * 历史记录中的页面索引、脚本变量和一张 RGB565 缩略图。所有整数为小端序，偏移量从文件开头计算。
+ *
+ * 文件布局：
+ *   vn_save_header_t
+ *   uint8_t[read_size]             已读页面位图
+ *   int32_t[history_count]         历史记录（从旧到新的页面索引），4字节对齐
+ *   char[vars_size]                脚本变量（vn_script_save_vars 生成的 Lua 源码）
+ *   uint16_t[thumb_w * thumb_h]    缩略图（RGB565），4字节对齐
+ *
+ * 缩略图取自最近一次渲染的画面：显示刷新时按缩略图尺寸采样刷新的区域，保存时不重新渲染屏幕。
+ * 保存时在主线程打包后交给写入线程：先写临时文件并 fsync，再 rename 替换存档，
+ * 断电时不会留下半个存档。删除存档同样在写入线程中按提交顺序执行。
+ * 读取存档只读一个几十KB的文件，并用文件头中的校验和检查整个文件（包括文件头）。
+ *
+ * 除写入线程外，所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef VN_SAVE_H
+#define VN_SAVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lvgl/lvgl.h"
+
+#define VN_SAVE_MAGIC           "VNSV"
+#define VN_SAVE_VERSION         3           /**< 3: 校验和包括文件头（仍可读取版本2） */
+#define VN_SAVE_EXTENSION       ".vns"
+#define VN_SAVE_DEFAULT_DIR     "/mnt/app/saves"
+#define VN_SAVE_SLOTS           8           /**< 存档槽数量 */
+#define VN_SAVE_AUTO_SLOT       0           /**< 退出时自动保存、启动时自动恢复的槽 */
+#define VN_SAVE_THUMB_W         160         /**< 缩略图宽度，高度按屏幕比例计算 */
+#define VN_SAVE_PAGE_ID_MAX     64          /**< 保存的页面ID最大长度 */
+
+/**
+ * @brief 文件头
+ */
+typedef struct {
+    char magic[4];              /**< "VNSV" */
+    uint16_t version;           /**< 格式版本 */
+    uint16_t header_size;       /**< sizeof(vn_save_header_t) */
+    uint32_t file_size;         /**< 文件总大小 */
+    uint32_t checksum;          /**< 整个文件的 FNV-1a 哈希值（计算时本字段为0） */
+    int64_t saved_at;           /**< 保存时间（time()） */
+    int32_t page_index;         /**< 当前页面索引 */
+    char page_id[VN_SAVE_PAGE_ID_MAX];  /**< 当前页面ID（故事修改后按ID查找页面），以0结尾 */
+    uint32_t page_count;        /**< 保存时故事的页数 */
+    uint32_t read_off;
+    uint32_t read_size;
+    uint32_t history_off;
+    uint32_t history_count;
+    uint32_t vars_off;
+    uint32_t vars_size;
+    uint32_t thumb_off;
+    uint16_t thumb_w;
+    uint16_t thumb_h;
+} vn_save_header_t;
+
+/**
+ * @brief 要保存的引擎状态
+ */
+typedef struct {
+    int page_index;
+    const char *page_id;
+    const uint8_t *read_pages;  /**< 已读页面位图，可以为NULL */
+    int page_count;
+    const int32_t *history;     /**< 历史记录（从旧到新） */
+    int history_count;
+    const char *vars;           /**< 脚本变量，可以为NULL */
+    size_t vars_size;
+} vn_save_state_t;
+
+/**
+ * @brief 设置存档目录（默认 VN_SAVE_DEFAULT_DIR，不存在时在首次保存时创建）
+ */
+void vn_save_set_dir(const char *dir);
+
+/**
+ * @brief 生成存档路径：目录/故事文件名.槽号.vns
+ * @param story_path 故事文件路径
+ * @param slot 槽号
+ * @param out 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 是否成功（路径过长时返回false）
+ */
+bool vn_save_path(const char *story_path, int slot, char *out, size_t size);
+
+/**
+ * @brief 开始跟踪屏幕所在显示的刷新：每次刷新时更新缩略图的采样，保存时直接复制
+ *        （引擎初始化时调用，第一次保存不需要重绘屏幕）
+ * @param screen 显示中的屏幕对象
+ */
+void vn_save_track_screen(lv_obj_t *screen);
+
+/**
+ * @brief 保存：用最近刷新的画面生成缩略图并打包，在写入线程中写入文件后立即返回
+ * @param story_path 故事文件路径
+ * @param slot 槽号
+ * @param state 引擎状态
+ * @param screen 显示中的屏幕对象（取其所在显示的画面），NULL 表示不保存缩略图
+ * @return 是否已提交写入
+ */
+bool vn_save_write(const char *story_path, int slot, const vn_save_state_t *state, lv_obj_t *screen);
+
+/**
+ * @brief 读取并校验存档
+ * @param story_path 故事文件路径
+ * @param slot 槽号
+ * @return 整个存档文件（以文件头开始），用 free() 释放；不存在或无效时返回NULL
+ */
+vn_save_header_t *vn_save_read(const char *story_path, int slot);
+
+/**
+ * @brief 存档中的已读页面位图
+ */
+const uint8_t *vn_save_read_pages(const vn_save_header_t *save);
+
+/**
+ * @brief 存档中的历史记录
+ */
+const int32_t *vn_save_history(const vn_save_header_t *save);
+
+/**
+ * @brief 存档中的脚本变量
+ * @param size 输出长度
+ * @return 变量源码，没有时返回NULL
+ */
+const char *vn_save_vars(const vn_save_header_t *save, size_t *size);
+
+/**
+ * @brief 用存档中的缩略图填写图片描述符（像素指向存档内存）
+ * @return 是否有缩略图
+ */
+bool vn_save_thumbnail(const vn_save_header_t *save, lv_image_dsc_t *dsc);
+
+/**
+ * @brief 删除存档：提交到写入线程后立即返回，排在之前提交的写入之后
+ * @return 是否已提交删除
+ */
+bool vn_save_remove(const char *story_path, int slot);
+
+/**
+ * @brief 等待已提交的存档写入完成
+ */
+void vn_save_flush(void);
+
+/**
+ * @brief 等待写入完成并停止写入线程，停止采样缩略图
+ */
+void vn_save_deinit(void);
+
+#endif /* VN_SAVE_H */
@@ -0,0 +1,680 @@
+/**
+ * @file vn_script.c
+ * @brief 视觉小说 Lua 脚本实现
+ *
+ * 编译缓存是注册表中的一个表：键为 类型+源码 的64位哈希值，值为编译好的函数
+ * （编译失败时为 false，同一段错误的脚本只报告一次）。表达式包装为 "return (表达式)"。
+ * 字节码缓存文件是 cache_header_t 加一个返回这个表的代码块：
+ *   return { [0x...] = function(...) 脚本 end, ... }
+ * 加载它只需要执行一次代码块，所有脚本的函数都已就绪。函数带 ... 参数，与单独编译时的
+ * 主代码块一致，使用了 ... 的脚本不会让整个代码块编译失败。文件头中的 Lua 版本或故事哈希值
+ * 不一致时不加载（不执行其它版本或其它故事的字节码）。
+ */
+
+#include "vn_script.h"
+#include "visual_novel_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if USE_LUA
+
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "lua.h"
+#include "lauxlib.h"
+#include "lualib.h"
+#include "../lua_sched.h"
+#include "../lua_alloc.h"
+#include "../lua_idle_gc.h"
+
+#define KIND_STMT           's'         /**< 语句（页面/选项脚本） */
+#define KIND_EXPR           'e'         /**< 表达式（条件/跳转） */
+#define VARS_MAX_STEPS      100000      /**< 恢复变量时最多执行的指令数 */
+#define CACHE_MAGIC         "VNSC"
+
+/**
+ * @brief 字节码缓存文件头
+ */
+typedef struct {
+    char magic[4];          /**< CACHE_MAGIC */
+    uint32_t version;       /**< LUA_VERSION_NUM */
+    uint64_t story_hash;    /**< 故事哈希值（story_hash） */
+} cache_header_t;
+
+/**
+ * @brief lua_load 的文件读取状态
+ */
+typedef struct {
+    FILE *f;
+    char buf[4096];
+} file_reader_t;
+
+/**
+ * @brief 可增长的字符串缓冲区
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t cap;
+    bool failed;
+} strbuf_t;
+
+/**
+ * @brief 生成字节码缓存时的遍历状态
+ */
+typedef struct {
+    strbuf_t *src;      /**< 代码块源码 */
+    int seen;           /**< 已写入的哈希值集合（栈下标） */
+    int missing;        /**< 缓存中没有的脚本数 */
+    uint64_t hash;      /**< 所有脚本缓存键的组合哈希值 */
+} walk_ctx_t;
+
+typedef void (*snippet_fn)(int kind, const char *code, const char *name, walk_ctx_t *ctx);
+
+static lua_State *state = NULL;
+static story_config_t *script_story = NULL;
+static int cache_ref = LUA_NOREF;   /**< 编译缓存在注册表中的引用 */
+
+static void sb_add(strbuf_t *b, const char *s, size_t len) {
+    if (b->failed) {
+        return;
+    }
+    if (b->size + len > b->cap) {
+        size_t cap = b->cap ? b->cap : 4096;
+        while (b->size + len > cap) {
+            cap *= 2;
+        }
+        char *data = (char *)realloc(b->data, cap);
+        if (data == NULL) {
+            b->failed = true;
+            return;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->size, s, len);
+    b->size += len;
+}
+
+static void sb_puts(strbuf_t *b, const char *s) {
+    sb_add(b, s, strlen(s));
+}
+
+/**
+ * @brief 写入 Lua 字符串常量（控制字符写为 \ddd）
+ */
+static void sb_quote(strbuf_t *b, const char *s, size_t len) {
+    sb_add(b, "\"", 1);
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        char esc[8];
+        if (c == '"' || c == '\\') {
+            esc[0] = '\\';
+            esc[1] = (char)c;
+            sb_add(b, esc, 2);
+        } else if (c < ' ' || c == 0x7F) {
+            snprintf(esc, sizeof(esc), "\\%03u", c);
+            sb_add(b, esc, 4);
+        } else {
+            sb_add(b, &s[i], 1);
+        }
+    }
+    sb_add(b, "\"", 1);
+}
+
+/**
+ * @brief 脚本的缓存键：类型 + 源码的 FNV-1a 64位哈希值
+ */
+static lua_Integer snippet_key(int kind, const char *code) {
+    uint64_t h = 14695981039346656037ull;
+    h = (h ^ (uint8_t)kind) * 1099511628211ull;
+    while (*code) {
+        h = (h ^ (uint8_t)*code++) * 1099511628211ull;
+    }
+    return (lua_Integer)h;
+}
+
+/**
+ * @brief 编译一段脚本，成功时压入函数，失败时压入错误信息
+ */
+static bool compile_snippet(int kind, const char *code, const char *name) {
+    char chunk[80];
+    snprintf(chunk, sizeof(chunk), "=%s", name ? name : "?");
+    if (kind == KIND_STMT) {
+        return luaL_loadbufferx(state, code, strlen(code), chunk, "t") == LUA_OK;
+    }
+
+    // 换行使表达式末尾的 "--" 注释不会注释掉右括号
+    const char *src = lua_pushfstring(state, "return (%s\n)", code);
+    bool ok = luaL_loadbufferx(state, src, strlen(src), chunk, "t") == LUA_OK;
+    lua_remove(state, -2);
+    return ok;
+}
+
+/**
+ * @brief 取出脚本编译好的函数（第一次使用时编译并放入缓存）
+ * @return 是否成功，成功时函数在栈顶
+ */
+static bool push_snippet(int kind, const char *code, const char *name) {
+    lua_Integer key = snippet_key(kind, code);
+    lua_rawgeti(state, LUA_REGISTRYINDEX, cache_ref);
+    int type = lua_rawgeti(state, -1, key);
+    if (type == LUA_TNIL) {
+        lua_pop(state, 1);
+        if (!compile_snippet(kind, code, name)) {
+            printf("[vn] 脚本编译失败: %s\n", lua_tostring(state, -1));
+            lua_pop(state, 1);
+            lua_pushboolean(state, 0);
+        }
+        lua_pushvalue(state, -1);
+        lua_rawseti(state, -3, key);
+        type = lua_type(state, -1);
+    }
+    lua_remove(state, -2);
+    if (type != LUA_TFUNCTION) {
+        lua_pop(state, 1);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 执行一段脚本
+ * @param nresults 返回值个数，成功时留在栈上
+ */
+static bool call_snippet(int kind, const char *code, const char *name, int nresults) {
+    if (!push_snippet(kind, code, name)) {
+        return false;
+    }
+    if (lua_sched_pcall(state, 0, nresults) != LUA_OK) {
+        printf("[vn] 脚本错误: %s\n", lua_tostring(state, -1));
+        lua_pop(state, 1);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief visited(id)：页面是否已读
+ */
+static int l_visited(lua_State *L) {
+    const char *id = luaL_checkstring(L, 1);
+    lua_pushboolean(L, vn_engine_is_page_read(find_page_index(script_story, id)));
+    return 1;
+}
+
+/**
+ * @brief 遍历故事中的所有脚本（只用于已全部解析的故事）
+ */
+static void for_each_snippet(const story_config_t *story, snippet_fn fn, walk_ctx_t *ctx) {
+    for (int i = 0; i < story->page_count; i++) {
+        const page_config_t *page = &story->pages[i];
+        if (page->script != NULL) {
+            fn(KIND_STMT, page->script, page->id, ctx);
+        }
+        if (page->jump != NULL) {
+            fn(KIND_EXPR, page->jump, page->id, ctx);
+        }
+        for (int j = 0; j < page->choice_count; j++) {
+            if (page->choices[j].condition != NULL) {
+                fn(KIND_EXPR, page->choices[j].condition, page->id, ctx);
+            }
+            if (page->choices[j].script != NULL) {
+                fn(KIND_STMT, page->choices[j].script, page->id, ctx);
+            }
+        }
+    }
+}
+
+static void hash_snippet(int kind, const char *code, const char *name, walk_ctx_t *ctx) {
+    (void)name;
+    uint64_t key = (uint64_t)snippet_key(kind, code);
+    for (int i = 0; i < 8; i++) {
+        ctx->hash = (ctx->hash ^ (uint8_t)(key >> (i * 8))) * 1099511628211ull;
+    }
+}
+
+/**
+ * @brief 故事哈希值：已全部解析的故事为所有脚本缓存键的组合，按需解析的故事
+ *        （不能遍历脚本）为 JSON 文件的 mtime 和大小
+ */
+static uint64_t story_hash(const story_config_t *story, const char *story_path) {
+    walk_ctx_t ctx = { NULL, 0, 0, 14695981039346656037ull };
+    if (story->lazy == NULL) {
+        for_each_snippet(story, hash_snippet, &ctx);
+        return ctx.hash;
+    }
+    struct stat st;
+    if (stat(story_path, &st) == 0) {
+        int64_t v[2] = { (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec, (int64_t)st.st_size };
+        const uint8_t *p = (const uint8_t *)v;
+        for (size_t i = 0; i < sizeof(v); i++) {
+            ctx.hash = (ctx.hash ^ p[i]) * 1099511628211ull;
+        }
+    }
+    return ctx.hash;
+}
+
+static void count_missing(int kind, const char *code, const char *name, walk_ctx_t *ctx) {
+    (void)name;
+    if (lua_rawgeti(state, ctx->seen, snippet_key(kind, code)) == LUA_TNIL) {
+        ctx->missing++;
+    }
+    lua_pop(state, 1);
+}
+
+/**
+ * @brief 把一段脚本写入缓存代码块；先单独编译一次，错误的脚本写为 false 并报告
+ */
+static void emit_snippet(int kind, const char *code, const char *name, walk_ctx_t *ctx) {
+    lua_Integer key = snippet_key(kind, code);
+    if (lua_rawgeti(state, ctx->seen, key) != LUA_TNIL) {
+        lua_pop(state, 1);
+        return;
+    }
+    lua_pop(state, 1);
+    lua_pushboolean(state, 1);
+    lua_rawseti(state, ctx->seen, key);
+
+    char head[48];
+    snprintf(head, sizeof(head), "[0x%016llx]=", (unsigned long long)key);
+    sb_puts(ctx->src, head);
+
+    bool ok = compile_snippet(kind, code, name);
+    if (!ok) {
+        printf("[vn] 脚本编译失败: %s\n", lua_tostring(state, -1));
+    }
+    lua_pop(state, 1);
+    if (!ok) {
+        sb_puts(ctx->src, "false,\n");
+        return;
+    }
+
+    // 与单独编译时的主代码块一样是可变参数函数
+    sb_puts(ctx->src, kind == KIND_EXPR ? "function(...)\nreturn (" : "function(...)\n");
+    sb_puts(ctx->src, code);
+    sb_puts(ctx->src, kind == KIND_EXPR ? "\n)\nend,\n" : "\nend,\n");
+}
+
+static const char *read_chunk(lua_State *L, void *ud, size_t *size) {
+    (void)L;
+    file_reader_t *r = (file_reader_t *)ud;
+    *size = fread(r->buf, 1, sizeof(r->buf), r->f);
+    return *size > 0 ? r->buf : NULL;
+}
+
+static int write_chunk(lua_State *L, const void *p, size_t size, void *ud) {
+    (void)L;
+    // lua_dump 最后以 (NULL, 0) 调用一次表示结束
+    if (size == 0) {
+        return 0;
+    }
+    return fwrite(p, 1, size, (FILE *)ud) == size ? 0 : 1;
+}
+
+/**
+ * @brief 把栈顶的函数保存为字节码文件（文件头 + lua_dump，临时文件 + rename）
+ */
+static bool save_bytecode(const char *path, uint64_t hash) {
+    char tmp[520];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    cache_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CACHE_MAGIC, 4);
+    hdr.version = LUA_VERSION_NUM;
+    hdr.story_hash = hash;
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 && lua_dump(state, write_chunk, f, 0) == 0 &&
+              fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 用栈顶的表替换编译缓存
+ */
+static void set_cache(void) {
+    luaL_unref(state, LUA_REGISTRYINDEX, cache_ref);
+    cache_ref = luaL_ref(state, LUA_REGISTRYINDEX);
+}
+
+/**
+ * @brief 加载字节码缓存（只接受文件头与 Lua 版本和故事哈希值一致的二进制代码块）
+ */
+static bool load_cache(const char *path, uint64_t hash) {
+    file_reader_t *r = (file_reader_t *)malloc(sizeof(*r));
+    if (r == NULL) {
+        return false;
+    }
+    r->f = fopen(path, "rb");
+    if (r->f == NULL) {
+        free(r);
+        return false;
+    }
+
+    cache_header_t hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, r->f) == 1 && memcmp(hdr.magic, CACHE_MAGIC, 4) == 0 &&
+              hdr.version == LUA_VERSION_NUM && hdr.story_hash == hash;
+    if (ok && lua_load(state, read_chunk, r, "=story", "b") != LUA_OK) {
+        lua_pop(state, 1);
+        ok = false;
+    }
+    fclose(r->f);
+    free(r);
+    if (!ok) {
+        printf("[vn] 脚本缓存无效或已过期: %s\n", path);
+        return false;
+    }
+    if (lua_pcall(state, 0, 1, 0) != LUA_OK || !lua_istable(state, -1)) {
+        printf("[vn] 脚本缓存无效: %s\n", path);
+        lua_pop(state, 1);
+        return false;
+    }
+    set_cache();
+    return true;
+}
+
+/**
+ * @brief 把故事中的所有脚本编译为一个代码块，保存字节码并替换编译缓存
+ */
+static bool build_cache(const story_config_t *story, const char *path, uint64_t hash) {
+    strbuf_t src = {0};
+    sb_puts(&src, "return {\n");
+    lua_newtable(state);
+    walk_ctx_t ctx = { &src, lua_gettop(state), 0, 0 };
+    for_each_snippet(story, emit_snippet, &ctx);
+    lua_pop(state, 1);
+    sb_puts(&src, "}\n");
+    if (src.failed) {
+        free(src.data);
+        return false;
+    }
+
+    int status = luaL_loadbufferx(state, src.data, src.size, "=story", "t");
+    free(src.data);
+    if (status != LUA_OK) {
+        printf("[vn] 脚本缓存编译失败: %s\n", lua_tostring(state, -1));
+        lua_pop(state, 1);
+        return false;
+    }
+
+    // 先保存字节码（目录只读时只在内存中使用），再执行代码块得到函数表
+    if (!save_bytecode(path, hash)) {
+        printf("[vn] 无法写入脚本缓存: %s\n", path);
+    }
+    if (lua_pcall(state, 0, 1, 0) != LUA_OK) {
+        printf("[vn] 脚本缓存加载失败: %s\n", lua_tostring(state, -1));
+        lua_pop(state, 1);
+        return false;
+    }
+    set_cache();
+    return true;
+}
+
+bool vn_script_init(story_config_t *story, const char *story_path) {
+    vn_script_deinit();
+    state = lua_alloc_newstate(VN_SCRIPT_MEM_LIMIT);
+    if (state == NULL) {
+        return false;
+    }
+    script_story = story;
+
+    // 只打开纯计算的库，并去掉可以读取文件或执行任意代码的函数
+    luaL_openselectedlibs(state, LUA_GLIBK | LUA_STRLIBK | LUA_MATHLIBK | LUA_TABLIBK | LUA_UTF8LIBK, 0);
+    static const char *const removed[] = { "dofile", "loadfile", "load", "collectgarbage" };
+    for (size_t i = 0; i < sizeof(removed) / sizeof(removed[0]); i++) {
+        lua_pushnil(state);
+        lua_setglobal(state, removed[i]);
+    }
+    lua_pushcfunction(state, l_visited);
+    lua_setglobal(state, "visited");
+    lua_sched_init(state, LUA_SCHED_BUDGET_US);
+    lua_idle_gc_attach(state);
+    vn_script_reset();
+
+    char path[512];
+    bool have_path = story_path != NULL && story_sibling_path(story_path, VN_SCRIPT_EXTENSION, path, sizeof(path));
+    uint64_t hash = have_path ? story_hash(story, story_path) : 0;
+    if (!have_path || !load_cache(path, hash)) {
+        lua_newtable(state);
+        set_cache();
+    }
+
+    // 故事中的脚本有任何一段不在缓存中时重新生成（按需解析的故事在执行时才编译）
+    if (have_path && story->lazy == NULL) {
+        lua_rawgeti(state, LUA_REGISTRYINDEX, cache_ref);
+        walk_ctx_t ctx = { NULL, lua_gettop(state), 0, 0 };
+        for_each_snippet(story, count_missing, &ctx);
+        lua_pop(state, 1);
+        if (ctx.missing > 0 && build_cache(story, path, hash)) {
+            printf("[vn] 已编译 %d 段脚本: %s\n", ctx.missing, path);
+        }
+    }
+    return true;
+}
+
+void vn_script_enter(const page_config_t *page) {
+    if (state == NULL) {
+        return;
+    }
+    lua_pushstring(state, page->id);
+    lua_setglobal(state, "page");
+    vn_script_run(page->script, page->id);
+}
+
+bool vn_script_run(const char *code, const char *name) {
+    if (code == NULL) {
+        return true;
+    }
+    return state != NULL && call_snippet(KIND_STMT, code, name, 0);
+}
+
+bool vn_script_test(const char *expr, const char *name) {
+    if (expr == NULL || state == NULL) {
+        return true;
+    }
+    if (!call_snippet(KIND_EXPR, expr, name, 1)) {
+        return false;
+    }
+    bool result = lua_toboolean(state, -1);
+    lua_pop(state, 1);
+    return result;
+}
+
+int vn_script_jump(const char *expr, const char *name) {
+    if (expr == NULL || state == NULL || !call_snippet(KIND_EXPR, expr, name, 1)) {
+        return -1;
+    }
+    int index = -1;
+    if (lua_type(state, -1) == LUA_TSTRING) {
+        const char *id = lua_tostring(state, -1);
+        index = find_page_index(script_story, id);
+        if (index < 0) {
+            printf("[vn] 页面 %s 跳转到不存在的页面: %s\n", name, id);
+        }
+    } else if (lua_toboolean(state, -1)) {
+        printf("[vn] 页面 %s 的跳转结果不是页面ID\n", name);
+    }
+    lua_pop(state, 1);
+    return index;
+}
+
+char *vn_script_save_vars(size_t *size) {
+    *size = 0;
+    if (state == NULL) {
+        return NULL;
+    }
+
+    strbuf_t b = {0};
+    int count = 0;
+    sb_puts(&b, "return {\n");
+    lua_getglobal(state, "v");
+    if (lua_istable(state, -1)) {
+        lua_pushnil(state);
+        while (lua_next(state, -2) != 0) {
+            // 只保存字符串键和简单的值（不能对非字符串键调用 lua_tolstring，会打乱遍历）
+            char num[64] = "";
+            int vtype = lua_type(state, -1);
+            if (vtype == LUA_TBOOLEAN) {
+                snprintf(num, sizeof(num), "%s", lua_toboolean(state, -1) ? "true" : "false");
+            } else if (vtype == LUA_TNUMBER && lua_isinteger(state, -1)) {
+                snprintf(num, sizeof(num), LUA_INTEGER_FMT, (LUAI_UACINT)lua_tointeger(state, -1));
+            } else if (vtype == LUA_TNUMBER && isfinite(lua_tonumber(state, -1))) {
+                snprintf(num, sizeof(num), "%a", (double)lua_tonumber(state, -1));
+            }
+
+            if (lua_type(state, -2) == LUA_TSTRING && (num[0] != '\0' || vtype == LUA_TSTRING)) {
+                size_t len;
+                const char *s = lua_tolstring(state, -2, &len);
+                sb_add(&b, "[", 1);
+                sb_quote(&b, s, len);
+                sb_add(&b, "]=", 2);
+                if (vtype == LUA_TSTRING) {
+                    s = lua_tolstring(state, -1, &len);
+                    sb_quote(&b, s, len);
+                } else {
+                    sb_puts(&b, num);
+                }
+                sb_add(&b, ",\n", 2);
+                count++;
+            }
+            lua_pop(state, 1);
+        }
+    }
+    lua_pop(state, 1);
+    sb_add(&b, "}\n", 3);
+
+    if (b.failed || count == 0) {
+        free(b.data);
+        return NULL;
+    }
+    *size = b.size - 1;
+    return b.data;
+}
+
+/**
+ * @brief 恢复变量时的指令数钩子：存档内容只应是一个表构造式
+ */
+static void vars_hook(lua_State *L, lua_Debug *ar) {
+    (void)ar;
+    luaL_error(L, "too many instructions");
+}
+
+bool vn_script_load_vars(const char *src, size_t size) {
+    if (state == NULL) {
+        return false;
+    }
+    vn_script_reset();
+    if (src == NULL || size == 0) {
+        return true;
+    }
+
+    if (luaL_loadbufferx(state, src, size, "=vars", "t") != LUA_OK) {
+        printf("[vn] 存档变量无效: %s\n", lua_tostring(state, -1));
+        lua_pop(state, 1);
+        return false;
+    }
+    // 在空环境中执行，不能访问全局变量
+    lua_newtable(state);
+    lua_setupvalue(state, -2, 1);
+    lua_sethook(state, vars_hook, LUA_MASKCOUNT, VARS_MAX_STEPS);
+    int status = lua_pcall(state, 0, 1, 0);
+    lua_sethook(state, NULL, 0, 0);
+    if (status != LUA_OK || !lua_istable(state, -1)) {
+        printf("[vn] 存档变量无效: %s\n", status != LUA_OK ? lua_tostring(state, -1) : "not a table");
+        lua_pop(state, 1);
+        return false;
+    }
+    lua_setglobal(state, "v");
+    return true;
+}
+
+void vn_script_reset(void) {
+    if (state == NULL) {
+        return;
+    }
+    lua_newtable(state);
+    lua_setglobal(state, "v");
+    lua_pushliteral(state, "");
+    lua_setglobal(state, "page");
+}
+
+void vn_script_deinit(void) {
+    if (state != NULL) {
+        lua_sched_deinit();
+        lua_idle_gc_detach(state);
+        lua_alloc_close(state);
+        state = NULL;
+    }
+    cache_ref = LUA_NOREF;
+    script_story = NULL;
+}
+
+#else /* !USE_LUA */
+
+/**
+ * @brief 故事使用了脚本时提示一次
+ */
+static void warn_disabled(const char *code) {
+    static bool warned = false;
+    if (code != NULL && !warned) {
+        printf("[vn] 未启用 Lua（USE_LUA），故事中的脚本被忽略\n");
+        warned = true;
+    }
+}
+
+bool vn_script_init(story_config_t *story, const char *story_path) {
+    (void)story;
+    (void)story_path;
+    return false;
+}
+
+void vn_script_enter(const page_config_t *page) {
+    warn_disabled(page->script);
+}
+
+bool vn_script_run(const char *code, const char *name) {
+    (void)name;
+    warn_disabled(code);
+    return code == NULL;
+}
+
+bool vn_script_test(const char *expr, const char *name) {
+    (void)name;
+    warn_disabled(expr);
+    return true;
+}
+
+int vn_script_jump(const char *expr, const char *name) {
+    (void)name;
+    warn_disabled(expr);
+    return -1;
+}
+
+char *vn_script_save_vars(size_t *size) {
+    *size = 0;
+    return NULL;
+}
+
+bool vn_script_load_vars(const char *src, size_t size) {
+    (void)src;
+    (void)size;
+    return false;
+}
+
+void vn_script_reset(void) {
+}
+
+void vn_script_deinit(void) {
+}
+
+#endif /* USE_LUA */
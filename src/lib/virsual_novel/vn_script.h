@@ -0,0 +1,104 @@
+/**
+ * @file vn_script.h
+ * @brief 视觉小说 Lua 脚本头文件
+ *
+ * 故事中的脚本都在同一个常驻的 lua_State 中执行，只打开基础库（去掉 load/dofile 等）、
+ * string、math、table 和 utf8 库。脚本可以使用的全局变量：
+ *   v            变量表，存档时保存（只保存字符串键，值为布尔、数字或字符串）
+ *   page         当前页面ID
+ *   visited(id)  页面是否已读
+ *   sched        分时执行的任务（sched.spawn 等，见 lua_sched.h）
+ * lua_State 使用 lua_alloc 的池分配器，内存不超过 VN_SCRIPT_MEM_LIMIT。
+ * 页面脚本和表达式不能挂起，执行超过 LUA_SCHED_CALL_LIMIT_US 时中止；
+ * 耗时的工作（如逐帧的效果）应放到 sched.spawn 创建的任务中。
+ *
+ * 每段脚本第一次执行时编译为函数，按 类型+源码 的64位哈希值缓存在注册表中，
+ * 之后每次执行只是一次表查找和 lua_pcall。初始化时把故事中所有脚本编译到一个
+ * 代码块中，用 lua_dump 保存为与故事同名的 .luac 文件，下次启动直接加载字节码，
+ * 不再编译；文件头中的 Lua 版本或故事哈希值不一致时不加载，脚本修改后会重新生成缓存。
+ * 按需解析的大故事不预先编译。
+ *
+ * 需要完整的 Lua 运行时，编译时定义 USE_LUA=1 才启用（CMake 选项 V833_ENABLE_LUA）；
+ * 未启用时条件总是成立，脚本和计算跳转被忽略。
+ *
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef VN_SCRIPT_H
+#define VN_SCRIPT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "data_parser.h"
+
+#ifndef USE_LUA
+#define USE_LUA 0
+#endif
+
+#define VN_SCRIPT_EXTENSION ".luac"     /**< 与故事同名的字节码缓存 */
+#define VN_SCRIPT_MEM_LIMIT (2 * 1024 * 1024)   /**< 脚本内存上限，超过时先紧急回收，仍不够时脚本出错 */
+
+/**
+ * @brief 创建 lua_State 并加载（或生成）故事的字节码缓存
+ * @param story 故事配置（visited 按页面ID查找索引）
+ * @param story_path 故事文件路径
+ * @return 是否成功
+ */
+bool vn_script_init(story_config_t *story, const char *story_path);
+
+/**
+ * @brief 进入页面：设置 page 并执行页面脚本
+ * @param page 页面配置
+ */
+void vn_script_enter(const page_config_t *page);
+
+/**
+ * @brief 执行一段脚本
+ * @param code Lua 代码，NULL 时什么也不做
+ * @param name 出错时显示的名称（通常是页面ID）
+ * @return 是否执行成功
+ */
+bool vn_script_run(const char *code, const char *name);
+
+/**
+ * @brief 计算条件表达式
+ * @param expr Lua 表达式，NULL 表示总是成立
+ * @param name 出错时显示的名称
+ * @return 条件是否成立，出错时返回false
+ */
+bool vn_script_test(const char *expr, const char *name);
+
+/**
+ * @brief 计算跳转表达式，结果为页面ID
+ * @param expr Lua 表达式
+ * @param name 出错时显示的名称
+ * @return 页面索引，结果为 nil/false、页面不存在或出错时返回-1
+ */
+int vn_script_jump(const char *expr, const char *name);
+
+/**
+ * @brief 把变量表 v 序列化为 Lua 源码（用于存档）
+ * @param size 输出长度
+ * @return 源码，用 free() 释放；没有变量或未启用时返回NULL
+ */
+char *vn_script_save_vars(size_t *size);
+
+/**
+ * @brief 从存档恢复变量表 v（在空环境中执行，只能构造表）
+ * @param src vn_script_save_vars 生成的源码，NULL 表示清空变量
+ * @param size 长度
+ * @return 是否成功
+ */
+bool vn_script_load_vars(const char *src, size_t size);
+
+/**
+ * @brief 清空变量（重新开始故事）
+ */
+void vn_script_reset(void);
+
+/**
+ * @brief 关闭 lua_State
+ */
+void vn_script_deinit(void);
+
+#endif /* VN_SCRIPT_H */
@@ -0,0 +1,180 @@
+/**
+ * @file vn_sprite_pool.c
+ * @brief 视觉小说角色图片对象池实现
+ *
+ * 每个对象记录最近一次设置的属性，只有属性变化时才调用 LVGL 接口
+ * （这些接口会使对象区域失效并触发重绘）。本页没有用到的对象优先分配给新角色，
+ * 其中最久未使用的先被复用，这样短暂离场的角色回来时仍可能匹配到原来的对象。
+ */
+
+#include "vn_sprite_pool.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief 池中的角色对象
+ */
+typedef struct {
+    lv_obj_t *obj;
+    char key[VN_SPRITE_KEY_MAX];    /**< 角色ID，空字符串表示从未使用 */
+    uint32_t hash;                  /**< 角色ID哈希值 */
+    const void *src;                /**< 当前图片 */
+    int x;
+    int y;
+    int scale;
+    bool shown;                     /**< 对象当前没有隐藏 */
+    int order;                      /**< 本页中的层叠顺序，-1表示本页未使用 */
+    uint32_t last_page;             /**< 最近使用的页序号 */
+} vn_sprite_t;
+
+static vn_sprite_t sprites[VN_SPRITE_POOL_MAX];
+static int sprite_count = 0;
+static int32_t base_index = 0;      /**< 第一个角色对象在父对象中的下标 */
+static int page_order = 0;          /**< 本页已显示的角色数 */
+static uint32_t page_serial = 0;
+
+static uint32_t key_hash(const char *key) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < VN_SPRITE_KEY_MAX - 1 && key[i]; i++) {
+        h ^= (uint8_t)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool vn_sprite_pool_init(lv_obj_t *parent) {
+    vn_sprite_pool_deinit();
+
+    base_index = (int32_t)lv_obj_get_child_count(parent);
+    for (int i = 0; i < VN_SPRITE_POOL_MAX; i++) {
+        lv_obj_t *obj = lv_image_create(parent);
+        if (obj == NULL) {
+            printf("[vn] 角色对象创建失败\n");
+            vn_sprite_pool_deinit();
+            return false;
+        }
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_set_style_transform_scale(obj, 256, 0);
+
+        vn_sprite_t *s = &sprites[i];
+        s->obj = obj;
+        s->scale = 256;
+        s->order = -1;
+        sprite_count++;
+    }
+    return true;
+}
+
+void vn_sprite_pool_begin(void) {
+    page_serial++;
+    page_order = 0;
+    for (int i = 0; i < sprite_count; i++) {
+        sprites[i].order = -1;
+    }
+}
+
+/**
+ * @brief 查找本页尚未使用的对象：优先同一角色，其次从未使用的，最后最久未使用的
+ */
+static vn_sprite_t *find_sprite(const char *key, uint32_t hash) {
+    vn_sprite_t *free_sprite = NULL;
+    for (int i = 0; i < sprite_count; i++) {
+        vn_sprite_t *s = &sprites[i];
+        if (s->order >= 0) {
+            continue;
+        }
+        if (s->hash == hash && s->key[0] != '\0' && strncmp(s->key, key, VN_SPRITE_KEY_MAX - 1) == 0) {
+            return s;
+        }
+        if (free_sprite == NULL ||
+            (free_sprite->key[0] != '\0' && (s->key[0] == '\0' || s->last_page < free_sprite->last_page))) {
+            free_sprite = s;
+        }
+    }
+    return free_sprite;
+}
+
+bool vn_sprite_pool_show(const char *key, const void *src, int x, int y, int scale, bool visible) {
+    if (key == NULL) {
+        key = "";
+    }
+    uint32_t hash = key_hash(key);
+    vn_sprite_t *s = find_sprite(key, hash);
+    if (s == NULL) {
+        printf("[vn] 每页最多显示 %d 个角色，忽略 %s\n", VN_SPRITE_POOL_MAX, key);
+        return false;
+    }
+
+    if (s->hash != hash || strncmp(s->key, key, VN_SPRITE_KEY_MAX - 1) != 0) {
+        snprintf(s->key, sizeof(s->key), "%s", key);
+        s->hash = hash;
+    }
+    s->order = page_order++;
+    s->last_page = page_serial;
+
+    // 只更新变化的属性
+    if (s->src != src) {
+        lv_image_set_src(s->obj, src);
+        s->src = src;
+    }
+    if (s->x != x || s->y != y) {
+        lv_obj_set_pos(s->obj, x, y);
+        s->x = x;
+        s->y = y;
+    }
+    if (s->scale != scale) {
+        lv_obj_set_style_transform_scale(s->obj, scale, 0);
+        s->scale = scale;
+    }
+
+    // 按调用顺序层叠：之前的角色已放在更小的下标上，移动本对象不会影响它们
+    int32_t index = base_index + s->order;
+    if (lv_obj_get_index(s->obj) != index) {
+        lv_obj_move_to_index(s->obj, index);
+    }
+
+    bool show = visible && src != NULL;
+    if (show != s->shown) {
+        if (show) {
+            lv_obj_clear_flag(s->obj, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_add_flag(s->obj, LV_OBJ_FLAG_HIDDEN);
+        }
+        s->shown = show;
+    }
+    return true;
+}
+
+void vn_sprite_pool_end(void) {
+    for (int i = 0; i < sprite_count; i++) {
+        vn_sprite_t *s = &sprites[i];
+        if (s->order >= 0) {
+            continue;
+        }
+        if (s->shown) {
+            lv_obj_add_flag(s->obj, LV_OBJ_FLAG_HIDDEN);
+            s->shown = false;
+        }
+        // 图片资源随页面释放，隐藏的对象不能继续引用
+        if (s->src != NULL) {
+            lv_image_set_src(s->obj, NULL);
+            s->src = NULL;
+        }
+    }
+}
+
+void vn_sprite_pool_hide_all(void) {
+    vn_sprite_pool_begin();
+    vn_sprite_pool_end();
+}
+
+void vn_sprite_pool_deinit(void) {
+    for (int i = 0; i < sprite_count; i++) {
+        if (sprites[i].obj != NULL) {
+            lv_obj_del(sprites[i].obj);
+        }
+    }
+    memset(sprites, 0, sizeof(sprites));
+    sprite_count = 0;
+    page_order = 0;
+}
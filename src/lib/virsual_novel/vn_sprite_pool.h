@@ -0,0 +1,62 @@
+/**
+ * @file vn_sprite_pool.h
+ * @brief 视觉小说角色图片对象池头文件
+ *
+ * 初始化时一次创建 VN_SPRITE_POOL_MAX 个隐藏的图片对象，翻页时按角色ID复用，
+ * 不再创建/删除 LVGL 对象。同一角色在相邻页面中保留同一个对象，只更新变化的
+ * 图片、位置、缩放、可见性和层叠顺序，LVGL 只重绘实际变化的区域。
+ *
+ * 每页的用法：vn_sprite_pool_begin()，按层叠顺序对每个角色调用
+ * vn_sprite_pool_show()，最后 vn_sprite_pool_end() 隐藏本页没有用到的对象。
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef VN_SPRITE_POOL_H
+#define VN_SPRITE_POOL_H
+
+#include <stdbool.h>
+#include "lvgl/lvgl.h"
+
+#define VN_SPRITE_POOL_MAX  16      /**< 对象池大小（每页最多显示的角色数） */
+#define VN_SPRITE_KEY_MAX   64      /**< 角色ID最大长度（超出部分不参与匹配） */
+
+/**
+ * @brief 创建对象池
+ * @param parent 父对象，角色对象位于其已有子对象之上（应在创建文本框之前调用）
+ * @return 是否成功
+ */
+bool vn_sprite_pool_init(lv_obj_t *parent);
+
+/**
+ * @brief 开始一页
+ */
+void vn_sprite_pool_begin(void);
+
+/**
+ * @brief 显示一个角色，按调用顺序从下到上层叠
+ * @param key 角色ID（为空时用图片路径）
+ * @param src 图片（lv_image_dsc_t），NULL 表示没有图片
+ * @param x X坐标
+ * @param y Y坐标
+ * @param scale 缩放（256 为原始大小）
+ * @param visible 是否可见
+ * @return 是否成功，本页角色数超过 VN_SPRITE_POOL_MAX 时返回false
+ */
+bool vn_sprite_pool_show(const char *key, const void *src, int x, int y, int scale, bool visible);
+
+/**
+ * @brief 结束一页：隐藏本页没有用到的对象并清除其图片引用
+ */
+void vn_sprite_pool_end(void);
+
+/**
+ * @brief 隐藏所有角色
+ */
+void vn_sprite_pool_hide_all(void);
+
+/**
+ * @brief 删除对象池中的对象
+ */
+void vn_sprite_pool_deinit(void);
+
+#endif /* VN_SPRITE_POOL_H */
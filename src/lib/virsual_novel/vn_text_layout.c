@@ -0,0 +1,538 @@
+/**
+ * @file vn_text_layout.c
+ * @brief 视觉小说文本排版缓存实现
+ *
+ * 排版只调用 lv_font_get_glyph_width 测量字宽（含字距调整），与 LVGL 绘制时
+ * 使用的宽度一致。每个排版结果是一整块内存：结构体、行数组和各行文本依次存放。
+ */
+
+#include "vn_text_layout.h"
+#include "resource_manager.h"
+#include "../font_atlas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static vn_text_layout_t *cache[VN_TEXT_LAYOUT_CACHE];
+static uint32_t use_clock = 0;
+
+/**
+ * @brief 已加载的 字体+字号（加载失败也记录，避免每页重试）
+ */
+typedef struct {
+    char *path;
+    int size;
+    lv_font_t *font;
+} loaded_font_t;
+
+static loaded_font_t loaded_fonts[VN_TEXT_FONT_MAX];
+static int loaded_font_count = 0;
+static char *glyph_set_path = NULL;
+
+/*=====================
+ * 字体
+ *====================*/
+
+typedef struct {
+    int size;
+    const lv_font_t *font;
+} builtin_font_t;
+
+static const builtin_font_t builtin_fonts[] = {
+#if LV_FONT_MONTSERRAT_8
+    { 8, &lv_font_montserrat_8 },
+#endif
+#if LV_FONT_MONTSERRAT_10
+    { 10, &lv_font_montserrat_10 },
+#endif
+#if LV_FONT_MONTSERRAT_12
+    { 12, &lv_font_montserrat_12 },
+#endif
+#if LV_FONT_MONTSERRAT_14
+    { 14, &lv_font_montserrat_14 },
+#endif
+#if LV_FONT_MONTSERRAT_16
+    { 16, &lv_font_montserrat_16 },
+#endif
+#if LV_FONT_MONTSERRAT_18
+    { 18, &lv_font_montserrat_18 },
+#endif
+#if LV_FONT_MONTSERRAT_20
+    { 20, &lv_font_montserrat_20 },
+#endif
+#if LV_FONT_MONTSERRAT_22
+    { 22, &lv_font_montserrat_22 },
+#endif
+#if LV_FONT_MONTSERRAT_24
+    { 24, &lv_font_montserrat_24 },
+#endif
+#if LV_FONT_MONTSERRAT_26
+    { 26, &lv_font_montserrat_26 },
+#endif
+#if LV_FONT_MONTSERRAT_28
+    { 28, &lv_font_montserrat_28 },
+#endif
+#if LV_FONT_MONTSERRAT_30
+    { 30, &lv_font_montserrat_30 },
+#endif
+#if LV_FONT_MONTSERRAT_32
+    { 32, &lv_font_montserrat_32 },
+#endif
+#if LV_FONT_MONTSERRAT_36
+    { 36, &lv_font_montserrat_36 },
+#endif
+#if LV_FONT_MONTSERRAT_40
+    { 40, &lv_font_montserrat_40 },
+#endif
+#if LV_FONT_MONTSERRAT_48
+    { 48, &lv_font_montserrat_48 },
+#endif
+    { 0, NULL }
+};
+
+static const lv_font_t *builtin_font(int font_size) {
+    const lv_font_t *best = LV_FONT_DEFAULT;
+    int best_diff = -1;
+    for (int i = 0; builtin_fonts[i].font != NULL; i++) {
+        int diff = abs(builtin_fonts[i].size - font_size);
+        if (best_diff < 0 || diff < best_diff) {
+            best = builtin_fonts[i].font;
+            best_diff = diff;
+        }
+    }
+    return best;
+}
+
+const lv_font_t *vn_text_font(const char *path, int font_size) {
+    const lv_font_t *builtin = builtin_font(font_size);
+    if (path == NULL || path[0] == '\0' || font_size <= 0) {
+        return builtin;
+    }
+
+    for (int i = 0; i < loaded_font_count; i++) {
+        loaded_font_t *lf = &loaded_fonts[i];
+        if (lf->size == font_size && strcmp(lf->path, path) == 0) {
+            return lf->font ? lf->font : builtin;
+        }
+    }
+    if (loaded_font_count >= VN_TEXT_FONT_MAX) {
+        return builtin;
+    }
+
+    // 同一字体的不同字号是不同的资源
+    char id[512];
+    snprintf(id, sizeof(id), "%s@%d", path, font_size);
+    lv_font_t *font = resource_manager_load_font(id, path, font_size);
+    if (font != NULL) {
+        font->fallback = builtin;
+        if (glyph_set_path != NULL) {
+            int n = font_atlas_warm_file(font, glyph_set_path);
+            if (n >= 0) {
+                printf("[vn] 预先光栅化 %d 个字形: %s@%d\n", n, path, font_size);
+            }
+        }
+    }
+
+    loaded_font_t *lf = &loaded_fonts[loaded_font_count];
+    lf->path = strdup(path);
+    if (lf->path == NULL) {
+        return font ? font : builtin;
+    }
+    lf->size = font_size;
+    lf->font = font;
+    loaded_font_count++;
+    return font ? font : builtin;
+}
+
+void vn_text_set_glyph_set(const char *path) {
+    free(glyph_set_path);
+    glyph_set_path = path ? strdup(path) : NULL;
+}
+
+void vn_text_style_from_textbox(vn_text_style_t *style, const textbox_config_t *textbox) {
+    style->font = vn_text_font(textbox->font, textbox->font_size);
+    style->max_width = textbox->width - 2 * VN_TEXTBOX_PADDING;
+    style->letter_space = 0;
+    style->line_space = 0;
+}
+
+/*=====================
+ * 断行
+ *====================*/
+
+static bool is_cjk(uint32_t cp) {
+    return (cp >= 0x2E80 && cp <= 0x9FFF) ||     // 部首、标点、假名、汉字
+           (cp >= 0xAC00 && cp <= 0xD7AF) ||     // 谚文
+           (cp >= 0xF900 && cp <= 0xFAFF) ||     // 兼容汉字
+           (cp >= 0xFF00 && cp <= 0xFFEF) ||     // 全角字符
+           (cp >= 0x20000 && cp <= 0x3FFFF);     // 扩展汉字
+}
+
+/**
+ * @brief 不能放在行首的字符
+ */
+static bool no_line_start(uint32_t cp) {
+    static const uint32_t chars[] = {
+        ',', '.', '!', '?', ':', ';', ')', ']', '}',
+        0x3001, 0x3002, 0xFF0C, 0xFF0E, 0xFF01, 0xFF1F, 0xFF1A, 0xFF1B,     // 、。，．！？：；
+        0xFF09, 0x300D, 0x300F, 0x3011, 0x300B, 0x3009, 0x3015, 0xFF5D,     // ）」』】》〉〕｝
+        0x2026, 0x2014, 0x30FC, 0x3005, 0x201D, 0x2019,                     // …—ー々”’
+        0x3041, 0x3043, 0x3045, 0x3047, 0x3049, 0x3063, 0x3083, 0x3085, 0x3087,     // 小写平假名
+        0x30A1, 0x30A3, 0x30A5, 0x30A7, 0x30A9, 0x30C3, 0x30E3, 0x30E5, 0x30E7,     // 小写片假名
+    };
+    for (size_t i = 0; i < sizeof(chars) / sizeof(chars[0]); i++) {
+        if (chars[i] == cp) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 不能放在行尾的字符
+ */
+static bool no_line_end(uint32_t cp) {
+    static const uint32_t chars[] = {
+        '(', '[', '{',
+        0xFF08, 0x300C, 0x300E, 0x3010, 0x300A, 0x3008, 0x3014, 0xFF5B,     // （「『【《〈〔｛
+        0x201C, 0x2018,                                                     // “‘
+    };
+    for (size_t i = 0; i < sizeof(chars) / sizeof(chars[0]); i++) {
+        if (chars[i] == cp) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t text_hash(const char *text, size_t len) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)text[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/**
+ * @brief 断行时记录的一行：原文中的字节范围和宽度
+ */
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    int32_t width;
+} line_span_t;
+
+vn_text_layout_t *vn_text_layout_create(const char *text, const vn_text_style_t *style) {
+    if (text == NULL) {
+        text = "";
+    }
+    const lv_font_t *font = style->font;
+    uint32_t len = (uint32_t)strlen(text);
+
+    // 每行至少一个字符或一个换行符
+    line_span_t *spans = (line_span_t *)malloc(sizeof(line_span_t) * (len + 1));
+    if (spans == NULL) {
+        return NULL;
+    }
+    uint32_t count = 0;
+
+    int64_t line_start = -1;    // 本行第一个字符的位置，-1表示本行还没有字符
+    uint32_t last_end = 0;      // 本行最后一个非空白字符之后的位置
+    int32_t last_width = 0;     // 到该字符为止的行宽
+    int64_t brk_pos = -1;       // 最近的断行机会：下一行从这里开始
+    uint32_t brk_end = 0;       // 在此断行时本行的结束位置和宽度
+    int32_t brk_width = 0;
+    int32_t x = 0;
+    uint32_t prev_cp = 0;
+    uint32_t i = 0;
+
+    while (i < len) {
+        uint32_t pos = i;
+        uint32_t cp = lv_text_encoded_next(text, &i);
+        if (cp == '\r') {
+            continue;
+        }
+        if (cp == '\n') {
+            spans[count].start = line_start >= 0 ? (uint32_t)line_start : pos;
+            spans[count].end = line_start >= 0 ? last_end : pos;
+            spans[count].width = line_start >= 0 ? last_width : 0;
+            count++;
+            line_start = -1;
+            brk_pos = -1;
+            continue;
+        }
+
+        bool space = cp == ' ' || cp == '\t';
+        if (line_start < 0) {
+            if (space) {
+                continue;   // 行首空白不显示
+            }
+            line_start = pos;
+            x = 0;
+            last_end = pos;
+            last_width = 0;
+            prev_cp = 0;
+        }
+
+        uint32_t next_i = i;
+        uint32_t next_cp = i < len ? lv_text_encoded_next(text, &next_i) : 0;
+        int32_t w = (int32_t)lv_font_get_glyph_width(font, cp, next_cp);
+
+        if (space) {
+            // 空白之后可以断行，行尾空白不计入行宽
+            brk_pos = i;
+            brk_end = last_end;
+            brk_width = last_width;
+            x += w + style->letter_space;
+            prev_cp = cp;
+            continue;
+        }
+
+        // 中日韩文字前后可以断行（避头尾）
+        if (pos > (uint32_t)line_start && prev_cp != ' ' && prev_cp != '\t' &&
+            (is_cjk(cp) || is_cjk(prev_cp)) && !no_line_start(cp) && !no_line_end(prev_cp)) {
+            brk_pos = pos;
+            brk_end = last_end;
+            brk_width = last_width;
+        }
+
+        if (x + w > style->max_width && pos > (uint32_t)line_start) {
+            if (brk_pos > line_start) {
+                // 在最近的断行机会处换行，从那里重新测量下一行
+                spans[count].start = (uint32_t)line_start;
+                spans[count].end = brk_end;
+                spans[count].width = brk_width;
+                count++;
+                i = (uint32_t)brk_pos;
+                line_start = -1;
+                brk_pos = -1;
+                continue;
+            }
+
+            // 没有断行机会（过长的单词）：在当前字符前断开
+            spans[count].start = (uint32_t)line_start;
+            spans[count].end = last_end;
+            spans[count].width = last_width;
+            count++;
+            line_start = pos;
+            x = 0;
+            brk_pos = -1;
+        }
+
+        x += w;
+        last_end = i;
+        last_width = x;
+        x += style->letter_space;
+        prev_cp = cp;
+    }
+    if (line_start >= 0) {
+        spans[count].start = (uint32_t)line_start;
+        spans[count].end = last_end;
+        spans[count].width = last_width;
+        count++;
+    }
+
+    // 结构体、行数组、行文本和原文放在同一块内存中
+    size_t text_bytes = len + 1;
+    for (uint32_t l = 0; l < count; l++) {
+        text_bytes += spans[l].end - spans[l].start + 1;
+    }
+    size_t bytes = sizeof(vn_text_layout_t) + sizeof(vn_text_line_t) * count + text_bytes;
+    vn_text_layout_t *layout = (vn_text_layout_t *)calloc(1, bytes);
+    if (layout == NULL) {
+        free(spans);
+        return NULL;
+    }
+    layout->style = *style;
+    layout->text_hash = text_hash(text, len);
+    layout->text_len = len;
+    layout->line_height = lv_font_get_line_height(font) + style->line_space;
+    layout->line_count = count;
+    layout->lines = (vn_text_line_t *)(layout + 1);
+    layout->text = (char *)(layout->lines + count);
+    layout->bytes = bytes;
+    // 原文放在各行文本之后
+    char *source = layout->text + text_bytes - (len + 1);
+    memcpy(source, text, len + 1);
+    layout->source = source;
+
+    char *dst = layout->text;
+    for (uint32_t l = 0; l < count; l++) {
+        uint32_t n = spans[l].end - spans[l].start;
+        memcpy(dst, text + spans[l].start, n);
+        dst[n] = '\0';
+        layout->lines[l].text_off = (uint32_t)(dst - layout->text);
+        layout->lines[l].width = spans[l].width;
+        if (spans[l].width > layout->width) {
+            layout->width = spans[l].width;
+        }
+        dst += n + 1;
+    }
+    layout->height = count > 0 ? layout->line_height * (int32_t)count - style->line_space : 0;
+
+    free(spans);
+    return layout;
+}
+
+void vn_text_layout_free(vn_text_layout_t *layout) {
+    free(layout);
+}
+
+/*=====================
+ * 缓存
+ *====================*/
+
+static bool style_equal(const vn_text_style_t *a, const vn_text_style_t *b) {
+    return a->font == b->font && a->max_width == b->max_width &&
+           a->letter_space == b->letter_space && a->line_space == b->line_space;
+}
+
+// 哈希和长度相同时再比较原文，哈希冲突不会返回别的文本的排版
+static int find_slot(const char *text, uint64_t hash, size_t len, const vn_text_style_t *style) {
+    for (int i = 0; i < VN_TEXT_LAYOUT_CACHE; i++) {
+        vn_text_layout_t *l = cache[i];
+        if (l != NULL && l->text_hash == hash && l->text_len == len && style_equal(&l->style, style) &&
+            memcmp(l->source, text, len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool vn_text_layout_contains(const char *text, const vn_text_style_t *style) {
+    if (text == NULL) {
+        text = "";
+    }
+    size_t len = strlen(text);
+    return find_slot(text, text_hash(text, len), len, style) >= 0;
+}
+
+bool vn_text_layout_insert(vn_text_layout_t *layout) {
+    if (layout == NULL ||
+        find_slot(layout->source, layout->text_hash, layout->text_len, &layout->style) >= 0) {
+        return false;
+    }
+
+    // 空槽优先，其次淘汰最久未使用且没有引用的
+    int victim = -1;
+    for (int i = 0; i < VN_TEXT_LAYOUT_CACHE; i++) {
+        if (cache[i] == NULL) {
+            victim = i;
+            break;
+        }
+        if (cache[i]->ref_count == 0 && (victim < 0 || cache[i]->last_used < cache[victim]->last_used)) {
+            victim = i;
+        }
+    }
+    if (victim < 0) {
+        return false;
+    }
+    if (cache[victim] != NULL) {
+        vn_text_layout_free(cache[victim]);
+    }
+
+    layout->cached = true;
+    layout->last_used = ++use_clock;
+    cache[victim] = layout;
+    return true;
+}
+
+vn_text_layout_t *vn_text_layout_acquire(const char *text, const vn_text_style_t *style) {
+    if (text == NULL) {
+        text = "";
+    }
+    size_t len = strlen(text);
+    int slot = find_slot(text, text_hash(text, len), len, style);
+    vn_text_layout_t *layout;
+    if (slot >= 0) {
+        layout = cache[slot];
+        layout->last_used = ++use_clock;
+    } else {
+        layout = vn_text_layout_create(text, style);
+        if (layout == NULL) {
+            return NULL;
+        }
+        vn_text_layout_insert(layout);
+    }
+    layout->ref_count++;
+    return layout;
+}
+
+void vn_text_layout_retain(vn_text_layout_t *layout) {
+    if (layout != NULL) {
+        layout->ref_count++;
+        layout->last_used = ++use_clock;
+    }
+}
+
+void vn_text_layout_release(vn_text_layout_t *layout) {
+    if (layout == NULL) {
+        return;
+    }
+    layout->ref_count--;
+    if (layout->ref_count <= 0 && !layout->cached) {
+        vn_text_layout_free(layout);
+    }
+}
+
+void vn_text_layout_cache_clear(void) {
+    for (int i = 0; i < VN_TEXT_LAYOUT_CACHE; i++) {
+        vn_text_layout_t *layout = cache[i];
+        if (layout == NULL) {
+            continue;
+        }
+        layout->cached = false;
+        if (layout->ref_count <= 0) {
+            vn_text_layout_free(layout);
+        }
+        cache[i] = NULL;
+    }
+
+    for (int i = 0; i < loaded_font_count; i++) {
+        free(loaded_fonts[i].path);
+    }
+    memset(loaded_fonts, 0, sizeof(loaded_fonts));
+    loaded_font_count = 0;
+    vn_text_set_glyph_set(NULL);
+}
+
+/*=====================
+ * 绘制
+ *====================*/
+
+void vn_text_layout_draw(lv_layer_t *layer, const vn_text_layout_t *layout, const lv_area_t *coords,
+                         const lv_area_t *clip, lv_color_t color, lv_opa_t opa) {
+    if (layout == NULL || layout->line_count == 0) {
+        return;
+    }
+
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.font = layout->style.font;
+    dsc.color = color;
+    dsc.opa = opa;
+    dsc.letter_space = layout->style.letter_space;
+    dsc.flag = LV_TEXT_FLAG_EXPAND;     // 已经断好行，绘制时不再换行
+
+    int32_t font_h = lv_font_get_line_height(layout->style.font);
+    for (uint32_t i = 0; i < layout->line_count; i++) {
+        lv_area_t area;
+        area.x1 = coords->x1;
+        area.x2 = coords->x2;
+        area.y1 = coords->y1 + (int32_t)i * layout->line_height;
+        area.y2 = area.y1 + font_h - 1;
+        if (clip != NULL && area.y2 < clip->y1) {
+            continue;
+        }
+        if (clip != NULL && area.y1 > clip->y2) {
+            break;
+        }
+        const char *line = layout->text + layout->lines[i].text_off;
+        if (line[0] == '\0') {
+            continue;
+        }
+        dsc.text = line;
+        lv_draw_label(layer, &dsc, &area);
+    }
+}
@@ -0,0 +1,151 @@
+/**
+ * @file vn_text_layout.h
+ * @brief 视觉小说文本排版缓存头文件
+ *
+ * 按文本框宽度和实际字号把页面文字预先断行，保存每一行的文本和宽度。
+ * 绘制时每行直接调用一次 lv_draw_label（不再换行、不再缩放图层），
+ * 排版结果按 文本+字体+宽度 缓存，预取模块会提前为后续页面排版。
+ *
+ * 断行规则：遇到 '\n' 换行；西文在空格处断开，单词超过行宽时按字符断开；
+ * 中日韩文字之间可以断开，但行首不放置 "，。！？）」" 等标点、
+ * 行尾不放置 "（「《" 等标点（避头尾）。
+ *
+ * 所有接口只能在 LVGL 主线程调用：测量字宽会读写字体内部的字形缓存，不是线程安全的。
+ */
+
+#ifndef VN_TEXT_LAYOUT_H
+#define VN_TEXT_LAYOUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "lvgl/lvgl.h"
+#include "data_parser.h"
+
+#define VN_TEXT_LAYOUT_CACHE    8       /**< 缓存的排版数量 */
+#define VN_TEXTBOX_PADDING      10      /**< 文本框内边距 */
+#define VN_TEXT_FONT_MAX        4       /**< 故事中最多使用的 字体+字号 组合 */
+
+/**
+ * @brief 排版参数（作为缓存键的一部分）
+ */
+typedef struct {
+    const lv_font_t *font;
+    int32_t max_width;      /**< 行宽上限（像素） */
+    int32_t letter_space;
+    int32_t line_space;
+} vn_text_style_t;
+
+/**
+ * @brief 一行文本
+ */
+typedef struct {
+    uint32_t text_off;      /**< 行文本在 text 中的偏移（以 '\0' 结尾，不含行尾空格） */
+    int32_t width;          /**< 行宽（像素） */
+} vn_text_line_t;
+
+/**
+ * @brief 排版结果
+ */
+typedef struct {
+    vn_text_style_t style;
+    uint64_t text_hash;     /**< 原文哈希值 */
+    size_t text_len;        /**< 原文长度 */
+    const char *source;     /**< 原文副本（哈希相同时比较，确认缓存命中） */
+    int32_t line_height;    /**< 行距（字体行高 + line_space） */
+    int32_t width;          /**< 最宽行的宽度 */
+    int32_t height;         /**< 总高度 */
+    uint32_t line_count;
+    vn_text_line_t *lines;
+    char *text;             /**< 各行文本，依次以 '\0' 分隔 */
+    size_t bytes;           /**< 占用字节数 */
+    int ref_count;          /**< 引用计数，大于0时不会被淘汰 */
+    bool cached;            /**< 是否在缓存中 */
+    uint32_t last_used;
+} vn_text_layout_t;
+
+/**
+ * @brief 选择字体：指定字体文件时通过资源管理器按字号加载 TTF/OTF 字体，
+ * 否则（或加载失败时）使用 lv_conf.h 中启用的最接近的 Montserrat 字号，
+ * 都未启用时使用 LV_FONT_DEFAULT。TTF 字体缺少的字形回退到该内置字体
+ * @param path 字体文件路径，NULL 或空字符串表示使用内置字体
+ * @param font_size 字号
+ * @return 字体
+ */
+const lv_font_t *vn_text_font(const char *path, int font_size);
+
+/**
+ * @brief 设置字形集文件，之后首次加载的 TTF 字体会预先光栅化其中的字形
+ * @param path 字形集文件路径，NULL 表示不预先光栅化
+ */
+void vn_text_set_glyph_set(const char *path);
+
+/**
+ * @brief 根据文本框配置计算排版参数（引擎和预取使用同一套参数，才能命中缓存）
+ * @param style 输出
+ * @param textbox 文本框配置
+ */
+void vn_text_style_from_textbox(vn_text_style_t *style, const textbox_config_t *textbox);
+
+/**
+ * @brief 排版（不使用缓存）
+ * @param text UTF-8 文本
+ * @param style 排版参数
+ * @return 排版结果，失败返回NULL
+ */
+vn_text_layout_t *vn_text_layout_create(const char *text, const vn_text_style_t *style);
+
+/**
+ * @brief 释放不在缓存中的排版结果
+ */
+void vn_text_layout_free(vn_text_layout_t *layout);
+
+/**
+ * @brief 获取排版结果并增加引用计数，未缓存时立即排版
+ * @param text UTF-8 文本
+ * @param style 排版参数
+ * @return 排版结果，失败返回NULL
+ */
+vn_text_layout_t *vn_text_layout_acquire(const char *text, const vn_text_style_t *style);
+
+/**
+ * @brief 增加一次引用（已持有的排版结果）
+ */
+void vn_text_layout_retain(vn_text_layout_t *layout);
+
+/**
+ * @brief 释放一次引用
+ */
+void vn_text_layout_release(vn_text_layout_t *layout);
+
+/**
+ * @brief 排版结果是否已在缓存中
+ */
+bool vn_text_layout_contains(const char *text, const vn_text_style_t *style);
+
+/**
+ * @brief 把预先计算的排版结果放入缓存
+ * @param layout 排版结果，成功时由缓存接管
+ * @return 是否放入（已存在或缓存已满且都在使用时返回false）
+ */
+bool vn_text_layout_insert(vn_text_layout_t *layout);
+
+/**
+ * @brief 绘制排版结果，只绘制与裁剪区域相交的行
+ * @param layer 图层
+ * @param layout 排版结果
+ * @param coords 文本区域（左上角为第一行的位置）
+ * @param clip 可见区域（通常由 lv_obj_area_is_visible 计算），NULL 表示绘制所有行
+ * @param color 文字颜色
+ * @param opa 不透明度
+ */
+void vn_text_layout_draw(lv_layer_t *layer, const vn_text_layout_t *layout, const lv_area_t *coords,
+                         const lv_area_t *clip, lv_color_t color, lv_opa_t opa);
+
+/**
+ * @brief 清空缓存（正在使用的排版在释放最后一个引用时删除），并忘记已加载的字体
+ * （字体本身由资源管理器释放）
+ */
+void vn_text_layout_cache_clear(void);
+
+#endif /* VN_TEXT_LAYOUT_H */
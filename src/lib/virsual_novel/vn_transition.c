@@ -0,0 +1,275 @@
+/**
+ * @file vn_transition.c
+ * @brief 视觉小说页面切换效果实现
+ *
+ * 动画值从 0 到 VN_TRANSITION_STEPS，时间曲线由 lv_anim 的 path 回调实现。
+ * 每帧根据动画值把旧/新页面缓冲合成到输出缓冲，再使显示区域失效：
+ * 淡入淡出和推入整屏失效，擦除只使本帧新露出的竖条失效。
+ */
+
+#include "vn_transition.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define VN_TRANSITION_STEPS 1024    /**< 动画值范围 */
+
+enum {
+    BUF_OLD,
+    BUF_NEW,
+    BUF_OUT,
+    BUF_COUNT
+};
+
+static lv_draw_buf_t bufs[BUF_COUNT];
+static void *buf_data[BUF_COUNT];
+static int32_t buf_w = 0;
+static int32_t buf_h = 0;
+
+static lv_obj_t *overlay = NULL;    /**< 显示输出缓冲的图片对象 */
+static transition_type_t active_type = TRANSITION_NONE;
+static bool running = false;
+static int32_t last_value = -1;     /**< 上一帧的动画值 */
+static int32_t last_offset = 0;     /**< 擦除：上一帧已显示新页面的列数 */
+
+static void free_buffers(void) {
+    for (int i = 0; i < BUF_COUNT; i++) {
+        if (buf_data[i] != NULL) {
+            lv_image_cache_drop(&bufs[i]);
+            free(buf_data[i]);
+            buf_data[i] = NULL;
+        }
+    }
+    buf_w = 0;
+    buf_h = 0;
+}
+
+/**
+ * @brief 按屏幕尺寸准备离屏缓冲，尺寸不变时直接复用
+ */
+static bool alloc_buffers(int32_t w, int32_t h) {
+    if (w == buf_w && h == buf_h) {
+        return true;
+    }
+    free_buffers();
+
+    uint32_t stride = lv_draw_buf_width_to_stride((uint32_t)w, LV_COLOR_FORMAT_RGB565);
+    uint32_t size = stride * (uint32_t)h;
+    for (int i = 0; i < BUF_COUNT; i++) {
+        buf_data[i] = malloc(size);
+        if (buf_data[i] == NULL) {
+            printf("[vn] 切换效果缓冲分配失败 (%dx%d)\n", (int)w, (int)h);
+            free_buffers();
+            return false;
+        }
+        lv_draw_buf_init(&bufs[i], (uint32_t)w, (uint32_t)h, LV_COLOR_FORMAT_RGB565, stride, buf_data[i], size);
+    }
+    buf_w = w;
+    buf_h = h;
+    return true;
+}
+
+static uint16_t *buf_row(int buf, int32_t y) {
+    return (uint16_t *)(bufs[buf].data + (size_t)bufs[buf].header.stride * (size_t)y);
+}
+
+/**
+ * @brief 混合一行 RGB565 像素：dst = (a * (256 - alpha) + b * alpha) / 256，各通道分别计算
+ * @param alpha 0~256
+ */
+static void blend_row(uint16_t *dst, const uint16_t *a, const uint16_t *b, int32_t n, uint16_t alpha) {
+    uint16_t inv = (uint16_t)(256 - alpha);
+    int32_t i = 0;
+#if defined(__ARM_NEON)
+    // 每次8个像素；通道最大63，63*256 不会溢出16位
+    const uint16x8_t mask6 = vdupq_n_u16(0x3F);
+    const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t pa = vld1q_u16(a + i);
+        uint16x8_t pb = vld1q_u16(b + i);
+        uint16x8_t r = vmlaq_n_u16(vmulq_n_u16(vshrq_n_u16(pa, 11), inv), vshrq_n_u16(pb, 11), alpha);
+        uint16x8_t g = vmlaq_n_u16(vmulq_n_u16(vandq_u16(vshrq_n_u16(pa, 5), mask6), inv),
+                                   vandq_u16(vshrq_n_u16(pb, 5), mask6), alpha);
+        uint16x8_t bl = vmlaq_n_u16(vmulq_n_u16(vandq_u16(pa, mask5), inv), vandq_u16(pb, mask5), alpha);
+        r = vshlq_n_u16(vshrq_n_u16(r, 8), 11);
+        g = vshlq_n_u16(vshrq_n_u16(g, 8), 5);
+        bl = vshrq_n_u16(bl, 8);
+        vst1q_u16(dst + i, vorrq_u16(vorrq_u16(r, g), bl));
+    }
+#endif
+    for (; i < n; i++) {
+        uint32_t pa = a[i];
+        uint32_t pb = b[i];
+        uint32_t r = ((pa >> 11) * inv + (pb >> 11) * alpha) >> 8;
+        uint32_t g = (((pa >> 5) & 0x3F) * inv + ((pb >> 5) & 0x3F) * alpha) >> 8;
+        uint32_t bl = ((pa & 0x1F) * inv + (pb & 0x1F) * alpha) >> 8;
+        dst[i] = (uint16_t)((r << 11) | (g << 5) | bl);
+    }
+}
+
+static void compose_fade(int32_t value) {
+    uint16_t alpha = (uint16_t)((value * 256) / VN_TRANSITION_STEPS);
+    for (int32_t y = 0; y < buf_h; y++) {
+        blend_row(buf_row(BUF_OUT, y), buf_row(BUF_OLD, y), buf_row(BUF_NEW, y), buf_w, alpha);
+    }
+    lv_obj_invalidate(overlay);
+}
+
+/**
+ * @brief 推入：旧页面向左移出，新页面从右侧进入
+ */
+static void compose_slide(int32_t value) {
+    int32_t off = (int32_t)(((int64_t)buf_w * value) / VN_TRANSITION_STEPS);
+    size_t old_bytes = (size_t)(buf_w - off) * sizeof(uint16_t);
+    for (int32_t y = 0; y < buf_h; y++) {
+        uint16_t *out = buf_row(BUF_OUT, y);
+        memcpy(out, buf_row(BUF_OLD, y) + off, old_bytes);
+        memcpy(out + (buf_w - off), buf_row(BUF_NEW, y), (size_t)off * sizeof(uint16_t));
+    }
+    lv_obj_invalidate(overlay);
+}
+
+/**
+ * @brief 擦除：新页面从左到右覆盖旧页面，只复制和重绘变化的列
+ */
+static void compose_wipe(int32_t value) {
+    int32_t off = (int32_t)(((int64_t)buf_w * value) / VN_TRANSITION_STEPS);
+    if (off == last_offset) {
+        return;
+    }
+    int32_t x1 = off > last_offset ? last_offset : off;
+    int32_t x2 = off > last_offset ? off : last_offset;
+    int src = off > last_offset ? BUF_NEW : BUF_OLD;
+    size_t bytes = (size_t)(x2 - x1) * sizeof(uint16_t);
+    for (int32_t y = 0; y < buf_h; y++) {
+        memcpy(buf_row(BUF_OUT, y) + x1, buf_row(src, y) + x1, bytes);
+    }
+    last_offset = off;
+
+    lv_area_t area;
+    lv_obj_get_coords(overlay, &area);
+    area.x2 = area.x1 + x2 - 1;
+    area.x1 += x1;
+    lv_obj_invalidate_area(overlay, &area);
+}
+
+static void anim_exec_cb(void *var, int32_t value) {
+    (void)var;
+    if (value == last_value || overlay == NULL) {
+        return;
+    }
+    last_value = value;
+
+    switch (active_type) {
+        case TRANSITION_FADE:
+            compose_fade(value);
+            break;
+        case TRANSITION_SLIDE:
+            compose_slide(value);
+            break;
+        case TRANSITION_WIPE:
+            compose_wipe(value);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 删除覆盖层，露出已更新的页面控件
+ */
+static void cleanup(void) {
+    if (overlay != NULL) {
+        lv_obj_delete(overlay);
+        overlay = NULL;
+    }
+    lv_image_cache_drop(&bufs[BUF_OUT]);
+    running = false;
+    active_type = TRANSITION_NONE;
+}
+
+static void anim_completed_cb(lv_anim_t *a) {
+    (void)a;
+    cleanup();
+}
+
+static lv_anim_path_cb_t curve_path(transition_curve_t curve) {
+    switch (curve) {
+        case TRANSITION_CURVE_EASE_IN:
+            return lv_anim_path_ease_in;
+        case TRANSITION_CURVE_EASE_OUT:
+            return lv_anim_path_ease_out;
+        case TRANSITION_CURVE_EASE_IN_OUT:
+            return lv_anim_path_ease_in_out;
+        default:
+            return lv_anim_path_linear;
+    }
+}
+
+bool vn_transition_begin(lv_obj_t *screen) {
+    vn_transition_finish();
+
+    lv_obj_update_layout(screen);
+    if (!alloc_buffers(lv_obj_get_width(screen), lv_obj_get_height(screen))) {
+        return false;
+    }
+    return lv_snapshot_take_to_draw_buffer(screen, LV_COLOR_FORMAT_RGB565, &bufs[BUF_OLD]) == LV_RESULT_OK;
+}
+
+void vn_transition_start(lv_obj_t *screen, const transition_config_t *config) {
+    // 新页面的控件位置和尺寸要先计算出来才能渲染
+    lv_obj_update_layout(screen);
+    if (lv_obj_get_width(screen) != buf_w || lv_obj_get_height(screen) != buf_h ||
+        lv_snapshot_take_to_draw_buffer(screen, LV_COLOR_FORMAT_RGB565, &bufs[BUF_NEW]) != LV_RESULT_OK) {
+        return;
+    }
+
+    // 第一帧显示旧页面
+    for (int32_t y = 0; y < buf_h; y++) {
+        memcpy(buf_row(BUF_OUT, y), buf_row(BUF_OLD, y), (size_t)buf_w * sizeof(uint16_t));
+    }
+
+    // 覆盖层作为屏幕的最后一个子对象，完全遮住下面的控件，动画期间它们不需要重绘
+    overlay = lv_image_create(screen);
+    if (overlay == NULL) {
+        return;
+    }
+    lv_obj_remove_flag(overlay, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_pos(overlay, 0, 0);
+    lv_image_set_src(overlay, &bufs[BUF_OUT]);
+
+    active_type = config->type;
+    running = true;
+    last_value = -1;
+    last_offset = 0;
+
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, &overlay);
+    lv_anim_set_exec_cb(&a, anim_exec_cb);
+    lv_anim_set_values(&a, 0, VN_TRANSITION_STEPS);
+    lv_anim_set_duration(&a, (uint32_t)config->duration);
+    lv_anim_set_path_cb(&a, curve_path(config->curve));
+    lv_anim_set_completed_cb(&a, anim_completed_cb);
+    lv_anim_start(&a);
+}
+
+void vn_transition_finish(void) {
+    if (!running) {
+        return;
+    }
+    lv_anim_delete(&overlay, anim_exec_cb);
+    cleanup();
+}
+
+bool vn_transition_running(void) {
+    return running;
+}
+
+void vn_transition_deinit(void) {
+    vn_transition_finish();
+    free_buffers();
+}
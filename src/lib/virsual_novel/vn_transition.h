@@ -0,0 +1,54 @@
+/**
+ * @file vn_transition.h
+ * @brief 视觉小说页面切换效果头文件
+ *
+ * 切换前把整个屏幕（旧页面）渲染到一张离屏缓冲，更新控件后再渲染一次（新页面），
+ * 之后每帧只把这两张缓冲合成到第三张缓冲，由屏幕最上层的图片对象显示。
+ * 动画期间不再重绘背景、角色和文本框，每帧的工作量与页面内容无关：
+ * 淡入淡出用 NEON 逐像素混合（非 ARM 平台使用等价的标量实现），
+ * 推入和擦除只是按行复制。
+ *
+ * 三张缓冲为 RGB565 格式，用 malloc 分配（不占用 LVGL 内存池），
+ * 首次切换时创建并一直保留，屏幕尺寸变化时重新分配。
+ *
+ * 用法：vn_transition_begin()，更新页面控件，vn_transition_start()。
+ * 所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef VN_TRANSITION_H
+#define VN_TRANSITION_H
+
+#include <stdbool.h>
+#include "lvgl/lvgl.h"
+#include "data_parser.h"
+
+/**
+ * @brief 保存旧页面画面（正在进行的切换会先直接结束）
+ * @param screen 页面所在的屏幕对象
+ * @return 是否成功，失败时不应调用 vn_transition_start
+ */
+bool vn_transition_begin(lv_obj_t *screen);
+
+/**
+ * @brief 渲染新页面画面并开始切换动画
+ * @param screen 页面所在的屏幕对象（控件已更新为新页面）
+ * @param config 切换效果配置
+ */
+void vn_transition_start(lv_obj_t *screen, const transition_config_t *config);
+
+/**
+ * @brief 立即结束正在进行的切换，显示新页面
+ */
+void vn_transition_finish(void);
+
+/**
+ * @brief 是否正在切换
+ */
+bool vn_transition_running(void);
+
+/**
+ * @brief 结束切换并释放离屏缓冲
+ */
+void vn_transition_deinit(void);
+
+#endif /* VN_TRANSITION_H */
@@ -0,0 +1,323 @@
+/**
+ * @file worker_pool.c
+ * @brief 通用后台工作线程池实现
+ *
+ * 排队和取消用一把互斥锁保护（每个优先级一个先进先出链表）；完成队列是无锁的
+ * Treiber 栈：工作线程用 CAS 压入，主线程用一次原子交换取走整个链表再反转为
+ * 完成顺序。只有一个消费者且每次取走全部节点，不存在 ABA 问题。
+ * 所有未回调的任务另外挂在 active 双向链表上，供 worker_pool_cancel 按ID查找。
+ */
+
+#include "worker_pool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief 任务状态
+ */
+typedef enum {
+    JOB_QUEUED = 0,             /**< 在优先级队列中 */
+    JOB_RUNNING,                /**< 工作线程执行中 */
+    JOB_FINISHED,               /**< 在完成队列中，等待主线程回调 */
+} job_state_t;
+
+/**
+ * @brief 任务
+ */
+typedef struct worker_job {
+    struct worker_job *next;            /**< 优先级队列 */
+    struct worker_job *done_next;       /**< 完成队列 */
+    struct worker_job *active_prev;     /**< active 链表 */
+    struct worker_job *active_next;
+    uint32_t id;
+    job_state_t state;
+    int cancelled;                      /**< 原子访问 */
+    worker_fn_t work;
+    worker_done_fn_t done;
+    void *arg;
+    uint64_t submit_us;
+} worker_job_t;
+
+/**
+ * @brief 先进先出队列
+ */
+typedef struct {
+    worker_job_t *head;
+    worker_job_t *tail;
+} job_queue_t;
+
+static pthread_t worker_tids[WORKER_POOL_THREADS];
+static int worker_count = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static job_queue_t queues[WORKER_PRIO_COUNT];
+static worker_job_t *active = NULL;         /**< 所有未回调的任务 */
+static worker_job_t *done_stack = NULL;     /**< 完成队列（无锁栈，后完成的在前） */
+static uint32_t next_id = 1;
+static volatile int worker_quit = 0;
+static worker_pool_stats_t pool_stats;
+static __thread worker_job_t *current_job = NULL;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/**
+ * @brief 放入完成队列（任意线程，无锁）
+ */
+static void push_done(worker_job_t *job) {
+    worker_job_t *head = __atomic_load_n(&done_stack, __ATOMIC_RELAXED);
+    do {
+        job->done_next = head;
+    } while (!__atomic_compare_exchange_n(&done_stack, &head, job, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief 取出优先级最高的排队任务（持有锁）
+ */
+static worker_job_t *pop_queued(void) {
+    for (int p = 0; p < WORKER_PRIO_COUNT; p++) {
+        worker_job_t *job = queues[p].head;
+        if (job != NULL) {
+            queues[p].head = job->next;
+            if (queues[p].head == NULL) {
+                queues[p].tail = NULL;
+            }
+            job->next = NULL;
+            pool_stats.pending--;
+            return job;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 从优先级队列中移除任务（持有锁）
+ */
+static void remove_queued(worker_job_t *job, job_queue_t *q) {
+    worker_job_t *prev = NULL;
+    for (worker_job_t *it = q->head; it != NULL; prev = it, it = it->next) {
+        if (it != job) {
+            continue;
+        }
+        if (prev != NULL) {
+            prev->next = job->next;
+        } else {
+            q->head = job->next;
+        }
+        if (q->tail == job) {
+            q->tail = prev;
+        }
+        job->next = NULL;
+        pool_stats.pending--;
+        return;
+    }
+}
+
+static void *worker_thread(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        worker_job_t *job = NULL;
+        while (!worker_quit && (job = pop_queued()) == NULL) {
+            pthread_cond_wait(&cond, &lock);
+        }
+        if (job == NULL) {
+            break;
+        }
+        job->state = JOB_RUNNING;
+        uint32_t wait_ms = (uint32_t)((now_us() - job->submit_us) / 1000u);
+        if (wait_ms > pool_stats.max_wait_ms) {
+            pool_stats.max_wait_ms = wait_ms;
+        }
+        pthread_mutex_unlock(&lock);
+
+        if (!__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED)) {
+            current_job = job;
+            job->work(job->arg);
+            current_job = NULL;
+        }
+
+        pthread_mutex_lock(&lock);
+        job->state = JOB_FINISHED;
+        push_done(job);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+/*=====================
+ * 公共接口
+ *====================*/
+
+bool worker_pool_init(void) {
+    if (worker_count > 0) {
+        return true;
+    }
+
+    worker_quit = 0;
+    for (int i = 0; i < WORKER_POOL_THREADS; i++) {
+        if (pthread_create(&worker_tids[i], NULL, worker_thread, NULL) != 0) {
+            printf("[worker] Failed to start worker thread %d\n", i);
+            break;
+        }
+        worker_count++;
+    }
+    return worker_count > 0;
+}
+
+uint32_t worker_pool_submit(worker_prio_t prio, worker_fn_t work, worker_done_fn_t done, void *arg) {
+    if (worker_count == 0 || work == NULL || prio < 0 || prio >= WORKER_PRIO_COUNT) {
+        return 0;
+    }
+
+    worker_job_t *job = calloc(1, sizeof(worker_job_t));
+    if (job == NULL) {
+        return 0;
+    }
+    job->work = work;
+    job->done = done;
+    job->arg = arg;
+    job->state = JOB_QUEUED;
+    job->submit_us = now_us();
+
+    pthread_mutex_lock(&lock);
+    job->id = next_id++;
+    if (next_id == 0) {
+        next_id = 1;
+    }
+    job->active_next = active;
+    if (active != NULL) {
+        active->active_prev = job;
+    }
+    active = job;
+
+    job_queue_t *q = &queues[prio];
+    if (q->tail != NULL) {
+        q->tail->next = job;
+    } else {
+        q->head = job;
+    }
+    q->tail = job;
+    pool_stats.pending++;
+    pool_stats.submitted++;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+    return job->id;
+}
+
+bool worker_pool_cancel(uint32_t id) {
+    if (id == 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&lock);
+    worker_job_t *job = active;
+    while (job != NULL && job->id != id) {
+        job = job->active_next;
+    }
+    if (job == NULL) {
+        pthread_mutex_unlock(&lock);
+        return false;
+    }
+    __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELAXED);
+    if (job->state == JOB_QUEUED) {
+        // 还没开始执行，直接放入完成队列
+        for (int p = 0; p < WORKER_PRIO_COUNT; p++) {
+            remove_queued(job, &queues[p]);
+        }
+        job->state = JOB_FINISHED;
+        push_done(job);
+    }
+    pthread_mutex_unlock(&lock);
+    return true;
+}
+
+bool worker_pool_cancelled(void) {
+    return current_job != NULL && __atomic_load_n(&current_job->cancelled, __ATOMIC_RELAXED);
+}
+
+int worker_pool_drain(void) {
+    worker_job_t *list = __atomic_exchange_n(&done_stack, NULL, __ATOMIC_ACQUIRE);
+    if (list == NULL) {
+        return 0;
+    }
+
+    // 反转为完成顺序
+    worker_job_t *ordered = NULL;
+    while (list != NULL) {
+        worker_job_t *job = list;
+        list = job->done_next;
+        job->done_next = ordered;
+        ordered = job;
+    }
+
+    int count = 0;
+    while (ordered != NULL) {
+        worker_job_t *job = ordered;
+        ordered = job->done_next;
+
+        // 回调前移出 active，之后的 worker_pool_cancel 找不到该任务；
+        // 回调中取消本批中后面的任务仍然有效
+        pthread_mutex_lock(&lock);
+        if (job->active_prev != NULL) {
+            job->active_prev->active_next = job->active_next;
+        } else {
+            active = job->active_next;
+        }
+        if (job->active_next != NULL) {
+            job->active_next->active_prev = job->active_prev;
+        }
+        pthread_mutex_unlock(&lock);
+
+        bool cancelled = __atomic_load_n(&job->cancelled, __ATOMIC_RELAXED) != 0;
+        pool_stats.completed++;
+        if (cancelled) {
+            pool_stats.cancelled++;
+        }
+        if (job->done != NULL) {
+            job->done(job->arg, cancelled);
+        }
+        free(job);
+        count++;
+    }
+    return count;
+}
+
+void worker_pool_get_stats(worker_pool_stats_t *stats) {
+    pthread_mutex_lock(&lock);
+    *stats = pool_stats;
+    pthread_mutex_unlock(&lock);
+}
+
+void worker_pool_deinit(void) {
+    if (worker_count == 0) {
+        return;
+    }
+
+    // 排队中的任务全部取消
+    pthread_mutex_lock(&lock);
+    worker_quit = 1;
+    worker_job_t *job;
+    while ((job = pop_queued()) != NULL) {
+        __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELAXED);
+        job->state = JOB_FINISHED;
+        push_done(job);
+    }
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(worker_tids[i], NULL);
+    }
+    worker_count = 0;
+
+    worker_pool_drain();
+}
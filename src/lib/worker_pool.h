@@ -0,0 +1,108 @@
+/**
+ * @file worker_pool.h
+ * @brief 通用后台工作线程池头文件
+ *
+ * 把会阻塞 UI 线程的工作（打开媒体文件、解析 JSON、读目录、ioctl 等）交给
+ * WORKER_POOL_THREADS 个共享线程执行，各模块不需要自己创建线程。
+ *
+ * 任务按优先级（高/普通/低）排队，同一优先级先进先出。work 在工作线程执行，
+ * 不能调用 LVGL；完成后任务放入无锁的多生产者单消费者完成队列，主循环在
+ * lv_timer_handler() 之前调用 worker_pool_drain()，在主线程调用 done，
+ * done 中可以直接操作 LVGL 对象。
+ *
+ * 每个提交成功的任务的 done 恰好调用一次（deinit 时也会调用），由 done 负责释放 arg。
+ * 取消后 done 的 cancelled 为 true：排队中的任务不再执行，执行中的任务可以用
+ * worker_pool_cancelled() 提前结束。取消之后调用方可以释放自己的对象，
+ * done 中只能释放 arg，不能再访问调用方。
+ *
+ * 除 worker_pool_cancelled 外，所有接口只能在 LVGL 主线程调用。
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WORKER_POOL_THREADS     2       /**< 工作线程数 */
+
+/**
+ * @brief 任务优先级
+ */
+typedef enum {
+    WORKER_PRIO_HIGH = 0,       /**< 用户正在等待的结果（如打开文件） */
+    WORKER_PRIO_NORMAL,         /**< 一般后台工作 */
+    WORKER_PRIO_LOW,            /**< 预取、统计等可以推迟的工作 */
+    WORKER_PRIO_COUNT,
+} worker_prio_t;
+
+/**
+ * @brief 工作函数（工作线程）
+ * @param arg 提交时的参数
+ */
+typedef void (*worker_fn_t)(void *arg);
+
+/**
+ * @brief 完成回调（LVGL 主线程）
+ * @param arg 提交时的参数
+ * @param cancelled 任务是否被取消（work 可能没有执行或只执行了一部分）
+ */
+typedef void (*worker_done_fn_t)(void *arg, bool cancelled);
+
+/**
+ * @brief 线程池统计
+ */
+typedef struct {
+    uint32_t submitted;         /**< 提交的任务数 */
+    uint32_t completed;         /**< 已调用 done 的任务数 */
+    uint32_t cancelled;         /**< 其中被取消的任务数 */
+    uint32_t pending;           /**< 排队中的任务数 */
+    uint32_t max_wait_ms;       /**< 提交到开始执行的最长等待时间 */
+} worker_pool_stats_t;
+
+/**
+ * @brief 启动工作线程
+ * @return 是否成功
+ */
+bool worker_pool_init(void);
+
+/**
+ * @brief 提交任务
+ * @param prio 优先级
+ * @param work 工作函数（必须）
+ * @param done 完成回调，可以为 NULL
+ * @param arg 传给 work 和 done 的参数
+ * @return 任务ID（非 0），线程池未启动或内存不足时返回 0（不会调用 done）
+ */
+uint32_t worker_pool_submit(worker_prio_t prio, worker_fn_t work, worker_done_fn_t done, void *arg);
+
+/**
+ * @brief 取消任务，done 仍会在主线程调用（cancelled 为 true）
+ * @param id 任务ID
+ * @return 任务是否还未完成回调
+ */
+bool worker_pool_cancel(uint32_t id);
+
+/**
+ * @brief 当前任务是否已被取消（只能在 work 中调用，用于提前结束长时间的工作）
+ */
+bool worker_pool_cancelled(void);
+
+/**
+ * @brief 在主线程调用已完成任务的 done，主循环在 lv_timer_handler() 之前调用
+ * @return 处理的任务数
+ */
+int worker_pool_drain(void);
+
+/**
+ * @brief 获取线程池统计
+ * @param stats 输出
+ */
+void worker_pool_get_stats(worker_pool_stats_t *stats);
+
+/**
+ * @brief 停止工作线程：排队中的任务按取消处理，等待执行中的任务结束，然后调用所有 done
+ */
+void worker_pool_deinit(void);
+
+#endif /* WORKER_POOL_H */
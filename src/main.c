@@ -16,6 +16,14 @@
 #include "lib/button.h"
 #include "lib/settings.h"
 #include "lib/player.h"
+#include "lib/dir_cache.h"
+#include "lib/media_library.h"
+#include "lib/thumb_cache.h"
+#include "lib/http_fetch.h"
+#include "lib/font_atlas.h"
+#include "lib/lua_idle_gc.h"
+#include "lib/lua_app.h"
+#include "lib/worker_pool.h"
 #include "main.h"
 
 #define PATH_MAX_LENGTH 256
@@ -272,6 +280,7 @@ int main(int argc, char *argv[])
   lv_linux_disp_init();
   printf("display OK!\n");
   lv_linux_touch_init();
+  dir_cache_init();
   printf("init OK\n");
   /*Initialized LVGL*/
   
@@ -279,8 +288,29 @@ int main(int argc, char *argv[])
 
   lv_obj_set_style_bg_color(lv_scr_act(), lv_color_hex(0xFFFFFF), 0);
 
+  /* 界面字体（含中文），字形缓存在共享图集中；加载失败时使用内置字体 */
+  font_atlas_init(FONT_ATLAS_DEFAULT_SIZE);
+  lv_font_t *ui_font = font_atlas_load(getenv_default("V833_UI_FONT", FONT_ATLAS_DEFAULT_UI_FONT), FONT_ATLAS_UI_SIZE);
+  if(ui_font) {
+      ui_font->fallback = LV_FONT_DEFAULT;
+      lv_obj_set_style_text_font(lv_scr_act(), ui_font, 0);
+  }
+
+  /* 共享后台线程，完成回调在主循环中执行 */
+  worker_pool_init();
   create_container();
+  /* 扫描 Lua 应用目录，应用在第一次打开时才加载 */
+  lua_app_init(getenv_default("V833_APP_DIR", LUA_APP_DEFAULT_DIR),
+               getenv_default("V833_APP_CACHE", LUA_APP_DEFAULT_CACHE));
   button();
+
+  /* 后台增量扫描媒体库，扫描根目录以 ':' 分隔 */
+  media_library_init(getenv_default("V833_MEDIA_ROOTS", MEDIA_LIBRARY_DEFAULT_ROOTS),
+                     getenv_default("V833_MEDIA_INDEX", MEDIA_LIBRARY_DEFAULT_INDEX));
+  /* 后台生成文件列表缩略图和播放器封面 */
+  thumb_cache_init(getenv_default("V833_THUMB_DIR", THUMB_CACHE_DEFAULT_DIR));
+  /* 网络资源（视觉小说中的 http/https 图片）的磁盘缓存 */
+  http_fetch_init(getenv_default("V833_HTTP_CACHE", HTTP_FETCH_DEFAULT_DIR), 0);
   //lv_demo_widgets();
 
   while(1) {
@@ -288,8 +318,13 @@ int main(int argc, char *argv[])
         if(backgroundTs == -1){
             readKeyPower();
          	if(sleepTs == -1) {
-            	lv_timer_handler();
-	            usleep(5000);
+                /* 先处理后台任务的完成回调，回调中修改的界面在本次刷新中绘制 */
+                worker_pool_drain();
+            	uint32_t idle_ms = lv_timer_handler();
+                /* 下一个定时器到期前的空闲时间先用于 Lua 垃圾回收，剩余的时间休眠 */
+                uint32_t slack_us = LV_MIN(idle_ms, 5) * 1000;
+                uint32_t gc_us = lua_idle_gc_run(slack_us);
+	            usleep(gc_us < 5000 ? 5000 - gc_us : 0);
             }
             else {
                 if(dontDeepSleep) 
@@ -0,0 +1,264 @@
+/**
+ * @file font_bake.c
+ * @brief 字形集生成工具：统计故事或文本中用到的字符
+ *
+ * 用法: font_bake [-n 最大字符数] [-o 输出.glyphs] 输入.json|输入.txt ...
+ * .json 文件只统计字符串值（跳过ID、路径和颜色等字段），其它文件统计全部文本。
+ * 输出为 UTF-8 文本，字符按出现次数从多到少排列，每行64个；
+ * 输出文件默认与第一个输入同名（扩展名改为 .glyphs）。
+ *
+ * 引擎加载 TTF 字体时用 font_atlas_warm_file 按顺序预先光栅化这些字形，
+ * 图集放不下时只保留最常用的部分。
+ */
+
+#include "json_tok.h"
+#include "data_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_CODEPOINT   0x110000
+
+typedef struct {
+    uint32_t cp;
+    uint32_t count;
+} glyph_count_t;
+
+static uint32_t *counts = NULL;
+
+/**
+ * @brief 解码一个 UTF-8 字符，无效字节按单字节跳过
+ */
+static uint32_t utf8_next(const char *s, size_t len, size_t *i) {
+    const unsigned char *p = (const unsigned char *)s + *i;
+    size_t left = len - *i;
+    if (p[0] < 0x80) {
+        *i += 1;
+        return p[0];
+    }
+    if ((p[0] & 0xE0) == 0xC0 && left >= 2) {
+        *i += 2;
+        return ((uint32_t)(p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+    }
+    if ((p[0] & 0xF0) == 0xE0 && left >= 3) {
+        *i += 3;
+        return ((uint32_t)(p[0] & 0x0F) << 12) | ((uint32_t)(p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+    }
+    if ((p[0] & 0xF8) == 0xF0 && left >= 4) {
+        *i += 4;
+        return ((uint32_t)(p[0] & 0x07) << 18) | ((uint32_t)(p[1] & 0x3F) << 12) |
+               ((uint32_t)(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+    }
+    *i += 1;
+    return 0;
+}
+
+static void count_text(const char *s, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        uint32_t cp = utf8_next(s, len, &i);
+        // 控制字符和空白不需要字形
+        if (cp > ' ' && cp < MAX_CODEPOINT && cp != 0x7F) {
+            counts[cp]++;
+        }
+    }
+}
+
+static bool skip_key(const char *key) {
+    static const char *keys[] = { "id", "image", "background", "next_page", "font", "bg_color", "text_color", "transition",
+                                  "script", "jump", "condition" };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        if (strcmp(key, keys[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 递归统计 JSON 中的字符串值
+ */
+static void count_json(const json_doc_t *doc, int tok) {
+    const json_tok_t *t = &doc->toks[tok];
+    if (t->type == JSON_STRING) {
+        count_text(doc->buf + t->start, t->len);
+    } else if (t->type == JSON_ARRAY) {
+        for (int e = json_first(doc, tok); e >= 0; e = json_next(doc, tok, e)) {
+            count_json(doc, e);
+        }
+    } else if (t->type == JSON_OBJECT) {
+        // 成员依次为 键、值
+        uint32_t k = (uint32_t)tok + 1;
+        for (uint32_t i = 0; i < t->size; i++) {
+            if (!skip_key(doc->buf + doc->toks[k].start)) {
+                count_json(doc, (int)k + 1);
+            }
+            k = doc->toks[k + 1].next;
+        }
+    }
+}
+
+static bool count_file(const char *path) {
+    size_t len = strlen(path);
+    if (len > 5 && strcmp(path + len - 5, ".json") == 0) {
+        json_doc_t doc;
+        if (!json_parse_file(&doc, path)) {
+            fprintf(stderr, "failed to parse %s\n", path);
+            return false;
+        }
+        count_json(&doc, 0);
+        json_free(&doc);
+        return true;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char buf[65536];
+    char carry[4];
+    size_t carry_len = 0;
+    size_t n;
+    while ((n = fread(buf + carry_len, 1, sizeof(buf) - carry_len, f)) > 0) {
+        memcpy(buf, carry, carry_len);
+        n += carry_len;
+        // 末尾不完整的 UTF-8 字符留到下一块
+        size_t end = n;
+        size_t back = 0;
+        while (back < 3 && end > 0 && ((unsigned char)buf[end - 1] & 0xC0) == 0x80) {
+            end--;
+            back++;
+        }
+        if (end > 0) {
+            unsigned char lead = (unsigned char)buf[end - 1];
+            size_t need = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+            end = need > back ? end - 1 : n;
+        } else {
+            end = n;
+        }
+        count_text(buf, end);
+        carry_len = n - end;
+        memcpy(carry, buf + end, carry_len);
+    }
+    count_text(carry, carry_len);
+    fclose(f);
+    return true;
+}
+
+static int compare_count(const void *a, const void *b) {
+    const glyph_count_t *x = (const glyph_count_t *)a;
+    const glyph_count_t *y = (const glyph_count_t *)b;
+    if (x->count != y->count) {
+        return x->count > y->count ? -1 : 1;
+    }
+    return x->cp < y->cp ? -1 : (x->cp > y->cp);
+}
+
+static int put_utf8(char *out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+int main(int argc, char **argv) {
+    const char *out_arg = NULL;
+    long max_glyphs = 0;
+    int first = 1;
+    while (first < argc && argv[first][0] == '-') {
+        if (strcmp(argv[first], "-o") == 0 && first + 1 < argc) {
+            out_arg = argv[first + 1];
+            first += 2;
+        } else if (strcmp(argv[first], "-n") == 0 && first + 1 < argc) {
+            max_glyphs = strtol(argv[first + 1], NULL, 10);
+            first += 2;
+        } else {
+            break;
+        }
+    }
+    if (first >= argc) {
+        fprintf(stderr, "usage: %s [-n max_glyphs] [-o out.glyphs] story.json|text.txt ...\n", argv[0]);
+        return 2;
+    }
+
+    char out_path[1024];
+    if (out_arg != NULL) {
+        snprintf(out_path, sizeof(out_path), "%s", out_arg);
+    } else if (!story_sibling_path(argv[first], STORY_GLYPHS_EXTENSION, out_path, sizeof(out_path))) {
+        fprintf(stderr, "output path too long\n");
+        return 2;
+    }
+
+    counts = (uint32_t *)calloc(MAX_CODEPOINT, sizeof(uint32_t));
+    if (counts == NULL) {
+        return 1;
+    }
+    for (int i = first; i < argc; i++) {
+        if (!count_file(argv[i])) {
+            free(counts);
+            return 1;
+        }
+    }
+
+    size_t unique = 0;
+    for (uint32_t cp = 0; cp < MAX_CODEPOINT; cp++) {
+        unique += counts[cp] != 0;
+    }
+    glyph_count_t *glyphs = (glyph_count_t *)malloc((unique ? unique : 1) * sizeof(glyph_count_t));
+    if (glyphs == NULL) {
+        free(counts);
+        return 1;
+    }
+    size_t n = 0;
+    for (uint32_t cp = 0; cp < MAX_CODEPOINT; cp++) {
+        if (counts[cp] != 0) {
+            glyphs[n].cp = cp;
+            glyphs[n].count = counts[cp];
+            n++;
+        }
+    }
+    qsort(glyphs, n, sizeof(glyph_count_t), compare_count);
+    if (max_glyphs > 0 && (size_t)max_glyphs < n) {
+        n = (size_t)max_glyphs;
+    }
+
+    FILE *f = fopen(out_path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        free(glyphs);
+        free(counts);
+        return 1;
+    }
+    size_t cjk = 0;
+    for (size_t i = 0; i < n; i++) {
+        char utf8[4];
+        fwrite(utf8, 1, (size_t)put_utf8(utf8, glyphs[i].cp), f);
+        if (i % 64 == 63 || i + 1 == n) {
+            fputc('\n', f);
+        }
+        cjk += glyphs[i].cp >= 0x2E80;
+    }
+    bool ok = fclose(f) == 0;
+
+    printf("%s: %zu glyphs (%zu unique, %zu CJK)\n", out_path, n, unique, cjk);
+    free(glyphs);
+    free(counts);
+    return ok ? 0 : 1;
+}
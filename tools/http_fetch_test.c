@@ -0,0 +1,490 @@
+/**
+ * @file http_fetch_test.c
+ * @brief http_fetch 测试（本地 HTTP 服务器）
+ *
+ * 用法: http_fetch_test [缓存目录]
+ * 在 127.0.0.1 的随机端口启动一个简单的 HTTP/1.1 服务器，验证下载、keep-alive 复用、
+ * 分块传输、重定向、ETag 重新验证、离线时使用缓存，以及多个 URL 共用同一份内容时
+ * 淘汰一个 URL 不会删除其它 URL 仍在使用的内容。全部通过时返回 0。
+ */
+
+#define _GNU_SOURCE
+#include "http_fetch.h"
+#include <openssl/evp.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BODY_SIZE   4000
+
+static int server_fd = -1;
+static int server_port = 0;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static int connections = 0;         /**< 服务器接受的连接数 */
+static int requests = 0;            /**< 服务器处理的请求数 */
+static int not_modified = 0;        /**< 返回 304 的次数 */
+static int flaky_calls = 0;
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (cond) { \
+        printf("  ok    "); \
+    } else { \
+        printf("  FAIL  "); \
+        failures++; \
+    } \
+    printf(__VA_ARGS__); \
+    printf("\n"); \
+} while (0)
+
+/*=====================
+ * 测试服务器
+ *====================*/
+
+/**
+ * @brief 生成第 seed 份测试内容（每份内容不同）
+ */
+static void make_body(char *buf, int seed) {
+    int n = snprintf(buf, BODY_SIZE, "body %d\n", seed);
+    for (int i = n; i < BODY_SIZE; i++) {
+        buf[i] = (char)('a' + (i * 7 + seed) % 26);
+    }
+}
+
+static bool write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool send_response(int fd, int status, const char *extra, const char *body, size_t len, bool close_conn) {
+    char head[512];
+    const char *reason = status == 200 ? "OK" : status == 302 ? "Found" : status == 304 ? "Not Modified" :
+                         status == 404 ? "Not Found" : "Internal Server Error";
+    int n = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\n%sContent-Length: %zu\r\n%s\r\n",
+                     status, reason, extra, len, close_conn ? "Connection: close\r\n" : "");
+    return write_all(fd, head, (size_t)n) && write_all(fd, body, len);
+}
+
+/**
+ * @brief 处理一个请求，返回是否保持连接
+ */
+static bool handle_request(int fd, const char *path, const char *inm) {
+    static char body[BODY_SIZE];
+
+    pthread_mutex_lock(&stats_lock);
+    requests++;
+    pthread_mutex_unlock(&stats_lock);
+
+    if (strcmp(path, "/a") == 0 || strcmp(path, "/a-copy") == 0) {
+        // 两个 URL 内容相同，缓存中共用一份内容文件
+        const char *etag = strcmp(path, "/a") == 0 ? "\"a1\"" : "\"c1\"";
+        if (inm != NULL && strcmp(inm, etag) == 0) {
+            pthread_mutex_lock(&stats_lock);
+            not_modified++;
+            pthread_mutex_unlock(&stats_lock);
+            char extra[64];
+            snprintf(extra, sizeof(extra), "ETag: %s\r\n", etag);
+            return send_response(fd, 304, extra, "", 0, false);
+        }
+        char extra[64];
+        snprintf(extra, sizeof(extra), "ETag: %s\r\n", etag);
+        make_body(body, 0);
+        return send_response(fd, 200, extra, body, BODY_SIZE, false);
+    }
+    if (strncmp(path, "/big/", 5) == 0) {
+        make_body(body, atoi(path + 5));
+        return send_response(fd, 200, "", body, BODY_SIZE, false);
+    }
+    if (strcmp(path, "/redirect") == 0) {
+        return send_response(fd, 302, "Location: /a\r\n", "", 0, false);
+    }
+    if (strcmp(path, "/close") == 0) {
+        make_body(body, 7);
+        send_response(fd, 200, "", body, BODY_SIZE, true);
+        return false;
+    }
+    if (strcmp(path, "/chunked") == 0) {
+        static const char resp[] =
+            "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+            "5\r\nhello\r\n7;ext=1\r\n, world\r\n0\r\n\r\n";
+        return write_all(fd, resp, sizeof(resp) - 1);
+    }
+    if (strcmp(path, "/flaky") == 0) {
+        // 第一次正常返回，之后服务器出错
+        pthread_mutex_lock(&stats_lock);
+        int call = flaky_calls++;
+        pthread_mutex_unlock(&stats_lock);
+        if (call == 0) {
+            make_body(body, 9);
+            return send_response(fd, 200, "ETag: \"f1\"\r\n", body, BODY_SIZE, false);
+        }
+        return send_response(fd, 500, "", "", 0, false);
+    }
+    return send_response(fd, 404, "", "", 0, false);
+}
+
+static void *conn_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    char buf[8192];
+    int len = 0;
+    buf[0] = '\0';
+
+    for (;;) {
+        char *end = NULL;
+        while ((end = strstr(buf, "\r\n\r\n")) == NULL) {
+            if (len >= (int)sizeof(buf) - 1) {
+                goto done;
+            }
+            ssize_t n = read(fd, buf + len, sizeof(buf) - 1 - (size_t)len);
+            if (n <= 0) {
+                goto done;
+            }
+            len += (int)n;
+            buf[len] = '\0';
+        }
+
+        char path[1024] = "";
+        char inm[128] = "";
+        sscanf(buf, "GET %1023s", path);
+        const char *h = strcasestr(buf, "\r\nIf-None-Match:");
+        if (h != NULL && h < end) {
+            h += 16;
+            while (*h == ' ') {
+                h++;
+            }
+            size_t n = strcspn(h, "\r\n");
+            if (n < sizeof(inm)) {
+                memcpy(inm, h, n);
+                inm[n] = '\0';
+            }
+        }
+
+        // 移除已处理的请求（GET 请求没有请求体）
+        int used = (int)(end + 4 - buf);
+        memmove(buf, buf + used, (size_t)(len - used) + 1);
+        len -= used;
+
+        if (!handle_request(fd, path, inm[0] ? inm : NULL)) {
+            break;
+        }
+    }
+done:
+    close(fd);
+    return NULL;
+}
+
+static void *accept_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        int fd = accept(server_fd, NULL, NULL);
+        if (fd < 0) {
+            break;
+        }
+        pthread_mutex_lock(&stats_lock);
+        connections++;
+        pthread_mutex_unlock(&stats_lock);
+
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, conn_thread, (void *)(intptr_t)fd) == 0) {
+            pthread_detach(tid);
+        } else {
+            close(fd);
+        }
+    }
+    return NULL;
+}
+
+static bool server_start(void) {
+    server_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server_fd < 0) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server_fd, 16) != 0 ||
+        getsockname(server_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        close(server_fd);
+        return false;
+    }
+    server_port = ntohs(addr.sin_port);
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, accept_thread, NULL) != 0) {
+        close(server_fd);
+        return false;
+    }
+    pthread_detach(tid);
+    return true;
+}
+
+/*=====================
+ * 辅助函数
+ *====================*/
+
+static void url_of(const char *path, char *out, size_t size) {
+    snprintf(out, size, "http://127.0.0.1:%d%s", server_port, path);
+}
+
+/**
+ * @brief 下载 path 并检查内容是否等于 expect
+ */
+static http_fetch_result_t fetch(const char *path, char *local, size_t size) {
+    char url[256];
+    url_of(path, url, sizeof(url));
+    return http_fetch_sync(url, local, size);
+}
+
+static bool file_equals(const char *file, const char *expect, size_t len) {
+    FILE *f = fopen(file, "rb");
+    if (f == NULL) {
+        return false;
+    }
+    char *buf = malloc(len + 1);
+    size_t n = buf ? fread(buf, 1, len + 1, f) : 0;
+    fclose(f);
+    bool ok = buf != NULL && n == len && memcmp(buf, expect, len) == 0;
+    free(buf);
+    return ok;
+}
+
+static void meta_file(const char *dir, const char *path, char *out, size_t size) {
+    char url[256];
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int md_len = 0;
+    char hex[65];
+
+    url_of(path, url, sizeof(url));
+    EVP_Digest(url, strlen(url), md, &md_len, EVP_sha256(), NULL);
+    for (unsigned int i = 0; i < md_len && i < 32; i++) {
+        sprintf(hex + i * 2, "%02x", md[i]);
+    }
+    hex[64] = '\0';
+    snprintf(out, size, "%s/meta/%s", dir, hex);
+}
+
+/**
+ * @brief 把 URL 的上次验证时间改为很久以前，下次获取时会重新验证
+ */
+static void expire(const char *dir, const char *path) {
+    char file[PATH_MAX];
+    char lines[3][300];
+    meta_file(dir, path, file, sizeof(file));
+
+    FILE *f = fopen(file, "r");
+    if (f == NULL) {
+        return;
+    }
+    bool ok = fgets(lines[0], sizeof(lines[0]), f) && fgets(lines[1], sizeof(lines[1]), f) &&
+              fgets(lines[2], sizeof(lines[2]), f);
+    fclose(f);
+    if (!ok) {
+        return;
+    }
+    f = fopen(file, "w");
+    if (f != NULL) {
+        fprintf(f, "%s%s%s0\n", lines[0], lines[1], lines[2]);
+        fclose(f);
+    }
+}
+
+/**
+ * @brief 设置 meta 的 mtime（最近使用时间）
+ */
+static void set_used(const char *dir, const char *path, time_t when) {
+    char file[PATH_MAX];
+    struct timespec ts[2] = { { when, 0 }, { when, 0 } };
+    meta_file(dir, path, file, sizeof(file));
+    utimensat(AT_FDCWD, file, ts, 0);
+}
+
+/**
+ * @brief 删除测试创建的缓存目录
+ */
+static void remove_cache(const char *dir) {
+    static const char *subs[] = { "blobs", "meta" };
+    for (int i = 0; i < 2; i++) {
+        char sub[PATH_MAX + 8];
+        snprintf(sub, sizeof(sub), "%s/%s", dir, subs[i]);
+        DIR *dp = opendir(sub);
+        if (dp == NULL) {
+            continue;
+        }
+        struct dirent *de;
+        while ((de = readdir(dp)) != NULL) {
+            if (strcmp(de->d_name, ".") != 0 && strcmp(de->d_name, "..") != 0) {
+                unlinkat(dirfd(dp), de->d_name, 0);
+            }
+        }
+        closedir(dp);
+        rmdir(sub);
+    }
+    rmdir(dir);
+}
+
+static int counter(int *value) {
+    pthread_mutex_lock(&stats_lock);
+    int v = *value;
+    pthread_mutex_unlock(&stats_lock);
+    return v;
+}
+
+/*=====================
+ * 测试
+ *====================*/
+
+int main(int argc, char **argv) {
+    char dir[PATH_MAX];
+    if (argc > 1) {
+        snprintf(dir, sizeof(dir), "%s", argv[1]);
+        mkdir(dir, 0755);
+    } else {
+        snprintf(dir, sizeof(dir), "/tmp/http_fetch_test-XXXXXX");
+        if (mkdtemp(dir) == NULL) {
+            perror("mkdtemp");
+            return 1;
+        }
+    }
+    if (!server_start()) {
+        perror("server");
+        return 1;
+    }
+    printf("缓存目录 %s，服务器端口 %d\n", dir, server_port);
+
+    char body[BODY_SIZE];
+    char local[PATH_MAX];
+    char other[PATH_MAX];
+    http_fetch_result_t res;
+
+    if (!http_fetch_init(dir, 1024 * 1024)) {
+        return 1;
+    }
+
+    printf("下载与 keep-alive:\n");
+    make_body(body, 0);
+    res = fetch("/a", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_OK && file_equals(local, body, BODY_SIZE), "/a 下载完成");
+    int before = counter(&requests);
+    res = fetch("/a", other, sizeof(other));
+    CHECK(res == HTTP_FETCH_OK && strcmp(local, other) == 0 && counter(&requests) == before,
+          "未过期的缓存不联网");
+    for (int i = 1; i <= 3; i++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/big/%d", i);
+        make_body(body, i);
+        res = fetch(path, local, sizeof(local));
+        CHECK(res == HTTP_FETCH_OK && file_equals(local, body, BODY_SIZE), "%s 下载完成", path);
+    }
+    CHECK(counter(&connections) == 1, "4 个请求复用同一个连接（连接数 %d）", counter(&connections));
+
+    printf("分块传输、重定向、Connection: close:\n");
+    res = fetch("/chunked", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_OK && file_equals(local, "hello, world", 12), "/chunked 内容正确");
+    make_body(body, 0);
+    res = fetch("/redirect", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_OK && file_equals(local, body, BODY_SIZE), "/redirect 跟随到 /a");
+    make_body(body, 7);
+    res = fetch("/close", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_OK && file_equals(local, body, BODY_SIZE), "/close 下载完成");
+    before = counter(&connections);
+    res = fetch("/big/4", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_OK && counter(&connections) == before + 1, "服务器关闭后重新连接");
+    res = fetch("/missing", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_ERROR, "404 返回错误");
+
+    printf("ETag 重新验证与离线缓存:\n");
+    expire(dir, "/a");
+    before = counter(&not_modified);
+    res = fetch("/a", local, sizeof(local));
+    make_body(body, 0);
+    CHECK(res == HTTP_FETCH_OK && counter(&not_modified) == before + 1 && file_equals(local, body, BODY_SIZE),
+          "过期后发送 If-None-Match，304 沿用缓存");
+    res = fetch("/flaky", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_OK, "/flaky 第一次下载");
+    expire(dir, "/flaky");
+    res = fetch("/flaky", local, sizeof(local));
+    make_body(body, 9);
+    CHECK(res == HTTP_FETCH_CACHED && file_equals(local, body, BODY_SIZE), "服务器出错时使用缓存");
+
+    printf("共用内容的淘汰:\n");
+    // /a 和 /a-copy 共用一份内容；/a 最久未用，其次是 /big/1，/a-copy 最近使用
+    res = fetch("/a-copy", other, sizeof(other));
+    fetch("/a", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_OK && strcmp(local, other) == 0, "/a 与 /a-copy 共用内容文件");
+    http_fetch_deinit();
+
+    // 只保留 /a、/big/1、/a-copy 三个 URL
+    char keep[3][PATH_MAX];
+    meta_file(dir, "/a", keep[0], sizeof(keep[0]));
+    meta_file(dir, "/big/1", keep[1], sizeof(keep[1]));
+    meta_file(dir, "/a-copy", keep[2], sizeof(keep[2]));
+    const char *drop[] = { "/big/2", "/big/3", "/big/4", "/chunked", "/close", "/redirect", "/flaky" };
+    for (size_t i = 0; i < sizeof(drop) / sizeof(drop[0]); i++) {
+        char file[PATH_MAX];
+        char blob[PATH_MAX + 80];
+        char hash[80] = "";
+        meta_file(dir, drop[i], file, sizeof(file));
+        FILE *f = fopen(file, "r");
+        if (f != NULL) {
+            char line[300];
+            if (fgets(line, sizeof(line), f) && fgets(line, sizeof(line), f) && fgets(hash, sizeof(hash), f)) {
+                hash[strcspn(hash, "\n")] = '\0';
+            }
+            fclose(f);
+            unlink(file);
+        }
+        snprintf(blob, sizeof(blob), "%s/blobs/%s", dir, hash);
+        // /redirect 与 /a 内容相同，不能删除
+        if (hash[0] != '\0' && strcmp(drop[i], "/redirect") != 0) {
+            unlink(blob);
+        }
+    }
+    set_used(dir, "/a", 1000);
+    set_used(dir, "/big/1", 2000);
+    set_used(dir, "/a-copy", 3000);
+
+    // 两份内容共 8000 字节，上限 5000：删除 /a 只减少引用，再删除 /big/1 后低于上限
+    if (!http_fetch_init(dir, 5000)) {
+        return 1;
+    }
+    struct stat st;
+    CHECK(stat(keep[0], &st) != 0, "/a 的元数据被淘汰");
+    CHECK(stat(keep[1], &st) != 0, "/big/1 的元数据被淘汰");
+    make_body(body, 0);
+    char cached[PATH_MAX];
+    url_of("/a-copy", local, sizeof(local));
+    bool hit = http_fetch_cached_path(local, cached, sizeof(cached));
+    CHECK(hit && file_equals(cached, body, BODY_SIZE), "/a-copy 仍在使用的内容没有被删除");
+    before = counter(&requests);
+    res = fetch("/a-copy", local, sizeof(local));
+    CHECK(res == HTTP_FETCH_OK && counter(&requests) == before, "/a-copy 直接使用缓存");
+    http_fetch_deinit();
+
+    if (argc <= 1) {
+        remove_cache(dir);
+    }
+    printf(failures ? "%d 项失败\n" : "全部通过\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file http_get.c
+ * @brief http_fetch 命令行工具（主机端调试用）
+ *
+ * 用法: http_get [-d 缓存目录] [-l 缓存上限] [-j 线程数] URL...
+ * 每个 URL 输出 "结果 本地路径 URL"，结果为 ok / cached / error。
+ * 可配合本地 HTTP 服务器验证 keep-alive、ETag 重新验证和缓存淘汰。
+ */
+
+#include "http_fetch.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static char **urls = NULL;
+static int url_count = 0;
+static int next_url = 0;
+static int failures = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *fetch_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&lock);
+        int i = next_url < url_count ? next_url++ : -1;
+        pthread_mutex_unlock(&lock);
+        if (i < 0) {
+            break;
+        }
+
+        char path[PATH_MAX];
+        http_fetch_result_t res = http_fetch_sync(urls[i], path, sizeof(path));
+        static const char *names[] = { "ok", "cached", "error" };
+
+        pthread_mutex_lock(&lock);
+        printf("%s %s %s\n", names[res], res == HTTP_FETCH_ERROR ? "-" : path, urls[i]);
+        if (res == HTTP_FETCH_ERROR) {
+            failures++;
+        }
+        pthread_mutex_unlock(&lock);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = "./http_cache";
+    size_t limit = 0;
+    int jobs = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:l:j:")) != -1) {
+        switch (opt) {
+        case 'd':
+            dir = optarg;
+            break;
+        case 'l':
+            limit = (size_t)strtoull(optarg, NULL, 10);
+            break;
+        case 'j':
+            jobs = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-d cache_dir] [-l max_bytes] [-j threads] url...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-d cache_dir] [-l max_bytes] [-j threads] url...\n", argv[0]);
+        return 2;
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+
+    if (!http_fetch_init(dir, limit)) {
+        return 1;
+    }
+
+    urls = argv + optind;
+    url_count = argc - optind;
+
+    pthread_t tids[16];
+    int started = 0;
+    for (int i = 0; i < jobs && i < 16; i++) {
+        if (pthread_create(&tids[i], NULL, fetch_thread, NULL) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        fetch_thread(NULL);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    http_fetch_deinit();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file json_bench.c
+ * @brief JSON 解析吞吐量基准测试
+ *
+ * 用法: json_bench [页面数] [重复次数] [文件]
+ * 不指定文件时生成与 story.json 结构相同的故事（含中文文本、转义和角色），
+ * 分别测量 json_parse 的吞吐量和 parse_story_json 的完整加载时间。
+ */
+
+#include "json_tok.h"
+#include "data_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * @brief 生成故事 JSON 到文件
+ */
+static bool generate_story(const char *path, int pages) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return false;
+    }
+
+    fprintf(f, "{\n  \"title\": \"基准测试故事\",\n  \"author\": \"json_bench\",\n  \"pages\": [\n");
+    for (int i = 0; i < pages; i++) {
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"id\": \"page_%d\",\n", i);
+        fprintf(f, "      \"background\": \"A:/mnt/app/data/vn/bg_%d.jpg\",\n", i % 16);
+        fprintf(f, "      \"text\": \"第%d页：\\\"你好，世界\\\"\\n这是一段用于测试解析速度的对话文本，"
+                   "包含转义字符\\t和 \\u00e9\\u4e2d 等 Unicode 字符。\",\n", i);
+        if (i + 1 < pages) {
+            fprintf(f, "      \"next_page\": \"page_%d\",\n", i + 1);
+        } else {
+            fprintf(f, "      \"next_page\": null,\n");
+        }
+        fprintf(f, "      \"textbox\": {\"visible\": true, \"x\": 50, \"y\": 400, \"width\": 700, \"height\": 150, "
+                   "\"bg_color\": \"#000000\", \"text_color\": \"#FFFFFF\", \"font_size\": 16},\n");
+        fprintf(f, "      \"characters\": [\n");
+        for (int j = 0; j < 2; j++) {
+            fprintf(f, "        {\"id\": \"char_%d\", \"image\": \"A:/mnt/app/data/vn/char_%d.png\", "
+                       "\"x\": %d, \"y\": 120, \"scale\": 0.75, \"visible\": %s}%s\n",
+                    j, (i + j) % 8, 100 + j * 300, j == 0 ? "true" : "false", j == 0 ? "," : "");
+        }
+        fprintf(f, "      ]\n    }%s\n", i + 1 < pages ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+static char *read_all(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = len >= 0 ? malloc((size_t)len + 1) : NULL;
+    if (buf != NULL && fread(buf, 1, (size_t)len, f) != (size_t)len) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *size = (size_t)len;
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    int pages = argc > 1 ? atoi(argv[1]) : 3000;
+    int runs = argc > 2 ? atoi(argv[2]) : 50;
+    char tmp[] = "/tmp/json_bench_XXXXXX";
+    const char *path = argc > 3 ? argv[3] : NULL;
+
+    if (pages <= 0 || runs <= 0) {
+        fprintf(stderr, "usage: %s [pages] [runs] [story.json]\n", argv[0]);
+        return 2;
+    }
+    if (path == NULL) {
+        int fd = mkstemp(tmp);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 1;
+        }
+        close(fd);
+        if (!generate_story(tmp, pages)) {
+            fprintf(stderr, "failed to write %s\n", tmp);
+            unlink(tmp);
+            return 1;
+        }
+        path = tmp;
+    }
+
+    size_t size = 0;
+    char *text = read_all(path, &size);
+    if (text == NULL) {
+        fprintf(stderr, "failed to read %s\n", path);
+        return 1;
+    }
+
+    // 1. 纯解析：文本 -> token
+    json_doc_t doc;
+    uint32_t tokens = 0;
+    double t0 = now_ms();
+    for (int r = 0; r < runs; r++) {
+        if (!json_parse(&doc, text, size)) {
+            fprintf(stderr, "parse failed\n");
+            return 1;
+        }
+        tokens = doc.count;
+        json_free(&doc);
+    }
+    double parse_ms = (now_ms() - t0) / runs;
+
+    // 2. 完整加载：读文件 + 解析 + 建立页面/资源索引
+    t0 = now_ms();
+    int page_count = 0;
+    for (int r = 0; r < runs; r++) {
+        story_config_t *story = parse_story_json(path);
+        if (story == NULL) {
+            fprintf(stderr, "parse_story_json failed\n");
+            return 1;
+        }
+        page_count = story->page_count;
+        free_story_config(story);
+    }
+    double load_ms = (now_ms() - t0) / runs;
+
+    printf("%s: %zu bytes, %u tokens, %d pages\n", path, size, tokens, page_count);
+    printf("json_parse:       %8.3f ms  %8.1f MB/s  %8.2f Mtok/s\n",
+           parse_ms, size / parse_ms / 1000.0, tokens / parse_ms / 1000.0);
+    printf("parse_story_json: %8.3f ms  %8.1f MB/s\n", load_ms, size / load_ms / 1000.0);
+
+    free(text);
+    if (path == tmp) {
+        unlink(tmp);
+    }
+    return 0;
+}
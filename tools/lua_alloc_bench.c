@@ -0,0 +1,110 @@
+/**
+ * @file lua_alloc_bench.c
+ * @brief Lua 分配器基准测试
+ *
+ * 用法: lua_alloc_bench [对象数] [重复次数]
+ * 在 luaL_newstate（libc realloc）和 lua_alloc_newstate（大小类别 slab）创建的
+ * lua_State 中分别执行同一段以小表和短字符串为主的脚本，输出耗时、
+ * Lua 统计的内存峰值，以及池分配器的分配次数和 slab 占用。
+ */
+
+#include "lua_alloc.h"
+#include "lauxlib.h"
+#include "lualib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 保留一个滑动窗口的对象，其余的成为垃圾，模拟故事脚本和界面绑定的分配模式
+static const char *const workload =
+    "local n, rounds = ...\n"
+    "local keep, peak = {}, 0\n"
+    "for r = 1, rounds do\n"
+    "  for i = 1, n do\n"
+    "    local t = { x = i, y = i * 2, name = 'item' .. (i % 100), tags = { r, i } }\n"
+    "    keep[i % 4096 + 1] = t\n"
+    "  end\n"
+    "  local kb = collectgarbage('count')\n"
+    "  if kb > peak then peak = kb end\n"
+    "end\n"
+    "return peak\n";
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * @brief 执行测试脚本
+ * @return 耗时（毫秒），失败返回负数
+ */
+static double run(lua_State *L, lua_Integer objects, lua_Integer rounds, double *peak_kb) {
+    luaL_openselectedlibs(L, LUA_GLIBK | LUA_STRLIBK | LUA_TABLIBK, 0);
+    if (luaL_loadstring(L, workload) != LUA_OK) {
+        fprintf(stderr, "加载测试脚本失败: %s\n", lua_tostring(L, -1));
+        return -1;
+    }
+    lua_pushinteger(L, objects);
+    lua_pushinteger(L, rounds);
+    double t0 = now_ms();
+    if (lua_pcall(L, 2, 1, 0) != LUA_OK) {
+        fprintf(stderr, "执行失败: %s\n", lua_tostring(L, -1));
+        return -1;
+    }
+    double ms = now_ms() - t0;
+    *peak_kb = lua_tonumber(L, -1);
+    lua_pop(L, 1);
+    return ms;
+}
+
+int main(int argc, char **argv) {
+    lua_Integer objects = argc > 1 ? atoll(argv[1]) : 200000;
+    lua_Integer rounds = argc > 2 ? atoll(argv[2]) : 10;
+    if (objects <= 0 || rounds <= 0) {
+        fprintf(stderr, "用法: %s [对象数] [重复次数]\n", argv[0]);
+        return 1;
+    }
+
+    double peak_kb;
+    lua_State *L = luaL_newstate();
+    double libc_ms = run(L, objects, rounds, &peak_kb);
+    lua_close(L);
+    if (libc_ms < 0) {
+        return 1;
+    }
+    printf("%lld 个对象 x %lld 轮\n", (long long)objects, (long long)rounds);
+    printf("  luaL_alloc: %8.2f ms，峰值 %.0f KB\n", libc_ms, peak_kb);
+
+    L = lua_alloc_newstate(0);
+    if (L == NULL) {
+        return 1;
+    }
+    double pool_ms = run(L, objects, rounds, &peak_kb);
+    lua_alloc_stats_t stats;
+    lua_alloc_get_stats(L, &stats);
+    lua_alloc_close(L);
+    if (pool_ms < 0) {
+        return 1;
+    }
+    printf("  lua_alloc:  %8.2f ms，峰值 %.0f KB，速度 %.2fx\n", pool_ms, peak_kb, libc_ms / pool_ms);
+    printf("    分配 %llu 次（%u 次/秒），slab %zu KB，大对象 %zu KB\n",
+           (unsigned long long)stats.allocs, stats.allocs_per_sec,
+           stats.slab_bytes / 1024, stats.large_bytes / 1024);
+
+    // 上限低于峰值：触发紧急回收，脚本仍能完成
+    L = lua_alloc_newstate((size_t)(peak_kb * 1024 * 3 / 4));
+    if (L == NULL) {
+        return 1;
+    }
+    double limited_ms = run(L, objects, rounds, &peak_kb);
+    lua_alloc_get_stats(L, &stats);
+    lua_alloc_close(L);
+    if (limited_ms < 0) {
+        printf("  限制 %zu KB: 内存不足\n", stats.limit / 1024);
+    } else {
+        printf("  限制 %zu KB: %8.2f ms，峰值 %zu KB，%u 次紧急回收\n",
+               stats.limit / 1024, limited_ms, stats.peak / 1024, stats.limit_hits);
+    }
+    return 0;
+}
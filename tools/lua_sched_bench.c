@@ -0,0 +1,158 @@
+/**
+ * @file lua_sched_bench.c
+ * @brief Lua 分时调度开销基准测试
+ *
+ * 用法: lua_sched_bench [每帧预算微秒] [循环次数]
+ * 同一段计算（表写入和字符串拼接）分别直接用 lua_pcall 执行和作为任务分帧执行，
+ * 比较总耗时得到调度（钩子检查时间、挂起和恢复）的开销，并输出单帧执行时间的分布，
+ * 确认不超过预算太多；最后测量只让出不计算的任务每帧的固定开销。
+ * 只要设置了计数钩子，Lua 虚拟机每条指令都会经过钩子检查，这部分开销与检查间隔无关，
+ * 用设置了空钩子的直接执行单独测量，分帧执行的开销相对它计算。
+ */
+
+#include "lua_sched.h"
+#include "lauxlib.h"
+#include "lualib.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define IDLE_FRAMES     10000
+#define MAX_FRAMES      100000
+
+static const char *const workload =
+    "function work(n)\n"
+    "  local t, s = {}, 0\n"
+    "  for i = 1, n do\n"
+    "    t[i % 1024 + 1] = i * 2\n"
+    "    if i % 4096 == 0 then s = s + #tostring(i) end\n"
+    "  end\n"
+    "  return s\n"
+    "end\n"
+    "function idle()\n"
+    "  while true do sched.yield() end\n"
+    "end\n";
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void empty_hook(lua_State *L, lua_Debug *ar) {
+    (void)L;
+    (void)ar;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief 直接执行 work(loops)，hooked 时设置一个不做任何事的计数钩子
+ * @return 耗时（毫秒），失败返回负数
+ */
+static double run_direct(lua_State *L, lua_Integer loops, bool hooked) {
+    lua_sethook(L, hooked ? empty_hook : NULL, hooked ? LUA_MASKCOUNT : 0, LUA_SCHED_HOOK_COUNT_MAX);
+    double t0 = now_ms();
+    lua_getglobal(L, "work");
+    lua_pushinteger(L, loops);
+    int status = lua_pcall(L, 1, 1, 0);
+    double ms = now_ms() - t0;
+    lua_sethook(L, NULL, 0, 0);
+    if (status != LUA_OK) {
+        fprintf(stderr, "执行失败: %s\n", lua_tostring(L, -1));
+        return -1;
+    }
+    lua_pop(L, 1);
+    return ms;
+}
+
+static lua_State *open_state(uint32_t budget_us) {
+    lua_State *L = luaL_newstate();
+    if (L == NULL) {
+        return NULL;
+    }
+    luaL_openselectedlibs(L, LUA_GLIBK | LUA_STRLIBK | LUA_MATHLIBK | LUA_TABLIBK, 0);
+    lua_sched_init(L, budget_us);
+    if (luaL_dostring(L, workload) != LUA_OK) {
+        fprintf(stderr, "加载测试脚本失败: %s\n", lua_tostring(L, -1));
+        lua_close(L);
+        return NULL;
+    }
+    return L;
+}
+
+int main(int argc, char **argv) {
+    uint32_t budget_us = argc > 1 ? (uint32_t)atoi(argv[1]) : LUA_SCHED_BUDGET_US;
+    lua_Integer loops = argc > 2 ? atoll(argv[2]) : 20000000;
+    if (budget_us == 0 || loops <= 0) {
+        fprintf(stderr, "用法: %s [每帧预算微秒] [循环次数]\n", argv[0]);
+        return 1;
+    }
+
+    lua_State *L = open_state(budget_us);
+    if (L == NULL) {
+        return 1;
+    }
+
+    // 直接执行，以及设置了空钩子的直接执行（虚拟机逐条指令检查钩子的开销）
+    double direct_ms = run_direct(L, loops, false);
+    double hooked_ms = run_direct(L, loops, true);
+    if (direct_ms < 0 || hooked_ms < 0) {
+        lua_close(L);
+        return 1;
+    }
+
+    // 作为任务分帧执行，记录每帧的执行时间
+    static uint32_t frame_us[MAX_FRAMES];
+    int frames = 0;
+    int over = 0;
+    double t0 = now_ms();
+    lua_getglobal(L, "work");
+    lua_pushinteger(L, loops);
+    lua_sched_spawn(L, 1);
+    while (lua_sched_count() > 0) {
+        uint32_t used = lua_sched_run();
+        if (frames < MAX_FRAMES) {
+            frame_us[frames++] = used;
+        }
+        if (used > budget_us) {
+            over++;
+        }
+    }
+    double sched_ms = now_ms() - t0;
+    qsort(frame_us, (size_t)frames, sizeof(frame_us[0]), compare_u32);
+
+    lua_sched_stats_t stats;
+    lua_sched_get_stats(&stats);
+    printf("预算 %u us，%lld 次循环\n", budget_us, (long long)loops);
+    printf("  直接执行:   %8.2f ms\n", direct_ms);
+    printf("  空钩子执行: %8.2f ms（虚拟机钩子检查 %+.2f%%）\n", hooked_ms, (hooked_ms - direct_ms) * 100.0 / direct_ms);
+    printf("  分帧执行:   %8.2f ms，%u 帧，%u 次挂起\n", sched_ms, stats.frames, stats.preempts);
+    printf("  调度开销:   %8.2f%%（相对空钩子执行），每帧 %.2f us\n",
+           (sched_ms - hooked_ms) * 100.0 / hooked_ms,
+           stats.frames > 0 ? (sched_ms - hooked_ms) * 1000.0 / stats.frames : 0.0);
+    if (frames > 0) {
+        printf("  单帧时间:   中位 %u us，p99 %u us，最长 %u us，超出预算 %d 帧\n",
+               frame_us[frames / 2], frame_us[(frames - 1) * 99 / 100], stats.max_us, over);
+    }
+
+    // 只让出的任务：每帧的固定开销
+    lua_sched_init(L, budget_us);
+    lua_getglobal(L, "idle");
+    lua_sched_spawn(L, 0);
+    t0 = now_ms();
+    for (int i = 0; i < IDLE_FRAMES; i++) {
+        lua_sched_run();
+    }
+    double idle_ms = now_ms() - t0;
+    printf("  空任务:     %8.3f us/帧\n", idle_ms * 1000.0 / IDLE_FRAMES);
+
+    lua_sched_deinit();
+    lua_close(L);
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file lv_lua_bench.c
+ * @brief LVGL Lua 绑定基准测试
+ *
+ * 用法: lv_lua_bench [调用次数]
+ * 在无显示输出的 LVGL 中创建一个标签，分别用 lv_lua 生成的绑定和按常见写法手写的绑定
+ * （luaL_checkudata 按名称检查类型，每次返回对象都新建 userdata）循环调用同样的函数，
+ * 输出每次调用的耗时和循环期间的分配次数。
+ */
+
+#include "lv_lua.h"
+#include "lua_alloc.h"
+#include "lauxlib.h"
+#include "lualib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NAIVE_TYPE  "naive_obj"
+
+/*=====================
+ * 手写绑定（对照）
+ *====================*/
+
+static lv_obj_t *naive_check(lua_State *L, int idx) {
+    return *(lv_obj_t **)luaL_checkudata(L, idx, NAIVE_TYPE);
+}
+
+static void naive_push(lua_State *L, lv_obj_t *obj) {
+    lv_obj_t **ud = (lv_obj_t **)lua_newuserdatauv(L, sizeof(lv_obj_t *), 0);
+    *ud = obj;
+    luaL_setmetatable(L, NAIVE_TYPE);
+}
+
+static int naive_set_pos(lua_State *L) {
+    lv_obj_set_pos(naive_check(L, 1), (int32_t)luaL_checkinteger(L, 2), (int32_t)luaL_checkinteger(L, 3));
+    return 0;
+}
+
+static int naive_get_x(lua_State *L) {
+    lua_pushinteger(L, lv_obj_get_x(naive_check(L, 1)));
+    return 1;
+}
+
+static int naive_get_parent(lua_State *L) {
+    naive_push(L, lv_obj_get_parent(naive_check(L, 1)));
+    return 1;
+}
+
+static const luaL_Reg naive_funcs[] = {
+    { "set_pos", naive_set_pos },
+    { "get_x", naive_get_x },
+    { "get_parent", naive_get_parent },
+    { NULL, NULL }
+};
+
+/*=====================
+ * 测试
+ *====================*/
+
+typedef struct {
+    const char *name;
+    bool naive;         /**< 参数传手写绑定的对象 */
+    const char *code;   /**< 参数: 对象, 次数 */
+} bench_case_t;
+
+static const bench_case_t cases[] = {
+    { "o:set_pos       ", false, "local o, n = ... for i = 1, n do o:set_pos(i % 100, 0) end" },
+    { "lv.obj_set_pos  ", false, "local o, n = ... local f = lv.obj_set_pos for i = 1, n do f(o, i % 100, 0) end" },
+    { "naive.set_pos   ", true, "local o, n = ... local f = naive.set_pos for i = 1, n do f(o, i % 100, 0) end" },
+    { "o:get_x         ", false, "local o, n = ... for i = 1, n do local x = o:get_x() end" },
+    { "naive.get_x     ", true, "local o, n = ... local f = naive.get_x for i = 1, n do local x = f(o) end" },
+    { "o:get_parent    ", false, "local o, n = ... for i = 1, n do local p = o:get_parent() end" },
+    { "naive.get_parent", true, "local o, n = ... local f = naive.get_parent for i = 1, n do local p = f(o) end" },
+};
+
+static void flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
+    (void)area;
+    (void)px_map;
+    lv_display_flush_ready(disp);
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char **argv) {
+    lua_Integer calls = argc > 1 ? atoll(argv[1]) : 1000000;
+    if (calls <= 0) {
+        fprintf(stderr, "用法: %s [调用次数]\n", argv[0]);
+        return 1;
+    }
+
+    static uint8_t draw_buf[480 * 10 * 4];
+    lv_init();
+    lv_display_t *disp = lv_display_create(480, 272);
+    lv_display_set_buffers(disp, draw_buf, NULL, sizeof(draw_buf), LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(disp, flush_cb);
+    lv_obj_t *label = lv_label_create(lv_screen_active());
+
+    lua_State *L = lua_alloc_newstate(0);
+    if (L == NULL) {
+        fprintf(stderr, "创建 lua_State 失败\n");
+        return 1;
+    }
+    luaL_openselectedlibs(L, LUA_GLIBK, 0);
+    lv_lua_open(L);
+    luaL_newmetatable(L, NAIVE_TYPE);
+    lua_pop(L, 1);
+    luaL_newlib(L, naive_funcs);
+    lua_setglobal(L, "naive");
+
+    printf("每项 %lld 次调用\n", (long long)calls);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (luaL_loadstring(L, cases[i].code) != LUA_OK) {
+            fprintf(stderr, "加载失败: %s\n", lua_tostring(L, -1));
+            return 1;
+        }
+        if (cases[i].naive) {
+            naive_push(L, label);
+        } else {
+            lv_lua_push_obj(L, label);
+        }
+        lua_pushinteger(L, calls);
+
+        lua_gc(L, LUA_GCCOLLECT);
+        lua_alloc_stats_t before, after;
+        lua_alloc_get_stats(L, &before);
+        double t0 = now_ms();
+        if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
+            fprintf(stderr, "执行失败: %s\n", lua_tostring(L, -1));
+            return 1;
+        }
+        double ms = now_ms() - t0;
+        lua_alloc_get_stats(L, &after);
+        printf("  %s %7.1f ns/次，分配 %llu 次\n", cases[i].name, ms * 1000000.0 / (double)calls,
+               (unsigned long long)(after.allocs - before.allocs));
+    }
+
+    lv_lua_close();
+    lua_alloc_close(L);
+    lv_obj_delete(label);
+    return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file vn_skip_bench.c
+ * @brief 视觉小说快进吞吐量基准测试（无显示输出）
+ *
+ * 用法: vn_skip_bench [页面数] [重复次数] [文件]
+ * 不指定文件时生成与 story.json 结构相同的线性故事。按引擎快进定时器的方式
+ * 沿 next_page 前进：每帧最多用 VN_SKIP_WALK_MS 跳过页面并标记为已读，帧末
+ * 固定最后到达的页面（相当于显示它），遇到有选项的页面或故事结束时停止。
+ * 分别测量完整解析和按需解析的故事在“快进所有页面”和“只快进已读页面”
+ * 两种模式下的页/秒。页面的 jump 脚本需要 Lua，这里只按 next_page 前进。
+ */
+
+#include "data_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define VN_SKIP_WALK_MS     10      /**< 与 visual_novel_engine.h 相同：每帧用于跳过页面的时间 */
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * @brief 生成线性故事 JSON 到文件
+ */
+static bool generate_story(const char *path, int pages) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return false;
+    }
+
+    fprintf(f, "{\n  \"title\": \"快进基准测试\",\n  \"author\": \"vn_skip_bench\",\n  \"pages\": [\n");
+    for (int i = 0; i < pages; i++) {
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"id\": \"page_%d\",\n", i);
+        fprintf(f, "      \"background\": \"A:/mnt/app/data/vn/bg_%d.jpg\",\n", i % 16);
+        fprintf(f, "      \"text\": \"第%d页：这是一段用于测试快进速度的对话文本。\",\n", i);
+        if (i + 1 < pages) {
+            fprintf(f, "      \"next_page\": \"page_%d\",\n", i + 1);
+        } else {
+            fprintf(f, "      \"next_page\": null,\n");
+        }
+        fprintf(f, "      \"textbox\": {\"visible\": true, \"x\": 50, \"y\": 400, \"width\": 700, \"height\": 150, "
+                   "\"bg_color\": \"#000000\", \"text_color\": \"#FFFFFF\", \"font_size\": 16},\n");
+        fprintf(f, "      \"characters\": [\n");
+        fprintf(f, "        {\"id\": \"char_0\", \"image\": \"A:/mnt/app/data/vn/char_%d.png\", "
+                   "\"x\": 100, \"y\": 120, \"scale\": 0.75, \"visible\": true}\n", i % 8);
+        fprintf(f, "      ]\n    }%s\n", i + 1 < pages ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+/**
+ * @brief 一次快进的结果
+ */
+typedef struct {
+    int pages;          /**< 前进的页数 */
+    int frames;         /**< 显示的页数（帧数） */
+    double ms;          /**< 耗时 */
+} walk_result_t;
+
+/**
+ * @brief 从第一页快进到停止
+ * @param story 故事
+ * @param read 已读页面位图
+ * @param read_only 只快进已读页面
+ */
+static walk_result_t skip_walk(story_config_t *story, uint8_t *read, bool read_only) {
+    walk_result_t result = {0, 0, 0};
+    const page_config_t *page = story_get_page(story, 0);
+    int index = 0;
+    double start = now_ms();
+
+    read[0] |= 1;
+    story_pin_page(story, 0);
+    bool stop = page == NULL;
+    while (!stop) {
+        double frame = now_ms();
+        int advanced = 0;
+        while (true) {
+            if (page->choice_count > 0) {
+                stop = true;
+                break;
+            }
+            int next = page->next_index;
+            if (next < 0 || (read_only && !(read[next >> 3] & (1u << (next & 7))))) {
+                stop = true;
+                break;
+            }
+            page = story_get_page(story, next);
+            if (page == NULL) {
+                stop = true;
+                break;
+            }
+            index = next;
+            read[next >> 3] |= (uint8_t)(1u << (next & 7));
+            advanced++;
+            if (now_ms() - frame >= VN_SKIP_WALK_MS) {
+                break;
+            }
+        }
+        if (advanced > 0) {
+            result.pages += advanced;
+            result.frames++;
+            story_pin_page(story, index);
+            page = story_get_page(story, index);
+        }
+    }
+    result.ms = now_ms() - start;
+    return result;
+}
+
+/**
+ * @brief 加载故事并测量两种快进模式
+ */
+static bool bench(const char *name, story_config_t *(*load)(const char *), const char *path, int runs) {
+    walk_result_t all = {0, 0, 0};
+    walk_result_t read_only = {0, 0, 0};
+
+    for (int r = 0; r < runs; r++) {
+        story_config_t *story = load(path);
+        if (story == NULL) {
+            fprintf(stderr, "%s: failed to load %s\n", name, path);
+            return false;
+        }
+        uint8_t *read = calloc((size_t)story->page_count / 8 + 1, 1);
+        if (read == NULL) {
+            free_story_config(story);
+            return false;
+        }
+
+        // 第一次快进所有页面，跳过的页面标记为已读，第二次只快进已读页面应能走完全部页面
+        walk_result_t a = skip_walk(story, read, false);
+        walk_result_t b = skip_walk(story, read, true);
+        if (b.pages != a.pages) {
+            fprintf(stderr, "%s: read-only skip stopped after %d of %d pages\n", name, b.pages, a.pages);
+            free(read);
+            free_story_config(story);
+            return false;
+        }
+        all.pages += a.pages;
+        all.frames += a.frames;
+        all.ms += a.ms;
+        read_only.pages += b.pages;
+        read_only.frames += b.frames;
+        read_only.ms += b.ms;
+
+        free(read);
+        free_story_config(story);
+    }
+
+    printf("%-6s skip all:  %8d pages %6d frames %10.0f pages/s\n",
+           name, all.pages / runs, all.frames / runs, all.pages / (all.ms > 0 ? all.ms : 1) * 1000.0);
+    printf("%-6s skip read: %8d pages %6d frames %10.0f pages/s\n",
+           name, read_only.pages / runs, read_only.frames / runs,
+           read_only.pages / (read_only.ms > 0 ? read_only.ms : 1) * 1000.0);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int pages = argc > 1 ? atoi(argv[1]) : 20000;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    char tmp[] = "/tmp/vn_skip_bench_XXXXXX";
+    const char *path = argc > 3 ? argv[3] : NULL;
+
+    if (pages <= 0 || runs <= 0) {
+        fprintf(stderr, "usage: %s [pages] [runs] [story.json]\n", argv[0]);
+        return 2;
+    }
+    if (path == NULL) {
+        int fd = mkstemp(tmp);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 1;
+        }
+        close(fd);
+        if (!generate_story(tmp, pages)) {
+            fprintf(stderr, "failed to write %s\n", tmp);
+            unlink(tmp);
+            return 1;
+        }
+        path = tmp;
+    }
+
+    bool ok = bench("full", parse_story_json, path, runs) &&
+              bench("lazy", load_story_lazy, path, runs);
+
+    if (path == tmp) {
+        unlink(tmp);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file vn_storyc.c
+ * @brief 视觉小说故事编译器：story.json -> story.vnb
+ *
+ * 用法: vn_storyc 输入.json [输出.vnb]
+ * 输出文件默认与输入同名（扩展名改为 .vnb），格式见 story_binary.h。
+ * 复用引擎的 JSON 解析器，页面ID重复或跳转目标不存在时编译失败。
+ */
+
+#include "data_parser.h"
+#include "story_binary.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief 去重字符串表
+ */
+typedef struct {
+    char *data;
+    uint32_t size;
+    uint32_t cap;
+    uint32_t *slots;        /**< 开放寻址，存放偏移，VNB_NONE 为空槽 */
+    uint32_t mask;
+    uint32_t count;
+} strtab_t;
+
+static uint32_t fnv1a(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool strtab_grow_slots(strtab_t *t) {
+    uint32_t size = t->slots ? (t->mask + 1) * 2 : 256;
+    uint32_t *slots = malloc(sizeof(uint32_t) * size);
+    if (slots == NULL) {
+        return false;
+    }
+    memset(slots, 0xff, sizeof(uint32_t) * size);
+    if (t->slots != NULL) {
+        for (uint32_t i = 0; i <= t->mask; i++) {
+            if (t->slots[i] == VNB_NONE) {
+                continue;
+            }
+            uint32_t slot = fnv1a(t->data + t->slots[i]) & (size - 1);
+            while (slots[slot] != VNB_NONE) {
+                slot = (slot + 1) & (size - 1);
+            }
+            slots[slot] = t->slots[i];
+        }
+        free(t->slots);
+    }
+    t->slots = slots;
+    t->mask = size - 1;
+    return true;
+}
+
+/**
+ * @brief 加入字符串表，返回偏移；s 为 NULL 时返回 VNB_NONE
+ */
+static uint32_t strtab_add(strtab_t *t, const char *s, bool *ok) {
+    if (s == NULL) {
+        return VNB_NONE;
+    }
+    if ((t->slots == NULL || (t->count + 1) * 2 > t->mask + 1) && !strtab_grow_slots(t)) {
+        *ok = false;
+        return VNB_NONE;
+    }
+
+    uint32_t slot = fnv1a(s) & t->mask;
+    while (t->slots[slot] != VNB_NONE) {
+        if (strcmp(t->data + t->slots[slot], s) == 0) {
+            return t->slots[slot];
+        }
+        slot = (slot + 1) & t->mask;
+    }
+
+    size_t len = strlen(s) + 1;
+    if (t->size + len > t->cap) {
+        uint32_t cap = t->cap ? t->cap : 4096;
+        while (t->size + len > cap) {
+            cap *= 2;
+        }
+        char *data = realloc(t->data, cap);
+        if (data == NULL) {
+            *ok = false;
+            return VNB_NONE;
+        }
+        t->data = data;
+        t->cap = cap;
+    }
+
+    uint32_t off = t->size;
+    memcpy(t->data + off, s, len);
+    t->size += (uint32_t)len;
+    t->slots[slot] = off;
+    t->count++;
+    return off;
+}
+
+static uint32_t align4(uint32_t v) {
+    return (v + 3u) & ~3u;
+}
+
+static uint32_t asset_id(int id) {
+    return id < 0 ? VNB_NONE : (uint32_t)id;
+}
+
+/**
+ * @brief 写入一段数据，之前的对齐空隙补0
+ */
+static bool write_section(FILE *f, uint32_t off, const void *data, size_t size) {
+    long pos = ftell(f);
+    while (pos >= 0 && (uint32_t)pos < off) {
+        if (fputc(0, f) == EOF) {
+            return false;
+        }
+        pos++;
+    }
+    return pos == (long)off && (size == 0 || fwrite(data, 1, size, f) == size);
+}
+
+static bool write_story(const story_config_t *story, const char *out_path) {
+    uint32_t page_count = (uint32_t)story->page_count;
+    uint32_t char_count = 0;
+    uint32_t choice_count = 0;
+    for (int i = 0; i < story->page_count; i++) {
+        char_count += (uint32_t)story->pages[i].character_count;
+        choice_count += (uint32_t)story->pages[i].choice_count;
+    }
+    uint32_t index_size = (uint32_t)story->page_index_mask + 1;
+
+    vnb_page_t *pages = calloc(page_count ? page_count : 1, sizeof(vnb_page_t));
+    vnb_character_t *chars = calloc(char_count ? char_count : 1, sizeof(vnb_character_t));
+    vnb_choice_t *choices = calloc(choice_count ? choice_count : 1, sizeof(vnb_choice_t));
+    int32_t *index = calloc(index_size, sizeof(int32_t));
+    uint32_t *assets = calloc(story->asset_count ? story->asset_count : 1, sizeof(uint32_t));
+    strtab_t strings = {0};
+    bool ok = pages && chars && choices && index && assets;
+
+    vnb_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, VNB_MAGIC, 4);
+    hdr.version = VNB_VERSION;
+    hdr.header_size = sizeof(vnb_header_t);
+    if (ok) {
+        hdr.title = strtab_add(&strings, story->title, &ok);
+        hdr.author = strtab_add(&strings, story->author, &ok);
+    }
+
+    uint32_t next_char = 0;
+    uint32_t next_choice = 0;
+    for (uint32_t i = 0; ok && i < page_count; i++) {
+        const page_config_t *p = &story->pages[i];
+        vnb_page_t *dst = &pages[i];
+        dst->id = strtab_add(&strings, p->id, &ok);
+        dst->background = strtab_add(&strings, p->background, &ok);
+        dst->text = strtab_add(&strings, p->text, &ok);
+        dst->next_page = strtab_add(&strings, p->next_page, &ok);
+        dst->next_index = p->next_index;
+        dst->background_asset = asset_id(p->background_asset);
+        dst->first_character = next_char;
+        dst->character_count = (uint32_t)p->character_count;
+        dst->tb_visible = p->textbox.visible;
+        dst->tb_x = p->textbox.x;
+        dst->tb_y = p->textbox.y;
+        dst->tb_width = p->textbox.width;
+        dst->tb_height = p->textbox.height;
+        dst->tb_bg_color = strtab_add(&strings, p->textbox.bg_color, &ok);
+        dst->tb_text_color = strtab_add(&strings, p->textbox.text_color, &ok);
+        dst->tb_font = strtab_add(&strings, p->textbox.font, &ok);
+        dst->tb_font_size = p->textbox.font_size;
+        dst->transition = p->transition.type;
+        dst->transition_duration = p->transition.duration;
+        dst->transition_curve = p->transition.curve;
+        dst->script = strtab_add(&strings, p->script, &ok);
+        dst->jump = strtab_add(&strings, p->jump, &ok);
+        dst->first_choice = next_choice;
+        dst->choice_count = (uint32_t)p->choice_count;
+
+        for (int j = 0; ok && j < p->character_count; j++) {
+            const character_config_t *c = &p->characters[j];
+            vnb_character_t *cd = &chars[next_char++];
+            cd->id = strtab_add(&strings, c->id, &ok);
+            cd->image = strtab_add(&strings, c->image, &ok);
+            cd->image_asset = asset_id(c->image_asset);
+            cd->x = c->x;
+            cd->y = c->y;
+            cd->scale = c->scale;
+            cd->visible = c->visible;
+        }
+        for (int j = 0; ok && j < p->choice_count; j++) {
+            const choice_config_t *c = &p->choices[j];
+            vnb_choice_t *cd = &choices[next_choice++];
+            cd->text = strtab_add(&strings, c->text, &ok);
+            cd->next_page = strtab_add(&strings, c->next_page, &ok);
+            cd->next_index = c->next_index;
+            cd->condition = strtab_add(&strings, c->condition, &ok);
+            cd->script = strtab_add(&strings, c->script, &ok);
+        }
+    }
+    for (int i = 0; ok && i < story->asset_count; i++) {
+        assets[i] = strtab_add(&strings, story->assets[i], &ok);
+    }
+    for (uint32_t i = 0; ok && i < index_size; i++) {
+        index[i] = story->page_index[i];
+    }
+
+    // 布局：各段按4字节对齐
+    hdr.page_count = page_count;
+    hdr.pages_off = align4(sizeof(vnb_header_t));
+    hdr.character_count = char_count;
+    hdr.characters_off = align4(hdr.pages_off + page_count * sizeof(vnb_page_t));
+    hdr.choice_count = choice_count;
+    hdr.choices_off = align4(hdr.characters_off + char_count * sizeof(vnb_character_t));
+    hdr.index_size = index_size;
+    hdr.index_off = align4(hdr.choices_off + choice_count * sizeof(vnb_choice_t));
+    hdr.hash_off = hdr.index_off + index_size * sizeof(int32_t);
+    hdr.asset_count = (uint32_t)story->asset_count;
+    hdr.assets_off = hdr.hash_off + page_count * sizeof(uint32_t);
+    hdr.strings_off = hdr.assets_off + hdr.asset_count * sizeof(uint32_t);
+    hdr.strings_size = strings.size;
+    hdr.file_size = hdr.strings_off + strings.size;
+
+    char tmp[1024];
+    FILE *f = NULL;
+    if (ok && snprintf(tmp, sizeof(tmp), "%s.tmp", out_path) < (int)sizeof(tmp)) {
+        f = fopen(tmp, "wb");
+    }
+    if (f != NULL) {
+        ok = write_section(f, 0, &hdr, sizeof(hdr)) &&
+             write_section(f, hdr.pages_off, pages, page_count * sizeof(vnb_page_t)) &&
+             write_section(f, hdr.characters_off, chars, char_count * sizeof(vnb_character_t)) &&
+             write_section(f, hdr.choices_off, choices, choice_count * sizeof(vnb_choice_t)) &&
+             write_section(f, hdr.index_off, index, index_size * sizeof(int32_t)) &&
+             write_section(f, hdr.hash_off, story->page_hash, page_count * sizeof(uint32_t)) &&
+             write_section(f, hdr.assets_off, assets, hdr.asset_count * sizeof(uint32_t)) &&
+             write_section(f, hdr.strings_off, strings.data, strings.size);
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || rename(tmp, out_path) != 0) {
+            unlink(tmp);
+            ok = false;
+        }
+    } else {
+        ok = false;
+    }
+
+    if (ok) {
+        printf("%s: %u pages, %u characters, %u choices, %u assets, %u string bytes, %u bytes total\n",
+               out_path, page_count, char_count, choice_count, hdr.asset_count, strings.size, hdr.file_size);
+    } else {
+        fprintf(stderr, "failed to write %s\n", out_path);
+    }
+
+    free(pages);
+    free(chars);
+    free(choices);
+    free(index);
+    free(assets);
+    free(strings.data);
+    free(strings.slots);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s story.json [story.vnb]\n", argv[0]);
+        return 2;
+    }
+
+    char out_path[1024];
+    if (argc == 3) {
+        snprintf(out_path, sizeof(out_path), "%s", argv[2]);
+    } else if (!story_binary_path(argv[1], out_path, sizeof(out_path))) {
+        fprintf(stderr, "output path too long\n");
+        return 2;
+    }
+
+    story_config_t *story = parse_story_json(argv[1]);
+    if (story == NULL) {
+        fprintf(stderr, "failed to parse %s\n", argv[1]);
+        return 1;
+    }
+
+    bool ok = write_story(story, out_path);
+    free_story_config(story);
+
+    // 重新加载一遍，确保引擎能够读取
+    if (ok) {
+        story_config_t *check = load_story_binary(out_path);
+        ok = check != NULL;
+        free_story_config(check);
+    }
+    return ok ? 0 : 1;
+}